@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "utils.h"
+#include "utf8.h"
+
+/* A benchmark of decodeUtf8Str() (check utf8.h) on long subjects, that mix plain text with base 64 and
+  Q encoded-words, in UTF-8 and in a charset that has to be converted. The subjects grow by 4 times from
+  one size to the next, and each size is decoded as many times as it takes to go through the same number
+  of bytes, so if the decoding is linear in the length of the subject, the time per byte stays the same
+  from size to size (it grew with the size, when the decoder was quadratic).
+   Run with "make bench" */
+
+#define MIN_SUBJECT 1024
+#define MAX_SUBJECT (256*1024)
+#define BENCH_BYTES (64*1024*1024) //Decoded at each size
+
+//A plain run, a base 64 word (UTF-8), and a Q word (ISO-8859-1), repeated until the subject is long enough
+static const char *segments[] = {
+	"Re: the meeting notes for the quarter ",
+	"=?utf-8?B?zprOsc67zrfOvM6tz4HOsSDOus+Mz4POvM61?= ",
+	"=?iso-8859-1?Q?caf=E9_J=F6rg_M=FCller?= ",
+	"and a few more plain words, "
+};
+
+//Build a subject of about len bytes, out of the segments in turn
+char *makeSubject(size_t len) {
+	char *subject;
+	size_t pos = 0, segLen;
+	int k = 0;
+
+	subject = malloc(len + 1);
+	if (!subject) {
+		return(NULL);
+	}
+
+	while (1) {
+		segLen = strlen(segments[k]);
+		if (pos + segLen > len) {
+			break;
+		}
+		memcpy(subject + pos, segments[k], segLen);
+		pos += segLen;
+		k = (k + 1) % (sizeof(segments) / sizeof(*segments));
+	}
+	subject[pos] = '\0';
+
+	return(subject);
+}
+
+int main(void) {
+	struct timespec start;
+	char *subject, *decoded;
+	size_t subjectLen, rounds;
+	double ms;
+
+	printf("%10s %10s %14s %12s\n", "Subject", "Decodes", "Per decode", "Per byte");
+	for (size_t len = MIN_SUBJECT ; len <= MAX_SUBJECT ; len *= 4) {
+		subject = makeSubject(len);
+		if (!subject) {
+			fprintf(stderr, "Out of memory\n");
+			return(1);
+		}
+		subjectLen = strlen(subject);
+		rounds = BENCH_BYTES / subjectLen;
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (size_t k = 0 ; k < rounds ; k++) {
+			decoded = decodeUtf8Str(subject);
+			if (!decoded) {
+				fprintf(stderr, "Decoding failed\n");
+				free(subject);
+				return(1);
+			}
+			free(decoded);
+		}
+		ms = elapsedMs(&start);
+
+		printf("%9zuB %10zu %11.1f us %9.2f ns\n", subjectLen, rounds, ms * 1000 / rounds, ms * 1e6 / ((double)rounds * subjectLen));
+		free(subject);
+	}
+
+	return(0);
+}
@@ -2,36 +2,43 @@
 	
 	#define ADDRESS_GUARD
 
-	//A list of addresses is modelled as a singly linked list
+	/* A list of addresses is stored as a single array, in the order of the envelope, and the parts
+	  of the addresses are interned (check intern.h), as the same names and hosts repeat across
+	  the messages of a mailbox */
 	
-	/* If an address list node contains the address "John Smith <john@mail.com>",
+	/* If an address is "John Smith <john@mail.com>",
            personalName contains the string "John Smith", mailboxName contains "john",
-           and hostName contains "mail.com" */
-	struct addressNode {
+           and hostName contains "mail.com" (any of them can be NULL) */
+	typedef struct address {
 		char *personalName;
 		char *mailboxName;
 		char *hostName;
-		struct addressNode *next; //Pointer to the next node of the list
-	};
-	typedef struct addressNode* addressNodeT;
-	
-	//Initialize an address list
-	addressNodeT addrListInit(void); 
+	} addressT;
 
-	//Add a node to an address list
-	int addrListAdd(addressNodeT *headPtr, char *personalName, char *mailboxName, char *hostName);
+	typedef struct addressList {
+		addressT *addrs; //NULL if the list is empty
+		int count;
+	} addressListT;
 
-	/* Print an address list, with the addresses in the format 
+	struct outBuf;
+	/* Format an address list into an output buffer (check outbuf.h), with the addresses in the format 
            <personal-name> (<mailbox-name>"@"<host-name>) */
-	void printAddressList(addressNodeT head);
+	void renderAddressList(struct outBuf *outPtr, addressListT *listPtr);
 	
-	//Free an address list
-	void freeAddressList(addressNodeT head);
+	//Free an address list (releasing its strings), leaving it empty
+	void freeAddressList(addressListT *listPtr);
 	
 	/* Parse an address list in IMAP format (so "(personal-name source-route mailbox-name host-name)",
           with source-route being relevant only to SMTP, so ignored in this application */
-	int parseAddress(imapObjectHandleT addressHandle, char **personalNamePtr, char **mailboxNamePtr, char **hostNamePtr);
+	int parseAddress(imapObjectHandleT addressHandle, addressT *addrPtr);
+
+	//Convert an imapObject of type LIST (or NIL) into a list of addresses (the names are not decoded)
+	int getAddressList(addressListT *listPtr, imapObjectHandleT addressListHandle);
+
+	//Decode the names of an address list (check decodeHeaderField() in utf8.h), the decoded names are interned too
+	int decodeAddressList(addressListT *listPtr);
 
-	//Convert an imapObject of type LIST into a list of addresses
-	int getAddressList(addressNodeT *headPtr, imapObjectHandleT addressListHandle);
+	/* The name shown for the sender of a message, the personal-name of the first address
+	  of its From list, or its mailbox-name, NULL if the list has neither */
+	char *senderName(addressListT *fromListPtr);
 #endif
@@ -0,0 +1,43 @@
+#include <stdio.h>
+#ifndef BACKGROUND_GUARD
+
+	#define BACKGROUND_GUARD
+
+	/* Fetching the envelopes of a large mailbox takes a while, most of it reading and parsing the responses,
+	  so once its first page is in, the rest is fetched by a network thread (check fetchMissing() in commands.c),
+	  while the main thread goes on reading commands, and pages and messages that are cached can be displayed.
+	   The network thread takes the commands from one queue (check queue.h), sends them, and parses the
+	  responses to them into IMAP objects (check parsing.h), which it passes back through another queue.
+	  The caches are only ever changed by the main thread, which applies the parsed responses (check
+	  applyFetch() in untagged.h) in the order they arrived, between commands, so what it displays is never
+	  changed under it. The stream belongs to the network thread from the moment a command is queued, until
+	  the main thread has applied its completion (the tagged response), the main thread must not use the
+	  stream in between (check waitBackground()) */
+
+	#define BACKGROUND_QUEUE_SIZE 1024 //The responses parsed ahead of the main thread, before the network thread waits
+
+	//Start the network thread, for a stream opened with openTransportStream()
+	int startBackground(FILE *imapStream);
+
+	/* Stop the network thread, and wait for it to exit. If it has commands left, the connection is
+	  shut down (as the responses may never come), and what it parsed is dropped */
+	void stopBackground(void);
+
+	/* Queue a command (without the tag) for the network thread to send, the responses to it are applied
+	  to cachePtr. The commands queued before the network thread wakes up are sent in a single write */
+	int queueBackground(msgCacheT *cachePtr, char *command);
+
+	//Whether commands were queued, that have not been completed, in which case the stream is not to be used
+	int backgroundBusy(void);
+
+	/* Apply the responses the network thread has parsed so far, if wait is set and there are none, wait
+	  for the next one first. A NO is printed, as sendCommand() does, and an error (e.g. the connection was
+	  lost) is only returned once every command has been completed, so that the stream can be used */
+	int applyBackground(int wait);
+
+	//Apply the responses until every command has been completed, after which the stream can be used
+	int waitBackground(void);
+
+	//The descriptor that becomes readable when there are responses to apply, to be polled
+	int backgroundFd(void);
+#endif
@@ -0,0 +1,31 @@
+#ifndef BASE64_GUARD
+
+	#define BASE64_GUARD
+
+	/* Base 64 encoding and decoding (RFC 4648), used for MIME encoded-words, message bodies
+	  and attachments, and SASL. For reading on base 64, check https://en.wikipedia.org/wiki/Base64
+	   Decoding is done through a lookup table, and on x86 CPUs that support them, blocks of
+	  16 (SSSE3) or 32 (AVX2) digits are decoded at once, falling back to the table for the
+	  rest of the text, or when a block contains anything other than digits. */
+
+	//The size of the base 64 text for len bytes (without the '\0')
+	#define B64_ENCODED_SIZE(len) (((len) + 2) / 3 * 4)
+	//The maximum number of bytes len base 64 digits decode to
+	#define B64_DECODED_SIZE(len) (((len) + 3) / 4 * 3)
+
+	/* Decode len base 64 digits into decodedStr, which must have room for B64_DECODED_SIZE(len) bytes,
+	  and store the number of bytes decoded in decodedLenPtr. The padding ('=') at the end is optional.
+	  Returns PARSE_ERROR if the text is not valid base 64 */
+	int b64Decode(char *b64Str, size_t len, char *decodedStr, size_t *decodedLenPtr);
+
+	//Same as b64Decode(), but the whitespace (e.g. the line breaks of a message body) is skipped
+	int b64DecodeText(char *b64Str, size_t len, char *decodedStr, size_t *decodedLenPtr);
+
+	/* Copy the base 64 digits of the text to digits (which can be the text itself), leaving out
+	  everything else, as RFC 2045 says for message bodies (padding included), returns their number */
+	size_t b64Strip(char *b64Str, size_t len, char *digits);
+
+	/* Encode len bytes into b64Str, which must have room for B64_ENCODED_SIZE(len)+1 characters,
+	  returns the length of the '\0' terminated text */
+	size_t b64Encode(char *str, size_t len, char *b64Str);
+#endif
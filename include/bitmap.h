@@ -0,0 +1,53 @@
+#ifndef BITMAP_GUARD
+
+	#define BITMAP_GUARD
+
+	/* A compressed bitmap (a set of 32 bit integers), in the style of Roaring bitmaps
+	  (check https://roaringbitmap.org). The values are split by their high 16 bits
+	  into containers, each holding the low 16 bits of up to 65536 values. A container
+	  with few values stores them as a sorted array, and when it fills up (more than
+	  ARRAY_MAX values) it switches to a plain bitmap of 65536 bits, so that a container
+	  never takes more than 8 KB, and sparse sets stay small.
+	   The number of values (cardinality) is kept up to date, so it is available in O(1). */
+
+	#define ARRAY_MAX 4096 //An array of 4096 16 bit values takes as much space as the 65536 bits
+	#define BITMAP_WORDS 1024 //65536 bits in 64 bit words
+
+	struct container {
+		unsigned int key; //The high 16 bits of the values in the container
+		unsigned int card; //The number of values in the container
+		unsigned short *array; //The sorted low 16 bits, if card <= ARRAY_MAX, else NULL
+		unsigned long long *bits; //BITMAP_WORDS words, if card > ARRAY_MAX, else NULL
+	};
+
+	typedef struct bitmap {
+		struct container *containers; //Sorted by key
+		size_t count; //The number of containers
+		size_t cap; //The number of containers that fit in the array
+		size_t card; //The total number of values
+	} bitmapT;
+
+	//Initialize an empty bitmap
+	void bitmapInit(bitmapT *bitmapPtr);
+
+	//Add a value to the bitmap (nothing happens if it is already there)
+	int bitmapAdd(bitmapT *bitmapPtr, unsigned long value);
+
+	//Remove a value from the bitmap (nothing happens if it isn't there)
+	void bitmapRemove(bitmapT *bitmapPtr, unsigned long value);
+
+	//Returns 1 if the value is in the bitmap, else 0
+	int bitmapContains(bitmapT *bitmapPtr, unsigned long value);
+
+	//Store the intersection of two bitmaps in resultPtr (which must not be initialized)
+	int bitmapAnd(bitmapT *bitmap1Ptr, bitmapT *bitmap2Ptr, bitmapT *resultPtr);
+
+	//Store the values of the first bitmap, that are not in the second, in resultPtr
+	int bitmapAndNot(bitmapT *bitmap1Ptr, bitmapT *bitmap2Ptr, bitmapT *resultPtr);
+
+	//Return the values in ascending order, in a dynamically allocated array (NULL if empty)
+	int bitmapToArray(bitmapT *bitmapPtr, unsigned long **valuesPtr, size_t *countPtr);
+
+	//Free the contents of the bitmap, leaving it empty
+	void freeBitmap(bitmapT *bitmapPtr);
+#endif
@@ -0,0 +1,18 @@
+#ifndef BROWSE_GUARD
+
+	#define BROWSE_GUARD
+
+	/* Browsing is a full-screen view of the current mailbox: the previews (in the current sort
+	  order, check sort.h) fill the terminal, and the user moves through them with the keys,
+	  j/k or the arrows (one message), space/b or PgDn/PgUp (one screen), g/G or Home/End
+	  (first/last message), Enter (read the selected message) and q (back to the prompt).
+	   Only the visible rows are rendered (from the cached previews, check cache.h), so moving
+	  costs the same in a mailbox of any size. What each row of the terminal shows is kept, and
+	  a redraw only rewrites the rows that changed, moving the cursor to them. When the list moves
+	  by less than a screen, the terminal scrolls it (so only the rows that came in are written).
+	   While browsing, NOOP is sent like at the prompt, so new messages (and flags that changed)
+	  appear in place. */
+
+	//Browse the current mailbox, until the user quits or reads a message
+	int browseMailbox(FILE *imapStream, cacheManagerT *managerPtr);
+#endif
@@ -1,3 +1,5 @@
+#include <time.h>
+
 #ifndef CACHE_GUARD
 
 	#define CACHE_GUARD
@@ -10,7 +12,10 @@
           is considered empty, so it should be filled by a pointer to
           dynamically allocated message data.
            Also the current size of the cache, and its size before an
-          expansion are stored to help determining when new data needs to be fetched. */
+          expansion are stored to help determining when new data needs to be fetched.
+           Every mailbox selected has its own cache, and the caches are kept by a cache
+          manager, so that when a mailbox is selected again, only the changes since it was
+          last selected need to be fetched (as long as its UIDVALIDITY has not changed). */
 	
 	/* The standard flags a message can have, they are powers of 2, 
          in order to be able to be stored in a single variable by ORing */
@@ -20,23 +25,60 @@
 	#define DELETED 4
 	#define FLAGGED 8
 	
+	//A part of a multipart text that is not displayed as the text (check mime.h)
+	typedef struct attachment {
+		int number; //The number of the part
+		char *filename; //NULL if the part has none
+		char *type;
+		size_t size; //The size of the part, as sent (encoded)
+	} attachmentT;
+
 	//A struct containing all the useful data of a message
 	typedef struct {
-		//The date of the message's arrival to the IMAP server
-		char *internalDate;
+		unsigned long uid; //The unique identifier of the message, 0 if not fetched yet
+		//The date of the message's arrival to the IMAP server, in seconds since the epoch (check date.h)
+		time_t internalDate;
+		int tzOffset; //The offset of the server's timezone from UTC, in minutes
 		//The size of the message in octets
 		int size; 
 		int flags;
 		//Only the needed parts of the envelope are saved
 		struct envelope {
 			char *subject; 
-			addressNodeT fromList; 
-			addressNodeT toList;
-			addressNodeT ccList;
+			addressListT fromList; //Check addresses.h
+			addressListT toList;
+			addressListT ccList;
+			//The terminal columns the subject and the name of the sender take (check utf8.h), for previews
+			int subjectWidth, fromWidth;
+			/* The fields are stored as the server sent them, and decoded when they are first
+			  needed (check decodeEnvelope() in untagged.h), which sets this */
+			char decoded;
 		} envelope;
-		char *text; //Only fetched when needed, so when the text is to be printed
+		char *text; //Only fetched when needed, so when the text is to be printed, it is stored decoded
+		//How the text is encoded (check decoder.h and charset.h), known once BODYSTRUCTURE has been fetched
+		char structureFetched;
+		int encoding;
+		int charset;
+		char *boundary; //The boundary of a multipart text (check mime.h), NULL if the text is not one
+		attachmentT *attachments; //Known once the text has been fetched
+		int attachmentCount;
+		/* Set once the fields the messages are sorted by have been fetched, as
+		  from then on, the message is in every built sort view (check sort.h) */
+		char inViews;
+		char indexed; //Set once the envelope has been added to the search index (check search.h)
+		/* The preview of the message, as displayed in pages, without its sequence number (which changes
+		  on expunges). It is rendered once, and again only if the flags or the layout change (check printing.c) */
+		char *preview;
+		size_t previewLen;
+		unsigned int previewLayout; //The layout the preview was rendered for, 0 if it has to be rendered
+		struct sender *sender; //The sender the message is counted for (check senders.h), NULL if it isn't
+		size_t memUsage; //The memory the message was last counted for, in the msgBytes of its cache
 	} msgT;
 
+	//The keys the messages can be sorted by, SORT_NONE is the sequence number order
+	#define SORT_NONE -1
+	enum sortKey {SORT_DATE, SORT_SIZE, SORT_FROM, SORT_SUBJECT, SORT_KEYS};
+
 	typedef struct {
 		msgT **msgPtrArray; //An array of pointers to msgT
 		size_t cacheSize; //The number of messages (and size of the array)
@@ -45,18 +87,79 @@
                  outside the resizing logic */
 		size_t prevSize; 
 		size_t recent; //The number of recent messages
+		struct sortView *views[SORT_KEYS]; //The sort views built so far, NULL if not built
+		/* The positions expunged since the views were last renumbered, ascending, in the numbering the
+		  views have, as they are renumbered once for a burst of expunges (check viewExpunge() in sort.h) */
+		size_t *viewExpunged;
+		size_t viewExpungedLen, viewExpungedCap;
+		int sortKey; //The current display order (a sortKey, or SORT_NONE)
+		int sortOrder; //ASCENDING or DESCENDING (check sort.h)
+		struct searchIndex *searchIndex; //Used to search the messages locally (check search.h)
+		struct flagIndex *flagIndex; //The messages with each flag, by UID (check flags.h)
+		struct senderIndex *senderIndex; //The messages of each sender, and their counts (check senders.h)
+		char *mailboxName; //The name of the mailbox the cache belongs to
+		unsigned long uidValidity; //If it changes, the UIDs of the cached messages are not valid anymore
+		unsigned long uidNext; //The UID the next message to arrive will (at least) have
+		/* When the mailbox is selected, the cached messages are moved aside (stashed),
+		  as their sequence numbers may have changed, and they are moved back to their
+		  new positions, by UID, as the server reports them */
+		msgT **stash;
+		unsigned long *stashUids; //The UIDs of the stashed messages, in ascending order
+		size_t stashSize;
+		unsigned long stashUidValidity; //The UIDVALIDITY of the stashed messages
+		unsigned long stashUidNext; //The UIDNEXT when they were stashed, if it is the same, no message arrived since
+		/* The memory used by the messages (cached or stashed), kept as they change (check cacheAccount()),
+		  so that the memory used by every cache can be known without going through their messages */
+		size_t msgBytes;
 	} msgCacheT;
 
-	//Initialize a pointer to msgCacheT
-	msgCacheT *cacheInit(void); 
+	typedef struct {
+		msgCacheT **cacheArray; //The caches of all mailboxes selected so far, least recently used first
+		size_t caches; //The number of caches
+		msgCacheT *current; //The cache of the selected mailbox
+		size_t memBudget; //The caches of other mailboxes are freed, when the total memory used exceeds this
+		struct folderTree *folderTree; //The mailboxes of the account (check mailbox.h), NULL until they are listed
+	} cacheManagerT;
+
+	//Initialize a pointer to msgCacheT, for the mailbox with the given name
+	msgCacheT *cacheInit(char *mailboxName); 
 	//Insert a message pointer at position pos of the cache's message pointer array
 	int cacheInsert(msgCacheT *cachePtr, msgT *msgPtr, size_t pos); 
 	//Resize the message pointer array
 	int cacheResize(msgCacheT *cachePtr, size_t newSize);
 	//Remove a message pointer, after freeing it, and reduce the cache's size by one
 	int cacheRemove(msgCacheT *cachePtr, size_t pos);
+	/* Find the position of the message with the given UID, by binary search, as UIDs
+	  ascend along with the sequence numbers. Returns 1 if found, 0 if not */
+	int cacheFindUid(msgCacheT *cachePtr, unsigned long uid, size_t *posPtr);
 	//Free the contents of the cache, and the pointer itself
 	void freeMsgCache(msgCacheT *cachePtr);
 	//Free the contents of a message, and the pointer itself
 	void freeMsgData(msgT *msgPtr);
+	//Count a message again in the memory its cache uses, after it changed (e.g. its text was fetched)
+	void cacheAccount(msgCacheT *cachePtr, msgT *msgPtr);
+	//Free the fields of an envelope, leaving it empty
+	void freeEnvelope(struct envelope *envPtr);
+	//Free an array of attachments, and their contents
+	void freeAttachments(attachmentT *attachments, int count);
+
+	//Move the cached messages to the stash, emptying the cache (done before selecting the mailbox)
+	int cacheStash(msgCacheT *cachePtr);
+	//Take the message with the given UID out of the stash, returns NULL if it is not there
+	msgT *cacheUnstash(msgCacheT *cachePtr, unsigned long uid);
+	//Move the stashed messages back to the cache (done if selecting the mailbox failed)
+	void cacheRestoreStash(msgCacheT *cachePtr);
+	//Free the messages left in the stash (they were expunged while the mailbox was not selected)
+	void freeStash(msgCacheT *cachePtr);
+	//An estimate of the memory used by a cache, in bytes (as of the last cacheAccount() of each message)
+	size_t cacheMemUsage(msgCacheT *cachePtr);
+
+	//Initialize a pointer to cacheManagerT, with a budget for the memory used by all caches
+	cacheManagerT *cacheManagerInit(size_t memBudget);
+	//Get the cache of a mailbox (creating it if needed), and make it the current one
+	msgCacheT *cacheManagerSelect(cacheManagerT *managerPtr, char *mailboxName);
+	//Free the least recently used caches (except the current), until the memory budget is respected
+	void cacheManagerEvict(cacheManagerT *managerPtr);
+	//Free all caches, and the pointer itself
+	void freeCacheManager(cacheManagerT *managerPtr);
 #endif
@@ -0,0 +1,29 @@
+#ifndef CHARSET_GUARD
+
+	#define CHARSET_GUARD
+
+	/* Conversion of text in other charsets to UTF-8 (the charset the terminal is assumed to use).
+	   Single byte charsets (ISO-8859-x, windows-125x, KOI8) are converted through static tables,
+	  that hold the UTF-8 encoding of every byte above 0x7F, so converting is just copying bytes.
+	  Other charsets (e.g. Shift_JIS or GB2312) are converted through iconv, if the program was
+	  built with it (make ICONV=1), else they are unknown. */
+
+	#define CHARSET_UNKNOWN -1
+	#define CHARSET_UTF8 0 //UTF-8 and US-ASCII, the text is copied as is
+
+	//No charset takes more than 3 UTF-8 bytes per byte (bytes that can't be converted become U+FFFD, which takes 3)
+	#define UTF8_EXPANSION 3
+
+	//Returns the charset with the given name (case-insensitive, not '\0' terminated), or CHARSET_UNKNOWN
+	int findCharset(char *name, size_t nameLen);
+
+	/* Convert len bytes of text in the given charset to UTF-8, into dest, which must have
+	  room for UTF8_EXPANSION*len bytes. Returns the number of bytes written */
+	size_t charsetToUtf8(int charset, char *src, size_t len, char *dest);
+
+	/* The same, for text that arrives in parts, an incomplete character at the end is not converted
+	  (convertedPtr gets the number of bytes that were), and the shift state of stateful charsets
+	  is kept between parts, charsetReset() must be called before the first one */
+	size_t charsetToUtf8Part(int charset, char *src, size_t len, char *dest, size_t *convertedPtr);
+	void charsetReset(int charset);
+#endif
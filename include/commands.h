@@ -8,33 +8,70 @@
 	
 	//Request the server to fetch the text part of the message with message number <msgNum>
 	int sendFetchText(FILE *imapStream, msgCacheT *cachePtr, size_t msgNum);
+	/* Fetch the text of the message again, saving the attachments of a multipart text to files in saveDir,
+	  savedPtr and failedPtr get the number of attachments that were saved, and that could not be */
+	int sendSaveAttachments(FILE *imapStream, msgCacheT *cachePtr, size_t msgNum, char *saveDir, int *savedPtr, int *failedPtr);
 
 	/* Request the server to fetch the flags, size (in octets), internal date 
 	 and envelope of the messages numbered in the range [startNum, endNum],
          if startNum == endNum, data for that single message is fetched */
 	int sendFetchAll(FILE *imapStream, msgCacheT *cachePtr, size_t startNum, size_t endNum);
 
-	//Send a SELECT command to the server (in order to select the mailbox with the given name)
-	int sendSelect(FILE *imapStream, msgCacheT *cachePtr, char *mailboxName);
+	/* Send a SELECT command to the server (in order to select the mailbox with the given (decoded) name),
+	  the mailbox's cache becomes the current one of the cache manager, and is brought up to date */
+	int sendSelect(FILE *imapStream, cacheManagerT *managerPtr, char *mailboxName);
 
-	/*Send a LIST command to the server (in order to list all mailboxes in the main 
-	  directory (not recursively) */
-	int listMailboxNames(FILE *imapStream, msgCacheT *cachePtr);
+	/* Print the tree of all mailboxes, the first time (or if refresh is set), a LIST command
+	  is sent to the server to build (or bring up to date) the tree (check mailbox.h) */
+	int listMailboxNames(FILE *imapStream, cacheManagerT *managerPtr, int refresh);
 
 	/* Send a NOOP to the server, to trigger the sending of untagged responses, and reset any autologout 		  timer the server might use */
 	int sendNoop(FILE *imapStream, msgCacheT *cachePtr);
 
+	/* Send a NOOP, and fetch the messages that the server reported as new (EXISTS),
+	  e.g. between commands, and while browsing (check browse.h) */
+	int checkMailbox(FILE *imapStream, msgCacheT *cachePtr);
+
 	//Send a STORE command to the server, in order to flag a single message for deletion
 	int deleteMsg(FILE *imapStream, msgCacheT *cachePtr, int msgNum);
 
+	/* Send UID STORE commands to flag all messages from a sender (mailbox-name@host-name)
+	  for deletion, the messages are found through the sender index (check senders.h) */
+	int deleteFromSender(FILE *imapStream, msgCacheT *cachePtr, char *address);
+
 	//Send a STORE command in order to undelete a single message
 	int undeleteMsg(FILE *imapStream, msgCacheT *cachePtr, int msgNum);
 
 	//Send an EXPUNGE command in order to purge all deleted messages
 	int sendExpunge(FILE *imapStream, msgCacheT *cachePtr);
 
-	//Send a LOGIN command in order to login to the server
-	int sendLogin(FILE *imapStream, char *username, char *password);
+	//How the login and the first SELECT went, the times are from the moment the login command was written
+	typedef struct startupStats {
+		struct timespec start;
+		double firstPageMs; //Until the first page of the mailbox was cached
+		double selectMs; //Until the whole mailbox was, by the network thread (check background.h), 0 until then
+	} startupStatsT;
+
+	/* Log in, and select a mailbox, in a single flight: the login command (AUTHENTICATE PLAIN if the server
+	  advertised SASL-IR, else LOGIN), SELECT, and a FETCH of the first page are written at once, so the first
+	  page is cached a single round trip after the login, instead of three. Returns SEND_AGAIN if the
+	  credentials were rejected, statsPtr can be NULL */
+	int sendLoginSelect(FILE *imapStream, cacheManagerT *managerPtr, char *username, char *password, char *mailboxName, startupStatsT *statsPtr);
+
+	/* Log in again (e.g. on a new connection, after the last one was lost), and select the mailbox that
+	  was selected, in a single flight as sendLoginSelect() does. Its cached messages are kept, and brought
+	  up to date (check refreshCache()), returns SEND_AGAIN if the credentials were rejected */
+	int sendReloginSelect(FILE *imapStream, cacheManagerT *managerPtr, char *username, char *password);
+
+	struct tlsStats;
+
+	/* Send a STARTTLS command, and start TLS on the connection (check tls.h), TLS becomes a layer of
+	  the stream (check transport.h), and the capabilities are asked for again. statsPtr can be NULL */
+	int sendStartTls(FILE *imapStream, char *hostname, char *port, struct tlsStats *statsPtr);
+
+	/* Send a COMPRESS DEFLATE command, and compress the connection (check compress.h) if the server accepts,
+	  if it does not (e.g. it already is compressed), the connection goes on as it was */
+	int sendCompress(FILE *imapStream, msgCacheT *cachePtr);
 
 	//Send a LOGOUT command to terminate the IMAP sesssion
 	int logout(FILE *imapStream);
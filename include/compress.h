@@ -0,0 +1,19 @@
+#ifndef COMPRESS_GUARD
+
+	#define COMPRESS_GUARD
+
+	/* COMPRESS=DEFLATE (RFC 4978) as a layer of the stream (check transport.h), through zlib: what is read
+	  from the layer below is inflated into the buffer the parser reads from, as it arrives, and what is
+	  written is deflated, and flushed at the end of every write (so at every fflush() of the stream), as
+	  the server must be able to read a command as soon as it is sent. Both directions are raw DEFLATE
+	  streams, with a window of COMPRESS_WINDOW_BITS.
+	   Compression is started after the login, if the server advertises it, under TLS it goes above it
+	  (what TLS encrypts is compressed, the reverse would not compress) */
+
+	#define COMPRESS_WINDOW_BITS 15 //The largest window, 32 KB (RFC 4978 requires raw DEFLATE, so it is negated)
+	#define COMPRESS_LEVEL 6 //Commands are short, so a higher level does not pay for itself
+
+	/* Push a DEFLATE layer onto a stream opened with openTransportStream(), once the server accepted
+	  a COMPRESS DEFLATE command (check sendCompress()) */
+	int compressOpen(FILE *imapStream);
+#endif
@@ -0,0 +1,35 @@
+#ifndef CONNECT_GUARD
+
+	#define CONNECT_GUARD
+
+	/* Connections are made in the style of Happy Eyeballs (RFC 8305): the addresses of the
+	  server (IPv6 and IPv4) are interleaved by family, and a non-blocking connect() is started
+	  to each in turn, CONNECT_ATTEMPT_DELAY apart (or as soon as the previous one fails),
+	  without waiting for the ones already started. The first one to connect is used, and the
+	  rest are closed, so an unreachable address costs a short delay instead of a TCP timeout.
+	   The addresses of a host are cached for DNS_CACHE_TTL seconds, so reconnecting does not
+	  resolve the name again, and the address that connected last is tried first. */
+
+	#define CONNECT_ATTEMPT_DELAY 250 //Milliseconds before the next address is tried (RFC 8305 recommends 250)
+	#define CONNECT_TIMEOUT 15000 //Milliseconds before giving up on all addresses
+	#define DNS_CACHE_TTL 300 //Seconds the addresses of a host are kept (getaddrinfo() does not report the real TTL)
+
+	#define ADDRESS_STR_SIZE 64 //Enough for an IPv6 address in brackets, and a port
+
+	//How a connection was made
+	typedef struct connectStats {
+		double resolveMs; //The time the name took to resolve, 0 if the addresses were cached
+		double connectMs; //The time from the first connect() to the connection
+		int cached; //Set if the addresses came from the cache
+		int attempts; //The number of addresses a connect() was started to
+		char address[ADDRESS_STR_SIZE]; //The address connected to, e.g. [::1]:143
+	} connectStatsT;
+
+	/* Connect to the server, returns the socket (in blocking mode), SYSCALL_ERROR if the name
+	  could not be resolved, or SOCKET_ERROR if no address could be connected to.
+	  statsPtr can be NULL */
+	int establishConnection(char *hostname, char *port, connectStatsT *statsPtr);
+
+	//Forget the cached addresses of all hosts
+	void freeDnsCache(void);
+#endif
@@ -0,0 +1,32 @@
+#include <time.h>
+#include <stdint.h>
+
+#ifndef DATE_GUARD
+
+	#define DATE_GUARD
+
+	/* The INTERNALDATE of a message is sent by the server as an IMAP date-time string,
+	  in the fixed format "DD-Mon-YYYY HH:MM:SS +ZZZZ" (the day may be space padded,
+	  and some servers send it as a single digit).
+	   It is parsed once, when the message data is fetched, into the number of seconds
+	  since the epoch (UTC), and the timezone offset of the server in minutes, so that
+	  the messages can be compared by date without reparsing strings. The date is only
+	  turned back into a string when it is displayed. */
+
+	//The size of a buffer that can hold a formatted date-time, including '\0'
+	#define DATE_SIZE 27
+
+	/* The date of a message whose date could not be parsed, such messages are still displayed
+	  (as they would be lost otherwise), and are the oldest when sorted by date. It is the smallest
+	  time_t, which no date-time parses to (the earliest, in the year 0000, is about -6.2e10), so that
+	  any date that parses, the epoch included, is shown (time_t is 64 bits where years past 2038 work) */
+	#define DATE_UNKNOWN ((time_t)INT64_MIN)
+
+	/* Parse an IMAP date-time string, returns PARSE_ERROR (error.h) if it is malformed
+	  (including dates that do not exist, e.g. 31-Feb, and zones with more than 59 minutes) */
+	int parseDateTime(char *dateStr, time_t *datePtr, int *tzOffsetPtr);
+
+	/* Format a date as "DD-Mon-YYYY HH:MM:SS +ZZZZ", the date is shown in the
+	  timezone it was sent in, the same way the server sent it (DATE_UNKNOWN is shown as such) */
+	void formatDateTime(char dateStr[DATE_SIZE], time_t date, int tzOffset);
+#endif
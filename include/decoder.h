@@ -0,0 +1,53 @@
+#ifndef DECODER_GUARD
+
+	#define DECODER_GUARD
+
+	/* Message bodies are decoded while they arrive (check literalSinkT in parsing.h). Every chunk
+	  read from the stream is transfer-decoded (base 64 or quoted-printable, RFC 2045), converted
+	  to UTF-8 from the body's charset (check charset.h), and appended to the decoded text, so the
+	  encoded body is never stored whole. The few bytes a chunk can end in the middle of (part of a
+	  base 64 quartet, of a "=XX" escape, or of a multibyte character) are carried to the next one. */
+
+	//The transfer encodings (Content-Transfer-Encoding)
+	#define ENCODING_IDENTITY 0 //7bit, 8bit and binary, nothing to decode
+	#define ENCODING_BASE64 1
+	#define ENCODING_QP 2 //Quoted-printable
+
+	#define CARRY_SIZE 8
+
+	typedef struct bodyDecoder {
+		literalSinkT sink; //Must be first, so that a pointer to the sink is a pointer to the decoder
+		int encoding;
+		int charset;
+		char encCarry[CARRY_SIZE]; //Encoded bytes left from the previous chunk
+		size_t encCarryLen;
+		char charsetCarry[CARRY_SIZE]; //The start of a multibyte character, left from the previous chunk
+		size_t charsetCarryLen;
+		char *raw; //Transfer-decoded bytes, before their conversion to UTF-8
+		size_t rawCap;
+		char *text; //The decoded text so far
+		size_t textLen, textCap;
+		//If set, the transfer-decoded bytes are written to it instead, as they are (e.g. an attachment)
+		FILE *outFile;
+	} bodyDecoderT;
+
+	//Returns the encoding with the given name (case-insensitive), ENCODING_IDENTITY if it is unknown
+	int findEncoding(char *name);
+
+	/* Initialize a decoder for a body with the given encoding and charset, its sink
+	  gets the string that follows item (e.g. RFC822.TEXT) */
+	void decoderInit(bodyDecoderT *decoderPtr, char *item, int encoding, int charset);
+
+	//Prepare for a body of the given (encoded) size
+	int decoderStart(bodyDecoderT *decoderPtr, size_t size);
+
+	//Decode the next chunk of the body
+	int decoderWrite(bodyDecoderT *decoderPtr, char *chunk, size_t len);
+
+	/* Decode what was left from the last chunk, and return the decoded text ('\0' terminated,
+	  dynamically allocated), or NULL if it was written to a file */
+	int decoderEnd(bodyDecoderT *decoderPtr, char **textPtr);
+
+	//Free the decoder's buffers (the text is not freed, if decoderEnd() returned it)
+	void freeDecoder(bodyDecoderT *decoderPtr);
+#endif
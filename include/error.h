@@ -11,6 +11,7 @@
 	#define SOCKET_ERROR -3 //In case the server disconnects before the user attempts to logout
 	#define COMMAND_ERROR -4 //An invalid command was sent (BAD tag)
 	#define SYSCALL_ERROR -5 //If a system call fails
+	#define TLS_ERROR -6 //If TLS could not be set up (e.g. the certificate of the server could not be verified)
 
 	int isError(int retVal);
 	void printError(char *message, int retVal);
@@ -0,0 +1,41 @@
+#ifndef FLAGS_GUARD
+
+	#define FLAGS_GUARD
+
+	/* For every standard flag, the UIDs of the messages that have it are kept in a
+	  bitmap (check bitmap.h), along with the UIDs of all messages whose flags are known.
+	  Since bitmaps keep their cardinality, the number of unseen, deleted or flagged
+	  messages is available without walking the cache, and messages with a combination of
+	  flags (e.g. unseen and flagged) are found by intersecting the bitmaps.
+	   The bitmaps are updated whenever the server reports the flags of a message, and
+	  when a message is expunged. */
+
+	#define FLAG_KINDS 5 //SEEN, RECENT, ANSWERED, DELETED and FLAGGED (check cache.h)
+
+	typedef struct flagIndex {
+		bitmapT known; //The UIDs of the messages whose flags have been fetched
+		bitmapT withFlag[FLAG_KINDS]; //The UIDs of the messages with each flag, by the flag's bit position
+	} flagIndexT;
+
+	//Initialize a pointer to flagIndexT
+	flagIndexT *flagIndexInit(void);
+
+	//Store the current flags of the message with the given UID
+	int flagIndexUpdate(flagIndexT *indexPtr, unsigned long uid, int flags);
+
+	//Remove an expunged message from the index
+	void flagIndexRemove(flagIndexT *indexPtr, unsigned long uid);
+
+	//The number of messages that have (or, if missing == 1, do not have) the given flag
+	size_t flagCount(flagIndexT *indexPtr, int flag, int missing);
+
+	/* Get the UIDs of the messages that have all of the flags in setFlags, and none of the
+	  flags in unsetFlags, in ascending order, in a dynamically allocated array (NULL if empty) */
+	int flagIndexFilter(flagIndexT *indexPtr, int setFlags, int unsetFlags, unsigned long **uidsPtr, size_t *countPtr);
+
+	//Empty the index (done when the UIDs of the mailbox are not valid anymore)
+	void resetFlagIndex(flagIndexT *indexPtr);
+
+	//Free the contents of the index, and the pointer itself
+	void freeFlagIndex(flagIndexT *indexPtr);
+#endif
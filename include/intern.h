@@ -0,0 +1,20 @@
+#ifndef INTERN_GUARD
+
+	#define INTERN_GUARD
+
+	/* The parts of addresses repeat across the messages of a mailbox (the same senders, and a few
+	  hosts), so they are interned: every distinct string is stored once, in a hash table, and
+	  each use of it holds a reference, the string is freed when the last reference is released.
+	   Interned strings are shared, so they must not be changed or freed with free(), and two
+	  interned strings are equal if and only if their pointers are. */
+
+	/* Get the interned copy of str (adding a reference to it), str itself is not kept,
+	  a NULL str gives NULL */
+	int internString(char *str, char **internedPtr);
+
+	//Release a reference to an interned string (NULL is ignored)
+	void releaseString(char *interned);
+
+	//The number of references to an interned string
+	size_t internRefs(char *interned);
+#endif
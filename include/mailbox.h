@@ -0,0 +1,76 @@
+#ifndef MAILBOX_GUARD
+
+	#define MAILBOX_GUARD
+
+	/* Mailbox names are sent in modified UTF-7 (RFC 3501, section 5.1.3): printable ASCII stands
+	  for itself (except '&', which is sent as "&-"), and anything else is UTF-16, in base 64 (with
+	  ',' in place of '/', and no padding), between '&' and '-'. e.g. "&BB4EQgQ,BEAEMAQyBDsENQQ9BD0ESwQ1-"
+	  is "Отправленные".
+	   The mailboxes of the account are kept as a tree, built from a single LIST "" * (all mailboxes,
+	  at every level), so that their names are decoded once, when they first appear. The tree is
+	  rendered to a string that is kept until the tree changes, and refreshing it only adds the
+	  mailboxes that appeared, and removes the ones that are gone. The folders are found both by
+	  the name the server knows them by, and by the decoded one (which the user types), through
+	  hash tables. */
+
+	//The attributes of a mailbox (LIST returns them), powers of 2, so that they can be ORed
+	#define FOLDER_NOSELECT 1 //Not a mailbox, only a level of the hierarchy
+	#define FOLDER_NOINFERIORS 2
+	#define FOLDER_MARKED 4 //Probably has new messages
+	#define FOLDER_UNMARKED 8
+
+	typedef struct folder {
+		char *name; //The full name, as the server knows it (modified UTF-7), e.g. INBOX/Archive
+		char *decodedName; //The full name, decoded to UTF-8
+		char *leafName; //The last level of the decoded name (points into it)
+		int attributes;
+		int depth; //The top level is 0
+		unsigned long generation; //The last refresh the folder was listed in
+		struct folder *parent; //NULL at the top level
+		struct folder *children; //Sorted by decoded name
+		struct folder *next; //The next sibling
+	} folderT;
+
+	typedef struct folderTree {
+		folderT *top; //The first folder of the top level
+		folderT **byName; //Hash tables, by name and by decoded name
+		folderT **byDecodedName;
+		size_t tableSize; //A power of two
+		size_t folders;
+		char delimiter; //The hierarchy delimiter, '\0' if the hierarchy is flat
+		char loaded; //Set once the tree has been listed
+		unsigned long generation; //Incremented on every refresh
+		char *rendered; //The listing of the tree, NULL if it has changed since it was rendered
+	} folderTreeT;
+
+	/* Decode a name in modified UTF-7 to a dynamically allocated UTF-8 string,
+	  returns PARSE_ERROR if it is not valid */
+	int utf7Decode(char *name, char **decodedPtr);
+
+	//Encode a UTF-8 string to a dynamically allocated name in modified UTF-7
+	int utf7Encode(char *str, char **encodedPtr);
+
+	folderTreeT *folderTreeInit(void);
+
+	//Start a refresh, the folders that are not added again before it ends are removed
+	void folderTreeStartRefresh(folderTreeT *treePtr);
+
+	/* Add a folder (or mark it as listed, if it is already in the tree), with a LIST response.
+	  The levels above it are added too, as not selectable, if the server has not listed them */
+	int folderTreeAdd(folderTreeT *treePtr, char *name, char delimiter, int attributes);
+
+	//End a refresh, removing the folders that were not listed in it
+	int folderTreeEndRefresh(folderTreeT *treePtr);
+
+	//Find a folder by its name (decoded if decoded is set), returns NULL if it is not in the tree
+	folderT *folderTreeFind(folderTreeT *treePtr, char *name, int decoded);
+
+	/* Get the name the server knows a mailbox by (dynamically allocated), from the name the user
+	  typed, if the mailbox is not in the tree, the name is encoded */
+	int folderServerName(folderTreeT *treePtr, char *decodedName, char **namePtr);
+
+	//Get the listing of the tree, it is only rendered again if the tree has changed
+	char *folderTreeRender(folderTreeT *treePtr);
+
+	void freeFolderTree(folderTreeT *treePtr);
+#endif
@@ -0,0 +1,91 @@
+#ifndef MIME_GUARD
+
+	#define MIME_GUARD
+
+	/* The text of a multipart message (RFC 2046) is a sequence of parts, separated by delimiter
+	  lines ("--" followed by the boundary), each part made of its own headers, a blank line and
+	  its body, and the last delimiter is followed by "--". A part can be a multipart itself, with
+	  its own boundary, so parts nest.
+	   The parser splits the text while it arrives, in chunks (it is a literalSinkT, check parsing.h),
+	  and reports every part through events: its start, once its headers have been parsed, each
+	  piece of its body, and its end. Only the bytes that can be the start of a delimiter are held
+	  between chunks, so no part is ever stored whole. Delimiters are searched for with SSE2/AVX2,
+	  a whole block of positions is compared with the first and the last byte of the delimiter at
+	  once, and only the positions where both match are compared in full. */
+
+	#define MIME_MAX_DEPTH 8 //Deeper parts are treated as a part that is not a multipart
+	#define MIME_BOUNDARY_SIZE 71 //A boundary has at most 70 characters (and the '\0')
+	#define MIME_DELIM_SIZE (MIME_BOUNDARY_SIZE + 4) //CRLF "--" boundary
+	#define MIME_TYPE_SIZE 64
+
+	//The states of the parser
+	enum mimeState {MIME_PREAMBLE, MIME_DELIM_LINE, MIME_HEADERS, MIME_BODY, MIME_DONE};
+
+	typedef struct mimePart {
+		int number; //The parts that are not multiparts are numbered from 1, in the order they appear
+		char type[MIME_TYPE_SIZE]; //Lowercase, e.g. text/plain
+		int encoding; //Check decoder.h
+		int charset; //Check charset.h
+		char *filename; //NULL if the part has none, dynamically allocated, freed after the end event
+		char attachment; //Set if the Content-Disposition is attachment
+		char boundary[MIME_BOUNDARY_SIZE]; //Empty, unless the part is a multipart
+		size_t size; //The size of the body so far (encoded)
+	} mimePartT;
+
+	typedef struct mimeParser {
+		literalSinkT sink; //Must be first, so that a pointer to the sink is a pointer to the parser
+		int (*partStart)(struct mimeParser *parserPtr, mimePartT *partPtr);
+		int (*partBody)(struct mimeParser *parserPtr, mimePartT *partPtr, char *chunk, size_t len);
+		int (*partEnd)(struct mimeParser *parserPtr, mimePartT *partPtr);
+		enum mimeState state;
+		char delims[MIME_MAX_DEPTH][MIME_DELIM_SIZE]; //The delimiters of the multiparts the parser is in
+		size_t delimLens[MIME_MAX_DEPTH];
+		int depth;
+		char *buf; //The bytes that have not been consumed yet
+		size_t bufLen, bufCap;
+		mimePartT part; //The part the parser is in
+		size_t bodyLead; //The length of the blank line before the body, while it is not known to be part of it
+		int parts;
+	} mimeParserT;
+
+	/* Reads a message while it arrives: the first text part that is not an attachment is decoded
+	  (a text/plain part is preferred, so if the first one is e.g. text/html, a text/plain part that
+	  follows replaces it), the attachments are listed, and if saveDir is set, also decoded to files
+	  in it. The bodies of the rest are skipped */
+	typedef struct mimeReader {
+		mimeParserT parser; //Must be first
+		bodyDecoderT decoder;
+		enum {READ_SKIP, READ_TEXT, READ_SAVE} mode; //What is done with the body of the current part
+		char *text; //The decoded text
+		char textPlain;
+		char *saveDir;
+		char savePath[FILENAME_MAX];
+		FILE *saveFile;
+		int saved, failed; //How many attachments were saved, and could not be
+		attachmentT *attachments;
+		int attachmentCount;
+	} mimeReaderT;
+
+	//Returns the first occurence of delim (at least 2 bytes long) in str, NULL if there is none
+	char *findDelimiter(char *str, size_t len, char *delim, size_t delimLen);
+
+	/* Initialize a parser for a text with the given boundary, its sink gets the string that
+	  follows item. The events are set by the caller */
+	void mimeInit(mimeParserT *parserPtr, char *item, char *boundary);
+
+	int mimeStart(mimeParserT *parserPtr, size_t size);
+
+	//Split the next chunk of the text
+	int mimeWrite(mimeParserT *parserPtr, char *chunk, size_t len);
+
+	//The text has ended, a part that is still open (as the last delimiter is missing) ends too
+	int mimeEnd(mimeParserT *parserPtr);
+
+	void freeMimeParser(mimeParserT *parserPtr);
+
+	//Initialize a reader for a text with the given boundary, saveDir can be NULL
+	void mimeReaderInit(mimeReaderT *readerPtr, char *item, char *boundary, char *saveDir);
+
+	//Free the reader's buffers, the attachments too, unless they were taken
+	void freeMimeReader(mimeReaderT *readerPtr);
+#endif
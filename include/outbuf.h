@@ -0,0 +1,39 @@
+#ifndef OUTBUF_GUARD
+
+	#define OUTBUF_GUARD
+
+	/* Pages and messages are formatted into a buffer, and written to the terminal with a single
+	  write(), instead of through hundreds of small stdio calls (each one a write() when stdout is
+	  unbuffered or line buffered), so a page is never seen half drawn, e.g. over SSH.
+	   The buffer grows as needed and is kept between pages. Appending never fails on its own,
+	  if the buffer can't grow, the output is dropped and the error is reported by outFlush(),
+	  so that formatting code does not have to check every call. */
+
+	typedef struct outBuf {
+		char *buf;
+		size_t len, cap;
+		char failed; //Set if the buffer could not grow
+	} outBufT;
+
+	#define OUTBUF_INIT {NULL, 0, 0, 0}
+
+	void outWrite(outBufT *outPtr, char *str, size_t len);
+
+	void outStr(outBufT *outPtr, char *str);
+
+	void outChar(outBufT *outPtr, char c);
+
+	void outPrintf(outBufT *outPtr, char *format, ...) __attribute__((format(printf, 2, 3)));
+
+	//Append num spaces (nothing if num is not positive)
+	void outPad(outBufT *outPtr, int num);
+
+	/* Write the buffer to fd (stdio's buffer for stdout is flushed first, so the output stays in
+	  order) and empty it. Returns MEM_ERROR if any output was dropped */
+	int outFlush(outBufT *outPtr, int fd);
+
+	//Empty the buffer without writing it
+	void outReset(outBufT *outPtr);
+
+	void freeOutBuf(outBufT *outPtr);
+#endif
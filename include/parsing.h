@@ -37,6 +37,20 @@
 	//typedefs to improve code readability
 	typedef struct imapObject imapObjectT;
 	typedef struct imapObject* imapObjectHandleT;
+
+	/* Instead of being stored as they are, strings can be passed to a sink while they are read,
+	  in chunks, e.g. to decode a message body as it arrives, without keeping the encoded text.
+	  A sink gets the string that follows the atom named item in a list (e.g. RFC822.TEXT in the
+	  list of a FETCH response), and the STRING object contains what the sink returns instead */
+	typedef struct literalSink {
+		char *item;
+		int (*start)(struct literalSink *sinkPtr, size_t size); //Called with the size of the string, before any chunk
+		int (*write)(struct literalSink *sinkPtr, char *chunk, size_t len);
+		int (*end)(struct literalSink *sinkPtr, char **strPtr); //Returns the string to store in the object
+	} literalSinkT;
+
+	//Set the sink strings are passed to (NULL to stop passing them)
+	void setLiteralSink(literalSinkT *sinkPtr);
 	
 	//Free an imap object through its handle
 	void freeImapObject(imapObjectHandleT imapHandle);
@@ -49,6 +63,9 @@
           return a handle to it */
 	int getStringObject(imapObjectHandleT *strHandlePtr, FILE *imapStream);
 
+	//Parse the IMAP data sent by the server, and return a handle to the resulting object, whatever its tag
+	int getImapObject(imapObjectHandleT *imapHandlePtr, FILE *imapStream);
+
 	//Same as getStringObject() but with LIST-tagged objects instead
 	int getListObject(imapObjectHandleT *imapHandlePtr, FILE *imapStream);
 	
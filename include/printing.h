@@ -8,17 +8,34 @@
 
 	/* About pages:
 	 The messages of the mailbox are split into totalMessages / PAGE_MSGS + 1
-         (PAGE_MSGS is defined in printing.c), so that their previews fit in a terminal
+         (PAGE_MSGS is defined below), so that their previews fit in a terminal
          window, and the user is able to display older or more recent messages. 
          The function displayMsgPage() can print messages by page, and by reading the 
          previews, the user can use the matching msgNum in commands such as !read or
          !delete (see main.c for those) */
+
+	#define PAGE_MSGS 20 //The number of messages per page (displayMsgPage() displays messages by page)
 	
+	/* Handle SIGWINCH, so that the previews take the width of the terminal when it is resized
+	  (the subject takes the columns the other fields leave) */
+	int watchTerminalSize(void);
+
+	struct outBuf;
+
+	//Read the width of the terminal, if it was resized (the previews are rendered again if it changed)
+	void updateLayout(void);
+
+	/* Append the column titles of the previews, and the preview of the message at position pos
+	  of the cache (both end in '\n') */
+	void renderPageHeader(struct outBuf *outPtr);
+	int renderMsgPreview(struct outBuf *outPtr, msgCacheT *cachePtr, size_t pos);
+
 	//Clear the screen (like the clear unix command)
 	void clearScreen(void);
 
 	/* Print information about the current mailbox (at the moment,
           the number of existing messages, the number of recent messages,
+          the number of unseen, flagged and deleted messages,
           and the number of pages (as used by displayMsgPage) */
 	void printStat(msgCacheT *cachePtr);
 
@@ -27,8 +44,23 @@
 	
 	//Display the contents of a message (subject, date, From, To, CC, text)
 	int displayMsg(FILE *imapStream, msgCacheT *cachePtr, int msgNum);
+
+	//Save the attachments of a message to files in saveDir (existing files are not overwritten)
+	int saveMsgAttachments(FILE *imapStream, msgCacheT *cachePtr, int msgNum, char *saveDir);
 	
 	/* Display a preview (in the format <msg-number> <subject> <from> <date> <size>),
           if a field doesn't fit, only part of it is printed */
-	void displayMsgPage(FILE *imapStream, msgCacheT *cachePtr, size_t pageNum);
+	int displayMsgPage(FILE *imapStream, msgCacheT *cachePtr, size_t pageNum);
+
+	/* Display the previews of the messages that contain all words of the query,
+	  the search is done locally, through the search index (check search.h) */
+	int displaySearch(msgCacheT *cachePtr, char *query);
+
+	/* Display the previews of the messages that have all flags in setFlags, and none in unsetFlags,
+	  found through the flag index (check flags.h) */
+	int displayFilter(msgCacheT *cachePtr, int setFlags, int unsetFlags);
+
+	/* Display the senders of the mailbox, ranked by rankBy (check senders.h), with their
+	  number of messages, unseen messages and total size, through the sender index */
+	int displaySenders(msgCacheT *cachePtr, int rankBy);
 #endif
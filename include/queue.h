@@ -0,0 +1,52 @@
+#include <stddef.h>
+#include <stdatomic.h>
+#ifndef QUEUE_GUARD
+
+	#define QUEUE_GUARD
+
+	/* A queue of pointers between two threads, one that only pushes (the producer), and one that only pops
+	  (the consumer), without locks: the items are kept in a ring, the consumer is the only one to move its
+	  head, and the producer the only one to move its tail, so each side only reads what the other wrote.
+	  Everything the producer wrote through a pointer before pushing it is seen by the consumer that pops it.
+	   Neither side ever blocks in a push or a pop, when there is nothing to pop (or no room to push) a side
+	  waits for the other through an eventfd. The producer wakes the consumer up after a batch of pushes
+	  (e.g. once what it read from the network has been parsed), instead of after each one, so a batch costs
+	  a single system call, and a single switch between the threads. The consumer wakes the producer up only
+	  when the queue stops being full. The eventfd the consumer waits on can be polled along with other
+	  descriptors (e.g. stdin) */
+
+	typedef struct spscQueue {
+		void **ring;
+		size_t mask; //The capacity minus one (the capacity is a power of two)
+		/* They only grow (wrapping around), tail - head is the number of items. Every access is sequentially
+		  consistent, as a producer that finds the queue full, and a consumer that pops at the same time,
+		  must agree on whether the producer has to be woken up */
+		atomic_size_t head, tail;
+		int itemFd, spaceFd; //Signalled by the producer after a batch, and when the queue stops being full
+	} spscQueueT;
+
+	//Make an empty queue that holds up to capacity items (rounded up to a power of two)
+	int queueInit(spscQueueT *queuePtr, size_t capacity);
+
+	//Push an item (by the producer), returns 0 if the queue is full
+	int queuePush(spscQueueT *queuePtr, void *item);
+
+	//Wake the consumer up (by the producer), after the items it pushed, before it waits for anything else
+	void queueSignal(spscQueueT *queuePtr);
+
+	//Pop the oldest item (by the consumer), returns NULL if the queue is empty
+	void *queuePop(spscQueueT *queuePtr);
+
+	/* Wait until the queue has an item (by the consumer), or until it has room for one (by the producer).
+	  They can return early, so they are called in a loop with queuePop() (or queuePush()) */
+	int queueWaitItem(spscQueueT *queuePtr);
+	int queueWaitSpace(spscQueueT *queuePtr);
+
+	/* The descriptor that becomes readable when the producer signals, to be polled by the consumer,
+	  which must call queueClearItemFd() before it pops what it has been woken up for */
+	int queueItemFd(spscQueueT *queuePtr);
+	void queueClearItemFd(spscQueueT *queuePtr);
+
+	//Free the ring (the items left in it are the caller's)
+	void freeQueue(spscQueueT *queuePtr);
+#endif
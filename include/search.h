@@ -0,0 +1,59 @@
+#ifndef SEARCH_GUARD
+
+	#define SEARCH_GUARD
+
+	/* Messages can be searched locally, without contacting the server, through an
+	  inverted index that maps every word (term) of the subjects, the From, To and CC
+	  addresses, and the texts fetched so far, to the list of messages containing it.
+	   Messages are identified by their UIDs and not their sequence numbers, as the
+	  UIDs do not change when messages are expunged (expunged messages are simply
+	  not found in the cache when the results are displayed).
+	   The message lists (posting lists) are compressed, as UIDs are mostly added in
+	  ascending order, only the difference from the previous UID is stored, as a
+	  variable length integer (7 bits per byte, the high bit set on all bytes but the last).
+	  UIDs added out of order (e.g. the text of an older message being fetched) are kept 
+	  uncompressed on the side, and merged in at query time.
+	   Indexing an envelope requires decoding it, which is otherwise left until the message is
+	  displayed (check decodeEnvelope() in untagged.h), so the envelopes are indexed in batches
+	  while the user is idle, once the mailbox has been fetched (check interactionLoop() in
+	  imap-client.c), and a search only indexes the few that arrived since then, if any.
+	  Texts are indexed when they are fetched, as they are already decoded. */
+
+	//A term, and the UIDs of the messages it appears in
+	struct term {
+		char *word; //NULL if the hash table slot is empty
+		unsigned char *postings; //Compressed ascending UIDs
+		size_t postingsLen, postingsCap;
+		unsigned long lastUid; //The last UID compressed into postings
+		unsigned long *unordered; //UIDs smaller than lastUid, added later
+		size_t unorderedLen;
+		//Set while the unordered UIDs are ascending, without duplicates (they are sorted by the first query after an add)
+		char unorderedSorted;
+	};
+
+	typedef struct searchIndex {
+		struct term *termTable; //A hash table (open addressing, linear probing)
+		size_t tableSize; //Always a power of two
+		size_t terms; //The number of used slots
+	} searchIndexT;
+
+	//Allocate an empty index, returns NULL on failure
+	searchIndexT *searchIndexInit(void);
+
+	//Add the words of the subject and addresses of a message to the index (the envelope must be decoded)
+	int indexEnvelope(searchIndexT *indexPtr, msgT *msgPtr);
+
+	/* Decode and index the envelopes of the messages of a cache that have not been indexed yet, at most
+	  batch of them, returns the number indexed (fewer than batch once they are all indexed), or an error */
+	int indexEnvelopes(msgCacheT *cachePtr, size_t batch);
+
+	//Add the words of a message's text to the index
+	int indexText(searchIndexT *indexPtr, msgT *msgPtr);
+
+	/* Find the messages that contain all words of the query, the UIDs are returned
+	  in ascending order, in a dynamically allocated array (NULL if no messages match) */
+	int searchIndexQuery(searchIndexT *indexPtr, char *query, unsigned long **uidsPtr, size_t *countPtr);
+
+	//Free the index, and the pointer itself
+	void freeSearchIndex(searchIndexT *indexPtr);
+#endif
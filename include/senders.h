@@ -0,0 +1,54 @@
+#ifndef SENDERS_GUARD
+
+	#define SENDERS_GUARD
+
+	/* The messages of a mailbox are grouped by sender (the address of the first From address),
+	  and for every sender the number of messages, their total size and the number of unseen ones
+	  are kept, along with the UIDs of the messages (in a bitmap, check bitmap.h). So the senders
+	  that fill a mailbox are ranked without walking the cache, and the messages of a sender are
+	  found without asking the server (e.g. to delete them all).
+	   A message is removed from its sender before its flags, size or envelope change, and added
+	  back after (check interpretFetch()), so each message adds exactly what it has to the counts.
+	  Senders are kept (with zero messages) until the index is freed, so that a message can leave
+	  its sender without the index, e.g. when it is freed. */
+
+	//The orders the senders can be ranked in
+	#define SENDERS_BY_COUNT 0
+	#define SENDERS_BY_SIZE 1
+	#define SENDERS_BY_UNSEEN 2
+
+	typedef struct sender {
+		char *address; //mailbox-name@host-name in lowercase, the key of the index
+		char *name; //The last personal name the sender used (interned, check intern.h), NULL if none
+		size_t msgs; //The number of messages
+		size_t unseen;
+		unsigned long long size; //The total size of the messages, in octets
+		bitmapT uids; //The UIDs of the messages
+	} senderT;
+
+	typedef struct senderIndex {
+		senderT **table; //A hash table (open addressing), by address
+		size_t tableSize; //A power of two
+		size_t senders;
+	} senderIndexT;
+
+	//Initialize a pointer to senderIndexT
+	senderIndexT *senderIndexInit(void);
+
+	/* Add a message to the counts of its sender, if it has a UID and a From address
+	  (if it is already counted, nothing happens) */
+	int senderAdd(senderIndexT *indexPtr, msgT *msgPtr);
+
+	//Remove a message from the counts of its sender (to be done before its data changes)
+	void senderRemove(msgT *msgPtr);
+
+	//Find a sender by address (in any case), returns NULL if no message has come from it
+	senderT *senderFind(senderIndexT *indexPtr, char *address);
+
+	/* Get the senders that have messages, ranked by rankBy (a SENDERS_BY_ value) in descending order,
+	  in a dynamically allocated array (NULL if there are none) */
+	int rankSenders(senderIndexT *indexPtr, int rankBy, senderT ***sendersPtr, size_t *countPtr);
+
+	//Free the contents of the index, and the pointer itself
+	void freeSenderIndex(senderIndexT *indexPtr);
+#endif
@@ -0,0 +1,51 @@
+#ifndef SORT_GUARD
+
+	#define SORT_GUARD
+
+	/* Besides the sequence number order of the cache, the messages can be viewed
+	  sorted by date, size, sender or subject. Each order is backed by a sort view,
+	  an array of cache positions kept sorted by the key (ties are broken by the
+	  position itself, so that every message has exactly one place in a view).
+	   A view is built (sorted) the first time its order is selected, and from then
+	  on it is maintained incrementally: a message is inserted by binary search when
+	  its data is fetched, and removed when it is expunged, so the mailbox is never
+	  sorted again as a whole. Descending order is the same view, read backwards.
+	   An expunge shifts the positions after it down by one, which would take going through
+	  every view, so expunges are only noted, and the views are renumbered (and the expunged
+	  messages dropped from them) in a single pass, the next time they are used, so a burst
+	  of expunges (e.g. after the EXPUNGE command) costs one pass, and not one per message. */
+
+	#define ASCENDING 0
+	#define DESCENDING 1
+
+	struct sortView {
+		size_t *posArray; //Cache positions, sorted by the key of the view
+		size_t len; //The number of positions in the view
+		size_t cap; //The number of positions that fit in posArray
+	};
+	typedef struct sortView sortViewT;
+
+	/* Select the order messages are displayed in (SORT_NONE is the sequence number order),
+	  building the view if needed. */
+	int selectSortOrder(msgCacheT *cachePtr, int sortKey, int sortOrder);
+
+	//Insert the message at cache position pos into every built view
+	int viewInsert(msgCacheT *cachePtr, size_t pos);
+
+	//Remove the message at cache position pos from every built view (to be done before its data changes)
+	void viewRemove(msgCacheT *cachePtr, size_t pos);
+
+	/* Note that the message at cache position pos is expunged (before the cache shifts the positions
+	  after it down by one), it is removed from every built view, and the positions after it shifted,
+	  the next time the views are used */
+	void viewExpunge(msgCacheT *cachePtr, size_t pos);
+
+	//Free all views, after which they are rebuilt when needed (e.g. when another mailbox is selected)
+	void freeViews(msgCacheT *cachePtr);
+
+	//The number of messages in the current order
+	size_t viewLength(msgCacheT *cachePtr);
+
+	//The cache position of the message at the given index of the current order
+	size_t viewMsgPos(msgCacheT *cachePtr, size_t index);
+#endif
@@ -0,0 +1,34 @@
+#ifndef TLS_GUARD
+
+	#define TLS_GUARD
+
+	/* TLS (through OpenSSL) as a layer of the stream the parser reads (check transport.h), so nothing above
+	  it changes. SSL_read() decrypts a record straight into the buffer the parser reads from, and OpenSSL
+	  reads ahead, taking in as many records as a single read() of the layer below returns.
+	   TLS 1.2 is the minimum, and 1.3 is preferred. The certificate of the server is verified against the
+	  CAs of the system (or the ones in SSL_CERT_FILE or SSL_CERT_DIR, e.g. for a self-signed certificate),
+	  and against the hostname.
+	   The sessions the server issues (TLS 1.3 tickets) are saved to a file per host and port (in
+	  $XDG_CACHE_HOME/TLS_SESSION_DIR, or ~/.cache/TLS_SESSION_DIR), and the next connection to the server,
+	  in this run or the next, resumes the last one, which leaves out the certificates and their verification.
+	   Without OpenSSL (built with NO_TLS=1), tlsOpen() returns TLS_ERROR */
+
+	#define TLS_RECORD_SIZE 16384 //The largest plaintext a TLS record carries
+	#define TLS_SESSION_DIR "imap-client"
+
+	//How the TLS session was set up
+	typedef struct tlsStats {
+		double handshakeMs;
+		int resumed; //Set if a saved session was resumed
+		char version[16]; //e.g. TLSv1.3
+		char cipher[64]; //e.g. TLS_AES_256_GCM_SHA384
+	} tlsStatsT;
+
+	/* Start TLS on a stream opened with openTransportStream(), and push it as a layer of the stream, which
+	  sends a close_notify when the stream is closed. Returns TLS_ERROR if the handshake fails (the reason is
+	  printed), in which case the stream is left as it was (but unusable), statsPtr can be NULL */
+	int tlsOpen(FILE *imapStream, char *hostname, char *port, tlsStatsT *statsPtr);
+
+	//Free the settings shared by all TLS connections
+	void freeTlsContext(void);
+#endif
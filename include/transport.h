@@ -0,0 +1,84 @@
+#include <sys/types.h>
+#include <sys/uio.h>
+#ifndef TRANSPORT_GUARD
+
+	#define TRANSPORT_GUARD
+
+	/* The parser reads from, and the commands are written to, a stdio stream (FILE *), but the stream is made
+	  with fopencookie(), and its buffer is filled and emptied through a stack of transport layers: the socket
+	  at the bottom, and above it the layers the connection is upgraded with (TLS, check tls.h), each of which
+	  reads from, and writes to, the one below it. A layer is pushed onto the stream of an open connection
+	  (e.g. after STARTTLS), so the stream the rest of the client holds never changes.
+	   The stream buffer is TRANSPORT_BUFFER_SIZE bytes, so a large response takes a read() per
+	  TRANSPORT_BUFFER_SIZE bytes (instead of one per 4 KB, the buffer stdio gives a socket), and all the
+	  commands written before a fflush() leave in a single write */
+
+	#define TRANSPORT_BUFFER_SIZE 65536
+	#define TRANSPORT_NAME_SIZE 16
+
+	//What pushTransport() does with what the stream read ahead
+	#define TRANSPORT_DROP_READ_AHEAD 0
+	#define TRANSPORT_KEEP_READ_AHEAD 1
+
+	typedef struct transport {
+		/* Read up to size bytes into buf, returns the number read, 0 at the end of the connection,
+		  or -1 on an error */
+		ssize_t (*read)(struct transport *layerPtr, char *buf, size_t size);
+		//Write all of the iovCount buffers, returns the number of bytes written, or -1 on an error
+		ssize_t (*writev)(struct transport *layerPtr, const struct iovec *iov, int iovCount);
+		//Free the state of the layer (not the layers below it), the socket layer closes the socket
+		void (*close)(struct transport *layerPtr);
+		//Print what the layer counts itself (e.g. the compression ratio), NULL if nothing
+		void (*printStats)(struct transport *layerPtr);
+		void *state; //Of the backend
+		struct transport *below; //NULL for the socket
+		int fd; //The socket at the bottom of the stack, that can be polled for readiness
+		char name[TRANSPORT_NAME_SIZE]; //e.g. tcp, tls
+		size_t bytesRead, bytesWritten; //Through this layer (after it decoded, and before it encoded them)
+		size_t reads, writes; //The number of calls to the layer
+		/* What the stream had read from the layer, and not consumed, when a layer was pushed above it (check
+		  pushTransport()), it is read again (by the layer above) before the layer is, NULL if there is none */
+		char *readAhead;
+		size_t readAheadLen, readAheadPos;
+	} transportT;
+
+	/* Make a layer with the given functions (check above), the rest of the fields are set when
+	  it is pushed onto a stream, returns NULL if there is no memory */
+	transportT *newTransport(char *name, ssize_t (*read)(transportT *, char *, size_t), ssize_t (*writev)(transportT *, const struct iovec *, int), void (*close)(transportT *), void *state);
+
+	//Read from, and write to, a layer, through its functions, a layer reaches the one below it through these
+	ssize_t transportRead(transportT *layerPtr, char *buf, size_t size);
+	ssize_t transportWritev(transportT *layerPtr, const struct iovec *iov, int iovCount);
+
+	/* Open a connected stream socket as a stream, with the socket as its only layer, e.g. a TCP
+	  connection, or an end of a socketpair(). Returns NULL on an error, in which case the socket
+	  is left open. Closing the stream closes every layer, and the socket */
+	FILE *openTransportStream(int sockFd);
+
+	/* Push a layer onto the stream, all reads and writes go through it from then on. Anything the stream
+	  has written is sent first. What it has read ahead is either dropped (TRANSPORT_DROP_READ_AHEAD), as it
+	  was not meant for the new layer (e.g. data after the OK of a STARTTLS, which was not protected, RFC 7457,
+	  2.2), or kept (TRANSPORT_KEEP_READ_AHEAD) for the new layer to read first, as it was meant for it (e.g.
+	  what the server compressed right after the OK of a COMPRESS). Returns COMMAND_ERROR if the stream was
+	  not opened with openTransportStream(), MEM_ERROR, or SOCKET_ERROR if its output could not be sent */
+	int pushTransport(FILE *imapStream, transportT *layerPtr, int readAhead);
+
+	/* Replace every layer of the stream with a new connected socket (e.g. after the last connection was lost),
+	  anything the stream held, to read or to write, is dropped. The stream is used as before, so whoever holds
+	  it does not have to know. Returns COMMAND_ERROR if the stream was not opened with openTransportStream() */
+	int resetTransport(FILE *imapStream, int sockFd);
+
+	/* Call hook(arg) whenever the stream has to read from its top layer, i.e. when what it read ahead has all
+	  been consumed, so the read may wait for the network (e.g. to hand over what was parsed before it does).
+	  A NULL hook removes it, returns COMMAND_ERROR if the stream was not opened with openTransportStream() */
+	int setTransportReadHook(FILE *imapStream, void (*hook)(void *), void *arg);
+
+	//The top layer of the stream, NULL if it was not opened with openTransportStream()
+	transportT *streamTransport(FILE *imapStream);
+
+	//The socket of the stream, -1 if it was not opened with openTransportStream()
+	int transportFd(FILE *imapStream);
+
+	//Print the layers of the stream, and the bytes and calls through each one
+	void printTransportStats(FILE *imapStream);
+#endif
@@ -16,4 +16,32 @@
 	/* Interprets an untagged response, and does something depending 
          on the response and context. */
 	int interpretUntagged(FILE *imapStream, msgCacheT *cachePtr, int context);
+
+	/* Apply the list of a FETCH response (e.g. parsed by the network thread, check background.h) to the
+	  message with sequence number msgNum, the list is freed */
+	struct imapObject;
+	int applyFetch(msgCacheT *cachePtr, size_t msgNum, struct imapObject *fetchList);
+
+	/* Decode the fields of an envelope (the subject and the names of the addresses), in place,
+	  unless they have already been. Decoding is left until a message is displayed, sorted by
+	  sender or subject, or searched, as most messages of a large mailbox never are */
+	int decodeEnvelope(struct envelope *envPtr);
+
+	/* Interpret the response code (if any) and the text that follow an OK, e.g. [UIDVALIDITY 3857529045],
+	  up to the end of the line. cachePtr can be NULL when no mailbox is selected (e.g. in the greeting) */
+	int interpretRespCode(FILE *imapStream, msgCacheT *cachePtr);
+
+	/* The capabilities of the server (from the [CAPABILITY ...] code of the greeting, or of a login,
+	  or from a CAPABILITY response) that are used */
+	#define CAP_SASL_IR 1 //AUTHENTICATE can carry the credentials, without waiting for a continuation (RFC 4959)
+	#define CAP_AUTH_PLAIN 2 //The PLAIN SASL mechanism (RFC 4616)
+	#define CAP_LOGINDISABLED 4 //LOGIN is refused
+	#define CAP_STARTTLS 8 //The connection can be upgraded to TLS
+	#define CAP_COMPRESS_DEFLATE 16 //The connection can be compressed (RFC 4978)
+
+	//Check whether the server advertised a capability (a CAP_ value)
+	int hasCapability(int cap);
+
+	//Set the tree the mailboxes in LIST responses are added to (check mailbox.h), NULL to ignore them
+	void setListTree(struct folderTree *treePtr);
 #endif
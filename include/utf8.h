@@ -2,22 +2,43 @@
 
 	#define UTF8_GUARD
 	
-	/* Decodes a Base 64 encoded string to UTF-8 charset only, so
-	 the Quoted-Printable encoding and other charsets are not
-	 supported. */
+	/* Decodes the MIME encoded-words (RFC 2047) of a string to UTF-8, both the Base 64 (B)
+	 and the Quoted-Printable (Q) encodings are supported, and the charsets check charset.h
+	 supports. */
 
 	/* Also, your terminal might not support UTF-8, in that case,
 	 some very bad things might happen. */
 
-	//Creates a heap-allocated string of decoded Base 64 bytes, returns NULL on failure
+	/* Creates a heap-allocated string of decoded Base 64 bytes, returns NULL on failure.
+	  The string is decoded in a single pass, into a buffer allocated once */
 	char *decodeUtf8Str(char *string);
 	
-	//Prints the first <chars> characters of a string (the characters can be UTF-8)
-	void printNChars(char *str, int chars);
+	/* Returns the length of the longest prefix of str that is valid UTF-8, and has no control
+	  characters (line breaks and tabs are allowed if keepLines is set). Blocks of 16 bytes are
+	  checked at once with SSSE3 */
+	size_t utf8CleanPrefix(char *str, size_t len, int keepLines);
 
-	//
-	int decodedCopyFromObject(char **decodedPtr, imapObjectHandleT imapHandle);
-	
-	//Returns the length of a UTF-8 string
-	int utf8StrLen(char *utf8Str);
+	/* Replace the malformed bytes and control characters of a string with U+FFFD (line breaks and
+	  tabs become spaces, unless keepLines is set), the string is only copied if it has any */
+	int utf8Sanitize(char **strPtr, int keepLines);
+
+	//Returns the length of the valid UTF-8 character at the start of str, 0 if it is malformed
+	size_t utf8CharLen(char *str, size_t len);
+
+	//Decode the character at the start of str, returns its length (a malformed byte is decoded as U+FFFD)
+	size_t utf8Decode(char *str, size_t len, unsigned int *codePointPtr);
+
+	//Encode a code point as UTF-8 into dest (which must have room for 4 bytes), returns the length
+	size_t utf8Encode(unsigned int codePoint, char *dest);
+
+	//Returns the number of terminal columns a (sanitized) string takes (check width.h)
+	int utf8Width(char *str);
+
+	/* Returns the length of the longest prefix of a string that fits in the given number of
+	  columns, and stores the columns it takes in widthPtr */
+	size_t columnsPrefix(char *str, int columns, int *widthPtr);
+
+	/* Decode the encoded-words of a header field that is displayed, and sanitize it, in place
+	  (the string is replaced if it changes, NULL is left as it is) */
+	int decodeHeaderField(char **strPtr);
 #endif
@@ -1,3 +1,4 @@
+#include <time.h>
 #ifndef UTILS_GUARD
 
 	#define UTILS_GUARD
@@ -6,4 +7,9 @@
 	int isNumber(char *str); //Detect whether str consists of digit characters only
 	void strUpper(char *str); //Convert str to uppercase
 	void generateTag(char tag[TAG_SIZE]); //Generate a tag to use with IMAP commands
+	int hexDigitValue(char digit); //The value of a hexadecimal digit, -1 if it is not one
+	size_t hashString(char *str); //Hash a string, for hash tables
+	//Make a dynamically allocated IMAP quoted string out of str (which must not contain CR or LF)
+	int quoteString(char *str, char **quotedPtr);
+	double elapsedMs(struct timespec *startPtr); //The milliseconds since startPtr (taken with CLOCK_MONOTONIC)
 #endif
@@ -0,0 +1,11 @@
+#ifndef WIDTH_GUARD
+
+	#define WIDTH_GUARD
+
+	/* The number of terminal columns a character takes (like wcwidth(), but independent of the
+	  locale): combining marks and format characters take none, East Asian wide and fullwidth
+	  characters (CJK, most emoji) take two, and the rest take one. The tables are generated from
+	  the Unicode Character Database (version 14.0) */
+
+	int charWidth(unsigned int codePoint);
+#endif
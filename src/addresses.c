@@ -1,131 +1,187 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include "parsing.h"
 #include "utf8.h"
 #include "addresses.h"
+#include "intern.h"
+#include "outbuf.h"
 #include "error.h"
 
-addressNodeT addrListInit(void) {
-	return(NULL);
+void releaseAddress(addressT *addrPtr) {
+	releaseString(addrPtr->personalName);
+	releaseString(addrPtr->mailboxName);
+	releaseString(addrPtr->hostName);
 }
 
-//Add a new address node to an address list
-int addrListAdd(addressNodeT *headPtr, char *personalName, char *mailboxName, char *hostName) {
-	struct addressNode *new;
-
-	new = malloc(sizeof(struct addressNode));
-	if (!new) {
-		return(MEM_ERROR);
+void freeAddressList(addressListT *listPtr) {
+	for (int k = 0 ; k < listPtr->count ; k++) {
+		releaseAddress(&listPtr->addrs[k]);
 	}
-	new->personalName = personalName;
-	new->mailboxName = mailboxName;
-	new->hostName = hostName;
-	new->next = *headPtr;
-
-	*headPtr = new;
-
-	return(SUCCESS);
+	free(listPtr->addrs);
+	listPtr->addrs = NULL;
+	listPtr->count = 0;
 }
 
-void freeAddressList(addressNodeT head) {
-	addressNodeT curr, next;
-
-	for (curr = head ; curr != NULL ; curr = next) {
-		next = curr->next;
-		free(curr->personalName);
-		free(curr->mailboxName);
-		free(curr->hostName);
-		free(curr);
+//Intern the string of a STRING object, or get NULL from a NIL one
+int internFromObject(char **strPtr, imapObjectHandleT strHandle) {
+	if (strHandle->tag == NIL) {
+		*strPtr = NULL;
+		return(SUCCESS);
+	}
+	else if (strHandle->tag != STRING) {
+		return(PARSE_ERROR);
 	}
+
+	return(internString(strHandle->content.string, strPtr));
 }
 
-int parseAddress(imapObjectHandleT addressHandle, char **personalNamePtr, char **mailboxNamePtr, char **hostNamePtr) {
+int parseAddress(imapObjectHandleT addressHandle, addressT *addrPtr) {
 	imapObjectHandleT *elemArray = addressHandle->content.list.elemArray;
-	char *personalName, *mailboxName, *hostName;
+	addressT addr = {NULL, NULL, NULL};
 	int retVal;
 
-	if (addressHandle->content.list.elems != 4) {
+	if (addressHandle->tag != LIST || addressHandle->content.list.elems != 4) {
 		//Server didn't follow the protocol, which specifies 4 fields for addresses, not my fault
 		return(PARSE_ERROR);
 	}
 
-	//Get personal name from the first handle of elemArray, after decoding it (for more, check utf8.h)
-	retVal = decodedCopyFromObject(&personalName, elemArray[0]);
-	if (isError(retVal)) {
-		return(retVal);
-	}
+	/* Get personal name from the first handle of elemArray, it is stored as it is, and only decoded
+	  when the envelope is (check decodeAddressList()) */
+	retVal = internFromObject(&addr.personalName, elemArray[0]);
 
 	//Skip the second field (source-route, only relevant to SMTP)
 
-	//Get mailbox name from third field
-	retVal = decodedCopyFromObject(&mailboxName, elemArray[2]);
-	if (isError(retVal)) {
-		free(personalName);
-		return(retVal);
+	//Get mailbox name from third field, and host name from the fourth
+	if (!isError(retVal)) {
+		retVal = internFromObject(&addr.mailboxName, elemArray[2]);
+	}
+	if (!isError(retVal)) {
+		retVal = internFromObject(&addr.hostName, elemArray[3]);
 	}
-
-	//Get host name from fourth field
-	retVal = decodedCopyFromObject(&hostName, elemArray[3]); 
 	if (isError(retVal)) {
-		free(personalName);
-		free(mailboxName);
+		releaseAddress(&addr);
 		return(retVal);
 	}
 
-	//Output via pointers
-	*personalNamePtr = personalName;
-	*mailboxNamePtr = mailboxName;
-	*hostNamePtr = hostName;
+	*addrPtr = addr;
 
 	return(SUCCESS);
 }
 
-int getAddressList(addressNodeT *headPtr, imapObjectHandleT addrListHandle) {
-	char *hostName, *personalName, *mailboxName;
-	imapObjectHandleT *elemArray = addrListHandle->content.list.elemArray;
-	int elems = addrListHandle->content.list.elems;
-	addressNodeT addrList = NULL;
+int getAddressList(addressListT *listPtr, imapObjectHandleT addrListHandle) {
+	addressListT addrList = {NULL, 0};
 	int retVal;
 
 	if (addrListHandle->tag == NIL) {
-		*headPtr = NULL;
+		*listPtr = addrList;
 		return(SUCCESS); //Empty list represented by handle to a NIL object, not an error
 	}
+	else if (addrListHandle->tag != LIST) {
+		return(PARSE_ERROR);
+	}
 
-	//Iterate over the handle list (the elements are the addresses), in order to add the addresses to the list
-	for (int k = 0 ; k < elems ; k++) {
-		retVal = parseAddress(elemArray[k], &personalName, &mailboxName, &hostName);
+	//A single allocation for the whole list, as the number of addresses is known
+	addrList.addrs = malloc(addrListHandle->content.list.elems * sizeof(addressT));
+	if (!addrList.addrs && addrListHandle->content.list.elems > 0) {
+		return(MEM_ERROR);
+	}
+
+	//The elements of the handle list are the addresses, they are kept in the same order
+	for (int k = 0 ; k < addrListHandle->content.list.elems ; k++) {
+		retVal = parseAddress(addrListHandle->content.list.elemArray[k], &addrList.addrs[k]);
 		if (isError(retVal)) {
-			freeAddressList(addrList);
+			freeAddressList(&addrList);
 			return(retVal);
 		}
+		addrList.count++;
+	}
 
-		if (isError(addrListAdd(&addrList, personalName, mailboxName, hostName))) {
-			freeAddressList(addrList);
-			free(hostName);
-			free(personalName);
-			free(mailboxName);
-			return(MEM_ERROR);
+	*listPtr = addrList;
+
+	return(SUCCESS);
+}
+
+//Whether decodeHeaderField() would change a string (encoded-words, or bytes that are not printable ASCII)
+int needsDecoding(char *str) {
+	for (unsigned char *curr = (unsigned char *)str ; *curr != '\0' ; curr++) {
+		if (*curr < ' ' || *curr >= 0x7f || (*curr == '=' && curr[1] == '?')) {
+			return(1);
 		}
 	}
 
-	*headPtr = addrList;
+	return(0);
+}
+
+//Replace an interned string with its decoded form, interned too
+int decodeInterned(char **strPtr) {
+	char *decoded, *interned;
+	int retVal;
+
+	if (!*strPtr || !needsDecoding(*strPtr)) {
+		return(SUCCESS);
+	}
+
+	decoded = strdup(*strPtr);
+	if (!decoded) {
+		return(MEM_ERROR);
+	}
+	retVal = decodeHeaderField(&decoded);
+	if (!isError(retVal)) {
+		retVal = internString(decoded, &interned);
+	}
+	free(decoded);
+	if (isError(retVal)) {
+		return(retVal);
+	}
+	releaseString(*strPtr);
+	*strPtr = interned;
+
+	return(SUCCESS);
+}
+
+int decodeAddressList(addressListT *listPtr) {
+	int retVal;
+
+	for (int k = 0 ; k < listPtr->count ; k++) {
+		if (isError(retVal = decodeInterned(&listPtr->addrs[k].personalName))) {
+			return(retVal);
+		}
+		if (isError(retVal = decodeInterned(&listPtr->addrs[k].mailboxName))) {
+			return(retVal);
+		}
+		if (isError(retVal = decodeInterned(&listPtr->addrs[k].hostName))) {
+			return(retVal);
+		}
+	}
 
 	return(SUCCESS);
 }
 
-void printAddressList(addressNodeT head) {
-	addressNodeT curr;
+char *senderName(addressListT *fromListPtr) {
+	if (fromListPtr->count == 0) {
+		return(NULL);
+	}
+	else if (fromListPtr->addrs[0].personalName != NULL) {
+		return(fromListPtr->addrs[0].personalName);
+	}
 
-	for (curr = head ; curr != NULL ; curr = curr->next) {
-		if (curr->personalName != NULL) {
-			printf("%s <%s@%s>", curr->personalName, curr->mailboxName, curr->hostName);
+	return(fromListPtr->addrs[0].mailboxName);
+}
+
+void renderAddressList(outBufT *outPtr, addressListT *listPtr) {
+	addressT *addrPtr;
+
+	for (int k = 0 ; k < listPtr->count ; k++) {
+		addrPtr = &listPtr->addrs[k];
+		if (addrPtr->personalName != NULL) {
+			outPrintf(outPtr, "%s <%s@%s>", addrPtr->personalName, addrPtr->mailboxName ? addrPtr->mailboxName : "", addrPtr->hostName ? addrPtr->hostName : "");
 		}
 		else {
-			printf("<%s@%s>", curr->mailboxName, curr->hostName);
+			outPrintf(outPtr, "<%s@%s>", addrPtr->mailboxName ? addrPtr->mailboxName : "", addrPtr->hostName ? addrPtr->hostName : "");
 		}
-		if (curr->next != NULL) {
-			printf(", ");
+		if (k+1 < listPtr->count) {
+			outStr(outPtr, ", ");
 		}
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,478 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include "error.h"
+#include "utils.h"
+#include "parsing.h"
+#include "addresses.h"
+#include "cache.h"
+#include "untagged.h"
+#include "transport.h"
+#include "queue.h"
+#include "background.h"
+
+#define COMMAND_QUEUE_SIZE 64
+
+//What a tagged response was, as readResponse() in commands.c returns it
+#define RESPONSE_NO 2
+#define RESPONSE_BAD 3
+
+enum itemType {FETCH_ITEM, UNTAGGED_ITEM, COMPLETED_ITEM};
+
+/* What goes through the queues: a command goes to the network thread, and comes back as COMPLETED_ITEM
+  once its tagged response was read (so that its completion is never lost for lack of memory), behind
+  the responses to it, which are FETCH_ITEMs, or copies of any other untagged response */
+typedef struct backgroundItem {
+	enum itemType type;
+	msgCacheT *cachePtr; //The cache the responses are applied to, only used by the main thread
+	char tag[TAG_SIZE];
+	char *command; //NULL to stop the network thread
+	size_t msgNum;
+	imapObjectHandleT fetchList;
+	char *text; //An untagged response as it was read, or what followed the status of a tagged one
+	size_t textLen;
+	int result; //SUCCESS, RESPONSE_NO, RESPONSE_BAD, or the error that stopped the command
+	struct backgroundItem *next; //The next command sent in the same write
+} backgroundItemT;
+
+FILE *backgroundStream;
+spscQueueT commandQueue, responseQueue;
+pthread_t networkThread;
+int backgroundStarted = 0;
+
+//Only used by the main thread
+size_t backgroundPending = 0; //The commands queued, and not completed
+int backgroundError = SUCCESS; //The first error, returned once the rest of the commands are completed
+
+backgroundItemT stopItem; //Its command is NULL
+
+//Set if the network thread pushed responses the main thread was not woken up for, only used by the network thread
+int unsignalled = 0;
+
+//Called before the stream reads from the network (check setTransportReadHook() in transport.h)
+void signalResponses(void *arg) {
+	/* The main thread reads from the stream too, when the network thread is idle, which may be while the
+	  network thread is still in pushResponse(), so the thread is checked before unsignalled is touched */
+	if (pthread_equal(pthread_self(), networkThread) && unsignalled) {
+		queueSignal(&responseQueue);
+		unsignalled = 0;
+	}
+}
+
+/* Items are pushed by the network thread, which waits while the main thread is behind. The main thread
+  is woken up for a command that was completed, and else once everything that was read has been parsed
+  (check signalResponses()), as waking it up for every message would take longer than parsing it */
+void pushResponse(backgroundItemT *itemPtr) {
+	enum itemType type = itemPtr->type; //Once pushed, the item is the main thread's, which may free it
+
+	while (!queuePush(&responseQueue, itemPtr)) {
+		queueSignal(&responseQueue);
+		queueWaitSpace(&responseQueue);
+	}
+	unsignalled = 1;
+	if (type == COMPLETED_ITEM) {
+		signalResponses(NULL);
+	}
+}
+
+/* Copy the rest of a response line (with the literals in it, a line that ends with {size} goes on after
+  size octets), after prefix, so that it can be parsed again from memory (e.g. through fmemopen()) */
+int copyResponse(FILE *imapStream, char *prefix, char **textPtr, size_t *lenPtr) {
+	FILE *copyStream;
+	char chunk[4096];
+	size_t litSize, len, k;
+	int c, retVal = SOCKET_ERROR;
+
+	copyStream = open_memstream(textPtr, lenPtr);
+	if (!copyStream) {
+		return(MEM_ERROR);
+	}
+	fputs(prefix, copyStream);
+
+	while ((c = fgetc(imapStream)) != EOF) {
+		fputc(c, copyStream);
+		if (c != '\n') {
+			continue;
+		}
+
+		fflush(copyStream); //For *textPtr and *lenPtr to be up to date
+		len = *lenPtr;
+		if (len < 4 || (*textPtr)[len-2] != '\r' || (*textPtr)[len-3] != '}') {
+			retVal = SUCCESS;
+			break;
+		}
+		for (k = len-4 ; k > 0 && (*textPtr)[k] >= '0' && (*textPtr)[k] <= '9' ; k--);
+		if ((*textPtr)[k] != '{') {
+			retVal = SUCCESS;
+			break;
+		}
+		for (litSize = strtoul(*textPtr + k+1, NULL, 10) ; litSize > 0 ; litSize -= len) {
+			len = litSize < sizeof(chunk) ? litSize : sizeof(chunk);
+			if (fread(chunk, 1, len, imapStream) != len) {
+				break;
+			}
+			fwrite(chunk, 1, len, copyStream);
+		}
+		if (litSize > 0) {
+			break;
+		}
+	}
+
+	if (fclose(copyStream) == EOF && !isError(retVal)) {
+		retVal = MEM_ERROR;
+	}
+	if (isError(retVal)) {
+		free(*textPtr);
+		*textPtr = NULL;
+	}
+
+	return(retVal);
+}
+
+/* Read an untagged response (whose "*" was read), a FETCH response is parsed, and anything else
+  is copied, to be interpreted by the main thread (check interpretUntagged() in untagged.h) */
+int readUntagged(FILE *imapStream, backgroundItemT *cmdPtr) {
+	imapObjectHandleT wordHandle, keyHandle = NULL, fetchList;
+	backgroundItemT *itemPtr;
+	char prefix[128];
+	int retVal;
+
+	if (isError(retVal = skipSpace(imapStream)) || isError(retVal = getStringObject(&wordHandle, imapStream))) {
+		return(retVal);
+	}
+	if (isNumber(wordHandle->content.string)) {
+		if (isError(retVal = skipSpace(imapStream)) || isError(retVal = getStringObject(&keyHandle, imapStream))) {
+			freeImapObject(wordHandle);
+			return(retVal);
+		}
+	}
+
+	itemPtr = calloc(1, sizeof(backgroundItemT));
+	if (!itemPtr) {
+		freeImapObject(wordHandle);
+		if (keyHandle != NULL) {
+			freeImapObject(keyHandle);
+		}
+		return(MEM_ERROR);
+	}
+	itemPtr->cachePtr = cmdPtr->cachePtr;
+
+	if (keyHandle != NULL && !strcasecmp(keyHandle->content.string, "FETCH")) {
+		itemPtr->type = FETCH_ITEM;
+		itemPtr->msgNum = strtoul(wordHandle->content.string, NULL, 10);
+		if (isError(retVal = skipSpace(imapStream)) || isError(retVal = getListObject(&fetchList, imapStream))) {
+			free(itemPtr);
+		}
+		else if (isError(retVal = skipLine(imapStream))) {
+			freeImapObject(fetchList);
+			free(itemPtr);
+		}
+		else {
+			itemPtr->fetchList = fetchList;
+		}
+	}
+	else {
+		itemPtr->type = UNTAGGED_ITEM;
+		snprintf(prefix, sizeof(prefix), "* %s%s%s", wordHandle->content.string, keyHandle ? " " : "", keyHandle ? keyHandle->content.string : "");
+		if (isError(retVal = copyResponse(imapStream, prefix, &itemPtr->text, &itemPtr->textLen))) {
+			free(itemPtr);
+		}
+	}
+	freeImapObject(wordHandle);
+	if (keyHandle != NULL) {
+		freeImapObject(keyHandle);
+	}
+
+	if (!isError(retVal)) {
+		pushResponse(itemPtr);
+	}
+
+	return(retVal);
+}
+
+//Read the responses to a command, up to its tagged response, as readResponse() in commands.c does
+int readBackgroundResponse(FILE *imapStream, backgroundItemT *cmdPtr) {
+	imapObjectHandleT tagHandle, statusHandle;
+	int retVal, tagged, status;
+
+	do {
+		if (isError(retVal = getStringObject(&tagHandle, imapStream))) {
+			return(retVal);
+		}
+		tagged = !strcmp(tagHandle->content.string, cmdPtr->tag);
+		freeImapObject(tagHandle);
+		if (!tagged && isError(retVal = readUntagged(imapStream, cmdPtr))) {
+			return(retVal);
+		}
+	} while (!tagged);
+
+	if (isError(retVal = skipSpace(imapStream)) || isError(retVal = getStringObject(&statusHandle, imapStream))) {
+		return(retVal);
+	}
+	if (!strcasecmp(statusHandle->content.string, "OK")) {
+		status = SUCCESS;
+	}
+	else {
+		status = !strcasecmp(statusHandle->content.string, "NO") ? RESPONSE_NO : RESPONSE_BAD;
+	}
+	freeImapObject(statusHandle);
+
+	//The rest is a response code (interpreted by the main thread), or the text of a NO or a BAD (printed by it)
+	if (isError(retVal = copyResponse(imapStream, "", &cmdPtr->text, &cmdPtr->textLen))) {
+		return(retVal);
+	}
+
+	return(status);
+}
+
+void *networkMain(void *arg) {
+	backgroundItemT *first, **lastPtr, *cmdPtr, *next;
+	int retVal, stop = 0;
+
+	while (!stop) {
+		//Wait for a command, and take the ones queued behind it too, to send them in the same write
+		first = NULL;
+		lastPtr = &first;
+		retVal = SUCCESS;
+		while ((cmdPtr = queuePop(&commandQueue)) != NULL || !first) {
+			if (!cmdPtr) {
+				queueWaitItem(&commandQueue);
+				continue;
+			}
+			else if (!cmdPtr->command) {
+				stop = 1;
+				break;
+			}
+			cmdPtr->next = NULL;
+			*lastPtr = cmdPtr;
+			lastPtr = &cmdPtr->next;
+			if (!isError(retVal) && fprintf(backgroundStream, "%s %s\r\n", cmdPtr->tag, cmdPtr->command) < 0) {
+				retVal = SOCKET_ERROR;
+			}
+		}
+		if (!isError(retVal) && first != NULL && fflush(backgroundStream) == EOF) {
+			retVal = SOCKET_ERROR;
+		}
+
+		//Once a command fails, so do the ones after it, as the stream is not where their responses start
+		for (cmdPtr = first ; cmdPtr != NULL ; cmdPtr = next) {
+			next = cmdPtr->next;
+			if (!isError(retVal)) {
+				retVal = readBackgroundResponse(backgroundStream, cmdPtr);
+			}
+			cmdPtr->type = COMPLETED_ITEM;
+			cmdPtr->result = retVal;
+			if (!isError(retVal)) {
+				retVal = SUCCESS;
+			}
+			pushResponse(cmdPtr);
+		}
+	}
+
+	return(NULL);
+}
+
+int startBackground(FILE *imapStream) {
+	int retVal;
+
+	backgroundStream = imapStream;
+	if (isError(retVal = queueInit(&commandQueue, COMMAND_QUEUE_SIZE))) {
+		return(retVal);
+	}
+	if (isError(retVal = queueInit(&responseQueue, BACKGROUND_QUEUE_SIZE))) {
+		freeQueue(&commandQueue);
+		return(retVal);
+	}
+	if (pthread_create(&networkThread, NULL, networkMain, NULL) != 0) {
+		freeQueue(&commandQueue);
+		freeQueue(&responseQueue);
+		return(SYSCALL_ERROR);
+	}
+	setTransportReadHook(imapStream, signalResponses, NULL);
+	backgroundStarted = 1;
+
+	return(SUCCESS);
+}
+
+void freeItem(backgroundItemT *itemPtr) {
+	if (itemPtr->fetchList != NULL) {
+		freeImapObject(itemPtr->fetchList);
+	}
+	free(itemPtr->text);
+	free(itemPtr->command);
+	free(itemPtr);
+}
+
+void stopBackground(void) {
+	backgroundItemT *itemPtr;
+
+	if (!backgroundStarted) {
+		return;
+	}
+	if (backgroundPending > 0) {
+		shutdown(transportFd(backgroundStream), SHUT_RDWR);
+	}
+	while (backgroundPending > 0) {
+		if (!(itemPtr = queuePop(&responseQueue))) {
+			queueWaitItem(&responseQueue);
+			continue;
+		}
+		backgroundPending -= itemPtr->type == COMPLETED_ITEM;
+		freeItem(itemPtr);
+	}
+
+	while (!queuePush(&commandQueue, &stopItem)) {
+		queueWaitSpace(&commandQueue);
+	}
+	queueSignal(&commandQueue);
+	pthread_join(networkThread, NULL);
+	setTransportReadHook(backgroundStream, NULL, NULL);
+	freeQueue(&commandQueue);
+	freeQueue(&responseQueue);
+	backgroundStarted = 0;
+}
+
+int queueBackground(msgCacheT *cachePtr, char *command) {
+	backgroundItemT *cmdPtr;
+	int retVal;
+
+	cmdPtr = calloc(1, sizeof(backgroundItemT));
+	if (!cmdPtr) {
+		return(MEM_ERROR);
+	}
+	cmdPtr->command = strdup(command);
+	if (!cmdPtr->command) {
+		free(cmdPtr);
+		return(MEM_ERROR);
+	}
+	cmdPtr->cachePtr = cachePtr;
+	generateTag(cmdPtr->tag);
+
+	//The network thread may be waiting for room for its responses, so they are applied until there is room
+	while (!queuePush(&commandQueue, cmdPtr)) {
+		if (isError(retVal = applyBackground(1))) {
+			freeItem(cmdPtr);
+			return(retVal);
+		}
+	}
+	queueSignal(&commandQueue);
+	backgroundPending++;
+
+	return(SUCCESS);
+}
+
+int backgroundBusy(void) {
+	return(backgroundPending > 0);
+}
+
+//Interpret a copied response (check copyResponse()) with a function that reads it from a stream
+int interpretCopy(backgroundItemT *itemPtr, int (*interpret)(FILE *, msgCacheT *)) {
+	FILE *copyStream;
+	int retVal;
+
+	copyStream = fmemopen(itemPtr->text, itemPtr->textLen, "r");
+	if (!copyStream) {
+		return(MEM_ERROR);
+	}
+	retVal = interpret(copyStream, itemPtr->cachePtr);
+	fclose(copyStream);
+
+	return(retVal);
+}
+
+int interpretCopiedUntagged(FILE *copyStream, msgCacheT *cachePtr) {
+	int retVal;
+
+	if (isError(retVal = skipObject(copyStream))) { //The "*"
+		return(retVal);
+	}
+
+	return(interpretUntagged(copyStream, cachePtr, NO_CONTEXT));
+}
+
+int printCopiedLine(FILE *copyStream, msgCacheT *cachePtr) {
+	fprintf(stderr, "[SERVER]: ");
+
+	return(printLine(stderr, copyStream));
+}
+
+int applyItem(backgroundItemT *itemPtr) {
+	int retVal;
+
+	switch (itemPtr->type) {
+		case FETCH_ITEM:
+			retVal = applyFetch(itemPtr->cachePtr, itemPtr->msgNum, itemPtr->fetchList);
+			itemPtr->fetchList = NULL; //applyFetch() freed it
+			break;
+		case UNTAGGED_ITEM:
+			retVal = interpretCopy(itemPtr, interpretCopiedUntagged);
+			break;
+		default:
+			backgroundPending--;
+			retVal = itemPtr->result;
+			if (retVal == SUCCESS) {
+				retVal = interpretCopy(itemPtr, interpretRespCode);
+			}
+			else if (retVal == RESPONSE_NO) {
+				retVal = interpretCopy(itemPtr, printCopiedLine);
+			}
+			//As sendCommand() in commands.c does, a BAD is printed, and stops the client
+			else if (retVal == RESPONSE_BAD) {
+				interpretCopy(itemPtr, printCopiedLine);
+				retVal = PARSE_ERROR;
+			}
+	}
+	freeItem(itemPtr);
+
+	return(retVal);
+}
+
+int applyBackground(int wait) {
+	backgroundItemT *itemPtr;
+	int retVal, applied = 0;
+
+	queueClearItemFd(&responseQueue);
+	while (backgroundPending > 0) {
+		itemPtr = queuePop(&responseQueue);
+		//After an error, the rest of the commands are waited for, as the caller may need the stream (e.g. to reconnect)
+		if (!itemPtr && (applied > 0 || !wait) && !isError(backgroundError)) {
+			return(SUCCESS);
+		}
+		else if (!itemPtr) {
+			if (isError(retVal = queueWaitItem(&responseQueue))) {
+				return(retVal);
+			}
+			continue;
+		}
+
+		retVal = applyItem(itemPtr);
+		if (isError(retVal) && !isError(backgroundError)) {
+			backgroundError = retVal;
+		}
+		applied++;
+	}
+
+	retVal = backgroundError;
+	backgroundError = SUCCESS;
+
+	return(retVal);
+}
+
+int waitBackground(void) {
+	int retVal;
+
+	while (backgroundPending > 0) {
+		if (isError(retVal = applyBackground(1))) {
+			return(retVal);
+		}
+	}
+
+	return(SUCCESS);
+}
+
+int backgroundFd(void) {
+	return(queueItemFd(&responseQueue));
+}
@@ -0,0 +1,270 @@
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "error.h"
+#include "base64.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+	#include <immintrin.h>
+	#define B64_SIMD
+#endif
+
+static const char b64Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+//The value (sextet) of each base 64 digit, -1 for anything else
+static const signed char b64Table[256] = {
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, -1, -1, 63,
+	52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1, -1, -1, -1, -1, -1,
+	-1,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+	15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1,
+	-1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+	41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+};
+
+#ifdef B64_SIMD
+/* The vectorized decoding follows Wojciech Muła's algorithm (check http://0x80.pl/notesen/2016-01-17-sse-base64-decoding.html).
+  The high and low nibble of every digit are looked up in two tables (with pshufb), and their
+  results only have a bit in common if the digit is not valid. A third lookup, on the high nibble,
+  gives the offset that turns a digit to its sextet ('/' is the exception, as it shares its high
+  nibble with '+'). The sextets are then packed, 4 into 3 bytes, by multiply-adds and a shuffle. */
+
+__attribute__((target("ssse3")))
+size_t b64DecodeSsse3(unsigned char *src, size_t len, unsigned char *dest) {
+	const __m128i lutLo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+	                                    0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+	const __m128i lutHi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+	                                    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+	const __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i mask2F = _mm_set1_epi8(0x2F);
+	const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+	__m128i digits, hiNibbles, loNibbles, roll;
+	size_t pos = 0;
+
+	/* Every block writes 16 bytes, of which 12 are decoded, so at least 8 more digits
+	  must follow, for the extra 4 to fall inside the output of the rest of the text */
+	for ( ; len - pos >= 24 ; pos += 16, dest += 12) {
+		digits = _mm_loadu_si128((__m128i*)(src + pos));
+
+		hiNibbles = _mm_and_si128(_mm_srli_epi32(digits, 4), mask2F);
+		loNibbles = _mm_and_si128(digits, mask2F);
+		if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(_mm_shuffle_epi8(lutLo, loNibbles), 
+		                      _mm_shuffle_epi8(lutHi, hiNibbles)), _mm_setzero_si128())) != 0) {
+			break; //Not valid, the table finds out where
+		}
+		roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(_mm_cmpeq_epi8(digits, mask2F), hiNibbles));
+		digits = _mm_add_epi8(digits, roll);
+
+		digits = _mm_maddubs_epi16(digits, _mm_set1_epi32(0x01400140));
+		digits = _mm_madd_epi16(digits, _mm_set1_epi32(0x00011000));
+		_mm_storeu_si128((__m128i*)dest, _mm_shuffle_epi8(digits, pack));
+	}
+
+	return(pos);
+}
+
+__attribute__((target("avx2")))
+size_t b64DecodeAvx2(unsigned char *src, size_t len, unsigned char *dest) {
+	const __m256i lutLo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+	                                       0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+	                                       0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+	                                       0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+	const __m256i lutHi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+	                                       0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+	                                       0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+	                                       0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+	const __m256i lutRoll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+	                                         0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m256i mask2F = _mm256_set1_epi8(0x2F);
+	const __m256i pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+	                                      2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+	//The shuffle packs each 128 bit lane on its own, so the two 12 byte halves are joined by a permute
+	const __m256i join = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+	__m256i digits, hiNibbles, loNibbles, roll;
+	size_t pos = 0;
+
+	//Every block writes 32 bytes, of which 24 are decoded, so at least 16 more digits must follow
+	for ( ; len - pos >= 48 ; pos += 32, dest += 24) {
+		digits = _mm256_loadu_si256((__m256i*)(src + pos));
+
+		hiNibbles = _mm256_and_si256(_mm256_srli_epi32(digits, 4), mask2F);
+		loNibbles = _mm256_and_si256(digits, mask2F);
+		if (_mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_and_si256(_mm256_shuffle_epi8(lutLo, loNibbles),
+		                         _mm256_shuffle_epi8(lutHi, hiNibbles)), _mm256_setzero_si256())) != 0) {
+			break;
+		}
+		roll = _mm256_shuffle_epi8(lutRoll, _mm256_add_epi8(_mm256_cmpeq_epi8(digits, mask2F), hiNibbles));
+		digits = _mm256_add_epi8(digits, roll);
+
+		digits = _mm256_maddubs_epi16(digits, _mm256_set1_epi32(0x01400140));
+		digits = _mm256_madd_epi16(digits, _mm256_set1_epi32(0x00011000));
+		digits = _mm256_shuffle_epi8(digits, pack);
+		_mm256_storeu_si256((__m256i*)dest, _mm256_permutevar8x32_epi32(digits, join));
+	}
+
+	return(pos);
+}
+#endif
+
+int b64Decode(char *b64Str, size_t len, char *decodedStr, size_t *decodedLenPtr) {
+	unsigned char *src = (unsigned char*)b64Str, *dest = (unsigned char*)decodedStr;
+	size_t pos = 0, bytes = 0, padding = 0;
+	int sextet[4];
+
+	//The padding can only end the text, so it is taken off, the length of the rest tells what it decodes to
+	while (padding < 2 && len > 0 && src[len-1] == '=') {
+		len--;
+		padding++;
+	}
+	if ((padding > 0 && (len + padding) % 4 != 0) || len % 4 == 1) {
+		return(PARSE_ERROR); //One digit alone does not make a byte
+	}
+
+#ifdef B64_SIMD
+	if (__builtin_cpu_supports("avx2")) {
+		pos = b64DecodeAvx2(src, len, dest);
+	}
+	if (__builtin_cpu_supports("ssse3")) {
+		pos += b64DecodeSsse3(src + pos, len - pos, dest + pos / 4 * 3);
+	}
+	bytes = pos / 4 * 3;
+#endif
+
+	//Whole quartets of digits decode to 3 bytes
+	for ( ; len - pos >= 4 ; pos += 4) {
+		sextet[0] = b64Table[src[pos]];
+		sextet[1] = b64Table[src[pos+1]];
+		sextet[2] = b64Table[src[pos+2]];
+		sextet[3] = b64Table[src[pos+3]];
+		if ((sextet[0] | sextet[1] | sextet[2] | sextet[3]) < 0) { //Only -1 sets the sign bit
+			return(PARSE_ERROR);
+		}
+
+		dest[bytes++] = (sextet[0] << 2) | (sextet[1] >> 4);
+		dest[bytes++] = (sextet[1] << 4) | (sextet[2] >> 2);
+		dest[bytes++] = (sextet[2] << 6) | sextet[3];
+	}
+
+	//The last quartet was padded, 2 digits decode to 1 byte, and 3 digits to 2 bytes
+	if (len - pos >= 2) {
+		sextet[0] = b64Table[src[pos]];
+		sextet[1] = b64Table[src[pos+1]];
+		sextet[2] = len - pos == 3 ? b64Table[src[pos+2]] : 0;
+		if ((sextet[0] | sextet[1] | sextet[2]) < 0) {
+			return(PARSE_ERROR);
+		}
+
+		dest[bytes++] = (sextet[0] << 2) | (sextet[1] >> 4);
+		if (len - pos == 3) {
+			dest[bytes++] = (sextet[1] << 4) | (sextet[2] >> 2);
+		}
+	}
+
+	*decodedLenPtr = bytes;
+
+	return(SUCCESS);
+}
+
+int b64DecodeText(char *b64Str, size_t len, char *decodedStr, size_t *decodedLenPtr) {
+	char quartet[4];
+	size_t pos = 0, start, runLen, wholeLen, bytes = 0, decoded;
+	int quartetLen = 0, retVal;
+
+	while (pos < len) {
+		//Find the next run of digits (usually a line)
+		while (pos < len && isspace((unsigned char)b64Str[pos])) {
+			pos++;
+		}
+		for (start = pos ; pos < len && !isspace((unsigned char)b64Str[pos]) ; pos++);
+		runLen = pos - start;
+
+		//Complete the quartet the previous run ended in the middle of
+		while (quartetLen > 0 && quartetLen < 4 && runLen > 0) {
+			quartet[quartetLen++] = b64Str[start++];
+			runLen--;
+		}
+		if (quartetLen == 4) {
+			retVal = b64Decode(quartet, 4, decodedStr + bytes, &decoded);
+			if (isError(retVal)) {
+				return(retVal);
+			}
+			bytes += decoded;
+			quartetLen = 0;
+		}
+
+		//Whole quartets are decoded at once, the rest waits for the next run
+		wholeLen = runLen / 4 * 4;
+		retVal = b64Decode(b64Str + start, wholeLen, decodedStr + bytes, &decoded);
+		if (isError(retVal)) {
+			return(retVal);
+		}
+		bytes += decoded;
+		for (size_t k = wholeLen ; k < runLen ; k++) {
+			quartet[quartetLen++] = b64Str[start + k];
+		}
+	}
+
+	//The text may end without its padding
+	retVal = b64Decode(quartet, quartetLen, decodedStr + bytes, &decoded);
+	if (isError(retVal)) {
+		return(retVal);
+	}
+	*decodedLenPtr = bytes + decoded;
+
+	return(SUCCESS);
+}
+
+size_t b64Strip(char *b64Str, size_t len, char *digits) {
+	unsigned char *src = (unsigned char*)b64Str;
+	size_t pos, count = 0, run;
+
+	for (pos = 0 ; pos < len ; ) {
+		//Bodies are lines of digits, so runs of them are copied at once
+		for (run = pos ; run < len && b64Table[src[run]] >= 0 ; run++);
+		memmove(digits + count, b64Str + pos, run - pos);
+		count += run - pos;
+
+		for (pos = run ; pos < len && b64Table[src[pos]] < 0 ; pos++);
+	}
+
+	return(count);
+}
+
+size_t b64Encode(char *str, size_t len, char *b64Str) {
+	unsigned char *src = (unsigned char*)str;
+	size_t pos, b64Len = 0;
+
+	//Every 3 bytes are split into 4 sextets
+	for (pos = 0 ; len - pos >= 3 ; pos += 3) {
+		b64Str[b64Len++] = b64Alphabet[src[pos] >> 2];
+		b64Str[b64Len++] = b64Alphabet[((src[pos] & 0x03) << 4) | (src[pos+1] >> 4)];
+		b64Str[b64Len++] = b64Alphabet[((src[pos+1] & 0x0F) << 2) | (src[pos+2] >> 6)];
+		b64Str[b64Len++] = b64Alphabet[src[pos+2] & 0x3F];
+	}
+
+	//The last 1 or 2 bytes are padded to a quartet
+	if (len - pos > 0) {
+		b64Str[b64Len++] = b64Alphabet[src[pos] >> 2];
+		if (len - pos == 1) {
+			b64Str[b64Len++] = b64Alphabet[(src[pos] & 0x03) << 4];
+			b64Str[b64Len++] = '=';
+		}
+		else {
+			b64Str[b64Len++] = b64Alphabet[((src[pos] & 0x03) << 4) | (src[pos+1] >> 4)];
+			b64Str[b64Len++] = b64Alphabet[(src[pos+1] & 0x0F) << 2];
+		}
+		b64Str[b64Len++] = '=';
+	}
+	b64Str[b64Len] = '\0';
+
+	return(b64Len);
+}
@@ -0,0 +1,450 @@
+#include <stdlib.h>
+#include <string.h>
+#include "error.h"
+#include "bitmap.h"
+
+#define CONTAINER_BATCH 8 //Used to decrease the number of allocations of the container array
+
+#define HIGH(value) ((unsigned int)((value) >> 16) & 0xFFFF)
+#define LOW(value) ((unsigned short)((value) & 0xFFFF))
+
+void bitmapInit(bitmapT *bitmapPtr) {
+	bitmapPtr->containers = NULL;
+	bitmapPtr->count = bitmapPtr->cap = 0;
+	bitmapPtr->card = 0;
+}
+
+/* Allocate an array for an array container. Arrays grow by doubling when their cardinality
+  reaches a power of two, so the capacity is always rounded up to one */
+unsigned short *allocArray(unsigned int card) {
+	unsigned int cap = 1;
+
+	while (cap < card) {
+		cap *= 2;
+	}
+
+	return(malloc(cap*sizeof(unsigned short)));
+}
+
+void freeContainer(struct container *contPtr) {
+	free(contPtr->array);
+	free(contPtr->bits);
+}
+
+void freeBitmap(bitmapT *bitmapPtr) {
+	for (size_t k = 0 ; k < bitmapPtr->count ; k++) {
+		freeContainer(&bitmapPtr->containers[k]);
+	}
+	free(bitmapPtr->containers);
+	bitmapInit(bitmapPtr);
+}
+
+//Binary search for the first container with key >= the given one
+size_t findContainer(bitmapT *bitmapPtr, unsigned int key) {
+	size_t low = 0, high = bitmapPtr->count, mid;
+
+	while (low < high) {
+		mid = low + (high - low) / 2;
+		if (bitmapPtr->containers[mid].key < key) {
+			low = mid + 1;
+		}
+		else {
+			high = mid;
+		}
+	}
+
+	return(low);
+}
+
+//Binary search for the first value >= the given one, in an array container
+unsigned int findLow(struct container *contPtr, unsigned short low16) {
+	unsigned int low = 0, high = contPtr->card, mid;
+
+	while (low < high) {
+		mid = low + (high - low) / 2;
+		if (contPtr->array[mid] < low16) {
+			low = mid + 1;
+		}
+		else {
+			high = mid;
+		}
+	}
+
+	return(low);
+}
+
+int containerContains(struct container *contPtr, unsigned short low16) {
+	unsigned int pos;
+
+	if (contPtr->bits != NULL) {
+		return((contPtr->bits[low16 >> 6] >> (low16 & 63)) & 1);
+	}
+
+	pos = findLow(contPtr, low16);
+
+	return(pos < contPtr->card && contPtr->array[pos] == low16);
+}
+
+//Switch a full array container to a bitmap container
+int arrayToBits(struct container *contPtr) {
+	unsigned long long *bits;
+
+	bits = calloc(BITMAP_WORDS, sizeof(unsigned long long));
+	if (!bits) {
+		return(MEM_ERROR);
+	}
+	for (unsigned int k = 0 ; k < contPtr->card ; k++) {
+		bits[contPtr->array[k] >> 6] |= 1ULL << (contPtr->array[k] & 63);
+	}
+
+	free(contPtr->array);
+	contPtr->array = NULL;
+	contPtr->bits = bits;
+
+	return(SUCCESS);
+}
+
+//Switch a bitmap container that became sparse back to an array container
+int bitsToArray(struct container *contPtr) {
+	unsigned short *array;
+	unsigned long long word;
+	unsigned int len = 0;
+
+	array = allocArray(contPtr->card);
+	if (!array) {
+		return(MEM_ERROR);
+	}
+	for (unsigned int k = 0 ; k < BITMAP_WORDS ; k++) {
+		for (word = contPtr->bits[k] ; word != 0 ; word &= word - 1) {
+			array[len++] = k*64 + __builtin_ctzll(word);
+		}
+	}
+
+	free(contPtr->bits);
+	contPtr->bits = NULL;
+	contPtr->array = array;
+
+	return(SUCCESS);
+}
+
+int bitmapAdd(bitmapT *bitmapPtr, unsigned long value) {
+	unsigned int key = HIGH(value), pos;
+	unsigned short low16 = LOW(value), *tempArray;
+	struct container *contPtr, *temp;
+	size_t index;
+
+	index = findContainer(bitmapPtr, key);
+	if (index == bitmapPtr->count || bitmapPtr->containers[index].key != key) {
+		//No container for these high bits yet, so insert an empty one
+		if (bitmapPtr->count == bitmapPtr->cap) {
+			temp = realloc(bitmapPtr->containers, (bitmapPtr->cap + CONTAINER_BATCH)*sizeof(struct container));
+			if (!temp) {
+				return(MEM_ERROR);
+			}
+			bitmapPtr->containers = temp;
+			bitmapPtr->cap += CONTAINER_BATCH;
+		}
+		memmove(bitmapPtr->containers + index + 1, bitmapPtr->containers + index, 
+		        (bitmapPtr->count - index)*sizeof(struct container));
+		bitmapPtr->containers[index].key = key;
+		bitmapPtr->containers[index].card = 0;
+		bitmapPtr->containers[index].array = NULL;
+		bitmapPtr->containers[index].bits = NULL;
+		bitmapPtr->count++;
+	}
+	contPtr = &bitmapPtr->containers[index];
+
+	if (contPtr->bits != NULL) {
+		if (!containerContains(contPtr, low16)) {
+			contPtr->bits[low16 >> 6] |= 1ULL << (low16 & 63);
+			contPtr->card++;
+			bitmapPtr->card++;
+		}
+		return(SUCCESS);
+	}
+
+	pos = findLow(contPtr, low16);
+	if (pos < contPtr->card && contPtr->array[pos] == low16) { //Already there
+		return(SUCCESS);
+	}
+
+	//The array grows by doubling, resizing when the cardinality is a power of two
+	if ((contPtr->card & (contPtr->card - 1)) == 0) {
+		tempArray = realloc(contPtr->array, (contPtr->card ? contPtr->card*2 : 1)*sizeof(unsigned short));
+		if (!tempArray) {
+			return(MEM_ERROR);
+		}
+		contPtr->array = tempArray;
+	}
+	memmove(contPtr->array + pos + 1, contPtr->array + pos, (contPtr->card - pos)*sizeof(unsigned short));
+	contPtr->array[pos] = low16;
+	contPtr->card++;
+	bitmapPtr->card++;
+
+	if (contPtr->card > ARRAY_MAX) {
+		return(arrayToBits(contPtr));
+	}
+
+	return(SUCCESS);
+}
+
+void bitmapRemove(bitmapT *bitmapPtr, unsigned long value) {
+	unsigned int key = HIGH(value), pos;
+	unsigned short low16 = LOW(value);
+	struct container *contPtr;
+	size_t index;
+
+	index = findContainer(bitmapPtr, key);
+	if (index == bitmapPtr->count || bitmapPtr->containers[index].key != key) {
+		return;
+	}
+	contPtr = &bitmapPtr->containers[index];
+
+	if (contPtr->bits != NULL) {
+		if (!containerContains(contPtr, low16)) {
+			return;
+		}
+		contPtr->bits[low16 >> 6] &= ~(1ULL << (low16 & 63));
+		contPtr->card--;
+		bitmapPtr->card--;
+
+		/* If the array can't be allocated, the container just stays a bitmap,
+		  so there is nothing to report */
+		if (contPtr->card <= ARRAY_MAX / 2) {
+			bitsToArray(contPtr);
+		}
+		return;
+	}
+
+	pos = findLow(contPtr, low16);
+	if (pos == contPtr->card || contPtr->array[pos] != low16) {
+		return;
+	}
+	memmove(contPtr->array + pos, contPtr->array + pos + 1, (contPtr->card - pos - 1)*sizeof(unsigned short));
+	contPtr->card--;
+	bitmapPtr->card--;
+
+	//Remove empty containers
+	if (contPtr->card == 0) {
+		freeContainer(contPtr);
+		memmove(bitmapPtr->containers + index, bitmapPtr->containers + index + 1,
+		        (bitmapPtr->count - index - 1)*sizeof(struct container));
+		bitmapPtr->count--;
+	}
+}
+
+int bitmapContains(bitmapT *bitmapPtr, unsigned long value) {
+	size_t index;
+
+	index = findContainer(bitmapPtr, HIGH(value));
+	if (index == bitmapPtr->count || bitmapPtr->containers[index].key != HIGH(value)) {
+		return(0);
+	}
+
+	return(containerContains(&bitmapPtr->containers[index], LOW(value)));
+}
+
+/* Append a container to a result bitmap (in ascending key order), if it is not empty,
+  turning it into an array container if it is sparse enough */
+int appendContainer(bitmapT *resultPtr, struct container *contPtr) {
+	struct container *temp;
+	int retVal;
+
+	if (contPtr->card == 0) {
+		freeContainer(contPtr);
+		return(SUCCESS);
+	}
+	if (contPtr->bits != NULL && contPtr->card <= ARRAY_MAX) {
+		retVal = bitsToArray(contPtr);
+		if (isError(retVal)) {
+			freeContainer(contPtr);
+			return(retVal);
+		}
+	}
+
+	if (resultPtr->count == resultPtr->cap) {
+		temp = realloc(resultPtr->containers, (resultPtr->cap + CONTAINER_BATCH)*sizeof(struct container));
+		if (!temp) {
+			freeContainer(contPtr);
+			return(MEM_ERROR);
+		}
+		resultPtr->containers = temp;
+		resultPtr->cap += CONTAINER_BATCH;
+	}
+	resultPtr->containers[resultPtr->count++] = *contPtr;
+	resultPtr->card += contPtr->card;
+
+	return(SUCCESS);
+}
+
+//Count the set bits of a bitmap container
+unsigned int countBits(unsigned long long *bits) {
+	unsigned int card = 0;
+
+	for (unsigned int k = 0 ; k < BITMAP_WORDS ; k++) {
+		card += __builtin_popcountll(bits[k]);
+	}
+
+	return(card);
+}
+
+/* Combine two containers with the same key, keeping the values of the first that are
+  (if andNot == 0) or are not (if andNot == 1) in the second */
+int combineContainers(struct container *cont1Ptr, struct container *cont2Ptr, int andNot, struct container *resultPtr) {
+	resultPtr->key = cont1Ptr->key;
+	resultPtr->card = 0;
+	resultPtr->array = NULL;
+	resultPtr->bits = NULL;
+
+	if (cont1Ptr->bits != NULL && (cont2Ptr->bits != NULL || andNot)) {
+		//The result is computed a word at a time
+		resultPtr->bits = malloc(BITMAP_WORDS*sizeof(unsigned long long));
+		if (!resultPtr->bits) {
+			return(MEM_ERROR);
+		}
+
+		if (cont2Ptr->bits != NULL) {
+			for (unsigned int k = 0 ; k < BITMAP_WORDS ; k++) {
+				resultPtr->bits[k] = andNot ? cont1Ptr->bits[k] & ~cont2Ptr->bits[k] : cont1Ptr->bits[k] & cont2Ptr->bits[k];
+			}
+		}
+		else { //Clear the values of the array container
+			memcpy(resultPtr->bits, cont1Ptr->bits, BITMAP_WORDS*sizeof(unsigned long long));
+			for (unsigned int k = 0 ; k < cont2Ptr->card ; k++) {
+				resultPtr->bits[cont2Ptr->array[k] >> 6] &= ~(1ULL << (cont2Ptr->array[k] & 63));
+			}
+		}
+		resultPtr->card = countBits(resultPtr->bits);
+
+		return(SUCCESS);
+	}
+
+	if (cont1Ptr->bits != NULL) { //Intersection of a bitmap with an array, keep the array's values
+		struct container *temp = cont1Ptr;
+
+		cont1Ptr = cont2Ptr;
+		cont2Ptr = temp;
+	}
+
+	//The result is at most as large as the first array, so it is filtered into a new array
+	resultPtr->array = allocArray(cont1Ptr->card);
+	if (!resultPtr->array) {
+		return(MEM_ERROR);
+	}
+	for (unsigned int k = 0 ; k < cont1Ptr->card ; k++) {
+		if (containerContains(cont2Ptr, cont1Ptr->array[k]) != andNot) {
+			resultPtr->array[resultPtr->card++] = cont1Ptr->array[k];
+		}
+	}
+
+	return(SUCCESS);
+}
+
+//Copy a container, used for the containers of the first bitmap that have no match in the second one
+int copyContainer(struct container *contPtr, struct container *copyPtr) {
+	*copyPtr = *contPtr;
+
+	if (contPtr->bits != NULL) {
+		copyPtr->bits = malloc(BITMAP_WORDS*sizeof(unsigned long long));
+		if (!copyPtr->bits) {
+			return(MEM_ERROR);
+		}
+		memcpy(copyPtr->bits, contPtr->bits, BITMAP_WORDS*sizeof(unsigned long long));
+	}
+	else {
+		copyPtr->array = allocArray(contPtr->card);
+		if (!copyPtr->array) {
+			return(MEM_ERROR);
+		}
+		memcpy(copyPtr->array, contPtr->array, contPtr->card*sizeof(unsigned short));
+	}
+
+	return(SUCCESS);
+}
+
+//Walk both container arrays by key, combining containers with the same key
+int combineBitmaps(bitmapT *bitmap1Ptr, bitmapT *bitmap2Ptr, int andNot, bitmapT *resultPtr) {
+	struct container result;
+	size_t pos1 = 0, pos2 = 0;
+	int retVal;
+
+	bitmapInit(resultPtr);
+
+	while (pos1 < bitmap1Ptr->count) {
+		if (pos2 < bitmap2Ptr->count && bitmap2Ptr->containers[pos2].key < bitmap1Ptr->containers[pos1].key) {
+			pos2++;
+			continue;
+		}
+
+		if (pos2 < bitmap2Ptr->count && bitmap2Ptr->containers[pos2].key == bitmap1Ptr->containers[pos1].key) {
+			retVal = combineContainers(&bitmap1Ptr->containers[pos1], &bitmap2Ptr->containers[pos2], andNot, &result);
+			pos2++;
+		}
+		else if (andNot) { //Nothing to remove from this container, so it is kept whole
+			retVal = copyContainer(&bitmap1Ptr->containers[pos1], &result);
+		}
+		else { //Nothing in common
+			pos1++;
+			continue;
+		}
+		pos1++;
+
+		if (!isError(retVal)) {
+			retVal = appendContainer(resultPtr, &result);
+		}
+		if (isError(retVal)) {
+			freeBitmap(resultPtr);
+			return(retVal);
+		}
+	}
+
+	return(SUCCESS);
+}
+
+int bitmapAnd(bitmapT *bitmap1Ptr, bitmapT *bitmap2Ptr, bitmapT *resultPtr) {
+	return(combineBitmaps(bitmap1Ptr, bitmap2Ptr, 0, resultPtr));
+}
+
+int bitmapAndNot(bitmapT *bitmap1Ptr, bitmapT *bitmap2Ptr, bitmapT *resultPtr) {
+	return(combineBitmaps(bitmap1Ptr, bitmap2Ptr, 1, resultPtr));
+}
+
+int bitmapToArray(bitmapT *bitmapPtr, unsigned long **valuesPtr, size_t *countPtr) {
+	unsigned long *values, high;
+	unsigned long long word;
+	struct container *contPtr;
+	size_t count = 0;
+
+	*valuesPtr = NULL;
+	*countPtr = 0;
+	if (bitmapPtr->card == 0) {
+		return(SUCCESS);
+	}
+
+	values = malloc(bitmapPtr->card*sizeof(unsigned long));
+	if (!values) {
+		return(MEM_ERROR);
+	}
+
+	for (size_t k = 0 ; k < bitmapPtr->count ; k++) {
+		contPtr = &bitmapPtr->containers[k];
+		high = (unsigned long)contPtr->key << 16;
+		if (contPtr->bits != NULL) {
+			for (unsigned int w = 0 ; w < BITMAP_WORDS ; w++) {
+				for (word = contPtr->bits[w] ; word != 0 ; word &= word - 1) {
+					values[count++] = high | (w*64 + __builtin_ctzll(word));
+				}
+			}
+		}
+		else {
+			for (unsigned int v = 0 ; v < contPtr->card ; v++) {
+				values[count++] = high | contPtr->array[v];
+			}
+		}
+	}
+
+	*valuesPtr = values;
+	*countPtr = count;
+
+	return(SUCCESS);
+}
@@ -0,0 +1,485 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+#include "parsing.h"
+#include "addresses.h"
+#include "cache.h"
+#include "error.h"
+#include "commands.h"
+#include "printing.h"
+#include "sort.h"
+#include "mailbox.h"
+#include "outbuf.h"
+#include "browse.h"
+
+#define BROWSE_NOOP_INTERVAL 3000 //Interval before sending a NOOP to server while browsing, in milliseconds
+#define KEYS_SIZE 64 //Keys read at once (a held key repeats faster than the screen is redrawn)
+#define MIN_ROWS 3 //The column titles, a message and the status line
+
+//ANSI escape codes
+#define ENTER_SCREEN "\033[?1049h\033[?25l\033[?7l" //Switch to the alternate screen, hide the cursor, don't wrap lines
+#define LEAVE_SCREEN "\033[?7h\033[?25h\033[?1049l"
+#define CLEAR "\033[2J"
+#define CLEAR_LINE "\033[K" //Clear from the cursor to the end of the line
+#define REVERSE "\033[7m" //Used for the selected message and the status line
+#define RSET "\033[0m"
+
+//The keys of browsing (escape sequences are mapped to them too)
+#define KEY_NONE 0
+#define KEY_DOWN 1
+#define KEY_UP 2
+#define KEY_PAGE_DOWN 3
+#define KEY_PAGE_UP 4
+#define KEY_FIRST 5
+#define KEY_LAST 6
+#define KEY_READ 7
+#define KEY_QUIT 8
+
+outBufT browseBuf = OUTBUF_INIT; //The updates of a redraw are written with a single write() (check outbuf.h)
+
+/* What the terminal shows, row 0 has the column titles, the last row is the status line,
+  and the rows between them are the list */
+typedef struct screen {
+	outBufT *rows; //The contents of each row, as they were written (with the escape codes)
+	int height, width; //The size of the terminal
+	size_t top; //The index (in the current order) of the message on the first row of the list
+	size_t drawnTop; //The one the list was drawn with, to tell how much it has moved
+	size_t selected; //The index of the selected message
+} screenT;
+
+outBufT frameRow = OUTBUF_INIT; //A row is rendered here, before it is compared to the one on the screen
+
+struct termios savedTerm; //The settings of the terminal before browsing, restored when it ends
+
+//The signals that would end the process while browsing (Ctrl-C still works), and what they did before
+int exitSignals[] = {SIGINT, SIGTERM, SIGHUP, SIGQUIT};
+#define EXIT_SIGNALS (sizeof(exitSignals) / sizeof(*exitSignals))
+struct sigaction savedActions[EXIT_SIGNALS];
+
+/* Leave the alternate screen and restore the terminal, otherwise a signal that ends the process
+  while browsing leaves the shell without echo, and the screen of the browser on. Then the
+  signal is raised again, with its previous disposition, to end the process as it would have */
+void leaveScreen(int signum) {
+	int saved = errno;
+
+	if (write(STDOUT_FILENO, LEAVE_SCREEN, sizeof(LEAVE_SCREEN) - 1) < 0) {
+		//Nothing to be done about it, but the terminal settings are still restored
+	}
+	tcsetattr(STDIN_FILENO, TCSANOW, &savedTerm);
+	for (size_t k = 0 ; k < EXIT_SIGNALS ; k++) {
+		if (exitSignals[k] == signum) {
+			sigaction(signum, &savedActions[k], NULL);
+		}
+	}
+	raise(signum);
+	errno = saved;
+}
+
+//Restore the terminal on the signals that would end the process, until restoreExitSignals()
+int catchExitSignals(void) {
+	struct sigaction action = {0};
+
+	action.sa_handler = leaveScreen;
+	sigemptyset(&action.sa_mask);
+	for (size_t k = 0 ; k < EXIT_SIGNALS ; k++) {
+		sigaddset(&action.sa_mask, exitSignals[k]); //So that the terminal is restored once
+	}
+	for (size_t k = 0 ; k < EXIT_SIGNALS ; k++) {
+		if (sigaction(exitSignals[k], &action, &savedActions[k]) < 0) {
+			while (k-- > 0) {
+				sigaction(exitSignals[k], &savedActions[k], NULL);
+			}
+			return(SYSCALL_ERROR);
+		}
+	}
+
+	return(SUCCESS);
+}
+
+void restoreExitSignals(void) {
+	for (size_t k = 0 ; k < EXIT_SIGNALS ; k++) {
+		sigaction(exitSignals[k], &savedActions[k], NULL);
+	}
+}
+
+//Read the size of the terminal, if it changed, the screen is cleared (the terminal may have moved the rows)
+int readScreenSize(screenT *screenPtr) {
+	struct winsize size;
+	int height = 24, width = 80;
+
+	if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_row > 0) {
+		height = size.ws_row;
+		width = size.ws_col;
+	}
+	if (height < MIN_ROWS) {
+		height = MIN_ROWS;
+	}
+	if (screenPtr->rows != NULL && height == screenPtr->height && width == screenPtr->width) {
+		return(SUCCESS);
+	}
+
+	for (int i = 0 ; screenPtr->rows != NULL && i < screenPtr->height ; i++) {
+		freeOutBuf(&screenPtr->rows[i]);
+	}
+	free(screenPtr->rows);
+	screenPtr->rows = calloc(height, sizeof(outBufT)); //All rows empty, as after clearing the screen
+	if (!screenPtr->rows) {
+		return(MEM_ERROR);
+	}
+	screenPtr->height = height;
+	screenPtr->width = width;
+	screenPtr->drawnTop = screenPtr->top; //Nothing to scroll
+	outStr(&browseBuf, CLEAR);
+
+	return(SUCCESS);
+}
+
+//Reverse the order of the rows in [start, end)
+void reverseRows(outBufT *rows, int start, int end) {
+	outBufT temp;
+
+	for (end-- ; start < end ; start++, end--) {
+		temp = rows[start];
+		rows[start] = rows[end];
+		rows[end] = temp;
+	}
+}
+
+/* Scroll the list by the difference between the top it was drawn with and the current one,
+  so that the rows still on the screen don't have to be written again */
+void scrollList(screenT *screenPtr) {
+	int listRows = screenPtr->height - 2, shift, count;
+
+	if (screenPtr->top == screenPtr->drawnTop) {
+		return;
+	}
+	else if (screenPtr->top > screenPtr->drawnTop && screenPtr->top - screenPtr->drawnTop < listRows) {
+		shift = screenPtr->top - screenPtr->drawnTop; //Up, the rows that come in are at the bottom
+	}
+	else if (screenPtr->top < screenPtr->drawnTop && screenPtr->drawnTop - screenPtr->top < listRows) {
+		shift = listRows - (screenPtr->drawnTop - screenPtr->top); //Down, as a rotation the other way
+	}
+	else { //Moved by a screen or more, every row is written anyway
+		screenPtr->drawnTop = screenPtr->top;
+		return;
+	}
+
+	//Scroll the region between the column titles and the status line
+	outPrintf(&browseBuf, "\033[2;%dr", listRows+1);
+	if (screenPtr->top > screenPtr->drawnTop) {
+		outPrintf(&browseBuf, "\033[%dS", shift);
+	}
+	else {
+		outPrintf(&browseBuf, "\033[%dT", listRows - shift);
+	}
+	outStr(&browseBuf, "\033[r");
+
+	//Rotate the rows of the list the same way (left by shift), the ones that came in are empty
+	reverseRows(screenPtr->rows, 1, 1+shift);
+	reverseRows(screenPtr->rows, 1+shift, 1+listRows);
+	reverseRows(screenPtr->rows, 1, 1+listRows);
+	if (screenPtr->top > screenPtr->drawnTop) {
+		for (count = 0 ; count < shift ; count++) {
+			screenPtr->rows[listRows-count].len = 0;
+		}
+	}
+	else {
+		for (count = 0 ; count < listRows - shift ; count++) {
+			screenPtr->rows[1+count].len = 0;
+		}
+	}
+	screenPtr->drawnTop = screenPtr->top;
+}
+
+//The previews and the column titles end in '\n', which would move the cursor
+void dropNewline(outBufT *outPtr) {
+	if (outPtr->len > 0 && outPtr->buf[outPtr->len-1] == '\n') {
+		outPtr->len--;
+	}
+}
+
+//Write row rowNum, if frameRow differs from what it shows
+void updateRow(screenT *screenPtr, int rowNum) {
+	outBufT *rowPtr = &screenPtr->rows[rowNum], temp;
+
+	if (rowPtr->len == frameRow.len && (frameRow.len == 0 || !memcmp(rowPtr->buf, frameRow.buf, frameRow.len))) {
+		outReset(&frameRow);
+		return;
+	}
+
+	outPrintf(&browseBuf, "\033[%d;1H", rowNum+1);
+	outWrite(&browseBuf, frameRow.buf, frameRow.len);
+	outStr(&browseBuf, CLEAR_LINE);
+
+	//The new contents become the row's, and the row's buffer is reused for the next one
+	temp = *rowPtr;
+	*rowPtr = frameRow;
+	frameRow = temp;
+	outReset(&frameRow);
+}
+
+//Render every row of the screen, and write the ones that changed
+int drawScreen(cacheManagerT *managerPtr, screenT *screenPtr) {
+	msgCacheT *cachePtr = managerPtr->current;
+	size_t msgs = viewLength(cachePtr), listRows = screenPtr->height - 2, pos;
+	folderT *folderPtr = NULL;
+	int retVal;
+
+	//Keep the selected message on the screen (messages may have been expunged, or the terminal resized)
+	if (screenPtr->selected >= msgs) {
+		screenPtr->selected = msgs ? msgs-1 : 0;
+	}
+	if (screenPtr->selected < screenPtr->top) {
+		screenPtr->top = screenPtr->selected;
+	}
+	else if (screenPtr->selected >= screenPtr->top + listRows) {
+		screenPtr->top = screenPtr->selected - listRows + 1;
+	}
+	if (screenPtr->top + listRows > msgs) { //Fill the screen, if there are enough messages
+		screenPtr->top = msgs > listRows ? msgs - listRows : 0;
+	}
+	scrollList(screenPtr);
+
+	renderPageHeader(&frameRow);
+	dropNewline(&frameRow);
+	updateRow(screenPtr, 0);
+
+	//Only the visible rows are rendered, from the cached previews
+	for (size_t k = 0 ; k < listRows ; k++) {
+		if (screenPtr->top + k < msgs) {
+			pos = viewMsgPos(cachePtr, screenPtr->top + k);
+			if (screenPtr->top + k == screenPtr->selected) {
+				outStr(&frameRow, REVERSE);
+			}
+			if (isError(retVal = renderMsgPreview(&frameRow, cachePtr, pos))) {
+				return(retVal);
+			}
+			dropNewline(&frameRow);
+			if (screenPtr->top + k == screenPtr->selected) {
+				outStr(&frameRow, RSET);
+			}
+		}
+		if (frameRow.failed) {
+			return(MEM_ERROR);
+		}
+		updateRow(screenPtr, k+1);
+	}
+
+	//The status line, with the decoded name of the mailbox if the mailboxes have been listed
+	if (managerPtr->folderTree != NULL) {
+		folderPtr = folderTreeFind(managerPtr->folderTree, cachePtr->mailboxName, 0);
+	}
+	outStr(&frameRow, REVERSE);
+	if (msgs > 0) {
+		outPrintf(&frameRow, " %s: %lu/%lu ", folderPtr ? folderPtr->decodedName : cachePtr->mailboxName, screenPtr->selected+1, msgs);
+	}
+	else {
+		outPrintf(&frameRow, " %s: empty ", folderPtr ? folderPtr->decodedName : cachePtr->mailboxName);
+	}
+	outStr(&frameRow, RSET);
+	outStr(&frameRow, "  j/k: move  space/b: screen  g/G: first/last  Enter: read  q: quit");
+	updateRow(screenPtr, screenPtr->height-1);
+
+	return(outFlush(&browseBuf, STDOUT_FILENO));
+}
+
+//Get the key at *posPtr of the keys read, and move past it
+int nextKey(char *keys, int len, int *posPtr) {
+	int pos = *posPtr;
+
+	*posPtr = pos+1;
+	switch (keys[pos]) {
+		case 'j':
+			return(KEY_DOWN);
+		case 'k':
+			return(KEY_UP);
+		case ' ':
+		case 'f':
+			return(KEY_PAGE_DOWN);
+		case 'b':
+			return(KEY_PAGE_UP);
+		case 'g':
+			return(KEY_FIRST);
+		case 'G':
+			return(KEY_LAST);
+		case '\n':
+		case '\r':
+			return(KEY_READ);
+		case 'q':
+			return(KEY_QUIT);
+		case '\033':
+			break;
+		default:
+			return(KEY_NONE);
+	}
+
+	//Escape sequences: ESC [ (or ESC O) followed by a letter, or by a number and '~'
+	if (pos+2 >= len || (keys[pos+1] != '[' && keys[pos+1] != 'O')) {
+		return(KEY_NONE);
+	}
+	*posPtr = pos+3;
+	switch (keys[pos+2]) {
+		case 'A':
+			return(KEY_UP);
+		case 'B':
+			return(KEY_DOWN);
+		case 'H':
+			return(KEY_FIRST);
+		case 'F':
+			return(KEY_LAST);
+	}
+	if (pos+3 < len && keys[pos+3] == '~') {
+		*posPtr = pos+4;
+		switch (keys[pos+2]) {
+			case '1':
+			case '7':
+				return(KEY_FIRST);
+			case '4':
+			case '8':
+				return(KEY_LAST);
+			case '5':
+				return(KEY_PAGE_UP);
+			case '6':
+				return(KEY_PAGE_DOWN);
+		}
+	}
+
+	return(KEY_NONE);
+}
+
+//Move the selection, returns KEY_READ or KEY_QUIT if the user pressed them, else KEY_NONE
+int handleKeys(screenT *screenPtr, size_t msgs, char *keys, int len) {
+	size_t listRows = screenPtr->height - 2;
+	int pos = 0, key;
+
+	while (pos < len) {
+		key = nextKey(keys, len, &pos);
+		if (key == KEY_DOWN && screenPtr->selected + 1 < msgs) {
+			screenPtr->selected++;
+		}
+		else if (key == KEY_UP && screenPtr->selected > 0) {
+			screenPtr->selected--;
+		}
+		else if (key == KEY_PAGE_DOWN) {
+			//The screen moves by a page, with the selection on the same row
+			screenPtr->top += listRows;
+			screenPtr->selected += listRows;
+			if (msgs > 0 && screenPtr->selected >= msgs) {
+				screenPtr->selected = msgs-1;
+			}
+		}
+		else if (key == KEY_PAGE_UP) {
+			screenPtr->top = screenPtr->top > listRows ? screenPtr->top - listRows : 0;
+			screenPtr->selected = screenPtr->selected > listRows ? screenPtr->selected - listRows : 0;
+		}
+		else if (key == KEY_FIRST) {
+			screenPtr->selected = 0;
+		}
+		else if (key == KEY_LAST && msgs > 0) {
+			screenPtr->selected = msgs-1;
+		}
+		else if ((key == KEY_READ && msgs > 0) || key == KEY_QUIT) {
+			return(key);
+		}
+	}
+
+	return(KEY_NONE);
+}
+
+int browseLoop(FILE *imapStream, cacheManagerT *managerPtr, screenT *screenPtr) {
+	struct pollfd pollfd = {0};
+	char keys[KEYS_SIZE];
+	int retVal, len;
+
+	pollfd.fd = STDIN_FILENO;
+	pollfd.events = POLLIN;
+
+	do {
+		updateLayout(); //The previews take the width of the terminal
+		if (isError(retVal = readScreenSize(screenPtr))) {
+			return(retVal);
+		}
+		if (isError(retVal = drawScreen(managerPtr, screenPtr))) {
+			return(retVal);
+		}
+
+		retVal = poll(&pollfd, 1, BROWSE_NOOP_INTERVAL);
+		if (retVal < 0) {
+			if (errno == EINTR) { //The terminal was resized, redraw
+				continue;
+			}
+			return(SYSCALL_ERROR);
+		}
+		else if (retVal > 0) {
+			len = read(STDIN_FILENO, keys, KEYS_SIZE);
+			if (len < 0 && errno == EINTR) {
+				continue;
+			}
+			else if (len <= 0) { //End of input
+				return(KEY_QUIT);
+			}
+			retVal = handleKeys(screenPtr, viewLength(managerPtr->current), keys, len);
+			if (retVal != KEY_NONE) {
+				return(retVal);
+			}
+		}
+		else { //Timeout, so new messages are placed in the list (in the current order) and drawn with the rest
+			if (isError(retVal = checkMailbox(imapStream, managerPtr->current))) {
+				return(retVal);
+			}
+		}
+	} while(1);
+}
+
+int browseMailbox(FILE *imapStream, cacheManagerT *managerPtr) {
+	msgCacheT *cachePtr = managerPtr->current;
+	screenT screen = {0};
+	struct termios rawTerm;
+	int retVal;
+
+	if (!isatty(STDOUT_FILENO) || tcgetattr(STDIN_FILENO, &savedTerm) < 0) {
+		printf("Browsing needs a terminal, try page instead.\n");
+		return(SUCCESS);
+	}
+
+	//Keys are read as they are pressed, without being echoed (Ctrl-C still works)
+	rawTerm = savedTerm;
+	rawTerm.c_lflag &= ~(ICANON | ECHO);
+	rawTerm.c_cc[VMIN] = 1;
+	rawTerm.c_cc[VTIME] = 0;
+	if (isError(retVal = catchExitSignals())) {
+		return(retVal);
+	}
+	if (tcsetattr(STDIN_FILENO, TCSANOW, &rawTerm) < 0) {
+		restoreExitSignals();
+		return(SYSCALL_ERROR);
+	}
+	outStr(&browseBuf, ENTER_SCREEN);
+
+	retVal = browseLoop(imapStream, managerPtr, &screen);
+
+	//Restore the terminal, even after an error
+	outStr(&browseBuf, LEAVE_SCREEN);
+	outFlush(&browseBuf, STDOUT_FILENO);
+	tcsetattr(STDIN_FILENO, TCSANOW, &savedTerm);
+	restoreExitSignals();
+	for (int i = 0 ; screen.rows != NULL && i < screen.height ; i++) {
+		freeOutBuf(&screen.rows[i]);
+	}
+	free(screen.rows);
+
+	if (retVal == KEY_READ) {
+		return(displayMsg(imapStream, cachePtr, viewMsgPos(cachePtr, screen.selected) + 1));
+	}
+	else if (isError(retVal)) {
+		return(retVal);
+	}
+
+	return(SUCCESS);
+}
@@ -1,12 +1,20 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <strings.h>
 #include "parsing.h"
 #include "addresses.h"
 #include "cache.h"
 #include "error.h"
+#include "sort.h"
+#include "search.h"
+#include "bitmap.h"
+#include "flags.h"
+#include "mailbox.h"
+#include "intern.h"
+#include "senders.h"
 
-msgCacheT *cacheInit(void) {
+msgCacheT *cacheInit(char *mailboxName) {
 	msgCacheT *cachePtr;
 
 	cachePtr = malloc(sizeof(msgCacheT));
@@ -14,10 +22,53 @@ msgCacheT *cacheInit(void) {
 		return(NULL);
 	}
 
+	cachePtr->mailboxName = strdup(mailboxName);
+	if (!cachePtr->mailboxName) {
+		free(cachePtr);
+		return(NULL);
+	}
+	cachePtr->uidValidity = cachePtr->uidNext = 0;
+	cachePtr->stash = NULL;
+	cachePtr->stashUids = NULL;
+	cachePtr->stashSize = 0;
+	cachePtr->stashUidValidity = cachePtr->stashUidNext = 0;
+	cachePtr->msgBytes = 0;
+
 	//Set everything to zero
 	cachePtr->msgPtrArray = NULL;
 	cachePtr->cacheSize = cachePtr->prevSize = 0;
 	cachePtr->recent = 0;
+	for (int k = 0 ; k < SORT_KEYS ; k++) {
+		cachePtr->views[k] = NULL;
+	}
+	cachePtr->viewExpunged = NULL;
+	cachePtr->viewExpungedLen = cachePtr->viewExpungedCap = 0;
+	cachePtr->sortKey = SORT_NONE;
+	cachePtr->sortOrder = ASCENDING;
+
+	cachePtr->searchIndex = searchIndexInit();
+	if (!cachePtr->searchIndex) {
+		free(cachePtr->mailboxName);
+		free(cachePtr);
+		return(NULL);
+	}
+
+	cachePtr->flagIndex = flagIndexInit();
+	if (!cachePtr->flagIndex) {
+		freeSearchIndex(cachePtr->searchIndex);
+		free(cachePtr->mailboxName);
+		free(cachePtr);
+		return(NULL);
+	}
+
+	cachePtr->senderIndex = senderIndexInit();
+	if (!cachePtr->senderIndex) {
+		freeFlagIndex(cachePtr->flagIndex);
+		freeSearchIndex(cachePtr->searchIndex);
+		free(cachePtr->mailboxName);
+		free(cachePtr);
+		return(NULL);
+	}
 
 	return(cachePtr);
 }
@@ -38,20 +89,78 @@ int cacheInsert(msgCacheT *cachePtr, msgT *msgPtr, size_t pos) {
 }
 
 
+int cacheFindUid(msgCacheT *cachePtr, unsigned long uid, size_t *posPtr) {
+	size_t low = 0, high = cachePtr->cacheSize, mid, probe;
+	msgT *msgPtr;
+
+	while (low < high) {
+		mid = low + (high - low) / 2;
+
+		//Messages that haven't been fetched yet have no UID, so probe for the next one that has
+		for (probe = mid ; probe < high ; probe++) {
+			msgPtr = cachePtr->msgPtrArray[probe];
+			if (msgPtr != NULL && msgPtr->uid != 0) {
+				break;
+			}
+		}
+		if (probe == high) { //No UIDs in [mid, high), so search the lower half
+			high = mid;
+			continue;
+		}
+
+		if (msgPtr->uid == uid) {
+			*posPtr = probe;
+			return(1);
+		}
+		else if (msgPtr->uid < uid) {
+			low = probe + 1;
+		}
+		else {
+			high = mid;
+		}
+	}
+
+	return(0);
+}
+
+void freeEnvelope(struct envelope *envPtr) {
+	free(envPtr->subject);
+	envPtr->subject = NULL;
+	//freeAddressList is defined in addresses.h
+	freeAddressList(&envPtr->fromList);
+	freeAddressList(&envPtr->toList);
+	freeAddressList(&envPtr->ccList);
+}
+
 void freeMsgData(msgT *msgPtr) {
 	if (!msgPtr) {
 		return;
 	}
-	free(msgPtr->internalDate);
-	free(msgPtr->envelope.subject);
-	//freeAddressList is defined in addresses.h
-	freeAddressList(msgPtr->envelope.fromList);
-	freeAddressList(msgPtr->envelope.toList);
-	freeAddressList(msgPtr->envelope.ccList);
+	senderRemove(msgPtr); //The sender's counts are kept by the sender index of the cache, which outlives the message
+	freeEnvelope(&msgPtr->envelope);
 	free(msgPtr->text);
+	free(msgPtr->boundary);
+	freeAttachments(msgPtr->attachments, msgPtr->attachmentCount);
+	free(msgPtr->preview);
 	free(msgPtr);
 }
 
+//Free a message of the cache, that is no longer counted in the memory it uses
+void freeCachedMsg(msgCacheT *cachePtr, msgT *msgPtr) {
+	if (msgPtr != NULL) {
+		cachePtr->msgBytes -= msgPtr->memUsage;
+	}
+	freeMsgData(msgPtr);
+}
+
+void freeAttachments(attachmentT *attachments, int count) {
+	for (int k = 0 ; k < count ; k++) {
+		free(attachments[k].filename);
+		free(attachments[k].type);
+	}
+	free(attachments);
+}
+
 void freeMsgCache(msgCacheT *cachePtr) {
 	size_t cacheSize;
 	msgT **msgPtrArray;
@@ -70,6 +179,12 @@ void freeMsgCache(msgCacheT *cachePtr) {
 		}
 		free(msgPtrArray);
 	}
+	freeViews(cachePtr);
+	freeSearchIndex(cachePtr->searchIndex);
+	freeStash(cachePtr);
+	freeFlagIndex(cachePtr->flagIndex);
+	freeSenderIndex(cachePtr->senderIndex); //After all messages, which leave their senders when freed
+	free(cachePtr->mailboxName);
 	free(cachePtr);
 }
 
@@ -83,6 +198,7 @@ int cacheResize(msgCacheT *cachePtr, size_t newSize) {
 	}
 
 	if (newSize == 0) { //If the size is to be set to 0, empty the cache array
+		freeViews(cachePtr);
 		free(cachePtr->msgPtrArray);
 		cachePtr->msgPtrArray = NULL;
 		cachePtr->cacheSize = cachePtr->prevSize = 0;
@@ -124,7 +240,12 @@ int cacheRemove(msgCacheT *cachePtr, size_t pos) {
 		return(SUCCESS); 
 	}
 
-	freeMsgData(msgPtrArray[pos]); //Free the message pointer to be deleted
+	//Remove it from the sort views first, as they need its data to find it
+	viewExpunge(cachePtr, pos);
+	if (msgPtrArray[pos] != NULL) {
+		flagIndexRemove(cachePtr->flagIndex, msgPtrArray[pos]->uid);
+	}
+	freeCachedMsg(cachePtr, msgPtrArray[pos]); //Free the message pointer to be deleted
 
 	if (cacheSize == 1) { //If the message to be deleted was the last
 		//Empty cache
@@ -152,4 +273,274 @@ int cacheRemove(msgCacheT *cachePtr, size_t pos) {
 	cachePtr->prevSize = cachePtr->cacheSize -= 1;
 
 	return(SUCCESS);
+}
+
+int cacheStash(msgCacheT *cachePtr) {
+	size_t stashSize = 0;
+	msgT *msgPtr;
+
+	freeStash(cachePtr); //In case a previous SELECT was interrupted
+
+	if (cachePtr->cacheSize > 0) {
+		cachePtr->stash = malloc(cachePtr->cacheSize*sizeof(msgT*));
+		cachePtr->stashUids = malloc(cachePtr->cacheSize*sizeof(unsigned long));
+		if (!cachePtr->stash || !cachePtr->stashUids) {
+			free(cachePtr->stash);
+			free(cachePtr->stashUids);
+			cachePtr->stash = NULL;
+			cachePtr->stashUids = NULL;
+			return(MEM_ERROR);
+		}
+	}
+
+	/* Messages keep their order, so the UIDs stay ascending, messages without
+	  a UID can't be matched to their new position, so they are freed */
+	for (size_t k = 0 ; k < cachePtr->cacheSize ; k++) {
+		msgPtr = cachePtr->msgPtrArray[k];
+		if (msgPtr != NULL && msgPtr->uid != 0) {
+			cachePtr->stash[stashSize] = msgPtr;
+			cachePtr->stashUids[stashSize] = msgPtr->uid;
+			stashSize++;
+		}
+		else {
+			freeCachedMsg(cachePtr, msgPtr);
+		}
+	}
+	cachePtr->stashSize = stashSize;
+	cachePtr->stashUidValidity = cachePtr->uidValidity;
+	cachePtr->stashUidNext = stashSize == cachePtr->cacheSize ? cachePtr->uidNext : 0; //Only if every message was stashed
+
+	//The sort views hold positions, which are about to change
+	freeViews(cachePtr);
+	free(cachePtr->msgPtrArray);
+	cachePtr->msgPtrArray = NULL;
+	cachePtr->cacheSize = cachePtr->prevSize = 0;
+	cachePtr->recent = 0;
+	cachePtr->uidValidity = cachePtr->uidNext = 0;
+
+	return(SUCCESS);
+}
+
+msgT *cacheUnstash(msgCacheT *cachePtr, unsigned long uid) {
+	size_t low = 0, high = cachePtr->stashSize, mid;
+	msgT *msgPtr;
+
+	while (low < high) {
+		mid = low + (high - low) / 2;
+		if (cachePtr->stashUids[mid] == uid) {
+			//Leave the UID in place, so that the binary search keeps working
+			msgPtr = cachePtr->stash[mid];
+			cachePtr->stash[mid] = NULL;
+			return(msgPtr);
+		}
+		else if (cachePtr->stashUids[mid] < uid) {
+			low = mid + 1;
+		}
+		else {
+			high = mid;
+		}
+	}
+
+	return(NULL);
+}
+
+void cacheRestoreStash(msgCacheT *cachePtr) {
+	size_t cacheSize = 0;
+
+	//Free whatever made it into the cache before the failure
+	for (size_t k = 0 ; k < cachePtr->cacheSize ; k++) {
+		if (cachePtr->msgPtrArray[k] != NULL) {
+			flagIndexRemove(cachePtr->flagIndex, cachePtr->msgPtrArray[k]->uid);
+		}
+		freeCachedMsg(cachePtr, cachePtr->msgPtrArray[k]);
+	}
+	free(cachePtr->msgPtrArray);
+	freeViews(cachePtr);
+
+	//The stash array becomes the message pointer array, without the messages taken out of it
+	for (size_t k = 0 ; k < cachePtr->stashSize ; k++) {
+		if (cachePtr->stash[k] != NULL) {
+			cachePtr->stash[cacheSize++] = cachePtr->stash[k];
+		}
+	}
+	cachePtr->msgPtrArray = cachePtr->stash;
+	cachePtr->cacheSize = cachePtr->prevSize = cacheSize;
+	cachePtr->uidValidity = cachePtr->stashUidValidity;
+	if (cacheSize == 0) {
+		free(cachePtr->msgPtrArray);
+		cachePtr->msgPtrArray = NULL;
+	}
+
+	free(cachePtr->stashUids);
+	cachePtr->stash = NULL;
+	cachePtr->stashUids = NULL;
+	cachePtr->stashSize = 0;
+}
+
+void freeStash(msgCacheT *cachePtr) {
+	for (size_t k = 0 ; k < cachePtr->stashSize ; k++) {
+		if (cachePtr->stash[k] != NULL) {
+			flagIndexRemove(cachePtr->flagIndex, cachePtr->stash[k]->uid);
+		}
+		freeCachedMsg(cachePtr, cachePtr->stash[k]);
+	}
+	free(cachePtr->stash);
+	free(cachePtr->stashUids);
+	cachePtr->stash = NULL;
+	cachePtr->stashUids = NULL;
+	cachePtr->stashSize = 0;
+}
+
+//An interned string is shared (check intern.h), so each message is counted for its share of it
+size_t internedMemUsage(char *str) {
+	return(str ? (strlen(str)+1) / internRefs(str) : 0);
+}
+
+size_t addressListMemUsage(addressListT *listPtr) {
+	size_t bytes = listPtr->count * sizeof(addressT);
+
+	for (int k = 0 ; k < listPtr->count ; k++) {
+		bytes += internedMemUsage(listPtr->addrs[k].personalName);
+		bytes += internedMemUsage(listPtr->addrs[k].mailboxName);
+		bytes += internedMemUsage(listPtr->addrs[k].hostName);
+	}
+
+	return(bytes);
+}
+
+size_t msgMemUsage(msgT *msgPtr) {
+	size_t bytes;
+
+	if (!msgPtr) {
+		return(0);
+	}
+
+	bytes = sizeof(msgT);
+	bytes += msgPtr->envelope.subject ? strlen(msgPtr->envelope.subject)+1 : 0;
+	bytes += msgPtr->text ? strlen(msgPtr->text)+1 : 0;
+	bytes += msgPtr->boundary ? strlen(msgPtr->boundary)+1 : 0;
+	bytes += msgPtr->preview ? msgPtr->previewLen : 0;
+	for (int k = 0 ; k < msgPtr->attachmentCount ; k++) {
+		bytes += sizeof(attachmentT) + strlen(msgPtr->attachments[k].type)+1;
+		bytes += msgPtr->attachments[k].filename ? strlen(msgPtr->attachments[k].filename)+1 : 0;
+	}
+	bytes += addressListMemUsage(&msgPtr->envelope.fromList);
+	bytes += addressListMemUsage(&msgPtr->envelope.toList);
+	bytes += addressListMemUsage(&msgPtr->envelope.ccList);
+
+	return(bytes);
+}
+
+void cacheAccount(msgCacheT *cachePtr, msgT *msgPtr) {
+	size_t bytes;
+
+	if (!msgPtr) {
+		return;
+	}
+
+	bytes = msgMemUsage(msgPtr);
+	cachePtr->msgBytes += bytes - msgPtr->memUsage;
+	msgPtr->memUsage = bytes;
+}
+
+size_t cacheMemUsage(msgCacheT *cachePtr) {
+	size_t bytes = sizeof(msgCacheT);
+
+	bytes += cachePtr->cacheSize*sizeof(msgT*);
+	bytes += cachePtr->stashSize*(sizeof(msgT*) + sizeof(unsigned long));
+
+	return(bytes + cachePtr->msgBytes);
+}
+
+cacheManagerT *cacheManagerInit(size_t memBudget) {
+	cacheManagerT *managerPtr;
+
+	managerPtr = malloc(sizeof(cacheManagerT));
+	if (!managerPtr) {
+		return(NULL);
+	}
+
+	managerPtr->cacheArray = NULL;
+	managerPtr->caches = 0;
+	managerPtr->current = NULL;
+	managerPtr->memBudget = memBudget;
+	managerPtr->folderTree = NULL;
+
+	return(managerPtr);
+}
+
+//INBOX is case-insensitive (RFC 3501), the names of all other mailboxes are not
+int sameMailbox(char *name1, char *name2) {
+	if (!strcasecmp(name1, "INBOX")) {
+		return(!strcasecmp(name2, "INBOX"));
+	}
+
+	return(!strcmp(name1, name2));
+}
+
+msgCacheT *cacheManagerSelect(cacheManagerT *managerPtr, char *mailboxName) {
+	msgCacheT **temp, *cachePtr = NULL;
+	size_t pos;
+
+	for (pos = 0 ; pos < managerPtr->caches ; pos++) {
+		if (sameMailbox(managerPtr->cacheArray[pos]->mailboxName, mailboxName)) {
+			cachePtr = managerPtr->cacheArray[pos];
+			break;
+		}
+	}
+
+	if (!cachePtr) { //First time the mailbox is selected
+		temp = realloc(managerPtr->cacheArray, (managerPtr->caches+1)*sizeof(msgCacheT*));
+		if (!temp) {
+			return(NULL);
+		}
+		managerPtr->cacheArray = temp;
+
+		cachePtr = cacheInit(mailboxName);
+		if (!cachePtr) {
+			return(NULL);
+		}
+		pos = managerPtr->caches++;
+	}
+
+	//Move the cache to the end of the array, as it is now the most recently used
+	memmove(managerPtr->cacheArray + pos, managerPtr->cacheArray + pos + 1, (managerPtr->caches - pos - 1)*sizeof(msgCacheT*));
+	managerPtr->cacheArray[managerPtr->caches-1] = cachePtr;
+	managerPtr->current = cachePtr;
+
+	return(cachePtr);
+}
+
+void cacheManagerEvict(cacheManagerT *managerPtr) {
+	size_t total = 0, pos = 0;
+
+	//The usage of each cache is kept as its messages change, so this does not go through them
+	for (size_t k = 0 ; k < managerPtr->caches ; k++) {
+		total += cacheMemUsage(managerPtr->cacheArray[k]);
+	}
+
+	//Free from the least recently used, the current cache is the last one, so it is never freed
+	for (size_t k = 0 ; k < managerPtr->caches ; k++) {
+		if (total > managerPtr->memBudget && managerPtr->cacheArray[k] != managerPtr->current) {
+			total -= cacheMemUsage(managerPtr->cacheArray[k]);
+			freeMsgCache(managerPtr->cacheArray[k]);
+		}
+		else {
+			managerPtr->cacheArray[pos++] = managerPtr->cacheArray[k];
+		}
+	}
+	managerPtr->caches = pos;
+}
+
+void freeCacheManager(cacheManagerT *managerPtr) {
+	if (!managerPtr) {
+		return;
+	}
+
+	for (size_t k = 0 ; k < managerPtr->caches ; k++) {
+		freeMsgCache(managerPtr->cacheArray[k]);
+	}
+	free(managerPtr->cacheArray);
+	freeFolderTree(managerPtr->folderTree);
+	free(managerPtr);
 }
\ No newline at end of file
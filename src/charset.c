@@ -0,0 +1,695 @@
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#ifdef USE_ICONV
+	#include <iconv.h>
+	#include <errno.h>
+#endif
+#include "charset.h"
+
+#define TABLE_CHARSETS 26
+#define MAX_CHARSET_NAME 40
+
+//UTF-8 encoding of U+FFFD (the replacement character), for bytes that can't be converted
+#define REPLACEMENT "\xEF\xBF\xBD"
+#define REPLACEMENT_LEN 3
+
+//The names (and aliases) of the charsets converted without iconv, with the charset each one stands for
+struct charsetName {
+	char *name;
+	int charset; //CHARSET_UTF8, or 1 + the charset's position in charsetTables
+};
+
+static const struct charsetName charsetNames[] = {
+	{"utf-8", CHARSET_UTF8},
+	{"utf8", CHARSET_UTF8},
+	{"us-ascii", CHARSET_UTF8},
+	{"ascii", CHARSET_UTF8},
+	{"iso-8859-1", 1},
+	{"iso-8859-2", 2},
+	{"iso-8859-3", 3},
+	{"iso-8859-4", 4},
+	{"iso-8859-5", 5},
+	{"iso-8859-6", 6},
+	{"iso-8859-7", 7},
+	{"iso-8859-8", 8},
+	{"iso-8859-8-i", 8},
+	{"iso-8859-9", 9},
+	{"iso-8859-10", 10},
+	{"iso-8859-11", 11},
+	{"iso-8859-13", 12},
+	{"iso-8859-14", 13},
+	{"iso-8859-15", 14},
+	{"iso-8859-16", 15},
+	{"windows-1250", 16},
+	{"cp1250", 16},
+	{"windows-1251", 17},
+	{"cp1251", 17},
+	{"windows-1252", 18},
+	{"cp1252", 18},
+	{"windows-1253", 19},
+	{"cp1253", 19},
+	{"windows-1254", 20},
+	{"cp1254", 20},
+	{"windows-1255", 21},
+	{"cp1255", 21},
+	{"windows-1256", 22},
+	{"cp1256", 22},
+	{"windows-1257", 23},
+	{"cp1257", 23},
+	{"windows-1258", 24},
+	{"cp1258", 24},
+	{"koi8-r", 25},
+	{"koi8-u", 26},
+	{"latin1", 1},
+};
+
+/* Every entry has the length of the UTF-8 encoding in its high byte, followed by the
+  encoding's (up to 3) bytes. The tables were generated from the codecs of Python's standard
+  library, bytes a charset leaves undefined are mapped to U+FFFD */
+//The UTF-8 encoding of the bytes 0x80 to 0xFF, for every charset in charsetNames (in the same order)
+static const unsigned int charsetTables[TABLE_CHARSETS][128] = {
+	{ //iso-8859-1
+		0x02C28000, 0x02C28100, 0x02C28200, 0x02C28300, 0x02C28400, 0x02C28500, 0x02C28600, 0x02C28700,
+		0x02C28800, 0x02C28900, 0x02C28A00, 0x02C28B00, 0x02C28C00, 0x02C28D00, 0x02C28E00, 0x02C28F00,
+		0x02C29000, 0x02C29100, 0x02C29200, 0x02C29300, 0x02C29400, 0x02C29500, 0x02C29600, 0x02C29700,
+		0x02C29800, 0x02C29900, 0x02C29A00, 0x02C29B00, 0x02C29C00, 0x02C29D00, 0x02C29E00, 0x02C29F00,
+		0x02C2A000, 0x02C2A100, 0x02C2A200, 0x02C2A300, 0x02C2A400, 0x02C2A500, 0x02C2A600, 0x02C2A700,
+		0x02C2A800, 0x02C2A900, 0x02C2AA00, 0x02C2AB00, 0x02C2AC00, 0x02C2AD00, 0x02C2AE00, 0x02C2AF00,
+		0x02C2B000, 0x02C2B100, 0x02C2B200, 0x02C2B300, 0x02C2B400, 0x02C2B500, 0x02C2B600, 0x02C2B700,
+		0x02C2B800, 0x02C2B900, 0x02C2BA00, 0x02C2BB00, 0x02C2BC00, 0x02C2BD00, 0x02C2BE00, 0x02C2BF00,
+		0x02C38000, 0x02C38100, 0x02C38200, 0x02C38300, 0x02C38400, 0x02C38500, 0x02C38600, 0x02C38700,
+		0x02C38800, 0x02C38900, 0x02C38A00, 0x02C38B00, 0x02C38C00, 0x02C38D00, 0x02C38E00, 0x02C38F00,
+		0x02C39000, 0x02C39100, 0x02C39200, 0x02C39300, 0x02C39400, 0x02C39500, 0x02C39600, 0x02C39700,
+		0x02C39800, 0x02C39900, 0x02C39A00, 0x02C39B00, 0x02C39C00, 0x02C39D00, 0x02C39E00, 0x02C39F00,
+		0x02C3A000, 0x02C3A100, 0x02C3A200, 0x02C3A300, 0x02C3A400, 0x02C3A500, 0x02C3A600, 0x02C3A700,
+		0x02C3A800, 0x02C3A900, 0x02C3AA00, 0x02C3AB00, 0x02C3AC00, 0x02C3AD00, 0x02C3AE00, 0x02C3AF00,
+		0x02C3B000, 0x02C3B100, 0x02C3B200, 0x02C3B300, 0x02C3B400, 0x02C3B500, 0x02C3B600, 0x02C3B700,
+		0x02C3B800, 0x02C3B900, 0x02C3BA00, 0x02C3BB00, 0x02C3BC00, 0x02C3BD00, 0x02C3BE00, 0x02C3BF00,
+	},
+	{ //iso-8859-2
+		0x02C28000, 0x02C28100, 0x02C28200, 0x02C28300, 0x02C28400, 0x02C28500, 0x02C28600, 0x02C28700,
+		0x02C28800, 0x02C28900, 0x02C28A00, 0x02C28B00, 0x02C28C00, 0x02C28D00, 0x02C28E00, 0x02C28F00,
+		0x02C29000, 0x02C29100, 0x02C29200, 0x02C29300, 0x02C29400, 0x02C29500, 0x02C29600, 0x02C29700,
+		0x02C29800, 0x02C29900, 0x02C29A00, 0x02C29B00, 0x02C29C00, 0x02C29D00, 0x02C29E00, 0x02C29F00,
+		0x02C2A000, 0x02C48400, 0x02CB9800, 0x02C58100, 0x02C2A400, 0x02C4BD00, 0x02C59A00, 0x02C2A700,
+		0x02C2A800, 0x02C5A000, 0x02C59E00, 0x02C5A400, 0x02C5B900, 0x02C2AD00, 0x02C5BD00, 0x02C5BB00,
+		0x02C2B000, 0x02C48500, 0x02CB9B00, 0x02C58200, 0x02C2B400, 0x02C4BE00, 0x02C59B00, 0x02CB8700,
+		0x02C2B800, 0x02C5A100, 0x02C59F00, 0x02C5A500, 0x02C5BA00, 0x02CB9D00, 0x02C5BE00, 0x02C5BC00,
+		0x02C59400, 0x02C38100, 0x02C38200, 0x02C48200, 0x02C38400, 0x02C4B900, 0x02C48600, 0x02C38700,
+		0x02C48C00, 0x02C38900, 0x02C49800, 0x02C38B00, 0x02C49A00, 0x02C38D00, 0x02C38E00, 0x02C48E00,
+		0x02C49000, 0x02C58300, 0x02C58700, 0x02C39300, 0x02C39400, 0x02C59000, 0x02C39600, 0x02C39700,
+		0x02C59800, 0x02C5AE00, 0x02C39A00, 0x02C5B000, 0x02C39C00, 0x02C39D00, 0x02C5A200, 0x02C39F00,
+		0x02C59500, 0x02C3A100, 0x02C3A200, 0x02C48300, 0x02C3A400, 0x02C4BA00, 0x02C48700, 0x02C3A700,
+		0x02C48D00, 0x02C3A900, 0x02C49900, 0x02C3AB00, 0x02C49B00, 0x02C3AD00, 0x02C3AE00, 0x02C48F00,
+		0x02C49100, 0x02C58400, 0x02C58800, 0x02C3B300, 0x02C3B400, 0x02C59100, 0x02C3B600, 0x02C3B700,
+		0x02C59900, 0x02C5AF00, 0x02C3BA00, 0x02C5B100, 0x02C3BC00, 0x02C3BD00, 0x02C5A300, 0x02CB9900,
+	},
+	{ //iso-8859-3
+		0x02C28000, 0x02C28100, 0x02C28200, 0x02C28300, 0x02C28400, 0x02C28500, 0x02C28600, 0x02C28700,
+		0x02C28800, 0x02C28900, 0x02C28A00, 0x02C28B00, 0x02C28C00, 0x02C28D00, 0x02C28E00, 0x02C28F00,
+		0x02C29000, 0x02C29100, 0x02C29200, 0x02C29300, 0x02C29400, 0x02C29500, 0x02C29600, 0x02C29700,
+		0x02C29800, 0x02C29900, 0x02C29A00, 0x02C29B00, 0x02C29C00, 0x02C29D00, 0x02C29E00, 0x02C29F00,
+		0x02C2A000, 0x02C4A600, 0x02CB9800, 0x02C2A300, 0x02C2A400, 0x03EFBFBD, 0x02C4A400, 0x02C2A700,
+		0x02C2A800, 0x02C4B000, 0x02C59E00, 0x02C49E00, 0x02C4B400, 0x02C2AD00, 0x03EFBFBD, 0x02C5BB00,
+		0x02C2B000, 0x02C4A700, 0x02C2B200, 0x02C2B300, 0x02C2B400, 0x02C2B500, 0x02C4A500, 0x02C2B700,
+		0x02C2B800, 0x02C4B100, 0x02C59F00, 0x02C49F00, 0x02C4B500, 0x02C2BD00, 0x03EFBFBD, 0x02C5BC00,
+		0x02C38000, 0x02C38100, 0x02C38200, 0x03EFBFBD, 0x02C38400, 0x02C48A00, 0x02C48800, 0x02C38700,
+		0x02C38800, 0x02C38900, 0x02C38A00, 0x02C38B00, 0x02C38C00, 0x02C38D00, 0x02C38E00, 0x02C38F00,
+		0x03EFBFBD, 0x02C39100, 0x02C39200, 0x02C39300, 0x02C39400, 0x02C4A000, 0x02C39600, 0x02C39700,
+		0x02C49C00, 0x02C39900, 0x02C39A00, 0x02C39B00, 0x02C39C00, 0x02C5AC00, 0x02C59C00, 0x02C39F00,
+		0x02C3A000, 0x02C3A100, 0x02C3A200, 0x03EFBFBD, 0x02C3A400, 0x02C48B00, 0x02C48900, 0x02C3A700,
+		0x02C3A800, 0x02C3A900, 0x02C3AA00, 0x02C3AB00, 0x02C3AC00, 0x02C3AD00, 0x02C3AE00, 0x02C3AF00,
+		0x03EFBFBD, 0x02C3B100, 0x02C3B200, 0x02C3B300, 0x02C3B400, 0x02C4A100, 0x02C3B600, 0x02C3B700,
+		0x02C49D00, 0x02C3B900, 0x02C3BA00, 0x02C3BB00, 0x02C3BC00, 0x02C5AD00, 0x02C59D00, 0x02CB9900,
+	},
+	{ //iso-8859-4
+		0x02C28000, 0x02C28100, 0x02C28200, 0x02C28300, 0x02C28400, 0x02C28500, 0x02C28600, 0x02C28700,
+		0x02C28800, 0x02C28900, 0x02C28A00, 0x02C28B00, 0x02C28C00, 0x02C28D00, 0x02C28E00, 0x02C28F00,
+		0x02C29000, 0x02C29100, 0x02C29200, 0x02C29300, 0x02C29400, 0x02C29500, 0x02C29600, 0x02C29700,
+		0x02C29800, 0x02C29900, 0x02C29A00, 0x02C29B00, 0x02C29C00, 0x02C29D00, 0x02C29E00, 0x02C29F00,
+		0x02C2A000, 0x02C48400, 0x02C4B800, 0x02C59600, 0x02C2A400, 0x02C4A800, 0x02C4BB00, 0x02C2A700,
+		0x02C2A800, 0x02C5A000, 0x02C49200, 0x02C4A200, 0x02C5A600, 0x02C2AD00, 0x02C5BD00, 0x02C2AF00,
+		0x02C2B000, 0x02C48500, 0x02CB9B00, 0x02C59700, 0x02C2B400, 0x02C4A900, 0x02C4BC00, 0x02CB8700,
+		0x02C2B800, 0x02C5A100, 0x02C49300, 0x02C4A300, 0x02C5A700, 0x02C58A00, 0x02C5BE00, 0x02C58B00,
+		0x02C48000, 0x02C38100, 0x02C38200, 0x02C38300, 0x02C38400, 0x02C38500, 0x02C38600, 0x02C4AE00,
+		0x02C48C00, 0x02C38900, 0x02C49800, 0x02C38B00, 0x02C49600, 0x02C38D00, 0x02C38E00, 0x02C4AA00,
+		0x02C49000, 0x02C58500, 0x02C58C00, 0x02C4B600, 0x02C39400, 0x02C39500, 0x02C39600, 0x02C39700,
+		0x02C39800, 0x02C5B200, 0x02C39A00, 0x02C39B00, 0x02C39C00, 0x02C5A800, 0x02C5AA00, 0x02C39F00,
+		0x02C48100, 0x02C3A100, 0x02C3A200, 0x02C3A300, 0x02C3A400, 0x02C3A500, 0x02C3A600, 0x02C4AF00,
+		0x02C48D00, 0x02C3A900, 0x02C49900, 0x02C3AB00, 0x02C49700, 0x02C3AD00, 0x02C3AE00, 0x02C4AB00,
+		0x02C49100, 0x02C58600, 0x02C58D00, 0x02C4B700, 0x02C3B400, 0x02C3B500, 0x02C3B600, 0x02C3B700,
+		0x02C3B800, 0x02C5B300, 0x02C3BA00, 0x02C3BB00, 0x02C3BC00, 0x02C5A900, 0x02C5AB00, 0x02CB9900,
+	},
+	{ //iso-8859-5
+		0x02C28000, 0x02C28100, 0x02C28200, 0x02C28300, 0x02C28400, 0x02C28500, 0x02C28600, 0x02C28700,
+		0x02C28800, 0x02C28900, 0x02C28A00, 0x02C28B00, 0x02C28C00, 0x02C28D00, 0x02C28E00, 0x02C28F00,
+		0x02C29000, 0x02C29100, 0x02C29200, 0x02C29300, 0x02C29400, 0x02C29500, 0x02C29600, 0x02C29700,
+		0x02C29800, 0x02C29900, 0x02C29A00, 0x02C29B00, 0x02C29C00, 0x02C29D00, 0x02C29E00, 0x02C29F00,
+		0x02C2A000, 0x02D08100, 0x02D08200, 0x02D08300, 0x02D08400, 0x02D08500, 0x02D08600, 0x02D08700,
+		0x02D08800, 0x02D08900, 0x02D08A00, 0x02D08B00, 0x02D08C00, 0x02C2AD00, 0x02D08E00, 0x02D08F00,
+		0x02D09000, 0x02D09100, 0x02D09200, 0x02D09300, 0x02D09400, 0x02D09500, 0x02D09600, 0x02D09700,
+		0x02D09800, 0x02D09900, 0x02D09A00, 0x02D09B00, 0x02D09C00, 0x02D09D00, 0x02D09E00, 0x02D09F00,
+		0x02D0A000, 0x02D0A100, 0x02D0A200, 0x02D0A300, 0x02D0A400, 0x02D0A500, 0x02D0A600, 0x02D0A700,
+		0x02D0A800, 0x02D0A900, 0x02D0AA00, 0x02D0AB00, 0x02D0AC00, 0x02D0AD00, 0x02D0AE00, 0x02D0AF00,
+		0x02D0B000, 0x02D0B100, 0x02D0B200, 0x02D0B300, 0x02D0B400, 0x02D0B500, 0x02D0B600, 0x02D0B700,
+		0x02D0B800, 0x02D0B900, 0x02D0BA00, 0x02D0BB00, 0x02D0BC00, 0x02D0BD00, 0x02D0BE00, 0x02D0BF00,
+		0x02D18000, 0x02D18100, 0x02D18200, 0x02D18300, 0x02D18400, 0x02D18500, 0x02D18600, 0x02D18700,
+		0x02D18800, 0x02D18900, 0x02D18A00, 0x02D18B00, 0x02D18C00, 0x02D18D00, 0x02D18E00, 0x02D18F00,
+		0x03E28496, 0x02D19100, 0x02D19200, 0x02D19300, 0x02D19400, 0x02D19500, 0x02D19600, 0x02D19700,
+		0x02D19800, 0x02D19900, 0x02D19A00, 0x02D19B00, 0x02D19C00, 0x02C2A700, 0x02D19E00, 0x02D19F00,
+	},
+	{ //iso-8859-6
+		0x02C28000, 0x02C28100, 0x02C28200, 0x02C28300, 0x02C28400, 0x02C28500, 0x02C28600, 0x02C28700,
+		0x02C28800, 0x02C28900, 0x02C28A00, 0x02C28B00, 0x02C28C00, 0x02C28D00, 0x02C28E00, 0x02C28F00,
+		0x02C29000, 0x02C29100, 0x02C29200, 0x02C29300, 0x02C29400, 0x02C29500, 0x02C29600, 0x02C29700,
+		0x02C29800, 0x02C29900, 0x02C29A00, 0x02C29B00, 0x02C29C00, 0x02C29D00, 0x02C29E00, 0x02C29F00,
+		0x02C2A000, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x02C2A400, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD,
+		0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x02D88C00, 0x02C2AD00, 0x03EFBFBD, 0x03EFBFBD,
+		0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD,
+		0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x02D89B00, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x02D89F00,
+		0x03EFBFBD, 0x02D8A100, 0x02D8A200, 0x02D8A300, 0x02D8A400, 0x02D8A500, 0x02D8A600, 0x02D8A700,
+		0x02D8A800, 0x02D8A900, 0x02D8AA00, 0x02D8AB00, 0x02D8AC00, 0x02D8AD00, 0x02D8AE00, 0x02D8AF00,
+		0x02D8B000, 0x02D8B100, 0x02D8B200, 0x02D8B300, 0x02D8B400, 0x02D8B500, 0x02D8B600, 0x02D8B700,
+		0x02D8B800, 0x02D8B900, 0x02D8BA00, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD,
+		0x02D98000, 0x02D98100, 0x02D98200, 0x02D98300, 0x02D98400, 0x02D98500, 0x02D98600, 0x02D98700,
+		0x02D98800, 0x02D98900, 0x02D98A00, 0x02D98B00, 0x02D98C00, 0x02D98D00, 0x02D98E00, 0x02D98F00,
+		0x02D99000, 0x02D99100, 0x02D99200, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD,
+		0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD,
+	},
+	{ //iso-8859-7
+		0x02C28000, 0x02C28100, 0x02C28200, 0x02C28300, 0x02C28400, 0x02C28500, 0x02C28600, 0x02C28700,
+		0x02C28800, 0x02C28900, 0x02C28A00, 0x02C28B00, 0x02C28C00, 0x02C28D00, 0x02C28E00, 0x02C28F00,
+		0x02C29000, 0x02C29100, 0x02C29200, 0x02C29300, 0x02C29400, 0x02C29500, 0x02C29600, 0x02C29700,
+		0x02C29800, 0x02C29900, 0x02C29A00, 0x02C29B00, 0x02C29C00, 0x02C29D00, 0x02C29E00, 0x02C29F00,
+		0x02C2A000, 0x03E28098, 0x03E28099, 0x02C2A300, 0x03E282AC, 0x03E282AF, 0x02C2A600, 0x02C2A700,
+		0x02C2A800, 0x02C2A900, 0x02CDBA00, 0x02C2AB00, 0x02C2AC00, 0x02C2AD00, 0x03EFBFBD, 0x03E28095,
+		0x02C2B000, 0x02C2B100, 0x02C2B200, 0x02C2B300, 0x02CE8400, 0x02CE8500, 0x02CE8600, 0x02C2B700,
+		0x02CE8800, 0x02CE8900, 0x02CE8A00, 0x02C2BB00, 0x02CE8C00, 0x02C2BD00, 0x02CE8E00, 0x02CE8F00,
+		0x02CE9000, 0x02CE9100, 0x02CE9200, 0x02CE9300, 0x02CE9400, 0x02CE9500, 0x02CE9600, 0x02CE9700,
+		0x02CE9800, 0x02CE9900, 0x02CE9A00, 0x02CE9B00, 0x02CE9C00, 0x02CE9D00, 0x02CE9E00, 0x02CE9F00,
+		0x02CEA000, 0x02CEA100, 0x03EFBFBD, 0x02CEA300, 0x02CEA400, 0x02CEA500, 0x02CEA600, 0x02CEA700,
+		0x02CEA800, 0x02CEA900, 0x02CEAA00, 0x02CEAB00, 0x02CEAC00, 0x02CEAD00, 0x02CEAE00, 0x02CEAF00,
+		0x02CEB000, 0x02CEB100, 0x02CEB200, 0x02CEB300, 0x02CEB400, 0x02CEB500, 0x02CEB600, 0x02CEB700,
+		0x02CEB800, 0x02CEB900, 0x02CEBA00, 0x02CEBB00, 0x02CEBC00, 0x02CEBD00, 0x02CEBE00, 0x02CEBF00,
+		0x02CF8000, 0x02CF8100, 0x02CF8200, 0x02CF8300, 0x02CF8400, 0x02CF8500, 0x02CF8600, 0x02CF8700,
+		0x02CF8800, 0x02CF8900, 0x02CF8A00, 0x02CF8B00, 0x02CF8C00, 0x02CF8D00, 0x02CF8E00, 0x03EFBFBD,
+	},
+	{ //iso-8859-8
+		0x02C28000, 0x02C28100, 0x02C28200, 0x02C28300, 0x02C28400, 0x02C28500, 0x02C28600, 0x02C28700,
+		0x02C28800, 0x02C28900, 0x02C28A00, 0x02C28B00, 0x02C28C00, 0x02C28D00, 0x02C28E00, 0x02C28F00,
+		0x02C29000, 0x02C29100, 0x02C29200, 0x02C29300, 0x02C29400, 0x02C29500, 0x02C29600, 0x02C29700,
+		0x02C29800, 0x02C29900, 0x02C29A00, 0x02C29B00, 0x02C29C00, 0x02C29D00, 0x02C29E00, 0x02C29F00,
+		0x02C2A000, 0x03EFBFBD, 0x02C2A200, 0x02C2A300, 0x02C2A400, 0x02C2A500, 0x02C2A600, 0x02C2A700,
+		0x02C2A800, 0x02C2A900, 0x02C39700, 0x02C2AB00, 0x02C2AC00, 0x02C2AD00, 0x02C2AE00, 0x02C2AF00,
+		0x02C2B000, 0x02C2B100, 0x02C2B200, 0x02C2B300, 0x02C2B400, 0x02C2B500, 0x02C2B600, 0x02C2B700,
+		0x02C2B800, 0x02C2B900, 0x02C3B700, 0x02C2BB00, 0x02C2BC00, 0x02C2BD00, 0x02C2BE00, 0x03EFBFBD,
+		0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD,
+		0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD,
+		0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD,
+		0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03E28097,
+		0x02D79000, 0x02D79100, 0x02D79200, 0x02D79300, 0x02D79400, 0x02D79500, 0x02D79600, 0x02D79700,
+		0x02D79800, 0x02D79900, 0x02D79A00, 0x02D79B00, 0x02D79C00, 0x02D79D00, 0x02D79E00, 0x02D79F00,
+		0x02D7A000, 0x02D7A100, 0x02D7A200, 0x02D7A300, 0x02D7A400, 0x02D7A500, 0x02D7A600, 0x02D7A700,
+		0x02D7A800, 0x02D7A900, 0x02D7AA00, 0x03EFBFBD, 0x03EFBFBD, 0x03E2808E, 0x03E2808F, 0x03EFBFBD,
+	},
+	{ //iso-8859-9
+		0x02C28000, 0x02C28100, 0x02C28200, 0x02C28300, 0x02C28400, 0x02C28500, 0x02C28600, 0x02C28700,
+		0x02C28800, 0x02C28900, 0x02C28A00, 0x02C28B00, 0x02C28C00, 0x02C28D00, 0x02C28E00, 0x02C28F00,
+		0x02C29000, 0x02C29100, 0x02C29200, 0x02C29300, 0x02C29400, 0x02C29500, 0x02C29600, 0x02C29700,
+		0x02C29800, 0x02C29900, 0x02C29A00, 0x02C29B00, 0x02C29C00, 0x02C29D00, 0x02C29E00, 0x02C29F00,
+		0x02C2A000, 0x02C2A100, 0x02C2A200, 0x02C2A300, 0x02C2A400, 0x02C2A500, 0x02C2A600, 0x02C2A700,
+		0x02C2A800, 0x02C2A900, 0x02C2AA00, 0x02C2AB00, 0x02C2AC00, 0x02C2AD00, 0x02C2AE00, 0x02C2AF00,
+		0x02C2B000, 0x02C2B100, 0x02C2B200, 0x02C2B300, 0x02C2B400, 0x02C2B500, 0x02C2B600, 0x02C2B700,
+		0x02C2B800, 0x02C2B900, 0x02C2BA00, 0x02C2BB00, 0x02C2BC00, 0x02C2BD00, 0x02C2BE00, 0x02C2BF00,
+		0x02C38000, 0x02C38100, 0x02C38200, 0x02C38300, 0x02C38400, 0x02C38500, 0x02C38600, 0x02C38700,
+		0x02C38800, 0x02C38900, 0x02C38A00, 0x02C38B00, 0x02C38C00, 0x02C38D00, 0x02C38E00, 0x02C38F00,
+		0x02C49E00, 0x02C39100, 0x02C39200, 0x02C39300, 0x02C39400, 0x02C39500, 0x02C39600, 0x02C39700,
+		0x02C39800, 0x02C39900, 0x02C39A00, 0x02C39B00, 0x02C39C00, 0x02C4B000, 0x02C59E00, 0x02C39F00,
+		0x02C3A000, 0x02C3A100, 0x02C3A200, 0x02C3A300, 0x02C3A400, 0x02C3A500, 0x02C3A600, 0x02C3A700,
+		0x02C3A800, 0x02C3A900, 0x02C3AA00, 0x02C3AB00, 0x02C3AC00, 0x02C3AD00, 0x02C3AE00, 0x02C3AF00,
+		0x02C49F00, 0x02C3B100, 0x02C3B200, 0x02C3B300, 0x02C3B400, 0x02C3B500, 0x02C3B600, 0x02C3B700,
+		0x02C3B800, 0x02C3B900, 0x02C3BA00, 0x02C3BB00, 0x02C3BC00, 0x02C4B100, 0x02C59F00, 0x02C3BF00,
+	},
+	{ //iso-8859-10
+		0x02C28000, 0x02C28100, 0x02C28200, 0x02C28300, 0x02C28400, 0x02C28500, 0x02C28600, 0x02C28700,
+		0x02C28800, 0x02C28900, 0x02C28A00, 0x02C28B00, 0x02C28C00, 0x02C28D00, 0x02C28E00, 0x02C28F00,
+		0x02C29000, 0x02C29100, 0x02C29200, 0x02C29300, 0x02C29400, 0x02C29500, 0x02C29600, 0x02C29700,
+		0x02C29800, 0x02C29900, 0x02C29A00, 0x02C29B00, 0x02C29C00, 0x02C29D00, 0x02C29E00, 0x02C29F00,
+		0x02C2A000, 0x02C48400, 0x02C49200, 0x02C4A200, 0x02C4AA00, 0x02C4A800, 0x02C4B600, 0x02C2A700,
+		0x02C4BB00, 0x02C49000, 0x02C5A000, 0x02C5A600, 0x02C5BD00, 0x02C2AD00, 0x02C5AA00, 0x02C58A00,
+		0x02C2B000, 0x02C48500, 0x02C49300, 0x02C4A300, 0x02C4AB00, 0x02C4A900, 0x02C4B700, 0x02C2B700,
+		0x02C4BC00, 0x02C49100, 0x02C5A100, 0x02C5A700, 0x02C5BE00, 0x03E28095, 0x02C5AB00, 0x02C58B00,
+		0x02C48000, 0x02C38100, 0x02C38200, 0x02C38300, 0x02C38400, 0x02C38500, 0x02C38600, 0x02C4AE00,
+		0x02C48C00, 0x02C38900, 0x02C49800, 0x02C38B00, 0x02C49600, 0x02C38D00, 0x02C38E00, 0x02C38F00,
+		0x02C39000, 0x02C58500, 0x02C58C00, 0x02C39300, 0x02C39400, 0x02C39500, 0x02C39600, 0x02C5A800,
+		0x02C39800, 0x02C5B200, 0x02C39A00, 0x02C39B00, 0x02C39C00, 0x02C39D00, 0x02C39E00, 0x02C39F00,
+		0x02C48100, 0x02C3A100, 0x02C3A200, 0x02C3A300, 0x02C3A400, 0x02C3A500, 0x02C3A600, 0x02C4AF00,
+		0x02C48D00, 0x02C3A900, 0x02C49900, 0x02C3AB00, 0x02C49700, 0x02C3AD00, 0x02C3AE00, 0x02C3AF00,
+		0x02C3B000, 0x02C58600, 0x02C58D00, 0x02C3B300, 0x02C3B400, 0x02C3B500, 0x02C3B600, 0x02C5A900,
+		0x02C3B800, 0x02C5B300, 0x02C3BA00, 0x02C3BB00, 0x02C3BC00, 0x02C3BD00, 0x02C3BE00, 0x02C4B800,
+	},
+	{ //iso-8859-11
+		0x02C28000, 0x02C28100, 0x02C28200, 0x02C28300, 0x02C28400, 0x02C28500, 0x02C28600, 0x02C28700,
+		0x02C28800, 0x02C28900, 0x02C28A00, 0x02C28B00, 0x02C28C00, 0x02C28D00, 0x02C28E00, 0x02C28F00,
+		0x02C29000, 0x02C29100, 0x02C29200, 0x02C29300, 0x02C29400, 0x02C29500, 0x02C29600, 0x02C29700,
+		0x02C29800, 0x02C29900, 0x02C29A00, 0x02C29B00, 0x02C29C00, 0x02C29D00, 0x02C29E00, 0x02C29F00,
+		0x02C2A000, 0x03E0B881, 0x03E0B882, 0x03E0B883, 0x03E0B884, 0x03E0B885, 0x03E0B886, 0x03E0B887,
+		0x03E0B888, 0x03E0B889, 0x03E0B88A, 0x03E0B88B, 0x03E0B88C, 0x03E0B88D, 0x03E0B88E, 0x03E0B88F,
+		0x03E0B890, 0x03E0B891, 0x03E0B892, 0x03E0B893, 0x03E0B894, 0x03E0B895, 0x03E0B896, 0x03E0B897,
+		0x03E0B898, 0x03E0B899, 0x03E0B89A, 0x03E0B89B, 0x03E0B89C, 0x03E0B89D, 0x03E0B89E, 0x03E0B89F,
+		0x03E0B8A0, 0x03E0B8A1, 0x03E0B8A2, 0x03E0B8A3, 0x03E0B8A4, 0x03E0B8A5, 0x03E0B8A6, 0x03E0B8A7,
+		0x03E0B8A8, 0x03E0B8A9, 0x03E0B8AA, 0x03E0B8AB, 0x03E0B8AC, 0x03E0B8AD, 0x03E0B8AE, 0x03E0B8AF,
+		0x03E0B8B0, 0x03E0B8B1, 0x03E0B8B2, 0x03E0B8B3, 0x03E0B8B4, 0x03E0B8B5, 0x03E0B8B6, 0x03E0B8B7,
+		0x03E0B8B8, 0x03E0B8B9, 0x03E0B8BA, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03E0B8BF,
+		0x03E0B980, 0x03E0B981, 0x03E0B982, 0x03E0B983, 0x03E0B984, 0x03E0B985, 0x03E0B986, 0x03E0B987,
+		0x03E0B988, 0x03E0B989, 0x03E0B98A, 0x03E0B98B, 0x03E0B98C, 0x03E0B98D, 0x03E0B98E, 0x03E0B98F,
+		0x03E0B990, 0x03E0B991, 0x03E0B992, 0x03E0B993, 0x03E0B994, 0x03E0B995, 0x03E0B996, 0x03E0B997,
+		0x03E0B998, 0x03E0B999, 0x03E0B99A, 0x03E0B99B, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD,
+	},
+	{ //iso-8859-13
+		0x02C28000, 0x02C28100, 0x02C28200, 0x02C28300, 0x02C28400, 0x02C28500, 0x02C28600, 0x02C28700,
+		0x02C28800, 0x02C28900, 0x02C28A00, 0x02C28B00, 0x02C28C00, 0x02C28D00, 0x02C28E00, 0x02C28F00,
+		0x02C29000, 0x02C29100, 0x02C29200, 0x02C29300, 0x02C29400, 0x02C29500, 0x02C29600, 0x02C29700,
+		0x02C29800, 0x02C29900, 0x02C29A00, 0x02C29B00, 0x02C29C00, 0x02C29D00, 0x02C29E00, 0x02C29F00,
+		0x02C2A000, 0x03E2809D, 0x02C2A200, 0x02C2A300, 0x02C2A400, 0x03E2809E, 0x02C2A600, 0x02C2A700,
+		0x02C39800, 0x02C2A900, 0x02C59600, 0x02C2AB00, 0x02C2AC00, 0x02C2AD00, 0x02C2AE00, 0x02C38600,
+		0x02C2B000, 0x02C2B100, 0x02C2B200, 0x02C2B300, 0x03E2809C, 0x02C2B500, 0x02C2B600, 0x02C2B700,
+		0x02C3B800, 0x02C2B900, 0x02C59700, 0x02C2BB00, 0x02C2BC00, 0x02C2BD00, 0x02C2BE00, 0x02C3A600,
+		0x02C48400, 0x02C4AE00, 0x02C48000, 0x02C48600, 0x02C38400, 0x02C38500, 0x02C49800, 0x02C49200,
+		0x02C48C00, 0x02C38900, 0x02C5B900, 0x02C49600, 0x02C4A200, 0x02C4B600, 0x02C4AA00, 0x02C4BB00,
+		0x02C5A000, 0x02C58300, 0x02C58500, 0x02C39300, 0x02C58C00, 0x02C39500, 0x02C39600, 0x02C39700,
+		0x02C5B200, 0x02C58100, 0x02C59A00, 0x02C5AA00, 0x02C39C00, 0x02C5BB00, 0x02C5BD00, 0x02C39F00,
+		0x02C48500, 0x02C4AF00, 0x02C48100, 0x02C48700, 0x02C3A400, 0x02C3A500, 0x02C49900, 0x02C49300,
+		0x02C48D00, 0x02C3A900, 0x02C5BA00, 0x02C49700, 0x02C4A300, 0x02C4B700, 0x02C4AB00, 0x02C4BC00,
+		0x02C5A100, 0x02C58400, 0x02C58600, 0x02C3B300, 0x02C58D00, 0x02C3B500, 0x02C3B600, 0x02C3B700,
+		0x02C5B300, 0x02C58200, 0x02C59B00, 0x02C5AB00, 0x02C3BC00, 0x02C5BC00, 0x02C5BE00, 0x03E28099,
+	},
+	{ //iso-8859-14
+		0x02C28000, 0x02C28100, 0x02C28200, 0x02C28300, 0x02C28400, 0x02C28500, 0x02C28600, 0x02C28700,
+		0x02C28800, 0x02C28900, 0x02C28A00, 0x02C28B00, 0x02C28C00, 0x02C28D00, 0x02C28E00, 0x02C28F00,
+		0x02C29000, 0x02C29100, 0x02C29200, 0x02C29300, 0x02C29400, 0x02C29500, 0x02C29600, 0x02C29700,
+		0x02C29800, 0x02C29900, 0x02C29A00, 0x02C29B00, 0x02C29C00, 0x02C29D00, 0x02C29E00, 0x02C29F00,
+		0x02C2A000, 0x03E1B882, 0x03E1B883, 0x02C2A300, 0x02C48A00, 0x02C48B00, 0x03E1B88A, 0x02C2A700,
+		0x03E1BA80, 0x02C2A900, 0x03E1BA82, 0x03E1B88B, 0x03E1BBB2, 0x02C2AD00, 0x02C2AE00, 0x02C5B800,
+		0x03E1B89E, 0x03E1B89F, 0x02C4A000, 0x02C4A100, 0x03E1B980, 0x03E1B981, 0x02C2B600, 0x03E1B996,
+		0x03E1BA81, 0x03E1B997, 0x03E1BA83, 0x03E1B9A0, 0x03E1BBB3, 0x03E1BA84, 0x03E1BA85, 0x03E1B9A1,
+		0x02C38000, 0x02C38100, 0x02C38200, 0x02C38300, 0x02C38400, 0x02C38500, 0x02C38600, 0x02C38700,
+		0x02C38800, 0x02C38900, 0x02C38A00, 0x02C38B00, 0x02C38C00, 0x02C38D00, 0x02C38E00, 0x02C38F00,
+		0x02C5B400, 0x02C39100, 0x02C39200, 0x02C39300, 0x02C39400, 0x02C39500, 0x02C39600, 0x03E1B9AA,
+		0x02C39800, 0x02C39900, 0x02C39A00, 0x02C39B00, 0x02C39C00, 0x02C39D00, 0x02C5B600, 0x02C39F00,
+		0x02C3A000, 0x02C3A100, 0x02C3A200, 0x02C3A300, 0x02C3A400, 0x02C3A500, 0x02C3A600, 0x02C3A700,
+		0x02C3A800, 0x02C3A900, 0x02C3AA00, 0x02C3AB00, 0x02C3AC00, 0x02C3AD00, 0x02C3AE00, 0x02C3AF00,
+		0x02C5B500, 0x02C3B100, 0x02C3B200, 0x02C3B300, 0x02C3B400, 0x02C3B500, 0x02C3B600, 0x03E1B9AB,
+		0x02C3B800, 0x02C3B900, 0x02C3BA00, 0x02C3BB00, 0x02C3BC00, 0x02C3BD00, 0x02C5B700, 0x02C3BF00,
+	},
+	{ //iso-8859-15
+		0x02C28000, 0x02C28100, 0x02C28200, 0x02C28300, 0x02C28400, 0x02C28500, 0x02C28600, 0x02C28700,
+		0x02C28800, 0x02C28900, 0x02C28A00, 0x02C28B00, 0x02C28C00, 0x02C28D00, 0x02C28E00, 0x02C28F00,
+		0x02C29000, 0x02C29100, 0x02C29200, 0x02C29300, 0x02C29400, 0x02C29500, 0x02C29600, 0x02C29700,
+		0x02C29800, 0x02C29900, 0x02C29A00, 0x02C29B00, 0x02C29C00, 0x02C29D00, 0x02C29E00, 0x02C29F00,
+		0x02C2A000, 0x02C2A100, 0x02C2A200, 0x02C2A300, 0x03E282AC, 0x02C2A500, 0x02C5A000, 0x02C2A700,
+		0x02C5A100, 0x02C2A900, 0x02C2AA00, 0x02C2AB00, 0x02C2AC00, 0x02C2AD00, 0x02C2AE00, 0x02C2AF00,
+		0x02C2B000, 0x02C2B100, 0x02C2B200, 0x02C2B300, 0x02C5BD00, 0x02C2B500, 0x02C2B600, 0x02C2B700,
+		0x02C5BE00, 0x02C2B900, 0x02C2BA00, 0x02C2BB00, 0x02C59200, 0x02C59300, 0x02C5B800, 0x02C2BF00,
+		0x02C38000, 0x02C38100, 0x02C38200, 0x02C38300, 0x02C38400, 0x02C38500, 0x02C38600, 0x02C38700,
+		0x02C38800, 0x02C38900, 0x02C38A00, 0x02C38B00, 0x02C38C00, 0x02C38D00, 0x02C38E00, 0x02C38F00,
+		0x02C39000, 0x02C39100, 0x02C39200, 0x02C39300, 0x02C39400, 0x02C39500, 0x02C39600, 0x02C39700,
+		0x02C39800, 0x02C39900, 0x02C39A00, 0x02C39B00, 0x02C39C00, 0x02C39D00, 0x02C39E00, 0x02C39F00,
+		0x02C3A000, 0x02C3A100, 0x02C3A200, 0x02C3A300, 0x02C3A400, 0x02C3A500, 0x02C3A600, 0x02C3A700,
+		0x02C3A800, 0x02C3A900, 0x02C3AA00, 0x02C3AB00, 0x02C3AC00, 0x02C3AD00, 0x02C3AE00, 0x02C3AF00,
+		0x02C3B000, 0x02C3B100, 0x02C3B200, 0x02C3B300, 0x02C3B400, 0x02C3B500, 0x02C3B600, 0x02C3B700,
+		0x02C3B800, 0x02C3B900, 0x02C3BA00, 0x02C3BB00, 0x02C3BC00, 0x02C3BD00, 0x02C3BE00, 0x02C3BF00,
+	},
+	{ //iso-8859-16
+		0x02C28000, 0x02C28100, 0x02C28200, 0x02C28300, 0x02C28400, 0x02C28500, 0x02C28600, 0x02C28700,
+		0x02C28800, 0x02C28900, 0x02C28A00, 0x02C28B00, 0x02C28C00, 0x02C28D00, 0x02C28E00, 0x02C28F00,
+		0x02C29000, 0x02C29100, 0x02C29200, 0x02C29300, 0x02C29400, 0x02C29500, 0x02C29600, 0x02C29700,
+		0x02C29800, 0x02C29900, 0x02C29A00, 0x02C29B00, 0x02C29C00, 0x02C29D00, 0x02C29E00, 0x02C29F00,
+		0x02C2A000, 0x02C48400, 0x02C48500, 0x02C58100, 0x03E282AC, 0x03E2809E, 0x02C5A000, 0x02C2A700,
+		0x02C5A100, 0x02C2A900, 0x02C89800, 0x02C2AB00, 0x02C5B900, 0x02C2AD00, 0x02C5BA00, 0x02C5BB00,
+		0x02C2B000, 0x02C2B100, 0x02C48C00, 0x02C58200, 0x02C5BD00, 0x03E2809D, 0x02C2B600, 0x02C2B700,
+		0x02C5BE00, 0x02C48D00, 0x02C89900, 0x02C2BB00, 0x02C59200, 0x02C59300, 0x02C5B800, 0x02C5BC00,
+		0x02C38000, 0x02C38100, 0x02C38200, 0x02C48200, 0x02C38400, 0x02C48600, 0x02C38600, 0x02C38700,
+		0x02C38800, 0x02C38900, 0x02C38A00, 0x02C38B00, 0x02C38C00, 0x02C38D00, 0x02C38E00, 0x02C38F00,
+		0x02C49000, 0x02C58300, 0x02C39200, 0x02C39300, 0x02C39400, 0x02C59000, 0x02C39600, 0x02C59A00,
+		0x02C5B000, 0x02C39900, 0x02C39A00, 0x02C39B00, 0x02C39C00, 0x02C49800, 0x02C89A00, 0x02C39F00,
+		0x02C3A000, 0x02C3A100, 0x02C3A200, 0x02C48300, 0x02C3A400, 0x02C48700, 0x02C3A600, 0x02C3A700,
+		0x02C3A800, 0x02C3A900, 0x02C3AA00, 0x02C3AB00, 0x02C3AC00, 0x02C3AD00, 0x02C3AE00, 0x02C3AF00,
+		0x02C49100, 0x02C58400, 0x02C3B200, 0x02C3B300, 0x02C3B400, 0x02C59100, 0x02C3B600, 0x02C59B00,
+		0x02C5B100, 0x02C3B900, 0x02C3BA00, 0x02C3BB00, 0x02C3BC00, 0x02C49900, 0x02C89B00, 0x02C3BF00,
+	},
+	{ //windows-1250
+		0x03E282AC, 0x03EFBFBD, 0x03E2809A, 0x03EFBFBD, 0x03E2809E, 0x03E280A6, 0x03E280A0, 0x03E280A1,
+		0x03EFBFBD, 0x03E280B0, 0x02C5A000, 0x03E280B9, 0x02C59A00, 0x02C5A400, 0x02C5BD00, 0x02C5B900,
+		0x03EFBFBD, 0x03E28098, 0x03E28099, 0x03E2809C, 0x03E2809D, 0x03E280A2, 0x03E28093, 0x03E28094,
+		0x03EFBFBD, 0x03E284A2, 0x02C5A100, 0x03E280BA, 0x02C59B00, 0x02C5A500, 0x02C5BE00, 0x02C5BA00,
+		0x02C2A000, 0x02CB8700, 0x02CB9800, 0x02C58100, 0x02C2A400, 0x02C48400, 0x02C2A600, 0x02C2A700,
+		0x02C2A800, 0x02C2A900, 0x02C59E00, 0x02C2AB00, 0x02C2AC00, 0x02C2AD00, 0x02C2AE00, 0x02C5BB00,
+		0x02C2B000, 0x02C2B100, 0x02CB9B00, 0x02C58200, 0x02C2B400, 0x02C2B500, 0x02C2B600, 0x02C2B700,
+		0x02C2B800, 0x02C48500, 0x02C59F00, 0x02C2BB00, 0x02C4BD00, 0x02CB9D00, 0x02C4BE00, 0x02C5BC00,
+		0x02C59400, 0x02C38100, 0x02C38200, 0x02C48200, 0x02C38400, 0x02C4B900, 0x02C48600, 0x02C38700,
+		0x02C48C00, 0x02C38900, 0x02C49800, 0x02C38B00, 0x02C49A00, 0x02C38D00, 0x02C38E00, 0x02C48E00,
+		0x02C49000, 0x02C58300, 0x02C58700, 0x02C39300, 0x02C39400, 0x02C59000, 0x02C39600, 0x02C39700,
+		0x02C59800, 0x02C5AE00, 0x02C39A00, 0x02C5B000, 0x02C39C00, 0x02C39D00, 0x02C5A200, 0x02C39F00,
+		0x02C59500, 0x02C3A100, 0x02C3A200, 0x02C48300, 0x02C3A400, 0x02C4BA00, 0x02C48700, 0x02C3A700,
+		0x02C48D00, 0x02C3A900, 0x02C49900, 0x02C3AB00, 0x02C49B00, 0x02C3AD00, 0x02C3AE00, 0x02C48F00,
+		0x02C49100, 0x02C58400, 0x02C58800, 0x02C3B300, 0x02C3B400, 0x02C59100, 0x02C3B600, 0x02C3B700,
+		0x02C59900, 0x02C5AF00, 0x02C3BA00, 0x02C5B100, 0x02C3BC00, 0x02C3BD00, 0x02C5A300, 0x02CB9900,
+	},
+	{ //windows-1251
+		0x02D08200, 0x02D08300, 0x03E2809A, 0x02D19300, 0x03E2809E, 0x03E280A6, 0x03E280A0, 0x03E280A1,
+		0x03E282AC, 0x03E280B0, 0x02D08900, 0x03E280B9, 0x02D08A00, 0x02D08C00, 0x02D08B00, 0x02D08F00,
+		0x02D19200, 0x03E28098, 0x03E28099, 0x03E2809C, 0x03E2809D, 0x03E280A2, 0x03E28093, 0x03E28094,
+		0x03EFBFBD, 0x03E284A2, 0x02D19900, 0x03E280BA, 0x02D19A00, 0x02D19C00, 0x02D19B00, 0x02D19F00,
+		0x02C2A000, 0x02D08E00, 0x02D19E00, 0x02D08800, 0x02C2A400, 0x02D29000, 0x02C2A600, 0x02C2A700,
+		0x02D08100, 0x02C2A900, 0x02D08400, 0x02C2AB00, 0x02C2AC00, 0x02C2AD00, 0x02C2AE00, 0x02D08700,
+		0x02C2B000, 0x02C2B100, 0x02D08600, 0x02D19600, 0x02D29100, 0x02C2B500, 0x02C2B600, 0x02C2B700,
+		0x02D19100, 0x03E28496, 0x02D19400, 0x02C2BB00, 0x02D19800, 0x02D08500, 0x02D19500, 0x02D19700,
+		0x02D09000, 0x02D09100, 0x02D09200, 0x02D09300, 0x02D09400, 0x02D09500, 0x02D09600, 0x02D09700,
+		0x02D09800, 0x02D09900, 0x02D09A00, 0x02D09B00, 0x02D09C00, 0x02D09D00, 0x02D09E00, 0x02D09F00,
+		0x02D0A000, 0x02D0A100, 0x02D0A200, 0x02D0A300, 0x02D0A400, 0x02D0A500, 0x02D0A600, 0x02D0A700,
+		0x02D0A800, 0x02D0A900, 0x02D0AA00, 0x02D0AB00, 0x02D0AC00, 0x02D0AD00, 0x02D0AE00, 0x02D0AF00,
+		0x02D0B000, 0x02D0B100, 0x02D0B200, 0x02D0B300, 0x02D0B400, 0x02D0B500, 0x02D0B600, 0x02D0B700,
+		0x02D0B800, 0x02D0B900, 0x02D0BA00, 0x02D0BB00, 0x02D0BC00, 0x02D0BD00, 0x02D0BE00, 0x02D0BF00,
+		0x02D18000, 0x02D18100, 0x02D18200, 0x02D18300, 0x02D18400, 0x02D18500, 0x02D18600, 0x02D18700,
+		0x02D18800, 0x02D18900, 0x02D18A00, 0x02D18B00, 0x02D18C00, 0x02D18D00, 0x02D18E00, 0x02D18F00,
+	},
+	{ //windows-1252
+		0x03E282AC, 0x03EFBFBD, 0x03E2809A, 0x02C69200, 0x03E2809E, 0x03E280A6, 0x03E280A0, 0x03E280A1,
+		0x02CB8600, 0x03E280B0, 0x02C5A000, 0x03E280B9, 0x02C59200, 0x03EFBFBD, 0x02C5BD00, 0x03EFBFBD,
+		0x03EFBFBD, 0x03E28098, 0x03E28099, 0x03E2809C, 0x03E2809D, 0x03E280A2, 0x03E28093, 0x03E28094,
+		0x02CB9C00, 0x03E284A2, 0x02C5A100, 0x03E280BA, 0x02C59300, 0x03EFBFBD, 0x02C5BE00, 0x02C5B800,
+		0x02C2A000, 0x02C2A100, 0x02C2A200, 0x02C2A300, 0x02C2A400, 0x02C2A500, 0x02C2A600, 0x02C2A700,
+		0x02C2A800, 0x02C2A900, 0x02C2AA00, 0x02C2AB00, 0x02C2AC00, 0x02C2AD00, 0x02C2AE00, 0x02C2AF00,
+		0x02C2B000, 0x02C2B100, 0x02C2B200, 0x02C2B300, 0x02C2B400, 0x02C2B500, 0x02C2B600, 0x02C2B700,
+		0x02C2B800, 0x02C2B900, 0x02C2BA00, 0x02C2BB00, 0x02C2BC00, 0x02C2BD00, 0x02C2BE00, 0x02C2BF00,
+		0x02C38000, 0x02C38100, 0x02C38200, 0x02C38300, 0x02C38400, 0x02C38500, 0x02C38600, 0x02C38700,
+		0x02C38800, 0x02C38900, 0x02C38A00, 0x02C38B00, 0x02C38C00, 0x02C38D00, 0x02C38E00, 0x02C38F00,
+		0x02C39000, 0x02C39100, 0x02C39200, 0x02C39300, 0x02C39400, 0x02C39500, 0x02C39600, 0x02C39700,
+		0x02C39800, 0x02C39900, 0x02C39A00, 0x02C39B00, 0x02C39C00, 0x02C39D00, 0x02C39E00, 0x02C39F00,
+		0x02C3A000, 0x02C3A100, 0x02C3A200, 0x02C3A300, 0x02C3A400, 0x02C3A500, 0x02C3A600, 0x02C3A700,
+		0x02C3A800, 0x02C3A900, 0x02C3AA00, 0x02C3AB00, 0x02C3AC00, 0x02C3AD00, 0x02C3AE00, 0x02C3AF00,
+		0x02C3B000, 0x02C3B100, 0x02C3B200, 0x02C3B300, 0x02C3B400, 0x02C3B500, 0x02C3B600, 0x02C3B700,
+		0x02C3B800, 0x02C3B900, 0x02C3BA00, 0x02C3BB00, 0x02C3BC00, 0x02C3BD00, 0x02C3BE00, 0x02C3BF00,
+	},
+	{ //windows-1253
+		0x03E282AC, 0x03EFBFBD, 0x03E2809A, 0x02C69200, 0x03E2809E, 0x03E280A6, 0x03E280A0, 0x03E280A1,
+		0x03EFBFBD, 0x03E280B0, 0x03EFBFBD, 0x03E280B9, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD,
+		0x03EFBFBD, 0x03E28098, 0x03E28099, 0x03E2809C, 0x03E2809D, 0x03E280A2, 0x03E28093, 0x03E28094,
+		0x03EFBFBD, 0x03E284A2, 0x03EFBFBD, 0x03E280BA, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD,
+		0x02C2A000, 0x02CE8500, 0x02CE8600, 0x02C2A300, 0x02C2A400, 0x02C2A500, 0x02C2A600, 0x02C2A700,
+		0x02C2A800, 0x02C2A900, 0x03EFBFBD, 0x02C2AB00, 0x02C2AC00, 0x02C2AD00, 0x02C2AE00, 0x03E28095,
+		0x02C2B000, 0x02C2B100, 0x02C2B200, 0x02C2B300, 0x02CE8400, 0x02C2B500, 0x02C2B600, 0x02C2B700,
+		0x02CE8800, 0x02CE8900, 0x02CE8A00, 0x02C2BB00, 0x02CE8C00, 0x02C2BD00, 0x02CE8E00, 0x02CE8F00,
+		0x02CE9000, 0x02CE9100, 0x02CE9200, 0x02CE9300, 0x02CE9400, 0x02CE9500, 0x02CE9600, 0x02CE9700,
+		0x02CE9800, 0x02CE9900, 0x02CE9A00, 0x02CE9B00, 0x02CE9C00, 0x02CE9D00, 0x02CE9E00, 0x02CE9F00,
+		0x02CEA000, 0x02CEA100, 0x03EFBFBD, 0x02CEA300, 0x02CEA400, 0x02CEA500, 0x02CEA600, 0x02CEA700,
+		0x02CEA800, 0x02CEA900, 0x02CEAA00, 0x02CEAB00, 0x02CEAC00, 0x02CEAD00, 0x02CEAE00, 0x02CEAF00,
+		0x02CEB000, 0x02CEB100, 0x02CEB200, 0x02CEB300, 0x02CEB400, 0x02CEB500, 0x02CEB600, 0x02CEB700,
+		0x02CEB800, 0x02CEB900, 0x02CEBA00, 0x02CEBB00, 0x02CEBC00, 0x02CEBD00, 0x02CEBE00, 0x02CEBF00,
+		0x02CF8000, 0x02CF8100, 0x02CF8200, 0x02CF8300, 0x02CF8400, 0x02CF8500, 0x02CF8600, 0x02CF8700,
+		0x02CF8800, 0x02CF8900, 0x02CF8A00, 0x02CF8B00, 0x02CF8C00, 0x02CF8D00, 0x02CF8E00, 0x03EFBFBD,
+	},
+	{ //windows-1254
+		0x03E282AC, 0x03EFBFBD, 0x03E2809A, 0x02C69200, 0x03E2809E, 0x03E280A6, 0x03E280A0, 0x03E280A1,
+		0x02CB8600, 0x03E280B0, 0x02C5A000, 0x03E280B9, 0x02C59200, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD,
+		0x03EFBFBD, 0x03E28098, 0x03E28099, 0x03E2809C, 0x03E2809D, 0x03E280A2, 0x03E28093, 0x03E28094,
+		0x02CB9C00, 0x03E284A2, 0x02C5A100, 0x03E280BA, 0x02C59300, 0x03EFBFBD, 0x03EFBFBD, 0x02C5B800,
+		0x02C2A000, 0x02C2A100, 0x02C2A200, 0x02C2A300, 0x02C2A400, 0x02C2A500, 0x02C2A600, 0x02C2A700,
+		0x02C2A800, 0x02C2A900, 0x02C2AA00, 0x02C2AB00, 0x02C2AC00, 0x02C2AD00, 0x02C2AE00, 0x02C2AF00,
+		0x02C2B000, 0x02C2B100, 0x02C2B200, 0x02C2B300, 0x02C2B400, 0x02C2B500, 0x02C2B600, 0x02C2B700,
+		0x02C2B800, 0x02C2B900, 0x02C2BA00, 0x02C2BB00, 0x02C2BC00, 0x02C2BD00, 0x02C2BE00, 0x02C2BF00,
+		0x02C38000, 0x02C38100, 0x02C38200, 0x02C38300, 0x02C38400, 0x02C38500, 0x02C38600, 0x02C38700,
+		0x02C38800, 0x02C38900, 0x02C38A00, 0x02C38B00, 0x02C38C00, 0x02C38D00, 0x02C38E00, 0x02C38F00,
+		0x02C49E00, 0x02C39100, 0x02C39200, 0x02C39300, 0x02C39400, 0x02C39500, 0x02C39600, 0x02C39700,
+		0x02C39800, 0x02C39900, 0x02C39A00, 0x02C39B00, 0x02C39C00, 0x02C4B000, 0x02C59E00, 0x02C39F00,
+		0x02C3A000, 0x02C3A100, 0x02C3A200, 0x02C3A300, 0x02C3A400, 0x02C3A500, 0x02C3A600, 0x02C3A700,
+		0x02C3A800, 0x02C3A900, 0x02C3AA00, 0x02C3AB00, 0x02C3AC00, 0x02C3AD00, 0x02C3AE00, 0x02C3AF00,
+		0x02C49F00, 0x02C3B100, 0x02C3B200, 0x02C3B300, 0x02C3B400, 0x02C3B500, 0x02C3B600, 0x02C3B700,
+		0x02C3B800, 0x02C3B900, 0x02C3BA00, 0x02C3BB00, 0x02C3BC00, 0x02C4B100, 0x02C59F00, 0x02C3BF00,
+	},
+	{ //windows-1255
+		0x03E282AC, 0x03EFBFBD, 0x03E2809A, 0x02C69200, 0x03E2809E, 0x03E280A6, 0x03E280A0, 0x03E280A1,
+		0x02CB8600, 0x03E280B0, 0x03EFBFBD, 0x03E280B9, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD,
+		0x03EFBFBD, 0x03E28098, 0x03E28099, 0x03E2809C, 0x03E2809D, 0x03E280A2, 0x03E28093, 0x03E28094,
+		0x02CB9C00, 0x03E284A2, 0x03EFBFBD, 0x03E280BA, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD,
+		0x02C2A000, 0x02C2A100, 0x02C2A200, 0x02C2A300, 0x03E282AA, 0x02C2A500, 0x02C2A600, 0x02C2A700,
+		0x02C2A800, 0x02C2A900, 0x02C39700, 0x02C2AB00, 0x02C2AC00, 0x02C2AD00, 0x02C2AE00, 0x02C2AF00,
+		0x02C2B000, 0x02C2B100, 0x02C2B200, 0x02C2B300, 0x02C2B400, 0x02C2B500, 0x02C2B600, 0x02C2B700,
+		0x02C2B800, 0x02C2B900, 0x02C3B700, 0x02C2BB00, 0x02C2BC00, 0x02C2BD00, 0x02C2BE00, 0x02C2BF00,
+		0x02D6B000, 0x02D6B100, 0x02D6B200, 0x02D6B300, 0x02D6B400, 0x02D6B500, 0x02D6B600, 0x02D6B700,
+		0x02D6B800, 0x02D6B900, 0x03EFBFBD, 0x02D6BB00, 0x02D6BC00, 0x02D6BD00, 0x02D6BE00, 0x02D6BF00,
+		0x02D78000, 0x02D78100, 0x02D78200, 0x02D78300, 0x02D7B000, 0x02D7B100, 0x02D7B200, 0x02D7B300,
+		0x02D7B400, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD,
+		0x02D79000, 0x02D79100, 0x02D79200, 0x02D79300, 0x02D79400, 0x02D79500, 0x02D79600, 0x02D79700,
+		0x02D79800, 0x02D79900, 0x02D79A00, 0x02D79B00, 0x02D79C00, 0x02D79D00, 0x02D79E00, 0x02D79F00,
+		0x02D7A000, 0x02D7A100, 0x02D7A200, 0x02D7A300, 0x02D7A400, 0x02D7A500, 0x02D7A600, 0x02D7A700,
+		0x02D7A800, 0x02D7A900, 0x02D7AA00, 0x03EFBFBD, 0x03EFBFBD, 0x03E2808E, 0x03E2808F, 0x03EFBFBD,
+	},
+	{ //windows-1256
+		0x03E282AC, 0x02D9BE00, 0x03E2809A, 0x02C69200, 0x03E2809E, 0x03E280A6, 0x03E280A0, 0x03E280A1,
+		0x02CB8600, 0x03E280B0, 0x02D9B900, 0x03E280B9, 0x02C59200, 0x02DA8600, 0x02DA9800, 0x02DA8800,
+		0x02DAAF00, 0x03E28098, 0x03E28099, 0x03E2809C, 0x03E2809D, 0x03E280A2, 0x03E28093, 0x03E28094,
+		0x02DAA900, 0x03E284A2, 0x02DA9100, 0x03E280BA, 0x02C59300, 0x03E2808C, 0x03E2808D, 0x02DABA00,
+		0x02C2A000, 0x02D88C00, 0x02C2A200, 0x02C2A300, 0x02C2A400, 0x02C2A500, 0x02C2A600, 0x02C2A700,
+		0x02C2A800, 0x02C2A900, 0x02DABE00, 0x02C2AB00, 0x02C2AC00, 0x02C2AD00, 0x02C2AE00, 0x02C2AF00,
+		0x02C2B000, 0x02C2B100, 0x02C2B200, 0x02C2B300, 0x02C2B400, 0x02C2B500, 0x02C2B600, 0x02C2B700,
+		0x02C2B800, 0x02C2B900, 0x02D89B00, 0x02C2BB00, 0x02C2BC00, 0x02C2BD00, 0x02C2BE00, 0x02D89F00,
+		0x02DB8100, 0x02D8A100, 0x02D8A200, 0x02D8A300, 0x02D8A400, 0x02D8A500, 0x02D8A600, 0x02D8A700,
+		0x02D8A800, 0x02D8A900, 0x02D8AA00, 0x02D8AB00, 0x02D8AC00, 0x02D8AD00, 0x02D8AE00, 0x02D8AF00,
+		0x02D8B000, 0x02D8B100, 0x02D8B200, 0x02D8B300, 0x02D8B400, 0x02D8B500, 0x02D8B600, 0x02C39700,
+		0x02D8B700, 0x02D8B800, 0x02D8B900, 0x02D8BA00, 0x02D98000, 0x02D98100, 0x02D98200, 0x02D98300,
+		0x02C3A000, 0x02D98400, 0x02C3A200, 0x02D98500, 0x02D98600, 0x02D98700, 0x02D98800, 0x02C3A700,
+		0x02C3A800, 0x02C3A900, 0x02C3AA00, 0x02C3AB00, 0x02D98900, 0x02D98A00, 0x02C3AE00, 0x02C3AF00,
+		0x02D98B00, 0x02D98C00, 0x02D98D00, 0x02D98E00, 0x02C3B400, 0x02D98F00, 0x02D99000, 0x02C3B700,
+		0x02D99100, 0x02C3B900, 0x02D99200, 0x02C3BB00, 0x02C3BC00, 0x03E2808E, 0x03E2808F, 0x02DB9200,
+	},
+	{ //windows-1257
+		0x03E282AC, 0x03EFBFBD, 0x03E2809A, 0x03EFBFBD, 0x03E2809E, 0x03E280A6, 0x03E280A0, 0x03E280A1,
+		0x03EFBFBD, 0x03E280B0, 0x03EFBFBD, 0x03E280B9, 0x03EFBFBD, 0x02C2A800, 0x02CB8700, 0x02C2B800,
+		0x03EFBFBD, 0x03E28098, 0x03E28099, 0x03E2809C, 0x03E2809D, 0x03E280A2, 0x03E28093, 0x03E28094,
+		0x03EFBFBD, 0x03E284A2, 0x03EFBFBD, 0x03E280BA, 0x03EFBFBD, 0x02C2AF00, 0x02CB9B00, 0x03EFBFBD,
+		0x02C2A000, 0x03EFBFBD, 0x02C2A200, 0x02C2A300, 0x02C2A400, 0x03EFBFBD, 0x02C2A600, 0x02C2A700,
+		0x02C39800, 0x02C2A900, 0x02C59600, 0x02C2AB00, 0x02C2AC00, 0x02C2AD00, 0x02C2AE00, 0x02C38600,
+		0x02C2B000, 0x02C2B100, 0x02C2B200, 0x02C2B300, 0x02C2B400, 0x02C2B500, 0x02C2B600, 0x02C2B700,
+		0x02C3B800, 0x02C2B900, 0x02C59700, 0x02C2BB00, 0x02C2BC00, 0x02C2BD00, 0x02C2BE00, 0x02C3A600,
+		0x02C48400, 0x02C4AE00, 0x02C48000, 0x02C48600, 0x02C38400, 0x02C38500, 0x02C49800, 0x02C49200,
+		0x02C48C00, 0x02C38900, 0x02C5B900, 0x02C49600, 0x02C4A200, 0x02C4B600, 0x02C4AA00, 0x02C4BB00,
+		0x02C5A000, 0x02C58300, 0x02C58500, 0x02C39300, 0x02C58C00, 0x02C39500, 0x02C39600, 0x02C39700,
+		0x02C5B200, 0x02C58100, 0x02C59A00, 0x02C5AA00, 0x02C39C00, 0x02C5BB00, 0x02C5BD00, 0x02C39F00,
+		0x02C48500, 0x02C4AF00, 0x02C48100, 0x02C48700, 0x02C3A400, 0x02C3A500, 0x02C49900, 0x02C49300,
+		0x02C48D00, 0x02C3A900, 0x02C5BA00, 0x02C49700, 0x02C4A300, 0x02C4B700, 0x02C4AB00, 0x02C4BC00,
+		0x02C5A100, 0x02C58400, 0x02C58600, 0x02C3B300, 0x02C58D00, 0x02C3B500, 0x02C3B600, 0x02C3B700,
+		0x02C5B300, 0x02C58200, 0x02C59B00, 0x02C5AB00, 0x02C3BC00, 0x02C5BC00, 0x02C5BE00, 0x02CB9900,
+	},
+	{ //windows-1258
+		0x03E282AC, 0x03EFBFBD, 0x03E2809A, 0x02C69200, 0x03E2809E, 0x03E280A6, 0x03E280A0, 0x03E280A1,
+		0x02CB8600, 0x03E280B0, 0x03EFBFBD, 0x03E280B9, 0x02C59200, 0x03EFBFBD, 0x03EFBFBD, 0x03EFBFBD,
+		0x03EFBFBD, 0x03E28098, 0x03E28099, 0x03E2809C, 0x03E2809D, 0x03E280A2, 0x03E28093, 0x03E28094,
+		0x02CB9C00, 0x03E284A2, 0x03EFBFBD, 0x03E280BA, 0x02C59300, 0x03EFBFBD, 0x03EFBFBD, 0x02C5B800,
+		0x02C2A000, 0x02C2A100, 0x02C2A200, 0x02C2A300, 0x02C2A400, 0x02C2A500, 0x02C2A600, 0x02C2A700,
+		0x02C2A800, 0x02C2A900, 0x02C2AA00, 0x02C2AB00, 0x02C2AC00, 0x02C2AD00, 0x02C2AE00, 0x02C2AF00,
+		0x02C2B000, 0x02C2B100, 0x02C2B200, 0x02C2B300, 0x02C2B400, 0x02C2B500, 0x02C2B600, 0x02C2B700,
+		0x02C2B800, 0x02C2B900, 0x02C2BA00, 0x02C2BB00, 0x02C2BC00, 0x02C2BD00, 0x02C2BE00, 0x02C2BF00,
+		0x02C38000, 0x02C38100, 0x02C38200, 0x02C48200, 0x02C38400, 0x02C38500, 0x02C38600, 0x02C38700,
+		0x02C38800, 0x02C38900, 0x02C38A00, 0x02C38B00, 0x02CC8000, 0x02C38D00, 0x02C38E00, 0x02C38F00,
+		0x02C49000, 0x02C39100, 0x02CC8900, 0x02C39300, 0x02C39400, 0x02C6A000, 0x02C39600, 0x02C39700,
+		0x02C39800, 0x02C39900, 0x02C39A00, 0x02C39B00, 0x02C39C00, 0x02C6AF00, 0x02CC8300, 0x02C39F00,
+		0x02C3A000, 0x02C3A100, 0x02C3A200, 0x02C48300, 0x02C3A400, 0x02C3A500, 0x02C3A600, 0x02C3A700,
+		0x02C3A800, 0x02C3A900, 0x02C3AA00, 0x02C3AB00, 0x02CC8100, 0x02C3AD00, 0x02C3AE00, 0x02C3AF00,
+		0x02C49100, 0x02C3B100, 0x02CCA300, 0x02C3B300, 0x02C3B400, 0x02C6A100, 0x02C3B600, 0x02C3B700,
+		0x02C3B800, 0x02C3B900, 0x02C3BA00, 0x02C3BB00, 0x02C3BC00, 0x02C6B000, 0x03E282AB, 0x02C3BF00,
+	},
+	{ //koi8-r
+		0x03E29480, 0x03E29482, 0x03E2948C, 0x03E29490, 0x03E29494, 0x03E29498, 0x03E2949C, 0x03E294A4,
+		0x03E294AC, 0x03E294B4, 0x03E294BC, 0x03E29680, 0x03E29684, 0x03E29688, 0x03E2968C, 0x03E29690,
+		0x03E29691, 0x03E29692, 0x03E29693, 0x03E28CA0, 0x03E296A0, 0x03E28899, 0x03E2889A, 0x03E28988,
+		0x03E289A4, 0x03E289A5, 0x02C2A000, 0x03E28CA1, 0x02C2B000, 0x02C2B200, 0x02C2B700, 0x02C3B700,
+		0x03E29590, 0x03E29591, 0x03E29592, 0x02D19100, 0x03E29593, 0x03E29594, 0x03E29595, 0x03E29596,
+		0x03E29597, 0x03E29598, 0x03E29599, 0x03E2959A, 0x03E2959B, 0x03E2959C, 0x03E2959D, 0x03E2959E,
+		0x03E2959F, 0x03E295A0, 0x03E295A1, 0x02D08100, 0x03E295A2, 0x03E295A3, 0x03E295A4, 0x03E295A5,
+		0x03E295A6, 0x03E295A7, 0x03E295A8, 0x03E295A9, 0x03E295AA, 0x03E295AB, 0x03E295AC, 0x02C2A900,
+		0x02D18E00, 0x02D0B000, 0x02D0B100, 0x02D18600, 0x02D0B400, 0x02D0B500, 0x02D18400, 0x02D0B300,
+		0x02D18500, 0x02D0B800, 0x02D0B900, 0x02D0BA00, 0x02D0BB00, 0x02D0BC00, 0x02D0BD00, 0x02D0BE00,
+		0x02D0BF00, 0x02D18F00, 0x02D18000, 0x02D18100, 0x02D18200, 0x02D18300, 0x02D0B600, 0x02D0B200,
+		0x02D18C00, 0x02D18B00, 0x02D0B700, 0x02D18800, 0x02D18D00, 0x02D18900, 0x02D18700, 0x02D18A00,
+		0x02D0AE00, 0x02D09000, 0x02D09100, 0x02D0A600, 0x02D09400, 0x02D09500, 0x02D0A400, 0x02D09300,
+		0x02D0A500, 0x02D09800, 0x02D09900, 0x02D09A00, 0x02D09B00, 0x02D09C00, 0x02D09D00, 0x02D09E00,
+		0x02D09F00, 0x02D0AF00, 0x02D0A000, 0x02D0A100, 0x02D0A200, 0x02D0A300, 0x02D09600, 0x02D09200,
+		0x02D0AC00, 0x02D0AB00, 0x02D09700, 0x02D0A800, 0x02D0AD00, 0x02D0A900, 0x02D0A700, 0x02D0AA00,
+	},
+	{ //koi8-u
+		0x03E29480, 0x03E29482, 0x03E2948C, 0x03E29490, 0x03E29494, 0x03E29498, 0x03E2949C, 0x03E294A4,
+		0x03E294AC, 0x03E294B4, 0x03E294BC, 0x03E29680, 0x03E29684, 0x03E29688, 0x03E2968C, 0x03E29690,
+		0x03E29691, 0x03E29692, 0x03E29693, 0x03E28CA0, 0x03E296A0, 0x03E28899, 0x03E2889A, 0x03E28988,
+		0x03E289A4, 0x03E289A5, 0x02C2A000, 0x03E28CA1, 0x02C2B000, 0x02C2B200, 0x02C2B700, 0x02C3B700,
+		0x03E29590, 0x03E29591, 0x03E29592, 0x02D19100, 0x02D19400, 0x03E29594, 0x02D19600, 0x02D19700,
+		0x03E29597, 0x03E29598, 0x03E29599, 0x03E2959A, 0x03E2959B, 0x02D29100, 0x03E2959D, 0x03E2959E,
+		0x03E2959F, 0x03E295A0, 0x03E295A1, 0x02D08100, 0x02D08400, 0x03E295A3, 0x02D08600, 0x02D08700,
+		0x03E295A6, 0x03E295A7, 0x03E295A8, 0x03E295A9, 0x03E295AA, 0x02D29000, 0x03E295AC, 0x02C2A900,
+		0x02D18E00, 0x02D0B000, 0x02D0B100, 0x02D18600, 0x02D0B400, 0x02D0B500, 0x02D18400, 0x02D0B300,
+		0x02D18500, 0x02D0B800, 0x02D0B900, 0x02D0BA00, 0x02D0BB00, 0x02D0BC00, 0x02D0BD00, 0x02D0BE00,
+		0x02D0BF00, 0x02D18F00, 0x02D18000, 0x02D18100, 0x02D18200, 0x02D18300, 0x02D0B600, 0x02D0B200,
+		0x02D18C00, 0x02D18B00, 0x02D0B700, 0x02D18800, 0x02D18D00, 0x02D18900, 0x02D18700, 0x02D18A00,
+		0x02D0AE00, 0x02D09000, 0x02D09100, 0x02D0A600, 0x02D09400, 0x02D09500, 0x02D0A400, 0x02D09300,
+		0x02D0A500, 0x02D09800, 0x02D09900, 0x02D09A00, 0x02D09B00, 0x02D09C00, 0x02D09D00, 0x02D09E00,
+		0x02D09F00, 0x02D0AF00, 0x02D0A000, 0x02D0A100, 0x02D0A200, 0x02D0A300, 0x02D09600, 0x02D09200,
+		0x02D0AC00, 0x02D0AB00, 0x02D09700, 0x02D0A800, 0x02D0AD00, 0x02D0A900, 0x02D0A700, 0x02D0AA00,
+	},
+};
+
+#ifdef USE_ICONV
+	#define MAX_ICONV 16 //The number of different iconv charsets that can be used
+	#define ICONV_BASE 1000 //Added to the position of the conversion descriptor, to make the charset
+
+	static struct {
+		char name[MAX_CHARSET_NAME];
+		iconv_t cd;
+	} iconvCharsets[MAX_ICONV];
+	static int iconvCount = 0;
+#endif
+
+int findCharset(char *name, size_t nameLen) {
+	char nameStr[MAX_CHARSET_NAME];
+
+	if (nameLen == 0 || nameLen >= MAX_CHARSET_NAME) {
+		return(CHARSET_UNKNOWN);
+	}
+	memcpy(nameStr, name, nameLen);
+	nameStr[nameLen] = '\0';
+
+	//A language can follow the charset's name (RFC 2231), e.g. "utf-8*en"
+	if (strchr(nameStr, '*') != NULL) {
+		*strchr(nameStr, '*') = '\0';
+	}
+
+	for (size_t k = 0 ; k < sizeof(charsetNames) / sizeof(charsetNames[0]) ; k++) {
+		if (!strcasecmp(nameStr, charsetNames[k].name)) {
+			return(charsetNames[k].charset);
+		}
+	}
+
+#ifdef USE_ICONV
+	//Conversion descriptors are opened once per charset, and kept until the program ends
+	for (int k = 0 ; k < iconvCount ; k++) {
+		if (!strcasecmp(nameStr, iconvCharsets[k].name)) {
+			return(ICONV_BASE + k);
+		}
+	}
+	if (iconvCount < MAX_ICONV) {
+		iconvCharsets[iconvCount].cd = iconv_open("UTF-8", nameStr);
+		if (iconvCharsets[iconvCount].cd != (iconv_t)-1) {
+			strcpy(iconvCharsets[iconvCount].name, nameStr);
+			return(ICONV_BASE + iconvCount++);
+		}
+	}
+#endif
+
+	return(CHARSET_UNKNOWN);
+}
+
+#ifdef USE_ICONV
+size_t iconvToUtf8(iconv_t cd, char *src, size_t len, char *dest) {
+	char *out = dest;
+	size_t outLeft = UTF8_EXPANSION*len;
+
+	iconv(cd, NULL, NULL, NULL, NULL); //Start from the initial shift state
+
+	while (len > 0) {
+		if (iconv(cd, &src, &len, &out, &outLeft) != (size_t)-1) {
+			break;
+		}
+		if (errno == E2BIG) { //Can't happen, as long as UTF8_EXPANSION holds
+			break;
+		}
+
+		//Invalid (EILSEQ) or incomplete (EINVAL) sequence, replace a byte and go on
+		memcpy(out, REPLACEMENT, REPLACEMENT_LEN);
+		out += REPLACEMENT_LEN;
+		outLeft -= REPLACEMENT_LEN;
+		src++;
+		len--;
+	}
+	//Return to the initial shift state, in case the text ended in another one
+	iconv(cd, NULL, NULL, &out, &outLeft);
+
+	return(out - dest);
+}
+#endif
+
+#ifdef USE_ICONV
+size_t iconvToUtf8Part(iconv_t cd, char *src, size_t len, char *dest, size_t *convertedPtr) {
+	char *out = dest, *in = src;
+	size_t outLeft = UTF8_EXPANSION*len, inLeft = len;
+
+	while (inLeft > 0) {
+		if (iconv(cd, &in, &inLeft, &out, &outLeft) != (size_t)-1 || errno != EILSEQ) {
+			break; //Done, or the rest is an incomplete character (EINVAL), left for the next part
+		}
+
+		memcpy(out, REPLACEMENT, REPLACEMENT_LEN);
+		out += REPLACEMENT_LEN;
+		outLeft -= REPLACEMENT_LEN;
+		in++;
+		inLeft--;
+	}
+	*convertedPtr = len - inLeft;
+
+	return(out - dest);
+}
+#endif
+
+void charsetReset(int charset) {
+#ifdef USE_ICONV
+	if (charset >= ICONV_BASE) {
+		iconv(iconvCharsets[charset - ICONV_BASE].cd, NULL, NULL, NULL, NULL);
+	}
+#endif
+}
+
+size_t charsetToUtf8Part(int charset, char *src, size_t len, char *dest, size_t *convertedPtr) {
+#ifdef USE_ICONV
+	if (charset >= ICONV_BASE) {
+		return(iconvToUtf8Part(iconvCharsets[charset - ICONV_BASE].cd, src, len, dest, convertedPtr));
+	}
+#endif
+	//Table charsets map single bytes and UTF-8 is copied byte for byte, so nothing is carried between parts
+	*convertedPtr = len;
+
+	return(charsetToUtf8(charset, src, len, dest));
+}
+
+size_t charsetToUtf8(int charset, char *src, size_t len, char *dest) {
+	const unsigned int *table;
+	unsigned char *bytes = (unsigned char*)src;
+	size_t pos = 0, destLen = 0, run;
+
+	if (charset == CHARSET_UTF8) {
+		memcpy(dest, src, len);
+		return(len);
+	}
+#ifdef USE_ICONV
+	if (charset >= ICONV_BASE) {
+		return(iconvToUtf8(iconvCharsets[charset - ICONV_BASE].cd, src, len, dest));
+	}
+#endif
+
+	table = charsetTables[charset - 1];
+	while (pos < len) {
+		//ASCII is the same in all of these charsets, so runs of it are copied at once
+		for (run = pos ; run < len && bytes[run] < 0x80 ; run++);
+		memcpy(dest + destLen, src + pos, run - pos);
+		destLen += run - pos;
+
+		//Every other byte is replaced by its UTF-8 encoding from the table
+		for (pos = run ; pos < len && bytes[pos] >= 0x80 ; pos++) {
+			dest[destLen] = (table[bytes[pos] - 0x80] >> 16) & 0xFF;
+			dest[destLen+1] = (table[bytes[pos] - 0x80] >> 8) & 0xFF;
+			dest[destLen+2] = table[bytes[pos] - 0x80] & 0xFF;
+			destLen += table[bytes[pos] - 0x80] >> 24;
+		}
+	}
+
+	return(destLen);
+}
@@ -1,5 +1,7 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include "parsing.h"
 #include "addresses.h"
 #include "cache.h"
@@ -7,27 +9,43 @@
 #include "untagged.h"
 #include "utils.h"
 #include "commands.h"
+#include "sort.h"
+#include "search.h"
+#include "bitmap.h"
+#include "flags.h"
+#include "decoder.h"
+#include "mime.h"
+#include "mailbox.h"
+#include "senders.h"
+#include "base64.h"
+#include "printing.h"
+#include "tls.h"
+#include "compress.h"
+#include "background.h"
 
 #define COMMAND_SIZE 300 //The size of a command string
+#define UID_SET_SIZE 1000 //The longest set of UIDs sent in a single command (servers limit the length of a line)
 
+/* The macro ALL (FLAGS INTERNALDATE RFC822.SIZE ENVELOPE), plus the UID, which
+  identifies the message in the search index (check search.h) */
+#define FETCH_ALL_ITEMS "(UID FLAGS INTERNALDATE RFC822.SIZE ENVELOPE)"
 
-/* Waiting for the tagged response while interpreting any untagged responses 
-   is a pattern followed by many of the following functions */
-int sendCommand(FILE *imapStream, msgCacheT *cachePtr, char *command, int context) {
-	char commandTag[TAG_SIZE];
-	imapObjectHandleT resTag, servResponse; //Handles used to access parts of the server's responses
-	int retVal;
+//What readResponse() returns (besides SUCCESS) for a tagged NO or BAD
+#define RESPONSE_NO 2
+#define RESPONSE_BAD 3
 
-	generateTag(commandTag);
 
-	//Send the command using the generated tag
-	if (fprintf(imapStream, "%s %s\r\n", commandTag, command) < 0) {
-		return(SOCKET_ERROR);
-	}
+/* Read the responses to a command until its tagged response (the one with commandTag), interpreting
+  the untagged ones. Returns SUCCESS on OK (the rest of the line is consumed), RESPONSE_NO or RESPONSE_BAD
+  with the text of the response left unread, as what is done with it depends on the command.
+   Commands can be pipelined (sent before the responses to the previous ones are read), as long as
+  the tagged responses are read in the order the commands were sent, as servers answer in order */
+int readResponse(FILE *imapStream, msgCacheT *cachePtr, char *commandTag, int context) {
+	imapObjectHandleT resTag, servResponse; //Handles used to access parts of the server's responses
+	int retVal;
 
 	//All responses are in the form: <tag> SP <data> CRLF
-	/* Loop until a tagged response is found (the tag matches that of the command,
-	 as this application processes one command at a time) */
+	//Loop until a tagged response is found (the tag matches that of the command)
 	do {
 		retVal = getStringObject(&resTag, imapStream); //Get the response's tag
 		if (isError(retVal)) {
@@ -36,77 +54,166 @@ int sendCommand(FILE *imapStream, msgCacheT *cachePtr, char *command, int contex
 		//If the tag matches that of the command
 		if (!strcmp(resTag->content.string, commandTag)) {
 			freeImapObject(resTag);
-
-			retVal = skipSpace(imapStream); //Skip a space
-			if (isError(retVal)) {
-				return(retVal);
-			}
-
-			//Get the next word of the response
-			retVal = getStringObject(&servResponse, imapStream);
-			if (isError(retVal)) {
-				return(retVal);
-			}
-
-			//Case insenistive in case the server uses lowecase
-			strUpper(servResponse->content.string);
-
-			//If it was an OK response
-			if (!strcmp(servResponse->content.string, "OK")) {
-				freeImapObject(servResponse);
-				break;
-			}
-			else if (!strcmp(servResponse->content.string, "NO")) { 
-				/* If it was a NO response, print the rest, as it could be an error message,
-				   but do not terminate (not fatal) */
-				freeImapObject(servResponse);
-				fprintf(stderr, "[SERVER]: ");
-				if (isError(retVal = printLine(stderr, imapStream))) {
-					return(retVal);
-				} 
-				break;
-			}
-			else { /* Assuming this application follows the IMAP protocol correctly,
-				     a BAD response is the product of an incompatibility between implementations,
-					 or the server does not follow the protocol. In any case, print the rest as
-					 an error message and terminate (as an error code is returned) */
-				freeImapObject(servResponse);
-				fprintf(stderr, "[SERVER]: ");
-				printLine(stderr, imapStream);
-				return(PARSE_ERROR);
-			}
+			break;
 		}
-		/*This client operates on one command at a time, 
+
+		/*The responses to the earlier commands have been read, 
 		  so if the tags don't match, the response is untagged */
-		else {
-			freeImapObject(resTag);
+		freeImapObject(resTag);
 
-			retVal = interpretUntagged(imapStream, cachePtr, context);
-			if (isError(retVal)) {
-				return(retVal);
-			}
+		retVal = interpretUntagged(imapStream, cachePtr, context);
+		if (isError(retVal)) {
+			return(retVal);
 		}
 	} while(1);
 
-	retVal = skipLine(imapStream);
-	if (isError(retVal)) { //Skip the rest of the line
+	retVal = skipSpace(imapStream); //Skip a space
+	if (isError(retVal)) {
 		return(retVal);
 	}
 
-	return(SUCCESS);
+	//Get the next word of the response
+	retVal = getStringObject(&servResponse, imapStream);
+	if (isError(retVal)) {
+		return(retVal);
+	}
+
+	//Case insenistive in case the server uses lowecase
+	strUpper(servResponse->content.string);
+
+	if (!strcmp(servResponse->content.string, "OK")) {
+		freeImapObject(servResponse);
+		//e.g. the capabilities of the server after a login
+		return(interpretRespCode(imapStream, cachePtr));
+	}
+	else if (!strcmp(servResponse->content.string, "NO")) {
+		freeImapObject(servResponse);
+		return(RESPONSE_NO);
+	}
+	freeImapObject(servResponse);
+
+	return(RESPONSE_BAD);
 }
 
-int sendFetchText(FILE *imapStream, msgCacheT *cachePtr, size_t msgNum) {
-	char command[COMMAND_SIZE];
+/* Waiting for the tagged response while interpreting any untagged responses 
+   is a pattern followed by many of the following functions */
+int sendCommand(FILE *imapStream, msgCacheT *cachePtr, char *command, int context) {
+	char commandTag[TAG_SIZE];
 	int retVal;
 
+	generateTag(commandTag);
+
+	//Send the command using the generated tag
+	if (fprintf(imapStream, "%s %s\r\n", commandTag, command) < 0) {
+		return(SOCKET_ERROR);
+	}
+
+	retVal = readResponse(imapStream, cachePtr, commandTag, context);
+	if (isError(retVal) || retVal == SUCCESS) {
+		return(retVal);
+	}
+
+	/* If it was a NO response, print the rest, as it could be an error message,
+	  but do not terminate (not fatal) */
+	fprintf(stderr, "[SERVER]: ");
+	if (retVal == RESPONSE_NO) {
+		return(printLine(stderr, imapStream));
+	}
+
+	/* Assuming this application follows the IMAP protocol correctly,
+	  a BAD response is the product of an incompatibility between implementations,
+	  or the server does not follow the protocol. In any case, print the rest as
+	  an error message and terminate (as an error code is returned) */
+	printLine(stderr, imapStream);
+
+	return(PARSE_ERROR);
+}
+
+/* Read the response to a pipelined command whose result no longer matters (e.g. a SELECT sent
+  behind a login that failed), the text of a NO or BAD is skipped instead of printed */
+int skipResponse(FILE *imapStream, msgCacheT *cachePtr, char *commandTag) {
+	int retVal;
+
+	retVal = readResponse(imapStream, cachePtr, commandTag, NO_CONTEXT);
+	if (isError(retVal) || retVal == SUCCESS) {
+		return(retVal);
+	}
+
+	return(skipLine(imapStream));
+}
+
+/* Fetch the text of a message, decoding it while it is read (check decoder.h), a multipart text is
+  split into its parts (check mime.h), and if saveDir is not NULL, its attachments are saved there */
+int fetchDecodedText(FILE *imapStream, msgCacheT *cachePtr, size_t msgNum, char *saveDir, int *savedPtr, int *failedPtr) {
+	char command[COMMAND_SIZE];
+	bodyDecoderT decoder;
+	mimeReaderT reader;
+	msgT *msgPtr;
+	int retVal, multipart;
+
+	*savedPtr = *failedPtr = 0;
+
+	//How the text is encoded is needed to decode it as it arrives, so it is fetched first
+	if (!cachePtr->msgPtrArray[msgNum-1]->structureFetched) {
+		sprintf(command, "FETCH %lu BODYSTRUCTURE", msgNum);
+		retVal = sendCommand(imapStream, cachePtr, command, NO_CONTEXT);
+		if (isError(retVal)) {
+			return(retVal);
+		}
+		if (msgNum > cachePtr->cacheSize) { //Expunged in the meantime
+			return(SUCCESS);
+		}
+	}
+	msgPtr = cachePtr->msgPtrArray[msgNum-1];
+
+	multipart = (msgPtr->boundary != NULL);
+	if (!multipart && saveDir) { //Nothing to save
+		return(SUCCESS);
+	}
+
+	if (multipart) {
+		mimeReaderInit(&reader, "RFC822.TEXT", msgPtr->boundary, saveDir);
+		setLiteralSink(&reader.parser.sink);
+	}
+	else {
+		decoderInit(&decoder, "RFC822.TEXT", msgPtr->encoding, msgPtr->charset);
+		setLiteralSink(&decoder.sink);
+	}
+
 	sprintf(command, "FETCH %lu RFC822.TEXT", msgNum);
 	retVal = sendCommand(imapStream, cachePtr, command, NO_CONTEXT);
-	if (isError(retVal)) {
+	setLiteralSink(NULL);
+
+	if (!multipart) {
+		freeDecoder(&decoder);
 		return(retVal);
 	}
 
-	return(SUCCESS);
+	//The attachments the reader found are kept with the message
+	if (!isError(retVal) && msgNum <= cachePtr->cacheSize) {
+		msgPtr = cachePtr->msgPtrArray[msgNum-1];
+		freeAttachments(msgPtr->attachments, msgPtr->attachmentCount);
+		msgPtr->attachments = reader.attachments;
+		msgPtr->attachmentCount = reader.attachmentCount;
+		reader.attachments = NULL;
+		reader.attachmentCount = 0;
+		cacheAccount(cachePtr, msgPtr);
+	}
+	*savedPtr = reader.saved;
+	*failedPtr = reader.failed;
+	freeMimeReader(&reader);
+
+	return(retVal);
+}
+
+int sendFetchText(FILE *imapStream, msgCacheT *cachePtr, size_t msgNum) {
+	int saved, failed;
+
+	return(fetchDecodedText(imapStream, cachePtr, msgNum, NULL, &saved, &failed));
+}
+
+int sendSaveAttachments(FILE *imapStream, msgCacheT *cachePtr, size_t msgNum, char *saveDir, int *savedPtr, int *failedPtr) {
+	return(fetchDecodedText(imapStream, cachePtr, msgNum, saveDir, savedPtr, failedPtr));
 }
 
 int sendFetchAll(FILE *imapStream, msgCacheT *cachePtr, size_t startNum, size_t endNum) {
@@ -118,10 +225,10 @@ int sendFetchAll(FILE *imapStream, msgCacheT *cachePtr, size_t startNum, size_t
 	}
 	
 	if (startNum == endNum) { //If startNum == endNum, fetch data for a single message
-		sprintf(command, "FETCH %lu ALL", startNum);
+		sprintf(command, "FETCH %lu " FETCH_ALL_ITEMS, startNum);
 	}
 	else {
-		sprintf(command, "FETCH %lu:%lu ALL", startNum, endNum);
+		sprintf(command, "FETCH %lu:%lu " FETCH_ALL_ITEMS, startNum, endNum);
 	}
 
 	retVal = sendCommand(imapStream, cachePtr, command, NO_CONTEXT);
@@ -132,104 +239,311 @@ int sendFetchAll(FILE *imapStream, msgCacheT *cachePtr, size_t startNum, size_t
 	return(SUCCESS);
 }
 
-/* This does not use the general sendCommand() function, as it behaves differently on NO responses,
- as a mailbox must always be selected, so SEND_AGAIN is returned to indicate the
- need to retry selecting a mailbox in case of a non-fatal error (NO) */
-int sendSelect(FILE *imapStream, msgCacheT *cachePtr, char *mailboxName) { 
-	char commandTag[TAG_SIZE];
-	imapObjectHandleT resTag, response;
+/* Fetch the data of all messages that are not in the cache, in as few commands as possible. The commands
+  are sent by the network thread (check background.h), so the cached messages can be displayed while the
+  rest arrive, e.g. the first page of a large mailbox, while the other thousands of messages are fetched */
+int fetchMissing(msgCacheT *cachePtr) {
+	char command[COMMAND_SIZE];
+	size_t start, end;
 	int retVal;
 
-	generateTag(commandTag);
+	for (start = 0 ; start < cachePtr->cacheSize ; start = end) {
+		if (cachePtr->msgPtrArray[start] != NULL) {
+			end = start + 1;
+			continue;
+		}
 
-	if (fprintf(imapStream, "%s SELECT %s\r\n", commandTag, mailboxName) < 0) {
-		return(SOCKET_ERROR);
-	}
-	
-	//Loop until a tagged response (with tag == commandTag) is recieved
-	do {
-		retVal = getStringObject(&resTag, imapStream);
+		//Find the end of the run of missing messages, and fetch the whole run at once
+		for (end = start ; end < cachePtr->cacheSize && !cachePtr->msgPtrArray[end] ; end++);
+		if (start+1 == end) {
+			sprintf(command, "FETCH %lu " FETCH_ALL_ITEMS, start+1);
+		}
+		else {
+			sprintf(command, "FETCH %lu:%lu " FETCH_ALL_ITEMS, start+1, end);
+		}
+		retVal = queueBackground(cachePtr, command);
 		if (isError(retVal)) {
 			return(retVal);
 		}
-		//If the response tag matches commandTag
-		if (!strcmp(resTag->content.string, commandTag)) {
-			freeImapObject(resTag);
+	}
 
-			if (isError(retVal = skipSpace(imapStream))) {
-				return(retVal);
-			}
-			break;
-		}
+	return(SUCCESS);
+}
 
-		//Else if untagged
-		freeImapObject(resTag);
+/* If the UIDVALIDITY of a just selected mailbox is not the one its messages were stashed with, the UIDs
+  in the search and flag indexes refer to other messages now, so they start over (only once, as the stash
+  is marked with the new UIDVALIDITY) */
+int checkUidValidity(msgCacheT *cachePtr) {
+	if (cachePtr->stashUidValidity == cachePtr->uidValidity) {
+		return(SUCCESS);
+	}
+
+	freeSearchIndex(cachePtr->searchIndex);
+	cachePtr->searchIndex = searchIndexInit();
+	if (!cachePtr->searchIndex) {
+		return(MEM_ERROR);
+	}
+	resetFlagIndex(cachePtr->flagIndex);
+	cachePtr->stashUidValidity = cachePtr->uidValidity;
+
+	return(SUCCESS);
+}
 
-		//Interpret it
-		retVal = interpretUntagged(imapStream, cachePtr, IN_SELECT);
+/* Bring the cache of a just selected mailbox up to date. If the mailbox was selected before,
+  and its UIDVALIDITY is the same, only the UIDs and flags of its messages are fetched, which
+  moves the cached messages back from the stash, and only the new messages are fetched in full.
+  If its UIDNEXT and the number of its messages are the same too, no message arrived, so none was
+  expunged either, and the stashed messages go back where they were, only their flags are fetched
+  (e.g. after reconnecting, check reconnect() in imap-client.c) */
+int refreshCache(FILE *imapStream, msgCacheT *cachePtr, int sortKey, int sortOrder) {
+	char command[COMMAND_SIZE];
+	int retVal;
+
+	if (cachePtr->stashSize > 0 && cachePtr->stashSize == cachePtr->cacheSize && cachePtr->stashUidValidity == cachePtr->uidValidity
+	  && cachePtr->uidNext != 0 && cachePtr->stashUidNext == cachePtr->uidNext) {
+		cacheRestoreStash(cachePtr);
+		sprintf(command, "FETCH 1:%lu (FLAGS)", cachePtr->cacheSize);
+		retVal = sendCommand(imapStream, cachePtr, command, NO_CONTEXT);
 		if (isError(retVal)) {
 			return(retVal);
 		}
-	} while(1);
+	}
+	else if (cachePtr->stashSize > 0 && cachePtr->stashUidValidity == cachePtr->uidValidity && cachePtr->cacheSize > 0) {
+		sprintf(command, "FETCH 1:%lu (UID FLAGS)", cachePtr->cacheSize);
+		retVal = sendCommand(imapStream, cachePtr, command, NO_CONTEXT);
+		if (isError(retVal)) {
+			return(retVal);
+		}
+	}
+	else if (isError(retVal = checkUidValidity(cachePtr))) {
+		return(retVal);
+	}
+	freeStash(cachePtr); //Whatever is left in the stash was expunged
 
-	//Else check the next word of the response
-	retVal = getStringObject(&response, imapStream);
+	/* In order to not waste time fetching the message data at the user's demand
+	  fetch all data except the text for the messages of the selected mailbox */
+	retVal = fetchMissing(cachePtr);
 	if (isError(retVal)) {
 		return(retVal);
 	}
 
-	strUpper(response->content.string); //Uppercase so that comparisons are case-insensitive 
+	/* Update the cache data, the previous and current sizes being equal, 
+	 indicates that no data needs to be fetched (for more on that, check interactionLoop() in main.c) */
+	cachePtr->prevSize = cachePtr->cacheSize; 
 
-	if (!strcmp(response->content.string, "OK")) {
-		freeImapObject(response);
+	//Rebuild the view the mailbox was displayed in, as the positions changed
+	return(selectSortOrder(cachePtr, sortKey, sortOrder));
+}
+
+/* This does not use the general sendCommand() function, as it behaves differently on NO responses,
+ as a mailbox must always be selected, so SEND_AGAIN is returned to indicate the
+ need to retry selecting a mailbox in case of a non-fatal error (NO).
+  If nothing is cached for the mailbox (e.g. it was never selected), a FETCH of its first page is
+ pipelined behind SELECT, so the first page is cached a round trip sooner, and the rest is fetched
+ after it (by refreshCache()). If loginTag is not NULL, a login command was written with that tag,
+ and SELECT goes out in the same flight as the login (check sendLoginSelect()) */
+int selectMailbox(FILE *imapStream, cacheManagerT *managerPtr, char *serverName, char *quotedName, char *loginTag, startupStatsT *statsPtr) { 
+	char selectTag[TAG_SIZE], fetchTag[TAG_SIZE];
+	msgCacheT *cachePtr;
+	int retVal, loginVal, sortKey, sortOrder, prefetch;
+
+	//Get the cache of the mailbox (kept from the last time it was selected, if any)
+	cachePtr = cacheManagerSelect(managerPtr, serverName);
+	if (!cachePtr) {
+		return(MEM_ERROR);
+	}
+
+	//Move the cached messages aside, they are moved back by UID as the server reports them
+	sortKey = cachePtr->sortKey;
+	sortOrder = cachePtr->sortOrder;
+	retVal = cacheStash(cachePtr);
+	if (isError(retVal)) {
+		return(retVal);
+	}
+
+	generateTag(selectTag);
+	if (fprintf(imapStream, "%s SELECT %s\r\n", selectTag, quotedName) < 0) {
+		return(SOCKET_ERROR);
+	}
+
+	//With nothing stashed, no UIDs are needed to move messages back, so the first page is fetched in full at once
+	prefetch = cachePtr->stashSize == 0;
+	if (prefetch) {
+		generateTag(fetchTag);
+		if (fprintf(imapStream, "%s FETCH 1:%d " FETCH_ALL_ITEMS "\r\n", fetchTag, PAGE_MSGS) < 0) {
+			return(SOCKET_ERROR);
+		}
+	}
+	//All the commands leave in a single write
+	if (fflush(imapStream) == EOF) {
+		return(SOCKET_ERROR);
+	}
+
+	if (loginTag != NULL) {
+		loginVal = readResponse(imapStream, cachePtr, loginTag, NO_CONTEXT);
+		if (isError(loginVal)) {
+			return(loginVal);
+		}
+		else if (loginVal != SUCCESS) {
+			//Only the reason the login failed is shown, the commands behind it fail because of it
+			fprintf(stderr, "[SERVER]: ");
+			if (isError(retVal = printLine(stderr, imapStream))) {
+				return(retVal);
+			}
+			if (isError(retVal = skipResponse(imapStream, cachePtr, selectTag))) {
+				return(retVal);
+			}
+			if (prefetch && isError(retVal = skipResponse(imapStream, cachePtr, fetchTag))) {
+				return(retVal);
+			}
+			cacheRestoreStash(cachePtr);
 
-		if (isError(retVal = skipLine(imapStream))) { //Skip the rest of the line
+			/* If a NO was returned, the user entered wrong credentials, so they must try again,
+			  if BAD was, the login command is probably not supported, so execution cannot continue */
+			return(loginVal == RESPONSE_NO ? SEND_AGAIN : COMMAND_ERROR);
+		}
+	}
+
+	retVal = readResponse(imapStream, cachePtr, selectTag, IN_SELECT);
+	if (retVal == SUCCESS) {
+		if (prefetch) {
+			//The search and flag indexes must be up to date before the messages are added to them
+			if (isError(retVal = checkUidValidity(cachePtr))) {
+				return(retVal);
+			}
+			/* If the mailbox has less than a page of messages, the range is out of bounds,
+			  which servers may reject, and the messages are fetched with the rest */
+			if (isError(retVal = skipResponse(imapStream, cachePtr, fetchTag))) {
+				return(retVal);
+			}
+		}
+		if (statsPtr != NULL) {
+			statsPtr->firstPageMs = elapsedMs(&statsPtr->start);
+		}
+		/* If the server can compress the connection (which is only known after the login), the rest of
+		  the mailbox is fetched compressed, the round trip of COMPRESS is left until the first page is in */
+		if (loginTag != NULL && hasCapability(CAP_COMPRESS_DEFLATE) && isError(retVal = sendCompress(imapStream, cachePtr))) {
 			return(retVal);
 		}
 
-		/* In order to not waste time fetching the message data at the user's demand
-		  fetch all data except the text for the messages of the selected mailbox */
-		retVal = sendFetchAll(imapStream, cachePtr, 1, cachePtr->cacheSize);
+		retVal = refreshCache(imapStream, cachePtr, sortKey, sortOrder);
 		if (isError(retVal)) {
 			return(retVal);
 		}
-		/* Update the cache data, the previous and current sizes being equal, 
-		 indicates that no data needs to be fetched (for more on that, check interactionLoop() in main.c) */
-		cachePtr->prevSize = cachePtr->cacheSize; 
+
+		//Now that the cache has grown, other mailboxes might have to make room for it (again, once the rest is in)
+		cacheManagerEvict(managerPtr);
+		//Else the time is taken once the network thread has fetched the rest (check interactionLoop() in imap-client.c)
+		if (statsPtr != NULL && !backgroundBusy()) {
+			statsPtr->selectMs = elapsedMs(&statsPtr->start);
+		}
 
 		return(SUCCESS);
 	}
-	else if (!strcmp(response->content.string, "NO")) {
-		freeImapObject(response);
-		fprintf(stderr, "[SERVER]: ");
+	else if (isError(retVal)) {
+		return(retVal);
+	}
+
+	//The mailbox wasn't selected, so keep its messages as they were
+	cacheRestoreStash(cachePtr);
+
+	fprintf(stderr, "[SERVER]: ");
+	if (retVal == RESPONSE_NO) {
 		if (isError(retVal = printLine(stderr, imapStream))) { //Print the server's error message and retry
 			return(retVal);
-		} 
-		return(SEND_AGAIN);
+		}
+		//No mailbox is selected after a failed SELECT, so the FETCH behind it fails too
+		if (prefetch && isError(retVal = skipResponse(imapStream, cachePtr, fetchTag))) {
+			return(retVal);
+		}
+		//INBOX always exists (RFC 3501), so if it can't be selected right after the login, something is wrong
+		return(loginTag != NULL ? COMMAND_ERROR : SEND_AGAIN);
 	}
 	//Something went terribly wrong (BAD or something unknown), print the rest of the response, and terminate
-	freeImapObject(response);
-	fprintf(stderr, "[SERVER]: ");
 	printLine(stderr, imapStream);
 
 	return(PARSE_ERROR);
 }
 
-int listMailboxNames(FILE *imapStream, msgCacheT *cachePtr) {
-	/* With "" (in essence, the root of the mailbox hiererachy) as the reference name (first arguement), the names
-	 are printed as they are supplied to SELECT, something that aids the user,
-	 and with the wildcard "%" as the mailbox name pattern (second arguement), the mailbox names
-	 that are printed, are those of the mailboxes that are directly under the root (so it does not
-	 print the names of all the mailboxes recursively) */
+//Get the name the server knows a mailbox by, as a quoted string (both dynamically allocated)
+int mailboxServerName(cacheManagerT *managerPtr, char *mailboxName, char **serverNamePtr, char **quotedNamePtr) {
+	int retVal;
+
+	retVal = folderServerName(managerPtr->folderTree, mailboxName, serverNamePtr);
+	if (isError(retVal)) {
+		return(retVal);
+	}
+
+	retVal = quoteString(*serverNamePtr, quotedNamePtr);
+	if (isError(retVal)) {
+		free(*serverNamePtr);
+		return(retVal);
+	}
+
+	return(SUCCESS);
+}
 
-	char command[COMMAND_SIZE] = "LIST \"\" %%"; 
+/* The name is the one the user typed (decoded), the server knows the mailbox by its
+  name in modified UTF-7 (check mailbox.h), sent as a quoted string, as it may contain spaces */
+int sendSelect(FILE *imapStream, cacheManagerT *managerPtr, char *mailboxName) {
+	char *serverName, *quotedName;
 	int retVal;
 
-	//Send a LIST command, the mailbox names will be printed by the interpretList function in untagged.h
-	retVal = sendCommand(imapStream, cachePtr, command, IN_LIST);
+	retVal = mailboxServerName(managerPtr, mailboxName, &serverName, &quotedName);
 	if (isError(retVal)) {
 		return(retVal);
 	}
+
+	retVal = selectMailbox(imapStream, managerPtr, serverName, quotedName, NULL, NULL);
+	free(serverName);
+	free(quotedName);
+
+	return(retVal);
+}
+
+int listMailboxNames(FILE *imapStream, cacheManagerT *managerPtr, int refresh) {
+	/* With "" (in essence, the root of the mailbox hiererachy) as the reference name (first arguement),
+	 the names are listed as they are supplied to SELECT, and with the wildcard "*" as the mailbox name
+	 pattern (second arguement), all the mailboxes are listed, at every level of the hierarchy, so the
+	 whole tree is built with a single command. After that, the tree is only listed again on a refresh */
+	char command[COMMAND_SIZE] = "LIST \"\" *"; 
+	folderTreeT *treePtr;
+	char *rendered;
+	int retVal;
+
+	if (!managerPtr->folderTree) {
+		managerPtr->folderTree = folderTreeInit();
+		if (!managerPtr->folderTree) {
+			return(MEM_ERROR);
+		}
+	}
+	treePtr = managerPtr->folderTree;
+
+	if (!treePtr->loaded || refresh) {
+		//Send a LIST command, the mailboxes are added to the tree by interpretList() in untagged.c
+		folderTreeStartRefresh(treePtr);
+		setListTree(treePtr);
+		retVal = sendCommand(imapStream, managerPtr->current, command, IN_LIST);
+		setListTree(NULL);
+		if (isError(retVal)) {
+			return(retVal);
+		}
+
+		retVal = folderTreeEndRefresh(treePtr);
+		if (isError(retVal)) {
+			return(retVal);
+		}
+	}
+
+	rendered = folderTreeRender(treePtr);
+	if (!rendered) {
+		return(MEM_ERROR);
+	}
+
+	if (treePtr->delimiter != '\0') {
+		printf("Mailboxes (select them by their full name, with '%c' between the levels):\n", treePtr->delimiter);
+	}
+	fputs(rendered, stdout);
 	putchar('\n');
 
 	return(SUCCESS);
@@ -248,6 +562,27 @@ int sendNoop(FILE *imapStream, msgCacheT *cachePtr) {
 	return(SUCCESS);
 }
 
+int checkMailbox(FILE *imapStream, msgCacheT *cachePtr) {
+	int retVal;
+
+	retVal = sendNoop(imapStream, cachePtr);
+	if (isError(retVal)) {
+		return(retVal);
+	}
+	if (cachePtr->cacheSize > cachePtr->prevSize) { 
+		/* If the cache grew (check cacheResize()), then there are new messages to be
+		 fetched */
+		retVal = sendFetchAll(imapStream, cachePtr, cachePtr->prevSize+1, cachePtr->cacheSize);
+		if (isError(retVal)) {
+			return(retVal);
+		}
+		//No need to fetch those anymore, so set prevSize to cacheSize
+		cachePtr->prevSize = cachePtr->cacheSize;
+	}
+
+	return(SUCCESS);
+}
+
 int deleteMsg(FILE *imapStream, msgCacheT *cachePtr, int msgNum) {
 	char command[COMMAND_SIZE];
 	int retVal;
@@ -269,6 +604,63 @@ int deleteMsg(FILE *imapStream, msgCacheT *cachePtr, int msgNum) {
 	return(SUCCESS);
 }
 
+//Add the \DELETED flag to the messages with the given UIDs (ascending), as ranges, in as few commands as fit
+int deleteUids(FILE *imapStream, msgCacheT *cachePtr, unsigned long *uids, size_t count) {
+	char command[UID_SET_SIZE + COMMAND_SIZE];
+	size_t k = 0, end, len, start;
+	int retVal;
+
+	while (k < count) {
+		start = len = sprintf(command, "UID STORE ");
+		//A range is at most 2 UIDs of 10 digits, a ':' and a ','
+		while (k < count && len < UID_SET_SIZE - 22) {
+			for (end = k ; end+1 < count && uids[end+1] == uids[end]+1 ; end++);
+			if (end > k) {
+				len += sprintf(command+len, "%s%lu:%lu", len > start ? "," : "", uids[k], uids[end]);
+			}
+			else {
+				len += sprintf(command+len, "%s%lu", len > start ? "," : "", uids[k]);
+			}
+			k = end+1;
+		}
+		//Not silent, so the server reports the new flags, and the cache is brought up to date
+		sprintf(command+len, " +FLAGS (\\DELETED)");
+		retVal = sendCommand(imapStream, cachePtr, command, NO_CONTEXT);
+		if (isError(retVal)) {
+			return(retVal);
+		}
+	}
+
+	return(SUCCESS);
+}
+
+int deleteFromSender(FILE *imapStream, msgCacheT *cachePtr, char *address) {
+	senderT *senderPtr;
+	unsigned long *uids;
+	size_t count;
+	int retVal;
+
+	//The messages are found through the sender index, without asking the server
+	senderPtr = senderFind(cachePtr->senderIndex, address);
+	if (!senderPtr || senderPtr->msgs == 0) {
+		printf("No messages from %s.\n", address);
+		return(SUCCESS);
+	}
+
+	retVal = bitmapToArray(&senderPtr->uids, &uids, &count);
+	if (isError(retVal)) {
+		return(retVal);
+	}
+	retVal = deleteUids(imapStream, cachePtr, uids, count);
+	free(uids);
+	if (isError(retVal)) {
+		return(retVal);
+	}
+	printf("%lu messages from %s were marked for deletion.\n", count, address);
+
+	return(SUCCESS);
+}
+
 int undeleteMsg(FILE *imapStream, msgCacheT *cachePtr, int msgNum) {
 	char command[COMMAND_SIZE];
 	int retVal;
@@ -300,70 +692,159 @@ int sendExpunge(FILE *imapStream, msgCacheT *cachePtr) {
 	return(SUCCESS);
 }
 
-int sendLogin(FILE *imapStream, char *username, char *password) {
+/* Write the login command, without waiting for its response. With SASL-IR (RFC 4959), AUTHENTICATE PLAIN
+  carries the credentials (in base 64, as "\0" <username> "\0" <password>, RFC 4616) in the command line,
+  like LOGIN does, so the commands behind it can be pipelined. Without SASL-IR it would have to wait for a
+  continuation, so LOGIN is sent instead */
+int writeLogin(FILE *imapStream, char *commandTag, char *username, char *password) {
+	size_t userLen, passLen, plainLen;
+	char *plain, *encoded, *quotedUser, *quotedPass;
+	int retVal = SUCCESS;
+
+	if (!hasCapability(CAP_SASL_IR) || !hasCapability(CAP_AUTH_PLAIN)) {
+		//Quoted, so that a '"' or a '\\' in the password does not end it, or add arguments to the command
+		if (isError(retVal = quoteString(username, &quotedUser))) {
+			return(retVal);
+		}
+		if (isError(retVal = quoteString(password, &quotedPass))) {
+			free(quotedUser);
+			return(retVal);
+		}
+		if (fprintf(imapStream, "%s LOGIN %s %s\r\n", commandTag, quotedUser, quotedPass) < 0) {
+			retVal = SOCKET_ERROR;
+		}
+		explicit_bzero(quotedPass, strlen(quotedPass));
+		free(quotedUser);
+		free(quotedPass);
+		return(retVal);
+	}
+
+	userLen = strlen(username);
+	passLen = strlen(password);
+	plainLen = userLen + passLen + 2;
+	plain = malloc(plainLen + B64_ENCODED_SIZE(plainLen) + 1);
+	if (!plain) {
+		return(MEM_ERROR);
+	}
+	plain[0] = '\0'; //No authorization identity, it is derived from the username
+	memcpy(plain+1, username, userLen);
+	plain[userLen+1] = '\0';
+	memcpy(plain+userLen+2, password, passLen);
+	encoded = plain + plainLen;
+	b64Encode(plain, plainLen, encoded);
+
+	if (fprintf(imapStream, "%s AUTHENTICATE PLAIN %s\r\n", commandTag, encoded) < 0) {
+		retVal = SOCKET_ERROR;
+	}
+	explicit_bzero(plain, plainLen + B64_ENCODED_SIZE(plainLen)); //The password does not linger in the heap
+	free(plain);
+
+	return(retVal);
+}
+
+int sendLoginSelect(FILE *imapStream, cacheManagerT *managerPtr, char *username, char *password, char *mailboxName, startupStatsT *statsPtr) {
+	char loginTag[TAG_SIZE], *serverName, *quotedName;
+	startupStatsT stats;
 	int retVal;
-	imapObjectHandleT resTag, response;
-	char commandTag[TAG_SIZE];
 
-	generateTag(commandTag);
+	if (!statsPtr) {
+		statsPtr = &stats;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &statsPtr->start);
 
-	//Attempt to send a LOGIN command
-	if (fprintf(imapStream, "%s LOGIN \"%s\" \"%s\"\r\n", commandTag, username, password) < 0) {
-		return(SOCKET_ERROR);
+	retVal = mailboxServerName(managerPtr, mailboxName, &serverName, &quotedName);
+	if (isError(retVal)) {
+		return(retVal);
+	}
+
+	generateTag(loginTag);
+	retVal = writeLogin(imapStream, loginTag, username, password);
+	if (!isError(retVal)) {
+		retVal = selectMailbox(imapStream, managerPtr, serverName, quotedName, loginTag, statsPtr);
 	}
+	free(serverName);
+	free(quotedName);
+
+	return(retVal);
+}
 
-	/* A mailbox wasn't selected, so no unsolicited responses will be sent, so if the
-	  tags don't match, a serious error has occured */
-	retVal = getStringObject(&resTag, imapStream);
+int sendReloginSelect(FILE *imapStream, cacheManagerT *managerPtr, char *username, char *password) {
+	char loginTag[TAG_SIZE], *serverName, *quotedName;
+	int retVal;
+
+	//The cache holds the name the server knows the mailbox by, so it needs no lookup
+	serverName = strdup(managerPtr->current->mailboxName);
+	if (!serverName) {
+		return(MEM_ERROR);
+	}
+	retVal = quoteString(serverName, &quotedName);
 	if (isError(retVal)) {
+		free(serverName);
 		return(retVal);
 	}
-	else if (strcmp(resTag->content.string, commandTag)) { 
-		fprintf(stderr, "Non matching tags, server-side protocol fail!\n");
-		freeImapObject(resTag);
-		return(PARSE_ERROR);
+
+	generateTag(loginTag);
+	retVal = writeLogin(imapStream, loginTag, username, password);
+	if (!isError(retVal)) {
+		retVal = selectMailbox(imapStream, managerPtr, serverName, quotedName, loginTag, NULL);
 	}
-	freeImapObject(resTag);
+	free(serverName);
+	free(quotedName);
 
-	if (isError(retVal = skipSpace(imapStream))) {
+	return(retVal);
+}
+
+int sendStartTls(FILE *imapStream, char *hostname, char *port, struct tlsStats *statsPtr) {
+	char commandTag[TAG_SIZE];
+	int retVal;
+
+	generateTag(commandTag);
+	if (fprintf(imapStream, "%s STARTTLS\r\n", commandTag) < 0) {
+		return(SOCKET_ERROR);
+	}
+
+	retVal = readResponse(imapStream, NULL, commandTag, NO_CONTEXT);
+	if (isError(retVal)) {
 		return(retVal);
 	}
+	else if (retVal != SUCCESS) {
+		fprintf(stderr, "[SERVER]: ");
+		printLine(stderr, imapStream);
+		return(COMMAND_ERROR);
+	}
 
-	retVal = getStringObject(&response, imapStream);
+	/* TLS is pushed onto the stream, and anything the stream read past the OK is dropped, as what
+	  arrives before the handshake could have been injected by an attacker (RFC 7457, 2.2) */
+	retVal = tlsOpen(imapStream, hostname, port, statsPtr);
 	if (isError(retVal)) {
 		return(retVal);
 	}
 
-	strUpper(response->content.string);
+	//The capabilities sent before TLS could have been tampered with, so they are asked for again
+	return(sendCommand(imapStream, NULL, "CAPABILITY", NO_CONTEXT));
+}
 
-	//If there was an OK response
-	if (!strcmp(response->content.string, "OK")) {
-		freeImapObject(response);
-		if (isError(retVal = skipLine(imapStream))) {
-			return(retVal);
-		}
-		return(SUCCESS);
-	}
-	/* If a NO was returned, the user entered wrong credentials, 
-	   so they must try again for the execution to progress (SEND_AGAIN) */
-	else if (!strcmp(response->content.string, "NO")) {
-		freeImapObject(response);
-		fprintf(stderr, "[SERVER]: ");
-		if (isError(retVal = printLine(stderr, imapStream))) {
-			return(retVal);
-		}
-		return(SEND_AGAIN);
+int sendCompress(FILE *imapStream, msgCacheT *cachePtr) {
+	char commandTag[TAG_SIZE];
+	int retVal;
+
+	generateTag(commandTag);
+	if (fprintf(imapStream, "%s COMPRESS DEFLATE\r\n", commandTag) < 0) {
+		return(SOCKET_ERROR);
 	}
-	/* If BAD was sent, LOGIN is probably not supported (some IMAP servers require other means of
-	 authentication), so execution cannot continue */
 
-	fprintf(stderr, "[SERVER]: ");
-	if (isError(retVal = printLine(stderr, imapStream))) {
+	retVal = readResponse(imapStream, cachePtr, commandTag, NO_CONTEXT);
+	if (isError(retVal)) {
 		return(retVal);
 	}
+	else if (retVal != SUCCESS) { //e.g. [COMPRESSIONACTIVE], the connection goes on as it was
+		return(skipLine(imapStream));
+	}
 
-	freeImapObject(response);
-	return(COMMAND_ERROR);
+	/* The server compresses everything after the OK, which it may start sending right away (e.g. an untagged
+	  response), so what the stream read ahead of the OK is compressed, and is kept for the new layer to
+	  inflate first (check compressOpen() in compress.h) */
+	return(compressOpen(imapStream));
 }
 
 int logout(FILE *imapStream) { 
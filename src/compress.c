@@ -0,0 +1,163 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <zlib.h>
+#include "error.h"
+#include "utils.h"
+#include "transport.h"
+#include "compress.h"
+
+//The state of the DEFLATE layer
+typedef struct compressState {
+	z_stream inflater, deflater;
+	char inBuf[TRANSPORT_BUFFER_SIZE]; //What was read from the layer below, and not inflated yet
+	char outBuf[TRANSPORT_BUFFER_SIZE]; //What was deflated, and not written to the layer below yet
+	size_t compressedIn, compressedOut; //The bytes read from, and written to, the layer below
+	double inflateMs; //The time zlib took
+} compressStateT;
+
+ssize_t compressRead(transportT *layerPtr, char *buf, size_t size) {
+	compressStateT *statePtr = layerPtr->state;
+	z_stream *zPtr = &statePtr->inflater;
+	struct timespec start;
+	ssize_t len;
+	int zRet;
+
+	size = size > UINT32_MAX ? UINT32_MAX : size; //What zlib takes at once
+	zPtr->next_out = (Bytef *)buf;
+	zPtr->avail_out = size;
+
+	//Only what has arrived is inflated, the layer below is read again only if none of it made a whole byte
+	while (zPtr->avail_out == size) {
+		if (zPtr->avail_in == 0) {
+			len = transportRead(layerPtr->below, statePtr->inBuf, TRANSPORT_BUFFER_SIZE);
+			if (len <= 0) {
+				return(len);
+			}
+			statePtr->compressedIn += len;
+			zPtr->next_in = (Bytef *)statePtr->inBuf;
+			zPtr->avail_in = len;
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		zRet = inflate(zPtr, Z_SYNC_FLUSH);
+		statePtr->inflateMs += elapsedMs(&start);
+		//The server never ends the stream, it only flushes it
+		if (zRet != Z_OK && zRet != Z_BUF_ERROR) {
+			return(-1);
+		}
+	}
+
+	return(size - zPtr->avail_out);
+}
+
+//Write what was deflated to the layer below
+int flushDeflated(transportT *layerPtr) {
+	compressStateT *statePtr = layerPtr->state;
+	struct iovec iov = {statePtr->outBuf, TRANSPORT_BUFFER_SIZE - statePtr->deflater.avail_out};
+
+	if (iov.iov_len > 0 && transportWritev(layerPtr->below, &iov, 1) < 0) {
+		return(SOCKET_ERROR);
+	}
+	statePtr->compressedOut += iov.iov_len;
+	statePtr->deflater.next_out = (Bytef *)statePtr->outBuf;
+	statePtr->deflater.avail_out = TRANSPORT_BUFFER_SIZE;
+
+	return(SUCCESS);
+}
+
+ssize_t compressWritev(transportT *layerPtr, const struct iovec *iov, int iovCount) {
+	compressStateT *statePtr = layerPtr->state;
+	z_stream *zPtr = &statePtr->deflater;
+	ssize_t total = 0;
+	int flush;
+
+	for (int k = 0 ; k < iovCount ; k++) {
+		zPtr->next_in = iov[k].iov_base;
+		zPtr->avail_in = iov[k].iov_len;
+		//The last buffer ends with a flush, so that the server can inflate the whole of it
+		flush = k == iovCount - 1 ? Z_SYNC_FLUSH : Z_NO_FLUSH;
+		//deflate() takes all the input, unless the output buffer fills up, in which case it is written out
+		while (1) {
+			deflate(zPtr, flush); //Cannot fail, the stream is never ended
+			if (zPtr->avail_out > 0) {
+				break;
+			}
+			if (isError(flushDeflated(layerPtr))) {
+				return(-1);
+			}
+		}
+		if (flush == Z_SYNC_FLUSH && isError(flushDeflated(layerPtr))) {
+			return(-1);
+		}
+		total += iov[k].iov_len;
+	}
+
+	return(total);
+}
+
+void compressClose(transportT *layerPtr) {
+	compressStateT *statePtr = layerPtr->state;
+
+	inflateEnd(&statePtr->inflater);
+	deflateEnd(&statePtr->deflater);
+	free(statePtr);
+}
+
+void compressPrintStats(transportT *layerPtr) {
+	compressStateT *statePtr = layerPtr->state;
+
+	if (statePtr->compressedIn > 0) {
+		printf("           received %zu bytes as %zu (%.1f:1), inflated at %.0f MB/s\n", layerPtr->bytesRead, statePtr->compressedIn,
+		  (double)layerPtr->bytesRead / statePtr->compressedIn, statePtr->inflateMs > 0 ? layerPtr->bytesRead / (statePtr->inflateMs * 1000) : 0);
+	}
+	if (statePtr->compressedOut > 0) {
+		//The commands are short, and each one is flushed, so they compress little, and how fast tells nothing
+		printf("           sent %zu bytes as %zu (%.1f:1)\n", layerPtr->bytesWritten, statePtr->compressedOut, (double)layerPtr->bytesWritten / statePtr->compressedOut);
+	}
+}
+
+int compressOpen(FILE *imapStream) {
+	compressStateT *statePtr;
+	transportT *layerPtr;
+	int retVal;
+
+	statePtr = calloc(1, sizeof(compressStateT));
+	if (!statePtr) {
+		return(MEM_ERROR);
+	}
+	//Negative window bits make a raw DEFLATE stream, without the zlib header and checksum
+	if (inflateInit2(&statePtr->inflater, -COMPRESS_WINDOW_BITS) != Z_OK) {
+		free(statePtr);
+		return(MEM_ERROR);
+	}
+	if (deflateInit2(&statePtr->deflater, COMPRESS_LEVEL, Z_DEFLATED, -COMPRESS_WINDOW_BITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+		inflateEnd(&statePtr->inflater);
+		free(statePtr);
+		return(MEM_ERROR);
+	}
+	statePtr->deflater.next_out = (Bytef *)statePtr->outBuf;
+	statePtr->deflater.avail_out = TRANSPORT_BUFFER_SIZE;
+
+	layerPtr = newTransport("deflate", compressRead, compressWritev, compressClose, statePtr);
+	if (!layerPtr) {
+		inflateEnd(&statePtr->inflater);
+		deflateEnd(&statePtr->deflater);
+		free(statePtr);
+		return(MEM_ERROR);
+	}
+	layerPtr->printStats = compressPrintStats;
+
+	//The server may compress what it sends right after the OK, which the stream may have read already
+	retVal = pushTransport(imapStream, layerPtr, TRANSPORT_KEEP_READ_AHEAD);
+	if (isError(retVal)) {
+		compressClose(layerPtr);
+		free(layerPtr);
+	}
+
+	return(retVal);
+}
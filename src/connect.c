@@ -0,0 +1,308 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include "error.h"
+#include "utils.h"
+#include "connect.h"
+
+#define MAX_ADDRESSES 16 //The addresses of a host that are tried
+
+//The addresses of a host, in the order they are tried
+typedef struct dnsEntry {
+	char *hostname;
+	char *port;
+	struct sockaddr_storage addrs[MAX_ADDRESSES];
+	socklen_t addrLens[MAX_ADDRESSES];
+	int count;
+	time_t resolvedAt;
+	struct dnsEntry *next;
+} dnsEntryT;
+
+dnsEntryT *dnsCache = NULL; //A client connects to a handful of hosts at most, so a list will do
+
+dnsEntryT *findDnsEntry(char *hostname, char *port) {
+	for (dnsEntryT *entryPtr = dnsCache ; entryPtr != NULL ; entryPtr = entryPtr->next) {
+		if (!strcasecmp(entryPtr->hostname, hostname) && !strcmp(entryPtr->port, port)) {
+			return(entryPtr);
+		}
+	}
+
+	return(NULL);
+}
+
+/* Resolve the name into entryPtr, the addresses are interleaved by family (RFC 8305, section 4),
+  starting with the family of the address getaddrinfo() prefers (RFC 6724) */
+int resolveHost(dnsEntryT *entryPtr) {
+	struct addrinfo hints = {0};
+	struct addrinfo *addrHead, *iter, *byFamily[2][MAX_ADDRESSES];
+	int counts[2] = {0, 0}, firstFamily = AF_UNSPEC, family, k;
+
+	hints.ai_family = AF_UNSPEC; //Both IPv4 and IPv6
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_ADDRCONFIG; //Only the families the host has an address of
+	if (getaddrinfo(entryPtr->hostname, entryPtr->port, &hints, &addrHead) != 0) {
+		return(SYSCALL_ERROR);
+	}
+
+	for (iter = addrHead ; iter != NULL ; iter = iter->ai_next) {
+		if (iter->ai_family != AF_INET && iter->ai_family != AF_INET6) {
+			continue;
+		}
+		if (firstFamily == AF_UNSPEC) {
+			firstFamily = iter->ai_family;
+		}
+		family = iter->ai_family != firstFamily; //0 for the preferred family, 1 for the other
+		if (counts[family] < MAX_ADDRESSES) {
+			byFamily[family][counts[family]++] = iter;
+		}
+	}
+
+	entryPtr->count = 0;
+	for (k = 0 ; entryPtr->count < MAX_ADDRESSES && (k < counts[0] || k < counts[1]) ; k++) {
+		for (family = 0 ; family < 2 ; family++) {
+			if (k < counts[family] && entryPtr->count < MAX_ADDRESSES) {
+				memcpy(&entryPtr->addrs[entryPtr->count], byFamily[family][k]->ai_addr, byFamily[family][k]->ai_addrlen);
+				entryPtr->addrLens[entryPtr->count] = byFamily[family][k]->ai_addrlen;
+				entryPtr->count++;
+			}
+		}
+	}
+	freeaddrinfo(addrHead);
+	entryPtr->resolvedAt = time(NULL);
+
+	return(entryPtr->count > 0 ? SUCCESS : SYSCALL_ERROR);
+}
+
+//Get the (cached if fresh) addresses of a host
+int getHostAddresses(char *hostname, char *port, int refresh, dnsEntryT **entryPtrPtr, connectStatsT *statsPtr) {
+	struct timespec start;
+	dnsEntryT *entryPtr;
+	int retVal;
+
+	entryPtr = findDnsEntry(hostname, port);
+	if (entryPtr != NULL && !refresh && time(NULL) - entryPtr->resolvedAt < DNS_CACHE_TTL) {
+		statsPtr->cached = 1;
+		statsPtr->resolveMs = 0;
+		*entryPtrPtr = entryPtr;
+		return(SUCCESS);
+	}
+
+	if (!entryPtr) {
+		entryPtr = calloc(1, sizeof(dnsEntryT));
+		if (!entryPtr) {
+			return(MEM_ERROR);
+		}
+		entryPtr->hostname = strdup(hostname);
+		entryPtr->port = strdup(port);
+		if (!entryPtr->hostname || !entryPtr->port) {
+			free(entryPtr->hostname);
+			free(entryPtr->port);
+			free(entryPtr);
+			return(MEM_ERROR);
+		}
+		entryPtr->next = dnsCache;
+		dnsCache = entryPtr;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	retVal = resolveHost(entryPtr);
+	statsPtr->resolveMs = elapsedMs(&start);
+	statsPtr->cached = 0;
+	if (isError(retVal)) {
+		entryPtr->resolvedAt = 0; //Resolved again next time
+		return(retVal);
+	}
+	*entryPtrPtr = entryPtr;
+
+	return(SUCCESS);
+}
+
+/* Start a non-blocking connect() to an address, returns the socket, or SOCKET_ERROR
+  if it failed at once, *connectedPtr is set if it connected at once (e.g. to localhost) */
+int startConnect(struct sockaddr_storage *addrPtr, socklen_t addrLen, int *connectedPtr) {
+	int sockFd;
+
+	*connectedPtr = 0;
+	sockFd = socket(addrPtr->ss_family, SOCK_STREAM, 0);
+	if (sockFd < 0) {
+		return(SOCKET_ERROR);
+	}
+	if (fcntl(sockFd, F_SETFL, fcntl(sockFd, F_GETFL) | O_NONBLOCK) < 0) {
+		close(sockFd);
+		return(SOCKET_ERROR);
+	}
+
+	if (connect(sockFd, (struct sockaddr *)addrPtr, addrLen) == 0) {
+		*connectedPtr = 1;
+	}
+	else if (errno != EINPROGRESS) {
+		close(sockFd);
+		return(SOCKET_ERROR);
+	}
+
+	return(sockFd);
+}
+
+/* Race the connections to the addresses, returns the socket of the first one to connect,
+  and its position in *winnerPtr */
+int raceConnect(dnsEntryT *entryPtr, int *winnerPtr, connectStatsT *statsPtr) {
+	struct pollfd pending[MAX_ADDRESSES];
+	int pendingAddr[MAX_ADDRESSES]; //The address each pending socket connects to
+	int pendingCount = 0, next = 0, sockFd = SOCKET_ERROR, fd, connected, error, ready, k;
+	double nextAt = 0, elapsed;
+	socklen_t errorLen;
+	struct timespec start;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	statsPtr->attempts = 0;
+
+	while (sockFd < 0) {
+		elapsed = elapsedMs(&start);
+		if (elapsed >= CONNECT_TIMEOUT) {
+			break;
+		}
+
+		//Start the next attempt, when its time comes, or at once if no attempt is pending
+		if (next < entryPtr->count && (pendingCount == 0 || elapsed >= nextAt)) {
+			fd = startConnect(&entryPtr->addrs[next], entryPtr->addrLens[next], &connected);
+			statsPtr->attempts++;
+			if (fd >= 0 && connected) {
+				sockFd = fd;
+				*winnerPtr = next;
+				break;
+			}
+			else if (fd >= 0) {
+				pending[pendingCount].fd = fd;
+				pending[pendingCount].events = POLLOUT;
+				pendingAddr[pendingCount++] = next;
+			}
+			next++;
+			nextAt = elapsed + CONNECT_ATTEMPT_DELAY;
+			continue;
+		}
+		if (pendingCount == 0) { //Every address failed
+			break;
+		}
+
+		//Wait for a pending attempt to finish, until the next attempt is due
+		ready = poll(pending, pendingCount, (int)((next < entryPtr->count ? nextAt : CONNECT_TIMEOUT) - elapsed) + 1);
+		if (ready < 0 && errno != EINTR) {
+			break;
+		}
+		for (k = 0 ; ready > 0 && k < pendingCount ; k++) {
+			if (!pending[k].revents) {
+				continue;
+			}
+			errorLen = sizeof(error);
+			if (getsockopt(pending[k].fd, SOL_SOCKET, SO_ERROR, &error, &errorLen) == 0 && error == 0) {
+				sockFd = pending[k].fd;
+				*winnerPtr = pendingAddr[k];
+				pending[k] = pending[--pendingCount]; //So that it is not closed with the rest
+				break;
+			}
+			//It failed, so the next address is tried at once
+			close(pending[k].fd);
+			pending[k] = pending[--pendingCount];
+			pendingAddr[k] = pendingAddr[pendingCount];
+			nextAt = elapsed;
+			k--;
+		}
+	}
+
+	//The attempts that lost the race
+	for (k = 0 ; k < pendingCount ; k++) {
+		close(pending[k].fd);
+	}
+	statsPtr->connectMs = elapsedMs(&start);
+	if (sockFd < 0) {
+		return(SOCKET_ERROR);
+	}
+
+	//The socket is read through stdio, so it goes back to blocking mode
+	if (fcntl(sockFd, F_SETFL, fcntl(sockFd, F_GETFL) & ~O_NONBLOCK) < 0) {
+		close(sockFd);
+		return(SOCKET_ERROR);
+	}
+
+	return(sockFd);
+}
+
+void formatAddress(struct sockaddr_storage *addrPtr, char address[ADDRESS_STR_SIZE]) {
+	char host[INET6_ADDRSTRLEN] = "?";
+
+	if (addrPtr->ss_family == AF_INET6) {
+		struct sockaddr_in6 *addr6Ptr = (struct sockaddr_in6 *)addrPtr;
+
+		inet_ntop(AF_INET6, &addr6Ptr->sin6_addr, host, sizeof(host));
+		snprintf(address, ADDRESS_STR_SIZE, "[%s]:%d", host, ntohs(addr6Ptr->sin6_port));
+	}
+	else {
+		struct sockaddr_in *addr4Ptr = (struct sockaddr_in *)addrPtr;
+
+		inet_ntop(AF_INET, &addr4Ptr->sin_addr, host, sizeof(host));
+		snprintf(address, ADDRESS_STR_SIZE, "%s:%d", host, ntohs(addr4Ptr->sin_port));
+	}
+}
+
+int establishConnection(char *hostname, char *port, connectStatsT *statsPtr) {
+	struct sockaddr_storage addr;
+	socklen_t addrLen;
+	connectStatsT stats = {0};
+	dnsEntryT *entryPtr;
+	int sockFd, winner, retVal;
+
+	retVal = getHostAddresses(hostname, port, 0, &entryPtr, &stats);
+	if (isError(retVal)) {
+		return(retVal);
+	}
+	sockFd = raceConnect(entryPtr, &winner, &stats);
+
+	//Cached addresses may be stale (e.g. the server moved), so the name is resolved again
+	if (sockFd < 0 && stats.cached) {
+		retVal = getHostAddresses(hostname, port, 1, &entryPtr, &stats);
+		if (isError(retVal)) {
+			return(retVal);
+		}
+		sockFd = raceConnect(entryPtr, &winner, &stats);
+	}
+	if (sockFd < 0) {
+		return(SOCKET_ERROR);
+	}
+
+	//The address that connected is tried first next time
+	addr = entryPtr->addrs[winner];
+	addrLen = entryPtr->addrLens[winner];
+	memmove(&entryPtr->addrs[1], &entryPtr->addrs[0], winner * sizeof(struct sockaddr_storage));
+	memmove(&entryPtr->addrLens[1], &entryPtr->addrLens[0], winner * sizeof(socklen_t));
+	entryPtr->addrs[0] = addr;
+	entryPtr->addrLens[0] = addrLen;
+
+	formatAddress(&addr, stats.address);
+	if (statsPtr != NULL) {
+		*statsPtr = stats;
+	}
+
+	return(sockFd);
+}
+
+void freeDnsCache(void) {
+	dnsEntryT *next;
+
+	for (dnsEntryT *entryPtr = dnsCache ; entryPtr != NULL ; entryPtr = next) {
+		next = entryPtr->next;
+		free(entryPtr->hostname);
+		free(entryPtr->port);
+		free(entryPtr);
+	}
+	dnsCache = NULL;
+}
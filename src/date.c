@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "error.h"
+#include "date.h"
+
+/* For reading on the date-time format, check RFC 3501 (the formal syntax section), and
+  for the conversion between dates and days since the epoch, check
+  http://howardhinnant.github.io/date_algorithms.html */
+
+#define DATE_LEN 26 //The length of "DD-Mon-YYYY HH:MM:SS +ZZZZ"
+
+#define SECS_PER_DAY 86400
+
+static const char *monthNames[12] = {
+	"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+	"Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
+};
+
+/* Month names are packed into an integer (in lowercase), so that finding the
+  month only takes comparing integers, instead of strings */
+static const int packedMonths[12] = {
+	('j' << 16) | ('a' << 8) | 'n', ('f' << 16) | ('e' << 8) | 'b', ('m' << 16) | ('a' << 8) | 'r',
+	('a' << 16) | ('p' << 8) | 'r', ('m' << 16) | ('a' << 8) | 'y', ('j' << 16) | ('u' << 8) | 'n',
+	('j' << 16) | ('u' << 8) | 'l', ('a' << 16) | ('u' << 8) | 'g', ('s' << 16) | ('e' << 8) | 'p',
+	('o' << 16) | ('c' << 8) | 't', ('n' << 16) | ('o' << 8) | 'v', ('d' << 16) | ('e' << 8) | 'c'
+};
+
+//Convert two (or four) digit characters to a number, returns -1 if any is not a digit
+int getDigits(char *str, int digits) {
+	int num = 0;
+
+	for (int k = 0 ; k < digits ; k++) {
+		if (str[k] < '0' || str[k] > '9') {
+			return(-1);
+		}
+		num = num*10 + str[k] - '0';
+	}
+
+	return(num);
+}
+
+//Returns the month (0 to 11) the three characters correspond to, or -1 if they are not a month name
+int getMonth(char *str) {
+	int packed;
+
+	//ORing with 0x20 converts ASCII letters to lowercase, so the comparison is case-insensitive
+	packed = ((str[0] | 0x20) << 16) | ((str[1] | 0x20) << 8) | (str[2] | 0x20);
+	for (int k = 0 ; k < 12 ; k++) {
+		if (packed == packedMonths[k]) {
+			return(k);
+		}
+	}
+
+	return(-1);
+}
+
+//The number of days in the given month (0 to 11), of the given year
+int daysInMonth(int year, int month) {
+	static const int monthDays[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+	if (month == 1 && year % 4 == 0 && (year % 100 != 0 || year % 400 == 0)) { //February of a leap year
+		return(29);
+	}
+
+	return(monthDays[month]);
+}
+
+//The number of days from 1970-01-01 to the given date (month is 1 to 12)
+long daysFromCivil(long year, int month, int day) {
+	long era, yearOfEra, dayOfYear, dayOfEra;
+
+	year -= month <= 2;
+	era = (year >= 0 ? year : year-399) / 400;
+	yearOfEra = year - era*400;
+	dayOfYear = (153*(month > 2 ? month-3 : month+9) + 2)/5 + day-1;
+	dayOfEra = yearOfEra*365 + yearOfEra/4 - yearOfEra/100 + dayOfYear;
+
+	return(era*146097 + dayOfEra - 719468);
+}
+
+int parseDateTime(char *dateStr, time_t *datePtr, int *tzOffsetPtr) {
+	int day, month, year, hours, mins, secs, zone, tzOffset;
+	char padded[DATE_LEN+1];
+	int k;
+
+	/* Some servers send a single digit day, without padding it, it is padded by
+	  a space here, so that the rest of the fields are where the format puts them */
+	if (dateStr[0] != '\0' && dateStr[1] == '-') {
+		padded[0] = ' ';
+		for (k = 0 ; k < DATE_LEN && dateStr[k] != '\0' ; k++) {
+			padded[k+1] = dateStr[k];
+		}
+		if (k != DATE_LEN-1) { //Too short, or too long
+			return(PARSE_ERROR);
+		}
+		padded[DATE_LEN] = '\0';
+		dateStr = padded;
+	}
+
+	//Check the length, and the position of the separators, as the format is fixed
+	for (k = 0 ; k < DATE_LEN && dateStr[k] != '\0' ; k++);
+	if (k != DATE_LEN || dateStr[DATE_LEN] != '\0') {
+		return(PARSE_ERROR);
+	}
+	if (dateStr[2] != '-' || dateStr[6] != '-' || dateStr[11] != ' ' || 
+	    dateStr[14] != ':' || dateStr[17] != ':' || dateStr[20] != ' ') {
+		return(PARSE_ERROR);
+	}
+
+	//The day can be padded by a space instead of a zero
+	if (dateStr[0] == ' ') {
+		day = getDigits(dateStr+1, 1);
+	}
+	else {
+		day = getDigits(dateStr, 2);
+	}
+	month = getMonth(dateStr+3);
+	year = getDigits(dateStr+7, 4);
+	hours = getDigits(dateStr+12, 2);
+	mins = getDigits(dateStr+15, 2);
+	secs = getDigits(dateStr+18, 2);
+	zone = getDigits(dateStr+22, 4);
+	if (day < 1 || month < 0 || year < 0 || hours < 0 || hours > 23 
+	    || mins < 0 || mins > 59 || secs < 0 || secs > 60 || zone < 0 || zone % 100 > 59) {
+		return(PARSE_ERROR);
+	}
+	if (day > daysInMonth(year, month)) { //e.g. 31-Feb, which would become a date in March
+		return(PARSE_ERROR);
+	}
+
+	//The zone is in the format +HHMM or -HHMM, convert it to minutes
+	tzOffset = (zone / 100)*60 + zone % 100;
+	if (dateStr[21] == '-') {
+		tzOffset = -tzOffset;
+	}
+	else if (dateStr[21] != '+') {
+		return(PARSE_ERROR);
+	}
+
+	//The date is local to the zone, so subtract the offset to get UTC
+	*datePtr = (time_t)daysFromCivil(year, month+1, day)*SECS_PER_DAY 
+	           + hours*3600 + mins*60 + secs - tzOffset*60;
+	*tzOffsetPtr = tzOffset;
+
+	return(SUCCESS);
+}
+
+void formatDateTime(char dateStr[DATE_SIZE], time_t date, int tzOffset) {
+	struct tm tm;
+	char buf[64]; //Larger than needed, as the compiler can't know the range of the struct tm fields
+	time_t localDate = date + tzOffset*60;
+	int absOffset = tzOffset < 0 ? -tzOffset : tzOffset;
+
+	if (date == DATE_UNKNOWN) {
+		snprintf(dateStr, DATE_SIZE, "(Unknown Date)");
+		return;
+	}
+
+	//Shifting by the offset, and then using gmtime_r(), gives the date in the zone it was sent in
+	if (!gmtime_r(&localDate, &tm)) {
+		snprintf(dateStr, DATE_SIZE, "(Unknown Date)");
+		return;
+	}
+
+	snprintf(buf, sizeof(buf), "%02d-%s-%04d %02d:%02d:%02d %c%02d%02d", tm.tm_mday, 
+	         monthNames[tm.tm_mon], tm.tm_year + 1900, tm.tm_hour, tm.tm_min, tm.tm_sec, 
+	         tzOffset < 0 ? '-' : '+', absOffset / 60, absOffset % 60);
+	memcpy(dateStr, buf, DATE_SIZE-1);
+	dateStr[DATE_SIZE-1] = '\0';
+}
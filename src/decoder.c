@@ -0,0 +1,272 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "parsing.h"
+#include "error.h"
+#include "utils.h"
+#include "base64.h"
+#include "charset.h"
+#include "decoder.h"
+
+int findEncoding(char *name) {
+	if (!strcasecmp(name, "BASE64")) {
+		return(ENCODING_BASE64);
+	}
+	else if (!strcasecmp(name, "QUOTED-PRINTABLE")) {
+		return(ENCODING_QP);
+	}
+
+	return(ENCODING_IDENTITY);
+}
+
+//Used as the functions of the decoder's sink, the sink is the first member of the decoder
+int decoderSinkStart(literalSinkT *sinkPtr, size_t size) {
+	return(decoderStart((bodyDecoderT*)sinkPtr, size));
+}
+
+int decoderSinkWrite(literalSinkT *sinkPtr, char *chunk, size_t len) {
+	return(decoderWrite((bodyDecoderT*)sinkPtr, chunk, len));
+}
+
+int decoderSinkEnd(literalSinkT *sinkPtr, char **strPtr) {
+	return(decoderEnd((bodyDecoderT*)sinkPtr, strPtr));
+}
+
+void decoderInit(bodyDecoderT *decoderPtr, char *item, int encoding, int charset) {
+	decoderPtr->sink.item = item;
+	decoderPtr->sink.start = decoderSinkStart;
+	decoderPtr->sink.write = decoderSinkWrite;
+	decoderPtr->sink.end = decoderSinkEnd;
+
+	decoderPtr->encoding = encoding;
+	decoderPtr->charset = charset;
+	decoderPtr->encCarryLen = decoderPtr->charsetCarryLen = 0;
+	decoderPtr->raw = NULL;
+	decoderPtr->rawCap = 0;
+	decoderPtr->text = NULL;
+	decoderPtr->textLen = decoderPtr->textCap = 0;
+	decoderPtr->outFile = NULL;
+}
+
+void freeDecoder(bodyDecoderT *decoderPtr) {
+	free(decoderPtr->raw);
+	free(decoderPtr->text);
+	decoderPtr->raw = decoderPtr->text = NULL;
+	decoderPtr->rawCap = decoderPtr->textLen = decoderPtr->textCap = 0;
+}
+
+//Make room for len more bytes of text (and the '\0'), the capacity is doubled to keep appending linear
+int reserveText(bodyDecoderT *decoderPtr, size_t len) {
+	size_t newCap;
+	char *temp;
+
+	if (decoderPtr->textLen + len + 1 <= decoderPtr->textCap) {
+		return(SUCCESS);
+	}
+
+	newCap = decoderPtr->textCap*2;
+	if (newCap < decoderPtr->textLen + len + 1) {
+		newCap = decoderPtr->textLen + len + 1;
+	}
+	temp = realloc(decoderPtr->text, newCap);
+	if (!temp) {
+		return(MEM_ERROR);
+	}
+	decoderPtr->text = temp;
+	decoderPtr->textCap = newCap;
+
+	return(SUCCESS);
+}
+
+int decoderStart(bodyDecoderT *decoderPtr, size_t size) {
+	decoderPtr->encCarryLen = decoderPtr->charsetCarryLen = 0;
+	decoderPtr->textLen = 0;
+	charsetReset(decoderPtr->charset);
+	if (decoderPtr->outFile) {
+		return(SUCCESS);
+	}
+
+	//The decoded text is about as long as the body, so that is the first guess
+	return(reserveText(decoderPtr, size));
+}
+
+//Convert transfer-decoded bytes to UTF-8, and append them to the text
+int appendDecoded(bodyDecoderT *decoderPtr, char *bytes, size_t len) {
+	char joined[2*CARRY_SIZE];
+	size_t joinedLen, carryLen = decoderPtr->charsetCarryLen, converted;
+	int retVal;
+
+	if (decoderPtr->outFile) {
+		return(fwrite(bytes, 1, len, decoderPtr->outFile) < len ? SYSCALL_ERROR : SUCCESS);
+	}
+
+	retVal = reserveText(decoderPtr, UTF8_EXPANSION*(len + carryLen));
+	if (isError(retVal)) {
+		return(retVal);
+	}
+
+	//A character split between chunks is converted first, joined with the bytes that complete it
+	if (carryLen > 0) {
+		joinedLen = carryLen + (len < CARRY_SIZE ? len : CARRY_SIZE);
+		memcpy(joined, decoderPtr->charsetCarry, carryLen);
+		memcpy(joined + carryLen, bytes, joinedLen - carryLen);
+		decoderPtr->textLen += charsetToUtf8Part(decoderPtr->charset, joined, joinedLen, 
+		                                         decoderPtr->text + decoderPtr->textLen, &converted);
+
+		if (converted < carryLen) { //Still incomplete, so all of the chunk was joined
+			decoderPtr->charsetCarryLen = joinedLen - converted < CARRY_SIZE ? joinedLen - converted : CARRY_SIZE;
+			memmove(decoderPtr->charsetCarry, joined + converted, decoderPtr->charsetCarryLen);
+			return(SUCCESS);
+		}
+		bytes += converted - carryLen;
+		len -= converted - carryLen;
+	}
+
+	decoderPtr->textLen += charsetToUtf8Part(decoderPtr->charset, bytes, len, 
+	                                         decoderPtr->text + decoderPtr->textLen, &converted);
+
+	//An incomplete character at the end waits for the next chunk
+	decoderPtr->charsetCarryLen = len - converted < CARRY_SIZE ? len - converted : CARRY_SIZE;
+	memcpy(decoderPtr->charsetCarry, bytes + converted, decoderPtr->charsetCarryLen);
+
+	return(SUCCESS);
+}
+
+/* Decode quoted-printable text (RFC 2045) into decoded (which can be the text itself), "=XX" stands
+  for the byte with the hexadecimal value XX, and a '=' at the end of a line is a soft line break
+  (the line continues on the next one). Unless final is set, a '=' too close to the end to tell
+  what it is waits for the next chunk, consumedPtr gets the number of bytes decoded */
+size_t qpDecode(char *qpStr, size_t len, char *decoded, int final, size_t *consumedPtr) {
+	size_t pos = 0, bytes = 0, run;
+	char *equals;
+	int high, low;
+
+	while (pos < len) {
+		//Most of the text stands for itself, so it is copied up to the next '=' at once
+		equals = memchr(qpStr + pos, '=', len - pos);
+		run = equals ? equals - (qpStr + pos) : len - pos;
+		memmove(decoded + bytes, qpStr + pos, run);
+		bytes += run;
+		pos += run;
+		if (!equals) {
+			break;
+		}
+
+		if (len - pos < 3 && !final) { //Can't tell yet
+			break;
+		}
+		if (len - pos >= 2 && qpStr[pos+1] == '\n') { //Soft line break
+			pos += 2;
+		}
+		else if (len - pos >= 3 && qpStr[pos+1] == '\r' && qpStr[pos+2] == '\n') {
+			pos += 3;
+		}
+		else if (len - pos >= 3 && (high = hexDigitValue(qpStr[pos+1])) >= 0 && (low = hexDigitValue(qpStr[pos+2])) >= 0) {
+			decoded[bytes++] = (high << 4) | low;
+			pos += 3;
+		}
+		else { //A '=' that is not followed by either stands for itself
+			decoded[bytes++] = '=';
+			pos++;
+		}
+	}
+	*consumedPtr = pos;
+
+	return(bytes);
+}
+
+//Make room for the encoded bytes of a chunk, and the ones carried from the previous one
+int reserveRaw(bodyDecoderT *decoderPtr, size_t len) {
+	char *temp;
+
+	if (len <= decoderPtr->rawCap) {
+		return(SUCCESS);
+	}
+
+	temp = realloc(decoderPtr->raw, len);
+	if (!temp) {
+		return(MEM_ERROR);
+	}
+	decoderPtr->raw = temp;
+	decoderPtr->rawCap = len;
+
+	return(SUCCESS);
+}
+
+int decoderWrite(bodyDecoderT *decoderPtr, char *chunk, size_t len) {
+	size_t rawLen, whole, bytes, consumed;
+	int retVal;
+
+	if (decoderPtr->encoding == ENCODING_IDENTITY) {
+		return(appendDecoded(decoderPtr, chunk, len));
+	}
+
+	retVal = reserveRaw(decoderPtr, decoderPtr->encCarryLen + len);
+	if (isError(retVal)) {
+		return(retVal);
+	}
+	memcpy(decoderPtr->raw, decoderPtr->encCarry, decoderPtr->encCarryLen);
+
+	//Both encodings decode to fewer bytes than they take, so the bytes are decoded in place
+	if (decoderPtr->encoding == ENCODING_BASE64) {
+		//Whole quartets of digits are decoded, the rest is carried
+		rawLen = decoderPtr->encCarryLen + b64Strip(chunk, len, decoderPtr->raw + decoderPtr->encCarryLen);
+		whole = rawLen / 4 * 4;
+		decoderPtr->encCarryLen = rawLen - whole;
+		memcpy(decoderPtr->encCarry, decoderPtr->raw + whole, decoderPtr->encCarryLen);
+
+		//Can't fail, as there are only digits, and no padding
+		b64Decode(decoderPtr->raw, whole, decoderPtr->raw, &bytes);
+	}
+	else {
+		memcpy(decoderPtr->raw + decoderPtr->encCarryLen, chunk, len);
+		rawLen = decoderPtr->encCarryLen + len;
+		bytes = qpDecode(decoderPtr->raw, rawLen, decoderPtr->raw, 0, &consumed);
+		decoderPtr->encCarryLen = rawLen - consumed;
+		memcpy(decoderPtr->encCarry, decoderPtr->raw + consumed, decoderPtr->encCarryLen);
+	}
+
+	return(appendDecoded(decoderPtr, decoderPtr->raw, bytes));
+}
+
+int decoderEnd(bodyDecoderT *decoderPtr, char **textPtr) {
+	char lastBytes[CARRY_SIZE], *temp;
+	size_t bytes = 0, consumed;
+	int retVal;
+
+	//The body can end in an unpadded quartet, or a '=' that stands for itself
+	if (decoderPtr->encoding == ENCODING_BASE64) {
+		if (isError(b64Decode(decoderPtr->encCarry, decoderPtr->encCarryLen, lastBytes, &bytes))) {
+			bytes = 0; //A single digit is not a byte, so it is dropped
+		}
+	}
+	else if (decoderPtr->encoding == ENCODING_QP) {
+		bytes = qpDecode(decoderPtr->encCarry, decoderPtr->encCarryLen, lastBytes, 1, &consumed);
+	}
+	retVal = appendDecoded(decoderPtr, lastBytes, bytes);
+	if (isError(retVal)) {
+		return(retVal);
+	}
+	if (decoderPtr->outFile) {
+		*textPtr = NULL;
+		return(SUCCESS);
+	}
+
+	//A character that never got completed is converted as is (to U+FFFD)
+	retVal = reserveText(decoderPtr, UTF8_EXPANSION*decoderPtr->charsetCarryLen);
+	if (isError(retVal)) {
+		return(retVal);
+	}
+	decoderPtr->textLen += charsetToUtf8(decoderPtr->charset, decoderPtr->charsetCarry, decoderPtr->charsetCarryLen,
+	                                     decoderPtr->text + decoderPtr->textLen);
+	decoderPtr->text[decoderPtr->textLen] = '\0';
+
+	//Give back what was reserved but not used, as the text is kept in the cache
+	temp = realloc(decoderPtr->text, decoderPtr->textLen + 1);
+	*textPtr = temp ? temp : decoderPtr->text;
+	decoderPtr->text = NULL;
+	decoderPtr->textLen = decoderPtr->textCap = 0;
+
+	return(SUCCESS);
+}
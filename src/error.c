@@ -31,5 +31,11 @@ void printError(char *message, int retVal) {
 		case SYSCALL_ERROR:
 			perror(NULL);
 			break;
+		case TLS_ERROR:
+			fputs("TLS error.", stderr);
+			break;
+	}
+	if (retVal != SYSCALL_ERROR) { //perror() ends the line itself
+		fputc('\n', stderr);
 	}
 }
\ No newline at end of file
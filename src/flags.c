@@ -0,0 +1,121 @@
+#include <stdlib.h>
+#include "error.h"
+#include "bitmap.h"
+#include "flags.h"
+
+flagIndexT *flagIndexInit(void) {
+	flagIndexT *indexPtr;
+
+	indexPtr = malloc(sizeof(flagIndexT));
+	if (!indexPtr) {
+		return(NULL);
+	}
+
+	bitmapInit(&indexPtr->known);
+	for (int k = 0 ; k < FLAG_KINDS ; k++) {
+		bitmapInit(&indexPtr->withFlag[k]);
+	}
+
+	return(indexPtr);
+}
+
+//The flags are powers of two, so the position of the bit is used to pick their bitmap
+bitmapT *flagBitmap(flagIndexT *indexPtr, int flag) {
+	return(&indexPtr->withFlag[__builtin_ctz(flag)]);
+}
+
+int flagIndexUpdate(flagIndexT *indexPtr, unsigned long uid, int flags) {
+	int retVal;
+
+	if (uid == 0) { //The message can't be identified yet, it is added when its UID is fetched
+		return(SUCCESS);
+	}
+
+	retVal = bitmapAdd(&indexPtr->known, uid);
+	if (isError(retVal)) {
+		return(retVal);
+	}
+
+	//Adding or removing a UID that is already there (or not) does nothing, so only the changes count
+	for (int k = 0 ; k < FLAG_KINDS ; k++) {
+		if (flags & (1 << k)) {
+			retVal = bitmapAdd(&indexPtr->withFlag[k], uid);
+			if (isError(retVal)) {
+				return(retVal);
+			}
+		}
+		else {
+			bitmapRemove(&indexPtr->withFlag[k], uid);
+		}
+	}
+
+	return(SUCCESS);
+}
+
+void flagIndexRemove(flagIndexT *indexPtr, unsigned long uid) {
+	if (uid == 0) {
+		return;
+	}
+
+	bitmapRemove(&indexPtr->known, uid);
+	for (int k = 0 ; k < FLAG_KINDS ; k++) {
+		bitmapRemove(&indexPtr->withFlag[k], uid);
+	}
+}
+
+size_t flagCount(flagIndexT *indexPtr, int flag, int missing) {
+	size_t count = flagBitmap(indexPtr, flag)->card;
+
+	//Every message with a flag has known flags, so the rest are the ones without it
+	return(missing ? indexPtr->known.card - count : count);
+}
+
+int flagIndexFilter(flagIndexT *indexPtr, int setFlags, int unsetFlags, unsigned long **uidsPtr, size_t *countPtr) {
+	bitmapT result, temp, empty;
+	int retVal;
+
+	//Start from all the messages, and narrow down by each flag
+	bitmapInit(&empty);
+	retVal = bitmapAndNot(&indexPtr->known, &empty, &result);
+	if (isError(retVal)) {
+		return(retVal);
+	}
+
+	for (int k = 0 ; k < FLAG_KINDS && result.card > 0 ; k++) {
+		if (setFlags & (1 << k)) {
+			retVal = bitmapAnd(&result, &indexPtr->withFlag[k], &temp);
+		}
+		else if (unsetFlags & (1 << k)) {
+			retVal = bitmapAndNot(&result, &indexPtr->withFlag[k], &temp);
+		}
+		else {
+			continue;
+		}
+		freeBitmap(&result);
+		if (isError(retVal)) {
+			return(retVal);
+		}
+		result = temp;
+	}
+
+	retVal = bitmapToArray(&result, uidsPtr, countPtr);
+	freeBitmap(&result);
+
+	return(retVal);
+}
+
+void resetFlagIndex(flagIndexT *indexPtr) {
+	freeBitmap(&indexPtr->known);
+	for (int k = 0 ; k < FLAG_KINDS ; k++) {
+		freeBitmap(&indexPtr->withFlag[k]);
+	}
+}
+
+void freeFlagIndex(flagIndexT *indexPtr) {
+	if (!indexPtr) {
+		return;
+	}
+
+	resetFlagIndex(indexPtr);
+	free(indexPtr);
+}
@@ -1,9 +1,9 @@
 #include <stdio.h>
-#include <sys/socket.h>
-#include <netdb.h>
+#include <stdlib.h>
 #include <string.h>
 #include <poll.h>
 #include <unistd.h>
+#include <errno.h>
 #include "error.h"
 #include "parsing.h"
 #include "utils.h"
@@ -12,99 +12,164 @@
 #include "untagged.h"
 #include "printing.h"
 #include "commands.h"
+#include "sort.h"
+#include "browse.h"
+#include "bitmap.h"
+#include "senders.h"
+#include "search.h"
+#include "connect.h"
+#include "transport.h"
+#include "tls.h"
+#include "background.h"
 
 #define NAME_SIZE 64 //Used for user input
 #define NOOP_INTERVAL 3000 //Interval before sending a NOOP to server in microseconds
+#define INDEX_BATCH 1000 //Envelopes indexed between checks for input while idle, about 10 ms worth
 #define MAX_LINE 128 //Used of user input
-
-int establishConnection(char *hostname, char *port); //Establish connection with server
+#define CACHE_MEM_BUDGET (256*1024*1024) //The memory (in bytes) the caches of all mailboxes may use
+#define IMAPS_PORT "993" //The port of IMAP over TLS
+#define RECONNECT_ATTEMPTS 8 //Before giving up on a lost connection, about a minute and a half in all
+#define RECONNECT_DELAY 500 //Milliseconds before the second attempt to reconnect, doubled for every next one
+#define RECONNECT_MAX_DELAY 30000 //The longest wait between attempts
+
+//What is needed to connect, and log in, again, if the connection is lost (check reconnect())
+typedef struct session {
+	char *hostname, *port;
+	char *security; //tls, starttls or plain
+	char username[NAME_SIZE], password[NAME_SIZE];
+} sessionT;
+
+/* Connect to the server, start TLS as the session asks, and get the greeting, errors are printed.
+  If *imapStreamPtr is NULL, a stream is opened, else the connection takes the place of the one of the stream */
+int openConnection(sessionT *sessionPtr, FILE **imapStreamPtr);
+/* Connect again, after the connection was lost, waiting RECONNECT_DELAY after the first failed attempt,
+  twice that after the next (up to RECONNECT_MAX_DELAY), and so on, for RECONNECT_ATTEMPTS attempts.
+  The stream stays the same (check resetTransport() in transport.h), the login is sent again, and the
+  mailbox that was selected is selected again, its cache is kept, and brought up to date */
+int reconnect(FILE *imapStream, cacheManagerT *managerPtr, sessionT *sessionPtr);
 int getGreeting(FILE *imapStream); //Get the server greeting (according to the IMAP protocol)
-int attemptLogin(FILE *imapStream); /* Try to login (with user inputted credentials), 
-                                      until success, or the user chooses to quit */
-int interactionLoop(FILE *imapStream, msgCacheT *cachePtr); //Polls stdin for input, and after a timeout sends NOOP to server
-int handleUserInput(FILE *imapStream, msgCacheT *cachePtr); //Executes commands entered by the yser
-int userSelectMailbox(FILE *imapStream, msgCacheT *cachePtr); /* Loops until the user selects an existing mailbox, 
+void printTlsStats(tlsStatsT *statsPtr); //Print how the TLS session was set up
+int attemptLogin(FILE *imapStream, cacheManagerT *managerPtr, sessionT *sessionPtr, startupStatsT *statsPtr); /* Try to login (with user inputted
+                      credentials, kept in the session), and select INBOX, until success, or the user chooses to quit */
+/* Polls stdin for input, and after a timeout sends NOOP to server, reconnects if the connection is lost,
+  applies what the network thread fetched meanwhile (check background.h) */
+int interactionLoop(FILE *imapStream, cacheManagerT *managerPtr, sessionT *sessionPtr, startupStatsT *statsPtr);
+/* Index the envelopes of the mailbox that have not been indexed yet (check search.h), in batches of
+  INDEX_BATCH, until they are all indexed, or the user enters input, or the network thread has something */
+int indexWhileIdle(msgCacheT *cachePtr, struct pollfd *pollfds);
+int handleUserInput(FILE *imapStream, cacheManagerT *managerPtr); //Executes commands entered by the yser
+int readMailboxName(char mailboxName[MAX_LINE]); //Reads a mailbox name, that can contain spaces
+int userSelectMailbox(FILE *imapStream, cacheManagerT *managerPtr); /* Loops until the user selects an existing mailbox, 
                                                          or selects INBOX if the user stops trying */
+int userSortMailbox(msgCacheT *cachePtr); //Changes the order the pages are displayed in
+/* Whether the messages of a page are cached, while the network thread fetches the rest (check background.h),
+  only pages in sequence number order can be displayed before all the messages are in */
+int pageCached(msgCacheT *cachePtr, int pageNum);
+int userFilterMailbox(msgCacheT *cachePtr); //Displays the messages with (or without) the given flags
 
 
 int main(int argc, char *argv[]) {
-	int imapSock, retVal;
-	FILE *imapStream;
-	msgCacheT *msgCache;
+	int retVal;
+	FILE *imapStream = NULL;
+	cacheManagerT *cacheManager;
+	startupStatsT startupStats = {0};
+	sessionT session = {0};
 
 	if (argc < 3) {
-		fprintf(stderr, "Run with <hostname> <port> next time.\n");
+		fprintf(stderr, "Run with <hostname> <port> [tls|starttls|plain] next time.\n");
+		return(1);
+	}
+	session.hostname = argv[1];
+	session.port = argv[2];
+
+	/* By default, TLS starts right away on the IMAPS port, and elsewhere the connection must be upgraded
+	  with STARTTLS. It is not left to whether the greeting offers it, as an attacker on the way can strip
+	  that from the greeting, to have the password sent in the clear (and again on every reconnection),
+	  so the password is only ever sent unencrypted if plain was asked for */
+	session.security = argc > 3 ? argv[3] : !strcmp(argv[2], IMAPS_PORT) ? "tls" : "starttls";
+	if (strcmp(session.security, "tls") && strcmp(session.security, "starttls") && strcmp(session.security, "plain")) {
+		fprintf(stderr, "The connection is either tls, starttls or plain.\n");
 		return(1);
 	}
 
-	imapSock = establishConnection(argv[1], argv[2]);
-	if (isError(imapSock)) {
-		printError("Failed to establish connection", imapSock);
+	retVal = openConnection(&session, &imapStream);
+	if (isError(retVal)) {
+		if (imapStream != NULL) {
+			fclose(imapStream);
+		}
+		freeDnsCache();
+		freeTlsContext();
 		return(1);
 	}
 
-	//Open the socket as a FILE stream in order to utilize functions from stdio.h
-	imapStream = fdopen(imapSock, "r+b"); 
-	if (!imapStream) {
-		printError("Failed to establish connection", SYSCALL_ERROR);
-		close(imapSock);
+	cacheManager = cacheManagerInit(CACHE_MEM_BUDGET);
+	if (!cacheManager) {
+		fclose(imapStream);
+		printError("Cache initialization failed", MEM_ERROR);
 		return(1);
 	}
 
-	retVal = getGreeting(imapStream);
+	//Most of a mailbox is fetched by the network thread (check background.h), which owns the stream meanwhile
+	retVal = startBackground(imapStream);
 	if (isError(retVal)) {
+		freeCacheManager(cacheManager);
 		fclose(imapStream);
-		printError("Problem with getting greeting", retVal);
+		printError("The network thread could not be started", retVal);
 		return(1);
 	}
 
-	retVal = attemptLogin(imapStream);
+	//The login and the selection of the inbox are sent together
+	retVal = attemptLogin(imapStream, cacheManager, &session, &startupStats);
 	if (isError(retVal)) { //BAD
+		stopBackground();
 		fclose(imapStream);
+		freeCacheManager(cacheManager);
 		printError("Login failed horribly", retVal);
 		return(1);
 	}
-	//If QUIT was returned, user refused to retry, so don't select a mailbox, and skip to the end
+	//If QUIT was returned, user refused to retry, so skip to the end
 	else if (retVal != QUIT) {
 		printf("Login was successful!\n");
-
-		msgCache = cacheInit();
-		if (!msgCache) {
-			fclose(imapStream);
-			printError("Cache initialization failed", retVal);
-			return(1);
+		if (backgroundBusy()) {
+			printf("Mailbox was selected successfully! (first page in %.1f ms, the rest is being fetched)\n", startupStats.firstPageMs);
 		}
-
-		retVal = sendSelect(imapStream, msgCache, "INBOX"); //Choose inbox by default
-		if (isError(retVal)) {
-			printError("Inbox selection failed", retVal);
-			fclose(imapStream);
-			freeMsgCache(msgCache);
-			return(1);
+		else {
+			printf("Mailbox was selected successfully! (first page in %.1f ms, whole mailbox in %.1f ms)\n", startupStats.firstPageMs, startupStats.selectMs);
 		}
-		printf("Mailbox was selected successfully!\n");
 
-		retVal = interactionLoop(imapStream, msgCache); //Enter the interaction loop
+		watchTerminalSize(); //If it fails, the previews keep the width they had
+		retVal = interactionLoop(imapStream, cacheManager, &session, &startupStats); //Enter the interaction loop
+		stopBackground(); //The stream is only used by this thread from here on
 		if (isError(retVal)) {
 			printError("Something went wrong", retVal);
-			freeMsgCache(msgCache);
+			freeCacheManager(cacheManager);
 			fclose(imapStream);
+			explicit_bzero(session.password, NAME_SIZE);
 			return(1);
 		}
 
-		//Free cache
-		freeMsgCache(msgCache);
+		//Free the caches
+		freeCacheManager(cacheManager);
 
 		//Attempt to logout
 		retVal = logout(imapStream);
 		if (isError(retVal)) {
 			printError("Logout didn't go well", retVal);
 			fclose(imapStream);
+			explicit_bzero(session.password, NAME_SIZE);
 			return(1);
 		}
 	}
+	else {
+		stopBackground();
+		freeCacheManager(cacheManager);
+	}
+	explicit_bzero(session.password, NAME_SIZE); //Kept until now, to log in again after reconnecting
 	
-	if (fclose(imapStream) < 0) { //Calling fclose() closes both imapSock and imapStream
+	retVal = fclose(imapStream); //Calling fclose() closes every layer of imapStream, and the socket
+	freeDnsCache();
+	freeTlsContext();
+	if (retVal < 0) {
 		return(1);
 	}
 
@@ -113,40 +178,104 @@ int main(int argc, char *argv[]) {
 	return(0);
 }
 
-int establishConnection(char *hostname, char *port) {
-	int sockFd;
-	struct addrinfo hints = {0};
-	struct addrinfo *addrHead, *iter;
+int openConnection(sessionT *sessionPtr, FILE **imapStreamPtr) {
+	connectStatsT connectStats;
+	tlsStatsT tlsStats;
+	int imapSock, retVal;
+	char *security = sessionPtr->security;
 
-	hints.ai_family = AF_INET;
-	hints.ai_socktype = SOCK_STREAM;
-	if (getaddrinfo(hostname, port, &hints, &addrHead) != 0) {
-		return(SYSCALL_ERROR);
+	imapSock = establishConnection(sessionPtr->hostname, sessionPtr->port, &connectStats);
+	if (isError(imapSock)) {
+		printError("Failed to establish connection", imapSock);
+		return(imapSock);
+	}
+	if (connectStats.cached) {
+		printf("Connected to %s in %.1f ms (addresses cached, %d attempted)\n", connectStats.address, connectStats.connectMs, connectStats.attempts);
+	}
+	else {
+		printf("Connected to %s in %.1f ms (DNS %.1f ms, %d attempted)\n", connectStats.address, connectStats.connectMs, connectStats.resolveMs, connectStats.attempts);
 	}
 
-	/* Iterate through the address list, until connecting to an address,
-	  or reaching the end of the list */
-	for (iter = addrHead ; iter != NULL ; iter = iter->ai_next) {
-		sockFd = socket(AF_INET, SOCK_STREAM, 0); //Create a socket
-		if (sockFd < 0) {
-			freeaddrinfo(addrHead);
-			return(SYSCALL_ERROR);
+	/* Open the socket as a FILE stream in order to utilize functions from stdio.h (check transport.h),
+	  or if the stream of a lost connection is given, the socket takes the place of that connection */
+	if (!*imapStreamPtr) {
+		*imapStreamPtr = openTransportStream(imapSock);
+		retVal = *imapStreamPtr != NULL ? SUCCESS : MEM_ERROR;
+	}
+	else {
+		retVal = resetTransport(*imapStreamPtr, imapSock);
+	}
+	if (isError(retVal)) {
+		printError("Failed to establish connection", retVal);
+		close(imapSock);
+		return(retVal);
+	}
+
+	if (!strcmp(security, "tls")) {
+		//The stream goes through TLS (check tls.h)
+		retVal = tlsOpen(*imapStreamPtr, sessionPtr->hostname, sessionPtr->port, &tlsStats);
+		if (isError(retVal)) {
+			printError("Failed to establish connection", retVal);
+			return(retVal);
 		}
-		//If connect() succeds, break
-		if (connect(sockFd, iter->ai_addr, iter->ai_addrlen) == 0) {
-			break;
+		printTlsStats(&tlsStats);
+	}
+
+	retVal = getGreeting(*imapStreamPtr);
+	if (isError(retVal)) {
+		printError("Problem with getting greeting", retVal);
+		return(retVal);
+	}
+
+	if (!strcmp(security, "starttls")) {
+		//Tried even if the greeting does not offer it, which may only mean that it was stripped on the way
+		retVal = sendStartTls(*imapStreamPtr, sessionPtr->hostname, sessionPtr->port, &tlsStats);
+		if (isError(retVal)) {
+			printError("STARTTLS failed", retVal);
+			fprintf(stderr, "The password is not sent unencrypted, unless the client is run with plain.\n");
+			return(retVal);
 		}
-		close(sockFd);
+		printTlsStats(&tlsStats);
 	}
 
-	if (!iter) { //Failed to connect to any of the addresses, or no addresses
-		freeaddrinfo(addrHead);
-		return(SOCKET_ERROR);
+	return(SUCCESS);
+}
+
+int reconnect(FILE *imapStream, cacheManagerT *managerPtr, sessionT *sessionPtr) {
+	struct timespec start;
+	int retVal = SOCKET_ERROR, delay = RECONNECT_DELAY;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	printf("\nThe connection to the server was lost, reconnecting...\n");
+	for (int attempt = 1 ; attempt <= RECONNECT_ATTEMPTS ; attempt++) {
+		retVal = openConnection(sessionPtr, &imapStream);
+		if (!isError(retVal)) {
+			retVal = sendReloginSelect(imapStream, managerPtr, sessionPtr->username, sessionPtr->password);
+			if (retVal == SUCCESS) {
+				printf("Reconnected in %.1f ms, %s.\n", elapsedMs(&start), backgroundBusy() ? "the messages that arrived are being fetched" : "the mailbox is up to date");
+				return(SUCCESS);
+			}
+			else if (retVal == SEND_AGAIN) { //The credentials are not accepted anymore
+				return(COMMAND_ERROR);
+			}
+		}
+
+		//Only a connection that could not be made, or was lost again, is worth another attempt
+		if (retVal != SOCKET_ERROR && retVal != SYSCALL_ERROR) {
+			return(retVal);
+		}
+		if (attempt < RECONNECT_ATTEMPTS) {
+			printf("Attempt %d of %d failed, trying again in %.1f s\n", attempt, RECONNECT_ATTEMPTS, delay / 1000.0);
+			poll(NULL, 0, delay);
+			delay = delay * 2 > RECONNECT_MAX_DELAY ? RECONNECT_MAX_DELAY : delay * 2;
+		}
 	}
 
-	freeaddrinfo(addrHead);
+	return(retVal);
+}
 
-	return(sockFd);
+void printTlsStats(tlsStatsT *statsPtr) {
+	printf("%s (%s), handshake in %.1f ms%s\n", statsPtr->version, statsPtr->cipher, statsPtr->handshakeMs, statsPtr->resumed ? " (resumed)" : "");
 }
 
 int getGreeting(FILE *imapStream) { //The successful greeting is "*" OK <text> CRLF
@@ -175,10 +304,8 @@ int getGreeting(FILE *imapStream) { //The successful greeting is "*" OK <text> C
 	//if the response is OK
 	else if (!strcmp(response->content.string, "OK")) {
 		freeImapObject(response);
-		if (isError(retVal = skipLine(imapStream))) { //Skip the restof the line
-			return(retVal);
-		}
-		return(SUCCESS);
+		//The greeting may advertise the capabilities of the server, which saves asking for them
+		return(interpretRespCode(imapStream, NULL));
 	}
 
 	//If the response was not OK, something went wrong
@@ -189,8 +316,8 @@ int getGreeting(FILE *imapStream) { //The successful greeting is "*" OK <text> C
 	return(PARSE_ERROR);
 }
 
-int attemptLogin(FILE *imapStream) {
-	char username[NAME_SIZE], password[NAME_SIZE], format[10];
+int attemptLogin(FILE *imapStream, cacheManagerT *managerPtr, sessionT *sessionPtr, startupStatsT *statsPtr) {
+	char *username = sessionPtr->username, *password = sessionPtr->password, format[10];
 	char option;
 	int retVal;
 
@@ -202,7 +329,7 @@ int attemptLogin(FILE *imapStream) {
 		scanf(format, username);
 		printf("Enter password: ");
 		scanf(format, password);
-		retVal = sendLogin(imapStream, username, password);
+		retVal = sendLoginSelect(imapStream, managerPtr, username, password, "INBOX", statsPtr); //Choose inbox by default
 		if (isError(retVal)) {
 			return(retVal);
 		}
@@ -221,18 +348,37 @@ int attemptLogin(FILE *imapStream) {
 	return(QUIT); //If the user stops trying, return QUIT in order to notify main() to close the program
 }
 
-int userSelectMailbox(FILE *imapStream, msgCacheT *cachePtr) {
-	char mailboxName[NAME_SIZE];
+/* Read a mailbox name, it is the rest of the line (without the surrounding whitespace), as names
+  can contain spaces, empty lines are skipped. Returns 0 if the input is over */
+int readMailboxName(char mailboxName[MAX_LINE]) {
+	size_t start, end;
+
+	do {
+		if (!fgets(mailboxName, MAX_LINE, stdin)) {
+			return(0);
+		}
+
+		start = strspn(mailboxName, " \t");
+		for (end = strcspn(mailboxName, "\r\n") ; end > start && (mailboxName[end-1] == ' ' || mailboxName[end-1] == '\t') ; end--);
+	} while (end == start);
+
+	memmove(mailboxName, mailboxName + start, end - start);
+	mailboxName[end - start] = '\0';
+
+	return(1);
+}
+
+int userSelectMailbox(FILE *imapStream, cacheManagerT *managerPtr) {
+	char mailboxName[MAX_LINE];
 	int retVal;
 	char option;
-	char mailFormat[10];
-
-	sprintf(mailFormat, "%%%ds", NAME_SIZE-1);
 
 	//Loop until SELECT succeds, or user stops trying
 	do {
-		scanf(mailFormat, mailboxName);
-		retVal = sendSelect(imapStream, cachePtr, mailboxName);
+		if (!readMailboxName(mailboxName)) {
+			break;
+		}
+		retVal = sendSelect(imapStream, managerPtr, mailboxName);
 		if (isError(retVal)) {
 			return(retVal);
 		}
@@ -253,7 +399,7 @@ int userSelectMailbox(FILE *imapStream, msgCacheT *cachePtr) {
 	} while (option == 'y' || option == 'Y'); 
 
 	//If user stops trying, select inbox by default
-	retVal = sendSelect(imapStream, cachePtr, "INBOX");
+	retVal = sendSelect(imapStream, managerPtr, "INBOX");
 	if (isError(retVal)) {
 		return(retVal);
 	}
@@ -263,21 +409,141 @@ int userSelectMailbox(FILE *imapStream, msgCacheT *cachePtr) {
 	return(SUCCESS);
 }
 
-int handleUserInput(FILE *imapStream, msgCacheT *cachePtr) {
+int userSortMailbox(msgCacheT *cachePtr) {
+	char line[MAX_LINE], keyStr[MAX_LINE], orderStr[MAX_LINE] = "asc";
+	int sortKey, sortOrder;
+
+	//The order is optional, so the rest of the line is read instead of using scanf() directly
+	if (!fgets(line, MAX_LINE, stdin) || sscanf(line, "%s %s", keyStr, orderStr) < 1) {
+		printf("Usage: sort date|size|from|subject|none [asc|desc]\n");
+		return(SUCCESS);
+	}
+
+	if (!strcmp(keyStr, "date")) {
+		sortKey = SORT_DATE;
+	}
+	else if (!strcmp(keyStr, "size")) {
+		sortKey = SORT_SIZE;
+	}
+	else if (!strcmp(keyStr, "from")) {
+		sortKey = SORT_FROM;
+	}
+	else if (!strcmp(keyStr, "subject")) {
+		sortKey = SORT_SUBJECT;
+	}
+	else if (!strcmp(keyStr, "none")) {
+		sortKey = SORT_NONE;
+	}
+	else {
+		printf("Usage: sort date|size|from|subject|none [asc|desc]\n");
+		return(SUCCESS);
+	}
+
+	if (!strcmp(orderStr, "asc")) {
+		sortOrder = ASCENDING;
+	}
+	else if (!strcmp(orderStr, "desc")) {
+		sortOrder = DESCENDING;
+	}
+	else {
+		printf("Usage: sort date|size|from|subject|none [asc|desc]\n");
+		return(SUCCESS);
+	}
+
+	return(selectSortOrder(cachePtr, sortKey, sortOrder));
+}
+
+int userFilterMailbox(msgCacheT *cachePtr) {
+	char line[MAX_LINE], *word, *flagName;
+	int setFlags = 0, unsetFlags = 0, flag, *flagsPtr;
+
+	if (!fgets(line, MAX_LINE, stdin)) {
+		return(SUCCESS);
+	}
+
+	//Every word names a flag the messages must have, or not have if it starts with "un"
+	for (word = strtok(line, " \t\n") ; word != NULL ; word = strtok(NULL, " \t\n")) {
+		flagName = word;
+		flagsPtr = &setFlags;
+		if (!strncmp(word, "un", 2)) {
+			flagName = word + 2;
+			flagsPtr = &unsetFlags;
+		}
+
+		if (!strcmp(flagName, "seen")) {
+			flag = SEEN;
+		}
+		else if (!strcmp(flagName, "answered")) {
+			flag = ANSWERED;
+		}
+		else if (!strcmp(flagName, "deleted")) {
+			flag = DELETED;
+		}
+		else if (!strcmp(flagName, "flagged")) {
+			flag = FLAGGED;
+		}
+		else if (!strcmp(flagName, "recent")) {
+			flag = RECENT;
+		}
+		else {
+			printf("Usage: filter [un]seen|[un]answered|[un]deleted|[un]flagged|[un]recent ...\n");
+			return(SUCCESS);
+		}
+		*flagsPtr |= flag;
+	}
+
+	return(displayFilter(cachePtr, setFlags, unsetFlags));
+}
+
+int pageCached(msgCacheT *cachePtr, int pageNum) {
+	size_t end = PAGE_MSGS * pageNum;
+
+	if (pageNum < 1) { //Out of bounds, which is reported right away
+		return(1);
+	}
+	else if (cachePtr->sortKey != SORT_NONE) {
+		return(0);
+	}
+
+	for (size_t k = PAGE_MSGS * (pageNum-1) ; k < end && k < cachePtr->cacheSize ; k++) {
+		if (!cachePtr->msgPtrArray[k]) {
+			return(0);
+		}
+	}
+
+	return(1);
+}
+
+int handleUserInput(FILE *imapStream, cacheManagerT *managerPtr) {
+	msgCacheT *cachePtr = managerPtr->current; //The cache of the selected mailbox
 	char command[MAX_LINE], commandFormat[10];
 	int retVal;
 
 	sprintf(commandFormat, "%%%ds", MAX_LINE-1);
 
 	scanf(commandFormat, command); //Get command, and depending on the command, get the other arguements
+
+	/* While the network thread fetches the rest of the mailbox (check background.h), what is cached can be
+	  paged through, and read, every other command waits for it, as it needs the stream, or all the messages */
+	if (strcmp(command, "page") && strcmp(command, "read") && strcmp(command, "help") && strcmp(command, "clear")) {
+		if (isError(retVal = waitBackground())) {
+			return(retVal);
+		}
+	}
+
 	if (!strcmp(command, "delete")) {
-		int msgNum; 
+		char target[MAX_LINE];
 
 		/* Get msgNum, note that this is the number that the user sees, 
 		  and IMAP commands utilize, so it is greater by 1 compared to the 
-		  cache position of the message */
-		scanf("%d", &msgNum);
-		retVal = deleteMsg(imapStream, cachePtr, msgNum); 
+		  cache position of the message, or from:<address>, for all messages of a sender */
+		scanf(commandFormat, target);
+		if (!strncmp(target, "from:", 5)) {
+			retVal = deleteFromSender(imapStream, cachePtr, target+5);
+		}
+		else {
+			retVal = deleteMsg(imapStream, cachePtr, atoi(target)); 
+		}
 		if (isError(retVal)) {
 			return(retVal);
 		}
@@ -301,35 +567,115 @@ int handleUserInput(FILE *imapStream, msgCacheT *cachePtr) {
 		int msgNum;
 
 		scanf("%d", &msgNum);
+		//Unless its text is cached, the message is fetched, so the stream is needed
+		if (msgNum < 1 || msgNum > cachePtr->cacheSize || !cachePtr->msgPtrArray[msgNum-1] || !cachePtr->msgPtrArray[msgNum-1]->text) {
+			if (isError(retVal = waitBackground())) {
+				return(retVal);
+			}
+		}
 		retVal = displayMsg(imapStream, cachePtr, msgNum);
 		if (isError(retVal)) {
 			return(retVal);
 		}
 	}
+	else if (!strcmp(command, "save")) {
+		char line[MAX_LINE], saveDir[MAX_LINE] = ".";
+		int msgNum;
+
+		//The directory is optional, and is the rest of the line, as it can contain spaces
+		if (fgets(line, MAX_LINE, stdin) != NULL && sscanf(line, "%d %[^\n]", &msgNum, saveDir) >= 1) {
+			retVal = saveMsgAttachments(imapStream, cachePtr, msgNum, saveDir);
+			if (isError(retVal)) {
+				return(retVal);
+			}
+		}
+	}
 	else if (!strcmp(command, "page")) {
 		int pageNum;
 
 		//Get pageNum, as the user sees it
 		scanf("%d", &pageNum);
-		displayMsgPage(imapStream, cachePtr, pageNum);
+		while (backgroundBusy() && !pageCached(cachePtr, pageNum)) {
+			if (isError(retVal = applyBackground(1))) {
+				return(retVal);
+			}
+		}
+		retVal = displayMsgPage(imapStream, cachePtr, pageNum);
+		if (isError(retVal)) {
+			return(retVal);
+		}
+	}
+	else if (!strcmp(command, "browse")) {
+		retVal = browseMailbox(imapStream, managerPtr);
+		if (isError(retVal)) {
+			return(retVal);
+		}
+	}
+	else if (!strcmp(command, "sort")) {
+		retVal = userSortMailbox(cachePtr);
+		if (isError(retVal)) {
+			return(retVal);
+		}
+	}
+	else if (!strcmp(command, "search")) {
+		char query[MAX_LINE];
+
+		//The query is the rest of the line, as it can contain any number of words
+		if (fgets(query, MAX_LINE, stdin) != NULL) {
+			retVal = displaySearch(cachePtr, query);
+			if (isError(retVal)) {
+				return(retVal);
+			}
+		}
+	}
+	else if (!strcmp(command, "senders")) {
+		char line[MAX_LINE], option[MAX_LINE] = "";
+		int rankBy = SENDERS_BY_COUNT;
+
+		if (fgets(line, MAX_LINE, stdin) != NULL) {
+			sscanf(line, "%s", option);
+		}
+		if (!strcmp(option, "size")) {
+			rankBy = SENDERS_BY_SIZE;
+		}
+		else if (!strcmp(option, "unseen")) {
+			rankBy = SENDERS_BY_UNSEEN;
+		}
+		retVal = displaySenders(cachePtr, rankBy);
+		if (isError(retVal)) {
+			return(retVal);
+		}
+	}
+	else if (!strcmp(command, "filter")) {
+		retVal = userFilterMailbox(cachePtr);
+		if (isError(retVal)) {
+			return(retVal);
+		}
 	}
 	else if (!strcmp(command, "logout")) {
 		return(QUIT);
 	}
 	else if (!strcmp(command, "select")) {
-		retVal = userSelectMailbox(imapStream, cachePtr);
+		retVal = userSelectMailbox(imapStream, managerPtr);
 		if (isError(retVal)) {
 			return(retVal);
 		}
 	}
 	else if (!strcmp(command, "list")) {
-		retVal = listMailboxNames(imapStream, cachePtr);
+		char line[MAX_LINE], option[MAX_LINE] = "";
+
+		//"list refresh" lists the mailboxes again, instead of displaying the ones already listed
+		if (fgets(line, MAX_LINE, stdin) != NULL) {
+			sscanf(line, "%s", option);
+		}
+		retVal = listMailboxNames(imapStream, managerPtr, !strcmp(option, "refresh"));
 		if (isError(retVal)) {
 			return(retVal);
 		}
 	}
 	else if (!strcmp(command, "stats")) {
 		printStat(cachePtr);
+		printTransportStats(imapStream);
 	}
 	else if (!strcmp(command, "clear")) {
 		clearScreen();
@@ -344,9 +690,10 @@ int handleUserInput(FILE *imapStream, msgCacheT *cachePtr) {
 	return(SUCCESS);
 }
 
-int interactionLoop(FILE *imapStream, msgCacheT *cachePtr) {
-	struct pollfd pollfd = {0};
-	int retVal;
+int interactionLoop(FILE *imapStream, cacheManagerT *managerPtr, sessionT *sessionPtr, startupStatsT *statsPtr) {
+	msgCacheT *cachePtr;
+	struct pollfd pollfds[2] = {{0}};
+	int retVal, fetching = 0;
 
 	/* The variable inputFlag is used to control when the command prompt "=>>"
 	  is printed. It is set at the start (so that the prompt can be printed at first),
@@ -355,9 +702,11 @@ int interactionLoop(FILE *imapStream, msgCacheT *cachePtr) {
 	  it is not printed again */
 	int inputFlag = 1;
 
-	//Prepare struct pollfd
-	pollfd.fd = STDIN_FILENO;
-	pollfd.events = POLLIN;
+	//Prepare struct pollfd, for the user, and for the responses the network thread parsed (check background.h)
+	pollfds[0].fd = STDIN_FILENO;
+	pollfds[0].events = POLLIN;
+	pollfds[1].fd = backgroundFd();
+	pollfds[1].events = POLLIN;
 
 	do {
 		if (inputFlag) {
@@ -368,11 +717,20 @@ int interactionLoop(FILE *imapStream, msgCacheT *cachePtr) {
 			inputFlag = 0;
 		}
 		//NOOP_INTERVAL is muly
-		if (poll(&pollfd, 1, NOOP_INTERVAL) < 0) { //If timeout elapses, send NOOP to server
+		if (poll(pollfds, 2, NOOP_INTERVAL) < 0) { //If timeout elapses, send NOOP to server
+			if (errno == EINTR) { //A signal (e.g. SIGWINCH, when the terminal is resized), wait again
+				continue;
+			}
 			return(SYSCALL_ERROR);
 		}
-		else if (pollfd.revents & POLLIN) { //If the user entered a command
-			retVal = handleUserInput(imapStream, cachePtr);
+		else if (pollfds[0].revents & POLLIN) { //If the user entered a command
+			retVal = handleUserInput(imapStream, managerPtr);
+			if (retVal == SOCKET_ERROR) {
+				retVal = reconnect(imapStream, managerPtr, sessionPtr);
+				if (retVal == SUCCESS) {
+					printf("The command may not have been carried out, enter it again if so.\n");
+				}
+			}
 			if (isError(retVal)) {
 				return(retVal);
 			}
@@ -382,21 +740,65 @@ int interactionLoop(FILE *imapStream, msgCacheT *cachePtr) {
 			inputFlag = 1; //User entered input, so set inputFlag
 		}
 
-		retVal = sendNoop(imapStream, cachePtr);
-		if (isError(retVal)) {
-			return(retVal);
-		}
-		if (cachePtr->cacheSize > cachePtr->prevSize) { 
-			/* If the cache grew (check cacheResize()), then there are new messages to be
-			 fetched */
-			retVal = sendFetchAll(imapStream, cachePtr, cachePtr->prevSize+1, cachePtr->cacheSize);
+		//What the network thread fetched is added to the cache between commands, the stream is its own meanwhile
+		if (backgroundBusy()) {
+			fetching = 1;
+			retVal = applyBackground(0);
+			if (retVal == SOCKET_ERROR) {
+				retVal = reconnect(imapStream, managerPtr, sessionPtr);
+				inputFlag = 1;
+			}
 			if (isError(retVal)) {
 				return(retVal);
 			}
-			//No need to fetch those anymore, so set prevSize to cacheSize
-			cachePtr->prevSize = cachePtr->cacheSize;
-		}	
+			if (backgroundBusy()) {
+				continue;
+			}
+		}
+		else if (pollfds[1].revents & POLLIN) { //A wakeup for a response that was applied already, it is cleared
+			applyBackground(0);
+		}
+		if (fetching) { //The rest of the mailbox is in, so other mailboxes might have to make room for it
+			cacheManagerEvict(managerPtr);
+			fetching = 0;
+		}
+		if (statsPtr->selectMs == 0) {
+			statsPtr->selectMs = elapsedMs(&statsPtr->start);
+			printf("\nThe whole mailbox is in (%.1f ms after the login).\n", statsPtr->selectMs);
+			inputFlag = 1;
+		}
+
+		cachePtr = managerPtr->current; //The user may have selected another mailbox
+		retVal = checkMailbox(imapStream, cachePtr);
+		if (retVal == SOCKET_ERROR) {
+			retVal = reconnect(imapStream, managerPtr, sessionPtr);
+			inputFlag = 1; //The prompt was pushed up by the messages
+		}
+		if (isError(retVal)) {
+			return(retVal);
+		}
+
+		//So that a search only has to look up the index
+		if (!backgroundBusy() && isError(retVal = indexWhileIdle(cachePtr, pollfds))) {
+			return(retVal);
+		}
 	} while(1);
 
 	return(SUCCESS);
 }
+
+int indexWhileIdle(msgCacheT *cachePtr, struct pollfd *pollfds) {
+	int retVal;
+
+	do {
+		if (poll(pollfds, 2, 0) != 0) { //Input, or an error (e.g. EINTR) that the poll() of the loop handles
+			return(SUCCESS);
+		}
+		retVal = indexEnvelopes(cachePtr, INDEX_BATCH);
+		if (isError(retVal)) {
+			return(retVal);
+		}
+	} while (retVal == INDEX_BATCH);
+
+	return(SUCCESS);
+}
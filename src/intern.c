@@ -0,0 +1,113 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include "error.h"
+#include "utils.h"
+#include "intern.h"
+
+#define INTERN_MIN_SIZE 256 //The initial size of the table, a power of two
+
+//The reference count and the hash are kept in front of the string
+typedef struct internEntry {
+	size_t refs;
+	size_t hash;
+	char str[];
+} internEntryT;
+
+//An open addressing table (linear probing), kept at most half full
+internEntryT **internTable = NULL;
+size_t internTableSize = 0, internCount = 0;
+
+internEntryT *entryOf(char *interned) {
+	return((internEntryT *)(interned - offsetof(internEntryT, str)));
+}
+
+int internGrow(void) {
+	size_t newSize = internTableSize ? internTableSize * 2 : INTERN_MIN_SIZE, slot;
+	internEntryT **newTable;
+
+	newTable = calloc(newSize, sizeof(internEntryT *));
+	if (!newTable) {
+		return(MEM_ERROR);
+	}
+	for (size_t k = 0 ; k < internTableSize ; k++) {
+		if (internTable[k] != NULL) {
+			for (slot = internTable[k]->hash & (newSize-1) ; newTable[slot] != NULL ; slot = (slot+1) & (newSize-1));
+			newTable[slot] = internTable[k];
+		}
+	}
+	free(internTable);
+	internTable = newTable;
+	internTableSize = newSize;
+
+	return(SUCCESS);
+}
+
+int internString(char *str, char **internedPtr) {
+	internEntryT *entry;
+	size_t hash, slot, len;
+
+	if (!str) {
+		*internedPtr = NULL;
+		return(SUCCESS);
+	}
+	if (2 * (internCount+1) > internTableSize && isError(internGrow())) {
+		return(MEM_ERROR);
+	}
+
+	hash = hashString(str);
+	for (slot = hash & (internTableSize-1) ; internTable[slot] != NULL ; slot = (slot+1) & (internTableSize-1)) {
+		if (internTable[slot]->hash == hash && !strcmp(internTable[slot]->str, str)) {
+			internTable[slot]->refs++;
+			*internedPtr = internTable[slot]->str;
+			return(SUCCESS);
+		}
+	}
+
+	len = strlen(str);
+	entry = malloc(sizeof(internEntryT) + len + 1);
+	if (!entry) {
+		return(MEM_ERROR);
+	}
+	entry->refs = 1;
+	entry->hash = hash;
+	memcpy(entry->str, str, len+1);
+	internTable[slot] = entry;
+	internCount++;
+
+	*internedPtr = entry->str;
+
+	return(SUCCESS);
+}
+
+void releaseString(char *interned) {
+	internEntryT *entry;
+	size_t slot, next, home;
+
+	if (!interned) {
+		return;
+	}
+	entry = entryOf(interned);
+	if (--entry->refs > 0) {
+		return;
+	}
+
+	for (slot = entry->hash & (internTableSize-1) ; internTable[slot] != entry ; slot = (slot+1) & (internTableSize-1));
+
+	/* Remove the entry, and move back the entries after it that would no longer be found
+	  (the ones whose probe sequence passes through the emptied slot), so no tombstones are needed */
+	for (next = (slot+1) & (internTableSize-1) ; internTable[next] != NULL ; next = (next+1) & (internTableSize-1)) {
+		home = internTable[next]->hash & (internTableSize-1);
+		if (((next - home) & (internTableSize-1)) >= ((next - slot) & (internTableSize-1))) {
+			internTable[slot] = internTable[next];
+			slot = next;
+		}
+	}
+	internTable[slot] = NULL;
+	internCount--;
+	free(entry);
+}
+
+size_t internRefs(char *interned) {
+	return(interned ? entryOf(interned)->refs : 0);
+}
@@ -0,0 +1,470 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "error.h"
+#include "utils.h"
+#include "base64.h"
+#include "utf8.h"
+#include "mailbox.h"
+
+#define INIT_TABLE_SIZE 64 //Must be a power of two
+
+//Printable ASCII stands for itself in modified UTF-7, everything else is encoded
+int isPrintableAscii(unsigned char c) {
+	return(c >= 0x20 && c <= 0x7E);
+}
+
+int utf7Decode(char *name, char **decodedPtr) {
+	size_t len = strlen(name), pos = 0, outLen = 0, runLen, utf16Len;
+	char *decoded, *digits, *utf16;
+	unsigned int unit, low, codePoint;
+	int retVal = SUCCESS;
+
+	/* A UTF-16 unit takes at least 8/3 digits, and at most 3 bytes as UTF-8 (a surrogate pair
+	  takes 4, for two units), so the decoded name is at most twice as long */
+	decoded = malloc(2*len+1);
+	digits = malloc(len+1);
+	utf16 = malloc(B64_DECODED_SIZE(len));
+	if (!decoded || !digits || !utf16) {
+		retVal = MEM_ERROR;
+		goto cleanup;
+	}
+
+	while (name[pos] != '\0') {
+		if (name[pos] != '&') {
+			decoded[outLen++] = name[pos++];
+			continue;
+		}
+		pos++;
+
+		//Copy the digits up to the '-', with '/' in place of ',', so that they are standard base 64
+		for (runLen = 0 ; name[pos+runLen] != '-' ; runLen++) {
+			if (name[pos+runLen] == '\0' || name[pos+runLen] == '/') {
+				retVal = PARSE_ERROR;
+				goto cleanup;
+			}
+			digits[runLen] = (name[pos+runLen] == ',') ? '/' : name[pos+runLen];
+		}
+
+		if (runLen == 0) { //"&-" is '&'
+			decoded[outLen++] = '&';
+		}
+		else {
+			if (isError(b64Decode(digits, runLen, utf16, &utf16Len)) || utf16Len % 2 != 0) {
+				retVal = PARSE_ERROR;
+				goto cleanup;
+			}
+
+			for (size_t k = 0 ; k < utf16Len ; k += 2) {
+				unit = (unsigned char)utf16[k] << 8 | (unsigned char)utf16[k+1];
+				//A high surrogate must be followed by a low one, together they are a single code point
+				if (unit >= 0xD800 && unit < 0xDC00 && k+3 < utf16Len) {
+					low = (unsigned char)utf16[k+2] << 8 | (unsigned char)utf16[k+3];
+					if (low < 0xDC00 || low > 0xDFFF) {
+						retVal = PARSE_ERROR;
+						goto cleanup;
+					}
+					codePoint = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+					k += 2;
+				}
+				else if (unit >= 0xD800 && unit <= 0xDFFF) {
+					retVal = PARSE_ERROR;
+					goto cleanup;
+				}
+				else {
+					codePoint = unit;
+				}
+				outLen += utf8Encode(codePoint, decoded + outLen);
+			}
+		}
+		pos += runLen+1; //Skip the '-' too
+	}
+	decoded[outLen] = '\0';
+
+	*decodedPtr = decoded;
+	decoded = NULL;
+
+cleanup:
+	free(decoded);
+	free(digits);
+	free(utf16);
+
+	return(retVal);
+}
+
+int utf7Encode(char *str, char **encodedPtr) {
+	size_t len = strlen(str), pos = 0, outLen = 0, utf16Len, b64Len;
+	char *encoded, *utf16, *b64Str;
+	unsigned int codePoint;
+
+	/* Every byte of UTF-8 gives at most 2 bytes of UTF-16, and printable ASCII
+	  takes at most 2 characters ('&' is "&-") */
+	encoded = malloc(B64_ENCODED_SIZE(2*len) + 2*len + 1);
+	utf16 = malloc(2*len+1);
+	b64Str = malloc(B64_ENCODED_SIZE(2*len) + 1);
+	if (!encoded || !utf16 || !b64Str) {
+		free(encoded);
+		free(utf16);
+		free(b64Str);
+		return(MEM_ERROR);
+	}
+
+	while (str[pos] != '\0') {
+		if (isPrintableAscii(str[pos])) {
+			encoded[outLen++] = str[pos];
+			if (str[pos++] == '&') {
+				encoded[outLen++] = '-';
+			}
+			continue;
+		}
+
+		//Encode the whole run of characters that are not printable ASCII, as UTF-16 (big endian)
+		utf16Len = 0;
+		while (str[pos] != '\0' && !isPrintableAscii(str[pos])) {
+			pos += utf8Decode(str + pos, len - pos, &codePoint);
+			if (codePoint >= 0x10000) { //Needs a surrogate pair
+				codePoint -= 0x10000;
+				utf16[utf16Len++] = (0xD800 | codePoint >> 10) >> 8;
+				utf16[utf16Len++] = (codePoint >> 10) & 0xFF;
+				codePoint = 0xDC00 | (codePoint & 0x3FF);
+			}
+			utf16[utf16Len++] = codePoint >> 8;
+			utf16[utf16Len++] = codePoint & 0xFF;
+		}
+
+		//Leave out the padding, and use ',' in place of '/'
+		b64Len = b64Encode(utf16, utf16Len, b64Str);
+		while (b64Len > 0 && b64Str[b64Len-1] == '=') {
+			b64Len--;
+		}
+		encoded[outLen++] = '&';
+		for (size_t k = 0 ; k < b64Len ; k++) {
+			encoded[outLen++] = (b64Str[k] == '/') ? ',' : b64Str[k];
+		}
+		encoded[outLen++] = '-';
+	}
+	encoded[outLen] = '\0';
+
+	free(utf16);
+	free(b64Str);
+
+	*encodedPtr = encoded;
+	return(SUCCESS);
+}
+
+folderTreeT *folderTreeInit(void) {
+	folderTreeT *treePtr = calloc(1, sizeof(folderTreeT));
+
+	if (!treePtr) {
+		return(NULL);
+	}
+
+	treePtr->tableSize = INIT_TABLE_SIZE;
+	treePtr->byName = calloc(treePtr->tableSize, sizeof(folderT*));
+	treePtr->byDecodedName = calloc(treePtr->tableSize, sizeof(folderT*));
+	if (!treePtr->byName || !treePtr->byDecodedName) {
+		freeFolderTree(treePtr);
+		return(NULL);
+	}
+
+	return(treePtr);
+}
+
+//Returns the slot of the folder with the given name, or the empty slot it would take
+folderT **findFolderSlot(folderT **table, size_t tableSize, char *name, int decoded) {
+	size_t slot = hashString(name) & (tableSize-1);
+
+	while (table[slot] != NULL && strcmp(decoded ? table[slot]->decodedName : table[slot]->name, name)) {
+		slot = (slot+1) & (tableSize-1);
+	}
+
+	return(&table[slot]);
+}
+
+void tableInsert(folderTreeT *treePtr, folderT *folderPtr) {
+	folderT **slotPtr;
+
+	*findFolderSlot(treePtr->byName, treePtr->tableSize, folderPtr->name, 0) = folderPtr;
+
+	//Two names may decode to the same one (if one of them is not valid modified UTF-7), the first is kept
+	slotPtr = findFolderSlot(treePtr->byDecodedName, treePtr->tableSize, folderPtr->decodedName, 1);
+	if (*slotPtr == NULL) {
+		*slotPtr = folderPtr;
+	}
+}
+
+void tableInsertAll(folderTreeT *treePtr, folderT *list) {
+	for (folderT *curr = list ; curr != NULL ; curr = curr->next) {
+		tableInsert(treePtr, curr);
+		tableInsertAll(treePtr, curr->children);
+	}
+}
+
+/* Fill the hash tables again, with the given size, done when they grow, and when folders are
+  removed (as open addressing does not allow removing a single entry) */
+int rebuildTables(folderTreeT *treePtr, size_t newSize) {
+	folderT **byName, **byDecodedName;
+
+	byName = calloc(newSize, sizeof(folderT*));
+	byDecodedName = calloc(newSize, sizeof(folderT*));
+	if (!byName || !byDecodedName) {
+		free(byName);
+		free(byDecodedName);
+		return(MEM_ERROR);
+	}
+
+	free(treePtr->byName);
+	free(treePtr->byDecodedName);
+	treePtr->byName = byName;
+	treePtr->byDecodedName = byDecodedName;
+	treePtr->tableSize = newSize;
+
+	tableInsertAll(treePtr, treePtr->top);
+
+	return(SUCCESS);
+}
+
+void folderTreeStartRefresh(folderTreeT *treePtr) {
+	treePtr->generation++;
+}
+
+folderT *folderTreeFind(folderTreeT *treePtr, char *name, int decoded) {
+	return(*findFolderSlot(decoded ? treePtr->byDecodedName : treePtr->byName, treePtr->tableSize, name, decoded));
+}
+
+//The changes to the tree are rendered the next time it is listed
+void invalidateRender(folderTreeT *treePtr) {
+	free(treePtr->rendered);
+	treePtr->rendered = NULL;
+}
+
+//INBOX comes first, and the rest of the folders are in the order of their decoded names
+int folderBefore(folderT *folderPtr, folderT *otherPtr) {
+	if (!strcmp(otherPtr->name, "INBOX")) {
+		return(0);
+	}
+	if (!strcmp(folderPtr->name, "INBOX")) {
+		return(1);
+	}
+
+	return(strcmp(folderPtr->leafName, otherPtr->leafName) < 0);
+}
+
+void freeFolder(folderT *folderPtr) {
+	free(folderPtr->name);
+	free(folderPtr->decodedName);
+	free(folderPtr);
+}
+
+int folderTreeAdd(folderTreeT *treePtr, char *name, char delimiter, int attributes) {
+	folderT *folderPtr, *parent = NULL, **listPtr;
+	char *levelEnd, *parentName;
+	int retVal;
+
+	folderPtr = folderTreeFind(treePtr, name, 0);
+	if (folderPtr) { //Already in the tree, it is only marked as listed
+		if (folderPtr->attributes != attributes) {
+			folderPtr->attributes = attributes;
+			invalidateRender(treePtr);
+		}
+		folderPtr->generation = treePtr->generation;
+		return(SUCCESS);
+	}
+
+	if (delimiter != '\0') {
+		treePtr->delimiter = delimiter;
+	}
+
+	//The name of the parent is the name up to the last delimiter
+	levelEnd = (delimiter != '\0') ? strrchr(name, delimiter) : NULL;
+	if (levelEnd && levelEnd != name && levelEnd[1] != '\0') {
+		parentName = strndup(name, levelEnd - name);
+		if (!parentName) {
+			return(MEM_ERROR);
+		}
+
+		//A parent that has not been listed (yet) is added as a level of the hierarchy
+		parent = folderTreeFind(treePtr, parentName, 0);
+		if (!parent) {
+			retVal = folderTreeAdd(treePtr, parentName, delimiter, FOLDER_NOSELECT);
+			if (isError(retVal)) {
+				free(parentName);
+				return(retVal);
+			}
+			parent = folderTreeFind(treePtr, parentName, 0);
+		}
+		free(parentName);
+	}
+
+	folderPtr = calloc(1, sizeof(folderT));
+	if (!folderPtr) {
+		return(MEM_ERROR);
+	}
+
+	folderPtr->name = strdup(name);
+	if (!folderPtr->name) {
+		freeFolder(folderPtr);
+		return(MEM_ERROR);
+	}
+
+	//A name that is not valid modified UTF-7 is displayed as it is
+	retVal = utf7Decode(name, &folderPtr->decodedName);
+	if (retVal == PARSE_ERROR) {
+		folderPtr->decodedName = strdup(name);
+		retVal = folderPtr->decodedName ? SUCCESS : MEM_ERROR;
+	}
+	if (isError(retVal) || isError(retVal = utf8Sanitize(&folderPtr->decodedName, 0))) {
+		freeFolder(folderPtr);
+		return(retVal);
+	}
+
+	//Printable ASCII is never encoded, so the delimiter separates the levels of the decoded name as well
+	folderPtr->leafName = folderPtr->decodedName;
+	if (parent && (levelEnd = strrchr(folderPtr->decodedName, delimiter))) {
+		folderPtr->leafName = levelEnd+1;
+	}
+
+	folderPtr->attributes = attributes;
+	folderPtr->generation = treePtr->generation;
+	folderPtr->parent = parent;
+	folderPtr->depth = parent ? parent->depth+1 : 0;
+
+	//Insert it among its siblings, in order
+	for (listPtr = parent ? &parent->children : &treePtr->top ; *listPtr && folderBefore(*listPtr, folderPtr) ; listPtr = &(*listPtr)->next);
+	folderPtr->next = *listPtr;
+	*listPtr = folderPtr;
+
+	//Keep the tables at most half full
+	treePtr->folders++;
+	if (treePtr->folders*2 > treePtr->tableSize) {
+		if (isError(retVal = rebuildTables(treePtr, treePtr->tableSize*2))) {
+			return(retVal);
+		}
+	}
+	else {
+		tableInsert(treePtr, folderPtr);
+	}
+
+	invalidateRender(treePtr);
+
+	return(SUCCESS);
+}
+
+/* Remove the folders that were not listed in the current refresh, a folder that was not, but
+  has a child that was, is kept as a level of the hierarchy. Returns the number of folders removed */
+size_t pruneFolders(folderTreeT *treePtr, folderT **listPtr) {
+	folderT *folderPtr;
+	size_t removed = 0;
+
+	while ((folderPtr = *listPtr) != NULL) {
+		removed += pruneFolders(treePtr, &folderPtr->children);
+
+		if (folderPtr->generation != treePtr->generation) {
+			if (!folderPtr->children) {
+				*listPtr = folderPtr->next;
+				freeFolder(folderPtr);
+				removed++;
+				continue;
+			}
+			if (folderPtr->attributes != FOLDER_NOSELECT) { //Rendered as selectable until now
+				folderPtr->attributes = FOLDER_NOSELECT;
+				invalidateRender(treePtr);
+			}
+		}
+		listPtr = &folderPtr->next;
+	}
+
+	return(removed);
+}
+
+int folderTreeEndRefresh(folderTreeT *treePtr) {
+	size_t removed = pruneFolders(treePtr, &treePtr->top);
+
+	treePtr->loaded = 1;
+	if (removed) {
+		treePtr->folders -= removed;
+		invalidateRender(treePtr);
+		return(rebuildTables(treePtr, treePtr->tableSize));
+	}
+
+	return(SUCCESS);
+}
+
+int folderServerName(folderTreeT *treePtr, char *decodedName, char **namePtr) {
+	folderT *folderPtr = NULL;
+
+	//INBOX is case-insensitive
+	if (!strcasecmp(decodedName, "INBOX")) {
+		decodedName = "INBOX";
+	}
+
+	if (treePtr) {
+		folderPtr = folderTreeFind(treePtr, decodedName, 1);
+	}
+	if (folderPtr) {
+		*namePtr = strdup(folderPtr->name);
+		return(*namePtr ? SUCCESS : MEM_ERROR);
+	}
+
+	return(utf7Encode(decodedName, namePtr));
+}
+
+//The length of the lines of a list of folders (and their children), as rendered
+size_t renderedLen(folderT *list) {
+	size_t len = 0;
+
+	for (folderT *curr = list ; curr != NULL ; curr = curr->next) {
+		//"> ", 2 spaces per level, the name, " (not selectable)" and '\n'
+		len += 2 + 2*curr->depth + strlen(curr->leafName) + 17 + 1;
+		len += renderedLen(curr->children);
+	}
+
+	return(len);
+}
+
+char *renderFolders(folderT *list, char *pos) {
+	for (folderT *curr = list ; curr != NULL ; curr = curr->next) {
+		pos += sprintf(pos, "> %*s%s%s\n", 2*curr->depth, "", curr->leafName, (curr->attributes & FOLDER_NOSELECT) ? " (not selectable)" : "");
+		pos = renderFolders(curr->children, pos);
+	}
+
+	return(pos);
+}
+
+char *folderTreeRender(folderTreeT *treePtr) {
+	if (treePtr->rendered) {
+		return(treePtr->rendered);
+	}
+
+	treePtr->rendered = malloc(renderedLen(treePtr->top) + 1);
+	if (!treePtr->rendered) {
+		return(NULL);
+	}
+	treePtr->rendered[0] = '\0';
+	renderFolders(treePtr->top, treePtr->rendered);
+
+	return(treePtr->rendered);
+}
+
+void freeFolderList(folderT *list) {
+	folderT *next;
+
+	for ( ; list != NULL ; list = next) {
+		next = list->next;
+		freeFolderList(list->children);
+		freeFolder(list);
+	}
+}
+
+void freeFolderTree(folderTreeT *treePtr) {
+	if (!treePtr) {
+		return;
+	}
+
+	freeFolderList(treePtr->top);
+	free(treePtr->byName);
+	free(treePtr->byDecodedName);
+	free(treePtr->rendered);
+	free(treePtr);
+}
@@ -0,0 +1,769 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include "parsing.h"
+#include "addresses.h"
+#include "cache.h"
+#include "error.h"
+#include "utils.h"
+#include "utf8.h"
+#include "charset.h"
+#include "decoder.h"
+#include "mime.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+	#include <immintrin.h>
+	#define MIME_SIMD
+#endif
+
+#define HEADER_VALUE_SIZE 1024 //Longer header values are cut
+
+#ifdef MIME_SIMD
+/* The search follows Wojciech Muła's "SIMD-friendly algorithms for substring searching"
+  (check http://0x80.pl/articles/simd-strfind.html). A block of positions is compared with the
+  first byte of the delimiter, and the block delimLen-1 bytes after it with the last byte, so
+  a position is only compared in full if both of its ends match. As every delimiter starts with
+  CRLF, which starts every line, the last byte (the end of the boundary) is what rules most
+  positions out. Both functions return the number of positions checked, and foundPtr gets the
+  first match among them (or NULL) */
+
+__attribute__((target("sse2")))
+size_t findDelimiterSse2(char *str, size_t len, char *delim, size_t delimLen, char **foundPtr) {
+	const __m128i first = _mm_set1_epi8(delim[0]), last = _mm_set1_epi8(delim[delimLen-1]);
+	__m128i blockFirst, blockLast;
+	unsigned int mask;
+	size_t pos;
+
+	*foundPtr = NULL;
+	for (pos = 0 ; pos + delimLen - 1 + 16 <= len ; pos += 16) {
+		blockFirst = _mm_loadu_si128((__m128i*)(str + pos));
+		blockLast = _mm_loadu_si128((__m128i*)(str + pos + delimLen - 1));
+		mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(blockFirst, first), _mm_cmpeq_epi8(blockLast, last)));
+		for ( ; mask != 0 ; mask &= mask - 1) {
+			if (!memcmp(str + pos + __builtin_ctz(mask) + 1, delim + 1, delimLen - 2)) {
+				*foundPtr = str + pos + __builtin_ctz(mask);
+				return(pos);
+			}
+		}
+	}
+
+	return(pos);
+}
+
+__attribute__((target("avx2")))
+size_t findDelimiterAvx2(char *str, size_t len, char *delim, size_t delimLen, char **foundPtr) {
+	const __m256i first = _mm256_set1_epi8(delim[0]), last = _mm256_set1_epi8(delim[delimLen-1]);
+	__m256i blockFirst, blockLast;
+	unsigned int mask;
+	size_t pos;
+
+	*foundPtr = NULL;
+	for (pos = 0 ; pos + delimLen - 1 + 32 <= len ; pos += 32) {
+		blockFirst = _mm256_loadu_si256((__m256i*)(str + pos));
+		blockLast = _mm256_loadu_si256((__m256i*)(str + pos + delimLen - 1));
+		mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(blockFirst, first), _mm256_cmpeq_epi8(blockLast, last)));
+		for ( ; mask != 0 ; mask &= mask - 1) {
+			if (!memcmp(str + pos + __builtin_ctz(mask) + 1, delim + 1, delimLen - 2)) {
+				*foundPtr = str + pos + __builtin_ctz(mask);
+				return(pos);
+			}
+		}
+	}
+
+	return(pos);
+}
+#endif
+
+char *findDelimiter(char *str, size_t len, char *delim, size_t delimLen) {
+	char *found = NULL;
+	size_t pos = 0;
+
+	if (len < delimLen) {
+		return(NULL);
+	}
+
+#ifdef MIME_SIMD
+	if (__builtin_cpu_supports("avx2")) {
+		pos = findDelimiterAvx2(str, len, delim, delimLen, &found);
+	}
+	if (!found && __builtin_cpu_supports("sse2")) {
+		pos += findDelimiterSse2(str + pos, len - pos, delim, delimLen, &found);
+	}
+	if (found) {
+		return(found);
+	}
+#endif
+
+	//The positions too close to the end for a whole block are checked one by one
+	while ((found = memchr(str + pos, delim[0], len - delimLen + 1 - pos))) {
+		if (!memcmp(found + 1, delim + 1, delimLen - 1)) {
+			return(found);
+		}
+		pos = found - str + 1;
+	}
+
+	return(NULL);
+}
+
+/* Copy the value of the header with the given name (case-insensitive) to value, unfolded (a line
+  that starts with whitespace continues the previous one, RFC 5322). Returns 1 if it was found */
+int getHeader(char *headers, size_t len, char *name, char *value, size_t size) {
+	size_t nameLen = strlen(name), pos = 0, valueLen = 0;
+	char *lineEnd;
+
+	while (pos < len) {
+		if (len - pos > nameLen && headers[pos+nameLen] == ':' && !strncasecmp(headers + pos, name, nameLen)) {
+			for (pos += nameLen + 1 ; pos < len ; pos++) {
+				if (headers[pos] == '\r' || headers[pos] == '\n') {
+					if (headers[pos] == '\n' && (pos+1 == len || (headers[pos+1] != ' ' && headers[pos+1] != '\t'))) {
+						break; //The value does not continue on the next line
+					}
+				}
+				else if (valueLen+1 < size && (valueLen > 0 || !isspace((unsigned char)headers[pos]))) {
+					value[valueLen++] = headers[pos];
+				}
+			}
+			value[valueLen] = '\0';
+			return(1);
+		}
+
+		lineEnd = memchr(headers + pos, '\n', len - pos);
+		if (!lineEnd) {
+			break;
+		}
+		pos = lineEnd - headers + 1;
+	}
+
+	return(0);
+}
+
+/* Copy the parameter with the given name (case-insensitive) of a header value, e.g. charset in
+  text/plain; charset="iso-8859-1", to param, unquoted. Returns 0 if the value has no such
+  parameter, 2 if it is in the extended form of RFC 2231 (name*=charset'language'%XX...), which is
+  preferred when both are there, or else 1 */
+int getParam(char *value, char *name, char *param, size_t size) {
+	size_t nameLen = strlen(name), attrLen, len;
+	char *pos = strchr(value, ';');
+	int found = 0, match, extended;
+
+	while (pos) {
+		pos++;
+		pos += strspn(pos, " \t");
+		attrLen = strcspn(pos, "=;");
+		if (pos[attrLen] != '=') {
+			pos = strchr(pos, ';');
+			continue;
+		}
+
+		for (len = attrLen ; len > 0 && isspace((unsigned char)pos[len-1]) ; len--);
+		extended = (len == nameLen+1 && pos[nameLen] == '*');
+		match = (len == nameLen || extended) && !strncasecmp(pos, name, nameLen);
+
+		pos += attrLen + 1;
+		pos += strspn(pos, " \t");
+		len = 0;
+		if (*pos == '"') { //A quoted string, where '\' escapes the character after it
+			for (pos++ ; *pos != '\0' && *pos != '"' ; pos++) {
+				if (*pos == '\\' && pos[1] != '\0') {
+					pos++;
+				}
+				if (match && len+1 < size) {
+					param[len++] = *pos;
+				}
+			}
+		}
+		else {
+			for ( ; *pos != '\0' && *pos != ';' && !isspace((unsigned char)*pos) ; pos++) {
+				if (match && len+1 < size) {
+					param[len++] = *pos;
+				}
+			}
+		}
+
+		if (match) {
+			param[len] = '\0';
+			found = extended ? 2 : 1;
+			if (extended) {
+				return(found);
+			}
+		}
+		pos = strchr(pos, ';');
+	}
+
+	return(found);
+}
+
+//Decode a parameter returned by getParam() (form is its return value) to UTF-8, returns NULL on failure
+char *decodeParam(char *param, int form) {
+	char *text = param, *quote, *decoded;
+	size_t len = 0;
+	int charset = CHARSET_UTF8, high, low;
+
+	//Encoded-words (RFC 2047) are not allowed in parameters, but many clients use them for file names
+	if (form != 2) {
+		return(decodeUtf8Str(param));
+	}
+
+	quote = strchr(param, '\'');
+	if (quote && strchr(quote+1, '\'')) {
+		charset = findCharset(param, quote - param);
+		if (charset == CHARSET_UNKNOWN) {
+			charset = CHARSET_UTF8;
+		}
+		text = strchr(quote+1, '\'') + 1;
+	}
+
+	//"%XX" stands for the byte with the hexadecimal value XX, the bytes are decoded in place
+	for ( ; *text != '\0' ; text++) {
+		if (text[0] == '%' && (high = hexDigitValue(text[1])) >= 0 && (low = hexDigitValue(text[2])) >= 0) {
+			param[len++] = (high << 4) | low;
+			text += 2;
+		}
+		else {
+			param[len++] = *text;
+		}
+	}
+
+	decoded = malloc(UTF8_EXPANSION*len + 1);
+	if (!decoded) {
+		return(NULL);
+	}
+	len = charsetToUtf8(charset, param, len, decoded);
+	decoded[len] = '\0';
+
+	return(decoded);
+}
+
+//Get the type, encoding, charset, boundary and file name of a part from its headers
+int parsePartHeaders(char *headers, size_t len, mimePartT *partPtr) {
+	char value[HEADER_VALUE_SIZE], param[HEADER_VALUE_SIZE];
+	size_t typeLen;
+	int form;
+
+	//The defaults (RFC 2045)
+	strcpy(partPtr->type, "text/plain");
+	partPtr->encoding = ENCODING_IDENTITY;
+	partPtr->charset = CHARSET_UTF8;
+	partPtr->filename = NULL;
+	partPtr->attachment = 0;
+	partPtr->boundary[0] = '\0';
+	partPtr->size = 0;
+
+	if (getHeader(headers, len, "Content-Type", value, sizeof(value))) {
+		typeLen = strcspn(value, "; \t");
+		if (typeLen > 0 && typeLen < MIME_TYPE_SIZE) {
+			for (size_t k = 0 ; k < typeLen ; k++) {
+				partPtr->type[k] = tolower((unsigned char)value[k]);
+			}
+			partPtr->type[typeLen] = '\0';
+		}
+
+		//Text in an unknown charset is displayed as it is
+		if (getParam(value, "charset", param, sizeof(param)) && findCharset(param, strlen(param)) != CHARSET_UNKNOWN) {
+			partPtr->charset = findCharset(param, strlen(param));
+		}
+		if (!strncmp(partPtr->type, "multipart/", 10) && getParam(value, "boundary", param, sizeof(param)) &&
+		    strlen(param) > 0 && strlen(param) < MIME_BOUNDARY_SIZE) {
+			strcpy(partPtr->boundary, param);
+		}
+		//The name parameter is the older way to give a file name
+		if ((form = getParam(value, "name", param, sizeof(param)))) {
+			partPtr->filename = decodeParam(param, form);
+			if (!partPtr->filename) {
+				return(MEM_ERROR);
+			}
+		}
+	}
+
+	if (getHeader(headers, len, "Content-Transfer-Encoding", value, sizeof(value))) {
+		value[strcspn(value, "; \t")] = '\0';
+		partPtr->encoding = findEncoding(value);
+	}
+
+	if (getHeader(headers, len, "Content-Disposition", value, sizeof(value))) {
+		partPtr->attachment = !strncasecmp(value, "attachment", 10);
+		if ((form = getParam(value, "filename", param, sizeof(param)))) {
+			free(partPtr->filename);
+			partPtr->filename = decodeParam(param, form);
+			if (!partPtr->filename) {
+				return(MEM_ERROR);
+			}
+		}
+	}
+
+	//The file name is displayed
+	return(utf8Sanitize(&partPtr->filename, 0));
+}
+
+//Used as the functions of the parser's sink, the sink is the first member of the parser
+int mimeSinkStart(literalSinkT *sinkPtr, size_t size) {
+	return(mimeStart((mimeParserT*)sinkPtr, size));
+}
+
+int mimeSinkWrite(literalSinkT *sinkPtr, char *chunk, size_t len) {
+	return(mimeWrite((mimeParserT*)sinkPtr, chunk, len));
+}
+
+//The parts were passed to the events, so the object is NIL
+int mimeSinkEnd(literalSinkT *sinkPtr, char **strPtr) {
+	*strPtr = NULL;
+	return(mimeEnd((mimeParserT*)sinkPtr));
+}
+
+void mimeInit(mimeParserT *parserPtr, char *item, char *boundary) {
+	parserPtr->sink.item = item;
+	parserPtr->sink.start = mimeSinkStart;
+	parserPtr->sink.write = mimeSinkWrite;
+	parserPtr->sink.end = mimeSinkEnd;
+	parserPtr->partStart = NULL;
+	parserPtr->partBody = NULL;
+	parserPtr->partEnd = NULL;
+
+	parserPtr->delimLens[0] = sprintf(parserPtr->delims[0], "\r\n--%.*s", MIME_BOUNDARY_SIZE-1, boundary);
+	parserPtr->depth = 1;
+	parserPtr->state = MIME_PREAMBLE;
+	parserPtr->buf = NULL;
+	parserPtr->bufLen = parserPtr->bufCap = 0;
+	parserPtr->part.filename = NULL;
+	parserPtr->parts = 0;
+}
+
+void freeMimeParser(mimeParserT *parserPtr) {
+	free(parserPtr->buf);
+	free(parserPtr->part.filename);
+	parserPtr->buf = parserPtr->part.filename = NULL;
+	parserPtr->bufLen = parserPtr->bufCap = 0;
+}
+
+//Make room for len bytes in the buffer
+int reserveMimeBuf(mimeParserT *parserPtr, size_t len) {
+	size_t newCap;
+	char *temp;
+
+	if (len <= parserPtr->bufCap) {
+		return(SUCCESS);
+	}
+
+	newCap = parserPtr->bufCap*2 > len ? parserPtr->bufCap*2 : len;
+	temp = realloc(parserPtr->buf, newCap);
+	if (!temp) {
+		return(MEM_ERROR);
+	}
+	parserPtr->buf = temp;
+	parserPtr->bufCap = newCap;
+
+	return(SUCCESS);
+}
+
+int mimeStart(mimeParserT *parserPtr, size_t size) {
+	int retVal;
+
+	parserPtr->depth = 1;
+	parserPtr->state = MIME_PREAMBLE;
+	parserPtr->parts = 0;
+	free(parserPtr->part.filename);
+	parserPtr->part.filename = NULL;
+
+	/* The CRLF that starts a delimiter belongs to it, so the text is read as if it started with
+	  one, for a delimiter on its first line to be found too */
+	retVal = reserveMimeBuf(parserPtr, 2);
+	if (isError(retVal)) {
+		return(retVal);
+	}
+	memcpy(parserPtr->buf, "\r\n", 2);
+	parserPtr->bufLen = 2;
+
+	return(SUCCESS);
+}
+
+int emitBody(mimeParserT *parserPtr, char *body, size_t len) {
+	parserPtr->part.size += len;
+	if (len == 0 || !parserPtr->partBody) {
+		return(SUCCESS);
+	}
+
+	return(parserPtr->partBody(parserPtr, &parserPtr->part, body, len));
+}
+
+int endPart(mimeParserT *parserPtr) {
+	int retVal = SUCCESS;
+
+	if (parserPtr->partEnd) {
+		retVal = parserPtr->partEnd(parserPtr, &parserPtr->part);
+	}
+	free(parserPtr->part.filename);
+	parserPtr->part.filename = NULL;
+
+	return(retVal);
+}
+
+//Returns the '\n' that ends the last header (or the delimiter line, if there are no headers), or NULL
+char *findHeadersEnd(char *str, size_t len, size_t *blankLenPtr) {
+	char *lineEnd = str;
+
+	while ((lineEnd = memchr(lineEnd, '\n', len - (lineEnd - str)))) {
+		if (lineEnd + 2 < str + len && lineEnd[1] == '\r' && lineEnd[2] == '\n') {
+			*blankLenPtr = 2;
+			return(lineEnd);
+		}
+		if (lineEnd + 1 < str + len && lineEnd[1] == '\n') {
+			*blankLenPtr = 1;
+			return(lineEnd);
+		}
+		lineEnd++;
+	}
+
+	return(NULL);
+}
+
+/* Split the buffered bytes, consuming as many as can be, the rest (e.g. the start of what can be
+  a delimiter) are left for the next chunk. When final is set no chunk follows */
+int splitBuffered(mimeParserT *parserPtr, int final) {
+	char *buf = parserPtr->buf, *found, *lineEnd;
+	size_t pos = 0, len = parserPtr->bufLen, delimLen, keep, blankLen;
+	int top, retVal = SUCCESS;
+
+	while (pos < len && !isError(retVal) && parserPtr->state != MIME_DONE) {
+		top = parserPtr->depth - 1;
+		delimLen = parserPtr->delimLens[top];
+
+		if (parserPtr->state == MIME_PREAMBLE || parserPtr->state == MIME_BODY) {
+			found = findDelimiter(buf + pos, len - pos, parserPtr->delims[top], delimLen);
+			/* The body starts after the blank line, unless the part is empty, and its delimiter
+			  starts at the blank line (which is then its CRLF) */
+			if (parserPtr->state == MIME_BODY && parserPtr->bodyLead > 0) {
+				if (!found && len - pos < delimLen && !final) {
+					break; //Can't tell yet
+				}
+				if (found != buf + pos) {
+					pos += parserPtr->bodyLead;
+				}
+				parserPtr->bodyLead = 0;
+			}
+			if (!found) {
+				//The end can be the start of a delimiter, so it is kept for the next chunk
+				keep = final ? 0 : (len - pos < delimLen - 1 ? len - pos : delimLen - 1);
+				if (parserPtr->state == MIME_BODY) {
+					retVal = emitBody(parserPtr, buf + pos, len - pos - keep);
+				}
+				pos = len - keep;
+				break;
+			}
+			if (parserPtr->state == MIME_BODY) {
+				retVal = emitBody(parserPtr, buf + pos, found - (buf + pos));
+				if (!isError(retVal)) {
+					retVal = endPart(parserPtr);
+				}
+			}
+			pos = found - buf + delimLen;
+			parserPtr->state = MIME_DELIM_LINE;
+		}
+		else if (parserPtr->state == MIME_DELIM_LINE) {
+			lineEnd = memchr(buf + pos, '\n', len - pos);
+			if (!lineEnd && !final) {
+				break;
+			}
+
+			if (len - pos >= 2 && buf[pos] == '-' && buf[pos+1] == '-') { //The last delimiter of the multipart
+				parserPtr->depth--;
+				parserPtr->state = parserPtr->depth > 0 ? MIME_PREAMBLE : MIME_DONE;
+				//The CRLF that ends the line can start the delimiter of the enclosing multipart
+				if (lineEnd) {
+					pos = lineEnd - buf - (lineEnd[-1] == '\r');
+				}
+			}
+			else if (lineEnd) {
+				//The '\n' is kept, so that a part without headers is found by the same search
+				pos = lineEnd - buf;
+				parserPtr->state = MIME_HEADERS;
+			}
+			else {
+				pos = len;
+			}
+		}
+		else { //MIME_HEADERS
+			lineEnd = findHeadersEnd(buf + pos, len - pos, &blankLen);
+			if (!lineEnd) {
+				break; //If the text ends in the headers, the part is not reported
+			}
+
+			retVal = parsePartHeaders(buf + pos + 1, lineEnd - (buf + pos), &parserPtr->part);
+			if (isError(retVal)) {
+				break;
+			}
+
+			if (parserPtr->part.boundary[0] != '\0' && parserPtr->depth < MIME_MAX_DEPTH) { //A multipart starts
+				top = parserPtr->depth++;
+				parserPtr->delimLens[top] = sprintf(parserPtr->delims[top], "\r\n--%s", parserPtr->part.boundary);
+				free(parserPtr->part.filename);
+				parserPtr->part.filename = NULL;
+				//The blank line can be the CRLF of the first delimiter, as there can be no preamble
+				pos = lineEnd - buf + 1;
+				parserPtr->state = MIME_PREAMBLE;
+			}
+			else {
+				parserPtr->part.number = ++parserPtr->parts;
+				if (parserPtr->partStart) {
+					retVal = parserPtr->partStart(parserPtr, &parserPtr->part);
+				}
+				pos = lineEnd - buf + 1;
+				parserPtr->bodyLead = blankLen;
+				parserPtr->state = MIME_BODY;
+			}
+		}
+	}
+
+	if (parserPtr->state == MIME_DONE) { //The epilogue is skipped
+		pos = len;
+	}
+
+	//What was not consumed is moved to the start of the buffer
+	memmove(buf, buf + pos, len - pos);
+	parserPtr->bufLen = len - pos;
+
+	return(retVal);
+}
+
+int mimeWrite(mimeParserT *parserPtr, char *chunk, size_t len) {
+	int retVal;
+
+	if (parserPtr->state == MIME_DONE) {
+		return(SUCCESS);
+	}
+
+	retVal = reserveMimeBuf(parserPtr, parserPtr->bufLen + len);
+	if (isError(retVal)) {
+		return(retVal);
+	}
+	memcpy(parserPtr->buf + parserPtr->bufLen, chunk, len);
+	parserPtr->bufLen += len;
+
+	return(splitBuffered(parserPtr, 0));
+}
+
+int mimeEnd(mimeParserT *parserPtr) {
+	int retVal;
+
+	retVal = splitBuffered(parserPtr, 1);
+	if (isError(retVal)) {
+		return(retVal);
+	}
+
+	if (parserPtr->state == MIME_BODY) {
+		retVal = endPart(parserPtr);
+	}
+	parserPtr->state = MIME_DONE;
+	parserPtr->bufLen = 0;
+
+	return(retVal);
+}
+
+//A part is an attachment, unless it is text that is meant to be displayed
+int isAttachment(mimePartT *partPtr) {
+	return(partPtr->attachment || partPtr->filename || strncmp(partPtr->type, "text/", 5));
+}
+
+//The name an attachment is saved as, only the last component of its file name, or part-<number>
+void attachmentFilename(mimePartT *partPtr, char *name, size_t size) {
+	char *base = partPtr->filename;
+
+	if (base) {
+		base = strrchr(base, '/') ? strrchr(base, '/') + 1 : base;
+		base = strrchr(base, '\\') ? strrchr(base, '\\') + 1 : base;
+	}
+	if (!base || !strcmp(base, "") || !strcmp(base, ".") || !strcmp(base, "..")) {
+		snprintf(name, size, "part-%d", partPtr->number);
+		return;
+	}
+
+	snprintf(name, size, "%s", base);
+	for (char *pos = name ; *pos != '\0' ; pos++) {
+		if ((unsigned char)*pos < 0x20 || *pos == 0x7F) {
+			*pos = '_';
+		}
+	}
+}
+
+//Open the file an attachment is decoded to, an existing file is not overwritten
+int readerSaveStart(mimeReaderT *readerPtr, mimePartT *partPtr) {
+	char name[FILENAME_MAX];
+
+	attachmentFilename(partPtr, name, sizeof(name));
+	if (snprintf(readerPtr->savePath, sizeof(readerPtr->savePath), "%s/%s", readerPtr->saveDir, name) >= sizeof(readerPtr->savePath)) {
+		fprintf(stderr, "%s: File name too long.\n", name);
+		readerPtr->failed++;
+		return(SUCCESS);
+	}
+
+	readerPtr->saveFile = fopen(readerPtr->savePath, "wx");
+	if (!readerPtr->saveFile) {
+		perror(readerPtr->savePath);
+		readerPtr->failed++;
+		return(SUCCESS);
+	}
+
+	//Attachments are saved as they were sent, only the transfer encoding is decoded
+	decoderInit(&readerPtr->decoder, NULL, partPtr->encoding, CHARSET_UTF8);
+	readerPtr->decoder.outFile = readerPtr->saveFile;
+	readerPtr->mode = READ_SAVE;
+
+	return(decoderStart(&readerPtr->decoder, 0));
+}
+
+//Close the file of an attachment, which is removed if it could not be saved whole
+void readerSaveEnd(mimeReaderT *readerPtr, int retVal) {
+	if (fclose(readerPtr->saveFile) || isError(retVal)) {
+		perror(readerPtr->savePath);
+		remove(readerPtr->savePath);
+		readerPtr->failed++;
+	}
+	else {
+		readerPtr->saved++;
+	}
+	readerPtr->saveFile = NULL;
+	freeDecoder(&readerPtr->decoder);
+	readerPtr->mode = READ_SKIP;
+}
+
+//The events of the reader's parser, the parser is the first member of the reader
+int readerPartStart(mimeParserT *parserPtr, mimePartT *partPtr) {
+	mimeReaderT *readerPtr = (mimeReaderT*)parserPtr;
+
+	readerPtr->mode = READ_SKIP;
+	if (isAttachment(partPtr)) {
+		return(readerPtr->saveDir ? readerSaveStart(readerPtr, partPtr) : SUCCESS);
+	}
+
+	//A text/plain part replaces a text of another type, but no other text replaces the one found
+	if (readerPtr->text && (readerPtr->textPlain || strcmp(partPtr->type, "text/plain"))) {
+		return(SUCCESS);
+	}
+	decoderInit(&readerPtr->decoder, NULL, partPtr->encoding, partPtr->charset);
+	readerPtr->mode = READ_TEXT;
+
+	return(decoderStart(&readerPtr->decoder, 0));
+}
+
+int readerPartBody(mimeParserT *parserPtr, mimePartT *partPtr, char *chunk, size_t len) {
+	mimeReaderT *readerPtr = (mimeReaderT*)parserPtr;
+	int retVal;
+
+	if (readerPtr->mode == READ_SKIP) {
+		return(SUCCESS);
+	}
+
+	retVal = decoderWrite(&readerPtr->decoder, chunk, len);
+	//An attachment that can't be written is given up on, but the rest of the message is still read
+	if (readerPtr->mode == READ_SAVE && retVal == SYSCALL_ERROR) {
+		readerSaveEnd(readerPtr, retVal);
+		return(SUCCESS);
+	}
+
+	return(retVal);
+}
+
+int readerPartEnd(mimeParserT *parserPtr, mimePartT *partPtr) {
+	mimeReaderT *readerPtr = (mimeReaderT*)parserPtr;
+	attachmentT *temp;
+	char *text;
+	int retVal = SUCCESS;
+
+	if (readerPtr->mode == READ_TEXT) {
+		retVal = decoderEnd(&readerPtr->decoder, &text);
+		freeDecoder(&readerPtr->decoder);
+		readerPtr->mode = READ_SKIP;
+		if (isError(retVal)) {
+			return(retVal);
+		}
+		free(readerPtr->text);
+		readerPtr->text = text;
+		readerPtr->textPlain = !strcmp(partPtr->type, "text/plain");
+		return(SUCCESS);
+	}
+
+	if (readerPtr->mode == READ_SAVE) {
+		retVal = decoderEnd(&readerPtr->decoder, &text);
+		readerSaveEnd(readerPtr, retVal);
+		if (retVal == MEM_ERROR) {
+			return(retVal);
+		}
+	}
+
+	if (!isAttachment(partPtr)) { //E.g. the HTML version of the text
+		return(SUCCESS);
+	}
+
+	temp = realloc(readerPtr->attachments, (readerPtr->attachmentCount+1)*sizeof(attachmentT));
+	if (!temp) {
+		return(MEM_ERROR);
+	}
+	readerPtr->attachments = temp;
+	temp = &readerPtr->attachments[readerPtr->attachmentCount];
+	temp->type = strdup(partPtr->type);
+	if (!temp->type) {
+		return(MEM_ERROR);
+	}
+	temp->number = partPtr->number;
+	temp->size = partPtr->size;
+	temp->filename = partPtr->filename; //Taken from the part
+	partPtr->filename = NULL;
+	readerPtr->attachmentCount++;
+
+	return(SUCCESS);
+}
+
+int readerSinkEnd(literalSinkT *sinkPtr, char **strPtr) {
+	mimeReaderT *readerPtr = (mimeReaderT*)sinkPtr;
+	int retVal;
+
+	retVal = mimeEnd(&readerPtr->parser);
+	if (isError(retVal)) {
+		return(retVal);
+	}
+
+	//The text is what the object contains, an empty one if the message has no text part
+	*strPtr = readerPtr->text ? readerPtr->text : strdup("");
+	readerPtr->text = NULL;
+	if (!*strPtr) {
+		return(MEM_ERROR);
+	}
+
+	return(SUCCESS);
+}
+
+void mimeReaderInit(mimeReaderT *readerPtr, char *item, char *boundary, char *saveDir) {
+	mimeInit(&readerPtr->parser, item, boundary);
+	readerPtr->parser.sink.end = readerSinkEnd;
+	readerPtr->parser.partStart = readerPartStart;
+	readerPtr->parser.partBody = readerPartBody;
+	readerPtr->parser.partEnd = readerPartEnd;
+
+	decoderInit(&readerPtr->decoder, NULL, ENCODING_IDENTITY, CHARSET_UTF8);
+	readerPtr->mode = READ_SKIP;
+	readerPtr->text = NULL;
+	readerPtr->textPlain = 0;
+	readerPtr->saveDir = saveDir;
+	readerPtr->saveFile = NULL;
+	readerPtr->saved = readerPtr->failed = 0;
+	readerPtr->attachments = NULL;
+	readerPtr->attachmentCount = 0;
+}
+
+void freeMimeReader(mimeReaderT *readerPtr) {
+	freeMimeParser(&readerPtr->parser);
+	freeDecoder(&readerPtr->decoder);
+	free(readerPtr->text);
+	readerPtr->text = NULL;
+
+	//An attachment that was still being saved is incomplete
+	if (readerPtr->saveFile) {
+		fclose(readerPtr->saveFile);
+		remove(readerPtr->savePath);
+		readerPtr->saveFile = NULL;
+	}
+	freeAttachments(readerPtr->attachments, readerPtr->attachmentCount);
+	readerPtr->attachments = NULL;
+	readerPtr->attachmentCount = 0;
+}
@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <unistd.h>
+#include "error.h"
+#include "outbuf.h"
+
+#define OUTBUF_MIN 4096
+
+//Make room for len more bytes (and a '\0'), returns 0 if there is none
+int outReserve(outBufT *outPtr, size_t len) {
+	size_t newCap;
+	char *temp;
+
+	if (outPtr->failed) {
+		return(0);
+	}
+	if (outPtr->len + len + 1 <= outPtr->cap) {
+		return(1);
+	}
+
+	//Doubling keeps the number of reallocations logarithmic in the size of the largest output
+	for (newCap = outPtr->cap ? outPtr->cap : OUTBUF_MIN ; newCap < outPtr->len + len + 1 ; newCap *= 2);
+	temp = realloc(outPtr->buf, newCap);
+	if (!temp) {
+		outPtr->failed = 1;
+		return(0);
+	}
+	outPtr->buf = temp;
+	outPtr->cap = newCap;
+
+	return(1);
+}
+
+void outWrite(outBufT *outPtr, char *str, size_t len) {
+	if (outReserve(outPtr, len)) {
+		memcpy(outPtr->buf + outPtr->len, str, len);
+		outPtr->len += len;
+	}
+}
+
+void outStr(outBufT *outPtr, char *str) {
+	outWrite(outPtr, str, strlen(str));
+}
+
+void outChar(outBufT *outPtr, char c) {
+	if (outReserve(outPtr, 1)) {
+		outPtr->buf[outPtr->len++] = c;
+	}
+}
+
+void outPrintf(outBufT *outPtr, char *format, ...) {
+	va_list args;
+	int len;
+
+	if (outPtr->failed) {
+		return;
+	}
+
+	//Most output fits in the room that is left, so it is formatted only once
+	va_start(args, format);
+	len = vsnprintf(outPtr->buf ? outPtr->buf + outPtr->len : NULL, outPtr->buf ? outPtr->cap - outPtr->len : 0, format, args);
+	va_end(args);
+	if (len < 0) {
+		return;
+	}
+
+	if (!outPtr->buf || outPtr->len + len + 1 > outPtr->cap) {
+		if (!outReserve(outPtr, len)) {
+			return;
+		}
+		va_start(args, format);
+		vsnprintf(outPtr->buf + outPtr->len, outPtr->cap - outPtr->len, format, args);
+		va_end(args);
+	}
+	outPtr->len += len;
+}
+
+void outPad(outBufT *outPtr, int num) {
+	if (num > 0 && outReserve(outPtr, num)) {
+		memset(outPtr->buf + outPtr->len, ' ', num);
+		outPtr->len += num;
+	}
+}
+
+int outFlush(outBufT *outPtr, int fd) {
+	size_t written = 0;
+	ssize_t bytes;
+
+	fflush(stdout);
+
+	if (outPtr->failed) {
+		outPtr->failed = 0;
+		outPtr->len = 0;
+		return(MEM_ERROR);
+	}
+
+	//A terminal normally takes everything at once, the loop is for signals and pipes
+	while (written < outPtr->len) {
+		bytes = write(fd, outPtr->buf + written, outPtr->len - written);
+		if (bytes < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			outPtr->len = 0;
+			return(SYSCALL_ERROR);
+		}
+		written += bytes;
+	}
+	outPtr->len = 0;
+
+	return(SUCCESS);
+}
+
+void outReset(outBufT *outPtr) {
+	outPtr->len = 0;
+	outPtr->failed = 0;
+}
+
+void freeOutBuf(outBufT *outPtr) {
+	free(outPtr->buf);
+	outPtr->buf = NULL;
+	outPtr->len = outPtr->cap = 0;
+	outPtr->failed = 0;
+}
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <ctype.h>
 #include <string.h>
+#include <strings.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include "parsing.h"
@@ -15,6 +16,13 @@
 #define BATCH 32
 #define LIST_BATCH 32
 
+#define LITERAL_CHUNK 16384 //Literals are read in chunks of this size
+
+/* The sink strings are passed to (check parsing.h), it is armed when its item is parsed
+  as a list element, so that the next object is passed to it */
+literalSinkT *literalSink = NULL;
+int literalSinkArmed = 0;
+
 //Frees an array of handles to imap objects
 void freeElemArray(imapObjectHandleT *elemArray, int elems);
 
@@ -30,8 +38,12 @@ int getAtom(imapObjectHandleT atomHandle, FILE *stream, char context);
 //Parses a list of elements, and returns a LIST object through the supplied handle (or NIL if the list is empty)
 int parseList(imapObjectHandleT listHandle, FILE *stream);
 
-/* Returns a STRING object (which may be a literal or a quoted string), or NIL. */
-int parseString(imapObjectHandleT strHandle, FILE *stream, char prevChar);
+/* Returns a STRING object (which may be a literal or a quoted string), or NIL. 
+  If toSink is set, the string is passed to the literal sink */
+int parseString(imapObjectHandleT strHandle, FILE *stream, char prevChar, int toSink);
+
+//Passes a quoted string to the literal sink
+int sinkString(char **strPtr, literalSinkT *sinkPtr);
 
 //Parses an atom, and returns a string
 int parseAtom(char **strPtr, FILE *stream, char context);
@@ -40,7 +52,7 @@ int parseAtom(char **strPtr, FILE *stream, char context);
 int parseQuoted(char **strPtr, FILE *stream);
 
 //Parses a literal string, and returns a string, or NIL (if it is the empty literal {0}\r\n)
-int parseLiteral(char **strPtr, FILE *stream);
+int parseLiteral(char **strPtr, FILE *stream, literalSinkT *sinkPtr);
 
 //Allocate and initialize an imapHandle
 int imapHandleInit(imapObjectHandleT *handlePtr);
@@ -109,10 +121,19 @@ int imapHandleInit(imapObjectHandleT *handlePtr) {
 	return(SUCCESS);
 }
 
+void setLiteralSink(literalSinkT *sinkPtr) {
+	literalSink = sinkPtr;
+	literalSinkArmed = 0;
+}
+
 int createImapObject(imapObjectHandleT *handlePtr, FILE *stream, char context) {
 	char c;
 	imapObjectHandleT imapHandle;
-	int retVal;
+	int retVal, toSink;
+
+	//Only the object right after the sink's item goes to the sink
+	toSink = literalSinkArmed;
+	literalSinkArmed = 0;
 
 	//Allocate the space for an imapObject, and get its handle
 	retVal = imapHandleInit(&imapHandle);
@@ -144,7 +165,7 @@ int createImapObject(imapObjectHandleT *handlePtr, FILE *stream, char context) {
 			free(imapHandle);
 			return(SOCKET_ERROR);
 		}
-		retVal = parseString(imapHandle, stream, c);
+		retVal = parseString(imapHandle, stream, c, toSink);
 		if (isError(retVal)) {
 			free(imapHandle);
 			return(retVal);
@@ -222,6 +243,9 @@ int parseList(imapObjectHandleT listHandle, FILE *stream) {
 			freeElemArray(elemArray, elems);
 			return(retVal);
 		}
+		if (literalSink != NULL && elemArray[elems]->tag == STRING && !strcasecmp(elemArray[elems]->content.string, literalSink->item)) {
+			literalSinkArmed = 1;
+		}
 		elems++;
 
 		c = peekChar(stream); 
@@ -262,7 +286,7 @@ int parseList(imapObjectHandleT listHandle, FILE *stream) {
   in the future, parseLiteral and parseQuoted might be called directly
   from createImapObject() */
 
-int parseString(imapObjectHandleT strHandle, FILE *stream, char prevChar) {
+int parseString(imapObjectHandleT strHandle, FILE *stream, char prevChar, int toSink) {
 	char *str;
 	int retVal;
 
@@ -271,9 +295,15 @@ int parseString(imapObjectHandleT strHandle, FILE *stream, char prevChar) {
 		if (isError(retVal)) {
 			return(retVal);
 		}
+		if (toSink) { //Short strings may be quoted, they are passed to the sink whole
+			retVal = sinkString(&str, literalSink);
+			if (isError(retVal)) {
+				return(retVal);
+			}
+		}
 	}
 	else { //If the first character was a left bracket, it is a literal string
-		retVal = parseLiteral(&str, stream);
+		retVal = parseLiteral(&str, stream, toSink ? literalSink : NULL);
 		if (isError(retVal)) {
 			return(retVal);
 		}
@@ -372,9 +402,52 @@ int getNum(FILE *stream) {
 	return(num);
 }
 
-int parseLiteral(char **strPtr, FILE *stream) {
+//Pass a whole string to a sink, replacing it with the string the sink returns
+int sinkString(char **strPtr, literalSinkT *sinkPtr) {
+	char *str = *strPtr ? *strPtr : "";
+	int retVal;
+
+	retVal = sinkPtr->start(sinkPtr, strlen(str));
+	if (!isError(retVal)) {
+		retVal = sinkPtr->write(sinkPtr, str, strlen(str));
+	}
+	free(*strPtr);
+	if (isError(retVal)) {
+		return(retVal);
+	}
+
+	return(sinkPtr->end(sinkPtr, strPtr));
+}
+
+//Read a literal's content in chunks, passing them to a sink
+int sinkLiteral(char **strPtr, FILE *stream, int litSize, literalSinkT *sinkPtr) {
+	char chunk[LITERAL_CHUNK];
+	size_t chunkSize;
+	int retVal;
+
+	retVal = sinkPtr->start(sinkPtr, litSize);
+	if (isError(retVal)) {
+		return(retVal);
+	}
+
+	while (litSize > 0) {
+		chunkSize = litSize < LITERAL_CHUNK ? litSize : LITERAL_CHUNK;
+		if (fread(chunk, 1, chunkSize, stream) != chunkSize) {
+			return(SOCKET_ERROR);
+		}
+		retVal = sinkPtr->write(sinkPtr, chunk, chunkSize);
+		if (isError(retVal)) {
+			return(retVal);
+		}
+		litSize -= chunkSize;
+	}
+
+	return(sinkPtr->end(sinkPtr, strPtr));
+}
+
+int parseLiteral(char **strPtr, FILE *stream, literalSinkT *sinkPtr) {
 	char *result;
-	int litSize, k;
+	int litSize;
 	char c;
 
 	/* A literal string is in the format {<octets>} CRLF <content>, if any of that is
@@ -405,6 +478,10 @@ int parseLiteral(char **strPtr, FILE *stream) {
 		return(PARSE_ERROR);
 	}
 
+	if (sinkPtr != NULL) {
+		return(sinkLiteral(strPtr, stream, litSize, sinkPtr));
+	}
+
 	if (!litSize) { //{0}\r\n is the empty literal, so NULL is returned
 		*strPtr = NULL;
 		return(SUCCESS);
@@ -417,15 +494,11 @@ int parseLiteral(char **strPtr, FILE *stream) {
 	}
 
 	//Fill string with litSize characters
-	for (k = 0 ; k < litSize ; k++) {
-		c = fgetc(stream);
-		if (c == EOF) {
-			free(result);
-			return(SOCKET_ERROR);
-		}
-		result[k] = c;
+	if (fread(result, 1, litSize, stream) != litSize) {
+		free(result);
+		return(SOCKET_ERROR);
 	}
-	result[k] = '\0'; //Terminate the result string
+	result[litSize] = '\0'; //Terminate the result string
 
 	*strPtr = result; //Return string via pointer
 
@@ -604,6 +677,10 @@ int getStringObject(imapObjectHandleT *imapHandlePtr, FILE *imapStream) {
 	return(SUCCESS);
 }
 
+int getImapObject(imapObjectHandleT *imapHandlePtr, FILE *imapStream) {
+	return(createImapObject(imapHandlePtr, imapStream, NO_PARSE_CONTEXT));
+}
+
 int getListObject(imapObjectHandleT *imapHandlePtr, FILE *imapStream) {
 	imapObjectHandleT imapHandle;
 	int retVal;
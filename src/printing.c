@@ -1,4 +1,11 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/ioctl.h>
 #include "parsing.h"
 #include "addresses.h"
 #include "cache.h"
@@ -6,6 +13,14 @@
 #include "utf8.h"
 #include "commands.h"
 #include "printing.h"
+#include "date.h"
+#include "sort.h"
+#include "search.h"
+#include "bitmap.h"
+#include "flags.h"
+#include "senders.h"
+#include "untagged.h"
+#include "outbuf.h"
 
 //ANSI escape codes 
 #define BOLD_WHITE "\e[1;37m" //Used to emphasize the subject
@@ -14,30 +29,84 @@
 
 //Used in printing the message preview
 #define NUM_CHARS 5 //Five digits for printing the message sequence number
-#define FROM_CHARS 20 //Max characters to be printed for the From field
-#define SUBJECT_CHARS 35 //Max charactes of the subject printed
+#define FROM_CHARS 20 //Max columns the From field takes (wide characters take 2, check width.h)
+#define SUBJECT_CHARS 35 //Min columns the subject takes (it takes the columns the other fields leave)
 #define DATE_CHARS 20 //DD-MMM-YYYY HH:MM:SS 
+#define SIZE_CHARS 10 //e.g. 1023.99 KB
+//The columns of a preview besides the subject: "[NNNNN] F", the spaces between the fields, From, Date and Size
+#define FIXED_CHARS (NUM_CHARS+4 + 2 + 2+FROM_CHARS + 2+DATE_CHARS + 2+SIZE_CHARS)
 
-#define PAGE_MSGS  20 //The number of messages per page (displayMsgPage() displays messages by page)
+#define SEARCH_MSGS 100 //The maximum number of search results displayed
+#define SENDERS_SHOWN 20 //The number of senders displayed, the heaviest ones
 
 //Used in printing the message size
 #define KB 1024
-#define MB 1024*KB
+#define MB (1024*KB)
+#define GB (1024*MB)
+
+//Pages and messages are formatted into this buffer, and displayed with a single write() (check outbuf.h)
+outBufT screenBuf = OUTBUF_INIT;
+outBufT lineBuf = OUTBUF_INIT; //A preview is rendered here, before it is copied to its message
+
+/* The previews of the messages are kept rendered (check cache.h), along with the generation of
+  the layout they were rendered for. The layout depends on the width of the terminal, as the subject
+  takes the columns the rest of the fields leave, so on a resize (SIGWINCH) the generation changes,
+  and each preview is rendered again the next time it is displayed */
+struct previewLayout {
+	int subjectChars;
+	unsigned int generation; //Starts from 1, as 0 marks a preview that has not been rendered
+} layout = {SUBJECT_CHARS, 1};
+
+volatile sig_atomic_t terminalResized = 1; //Set at first too, so that the width is read
+
+void handleResize(int signum) {
+	terminalResized = 1;
+}
 
-void clearScreen(void) {
-	printf(CLEAR);
+int watchTerminalSize(void) {
+	struct sigaction action = {0};
+
+	action.sa_handler = handleResize;
+	action.sa_flags = SA_RESTART; //So that reading the user's input is not interrupted
+	sigemptyset(&action.sa_mask);
+	if (sigaction(SIGWINCH, &action, NULL) < 0) {
+		return(SYSCALL_ERROR);
+	}
+
+	return(SUCCESS);
 }
 
-void printWhitespaces(int num) {
-	for (int k = 0 ; k < num ; k++) {
-		putchar(' ');
+void updateLayout(void) {
+	struct winsize size;
+	int subjectChars = SUBJECT_CHARS;
+
+	if (!terminalResized) {
+		return;
 	}
+	terminalResized = 0;
+
+	//The last column is left empty, as some terminals move to the next line when it is written to
+	if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_col > FIXED_CHARS + SUBJECT_CHARS + 1) {
+		subjectChars = size.ws_col - FIXED_CHARS - 1;
+	}
+	if (subjectChars != layout.subjectChars) {
+		layout.subjectChars = subjectChars;
+		layout.generation++;
+	}
+}
+
+void clearScreen(void) {
+	printf(CLEAR);
 }
 
 void printStat(msgCacheT *cachePtr) {
 	printf("Stats:\n");
 	printf("\tMessages: %lu\n", cachePtr->cacheSize);
 	printf("\tRecent: %lu\n", cachePtr->recent);
+	//Counted by the flag index, so only messages whose flags have been fetched are included
+	printf("\tUnseen: %lu\n", flagCount(cachePtr->flagIndex, SEEN, 1));
+	printf("\tFlagged: %lu\n", flagCount(cachePtr->flagIndex, FLAGGED, 0));
+	printf("\tDeleted: %lu\n", flagCount(cachePtr->flagIndex, DELETED, 0));
 	if (cachePtr->cacheSize == 0) {
 		printf("\tPages: 0\n");
 	}
@@ -49,111 +118,196 @@ void printStat(msgCacheT *cachePtr) {
 void printHelp(void) {
 	printf("Commands:\n");
 	printf("\tdelete <num> - Marks the message with message number <num> for deletion.\n");
+	printf("\tdelete from:<address> - Marks all messages from <address> for deletion.\n");
 	printf("\tundelete <num> - Unmarks the marked for deletion message <num>. If not marked, it does nothing.\n");
 	printf("\texpunge - Deletes all messages that are marked for deletion.\n");
 	printf("\tread <num> - Display the message with number <num>.\n");
+	printf("\tsave <num> [dir] - Save the attachments of the message <num> to the directory [dir] (the current one by default).\n");
 	printf("\tpage <num> - Display all the messages on the page numbered <num>.\n");
+	printf("\tbrowse - Browse the messages full-screen (j/k, space/b, g/G, Enter to read, q to quit).\n");
+	printf("\tsort date|size|from|subject|none [asc|desc] - Change the order pages are displayed in.\n");
+	printf("\tsearch <words> - Display the messages containing all of the words.\n");
+	printf("\tsenders [count|size|unseen] - Display the senders with the most messages (or size, or unseen messages).\n");
+	printf("\tfilter <flags> - Display the messages with all of the flags, e.g. filter unseen flagged.\n");
+	printf("\t                 The flags are [un]seen, [un]answered, [un]deleted, [un]flagged and [un]recent.\n");
 	printf("\tlogout - Close the connection with the server, and close the program.\n");
-	printf("\tselect <mailbox-name> - Select the mailbox named <mailbox-name>.\n");
-	printf("\tlist - List mailbox names (not recursively).\n");
-	printf("\tstats - Display information about the mailbox.\n");
+	printf("\tselect <mailbox-name> - Select the mailbox named <mailbox-name> (its full name, as list displays it).\n");
+	printf("\tlist [refresh] - List all mailboxes as a tree, refresh lists them again from the server.\n");
+	printf("\tstats - Display information about the mailbox, and the connection.\n");
 	printf("\tclear - Clear the screen.\n");
 	printf("\thelp - You are here.\n\n");
 }
 
-void printMsgContents(msgT *msgPtr) {
+//Format the message size, with the appropriate units
+void renderSize(outBufT *outPtr, unsigned long long msgSize) {
+	if (msgSize < KB) {
+		outPrintf(outPtr, "%llu B", msgSize);
+	}
+	else if (msgSize >= KB && msgSize < MB) {
+		outPrintf(outPtr, "%.2f KB", (double)msgSize / KB);
+	}
+	else if (msgSize < GB) {
+		outPrintf(outPtr, "%.2f MB", (double)msgSize / MB);
+	}
+	else { //Only the totals of the senders get this large
+		outPrintf(outPtr, "%.2f GB", (double)msgSize / GB);
+	}
+}
+
+int renderMsgContents(outBufT *outPtr, msgT *msgPtr) {
+	char dateStr[DATE_SIZE];
+	int retVal;
+
+	if (isError(retVal = decodeEnvelope(&msgPtr->envelope))) {
+		return(retVal);
+	}
+
 	if (msgPtr->envelope.subject != NULL) {
-		printf(BOLD_WHITE"%s\n\n"RSET, msgPtr->envelope.subject);
+		outPrintf(outPtr, BOLD_WHITE"%s\n\n"RSET, msgPtr->envelope.subject);
 	}
 	else { //If the message didn't have a subject
-		printf(BOLD_WHITE"(No Subject)\n\n"RSET);
+		outStr(outPtr, BOLD_WHITE"(No Subject)\n\n"RSET);
 	}
-	printf("Date: %s\n", msgPtr->internalDate); 
-	printf("From: ");
-	printAddressList(msgPtr->envelope.fromList);
-	putchar('\n');
-	printf("To: ");
-	printAddressList(msgPtr->envelope.toList);
-	putchar('\n');
+	formatDateTime(dateStr, msgPtr->internalDate, msgPtr->tzOffset);
+	outPrintf(outPtr, "Date: %s\n", dateStr); 
+	outStr(outPtr, "From: ");
+	renderAddressList(outPtr, &msgPtr->envelope.fromList);
+	outChar(outPtr, '\n');
+	outStr(outPtr, "To: ");
+	renderAddressList(outPtr, &msgPtr->envelope.toList);
+	outChar(outPtr, '\n');
 
 	//If no addresses were CC'd
-	if (msgPtr->envelope.ccList != NULL) {
-		printf("Cc: ");
-		printAddressList(msgPtr->envelope.ccList);
-		putchar('\n');
+	if (msgPtr->envelope.ccList.count > 0) {
+		outStr(outPtr, "Cc: ");
+		renderAddressList(outPtr, &msgPtr->envelope.ccList);
+		outChar(outPtr, '\n');
 	}
-	printf("\n\n");
-	printf("%s\n", msgPtr->text);
-}
+	outStr(outPtr, "\n\n");
+	outStr(outPtr, msgPtr->text);
+	outChar(outPtr, '\n');
 
-//Print the message size, with the appropriate units
-void printSize(int msgSize) {
-	if (msgSize < KB) {
-		printf("%d B", msgSize);
-	}
-	else if (msgSize >= KB && msgSize < MB) {
-		printf("%.2f KB", (double)msgSize / KB);
+	//The parts of a multipart text that were not displayed
+	if (msgPtr->attachmentCount > 0) {
+		outStr(outPtr, "\nAttachments:\n");
 	}
-	else {
-		printf("%.2f MB", (double)msgSize / MB);
+	for (int k = 0 ; k < msgPtr->attachmentCount ; k++) {
+		outPrintf(outPtr, "\t%s (%s, ", msgPtr->attachments[k].filename ? msgPtr->attachments[k].filename : "(No Name)",
+		          msgPtr->attachments[k].type);
+		renderSize(outPtr, msgPtr->attachments[k].size);
+		outStr(outPtr, ")\n");
 	}
+
+	return(SUCCESS);
 }
 
-//Display a preview of a string, meaning that only the first <maxChars> characters are printed
-void displayStrPreview(char *str, int maxChars) {
-	int len;
+/* Format a preview of a string, that takes width columns, in maxColumns columns, if it does
+  not fit, only its start is shown, followed by "(..)" */
+void renderStrPreview(outBufT *outPtr, char *str, int width, int maxColumns) {
+	size_t len;
+	int printed;
 
-	len = utf8StrLen(str); //Check utf8.h, strlen() can't be used with utf-8 chars
-	if (len <= maxChars) {
-		printf("%s", str);
-		printWhitespaces(maxChars-len);
+	if (width <= maxColumns) {
+		outStr(outPtr, str);
+		outPad(outPtr, maxColumns-width);
 	}
 	else {
-		printNChars(str, maxChars-4); //The length of "(..)" is 4
-		printf("(..)");
+		len = columnsPrefix(str, maxColumns-4, &printed); //The length of "(..)" is 4
+		outWrite(outPtr, str, len);
+		outStr(outPtr, "(..)");
+		outPad(outPtr, maxColumns-4-printed); //If a wide character did not fit
 	}
 }
 
-void displayMsgPreview(msgT *msgPtr, size_t msgNum) {
-	char format[10];
+//The flag shown in a preview, the most important one if there are many
+char flagMark(int flags) {
+	if (flags & DELETED) {
+		return('D');
+	}
+	else if (flags & FLAGGED) {
+		return('*');
+	}
+	else if (!(flags & SEEN)) {
+		return('N');
+	}
 
-	//Print the message sequence number
-	sprintf(format, "[%%0%dlu]", NUM_CHARS);
-	printf(format, msgNum); //M<e 
-	printWhitespaces(2);
+	return(' ');
+}
+
+//Render the preview of a message (all but its sequence number), and keep it in the message
+int cachePreview(msgT *msgPtr) {
+	char dateStr[DATE_SIZE], *temp;
+	int retVal;
 
-	//Print subject (probably utf-8)
+	//Only the envelopes of the messages that are displayed are decoded
+	if (isError(retVal = decodeEnvelope(&msgPtr->envelope))) {
+		return(retVal);
+	}
+
+	outChar(&lineBuf, flagMark(msgPtr->flags));
+	outPad(&lineBuf, 2);
+
+	//The subject (probably utf-8)
 	if (msgPtr->envelope.subject != NULL) {
-		displayStrPreview(msgPtr->envelope.subject, SUBJECT_CHARS);
+		renderStrPreview(&lineBuf, msgPtr->envelope.subject, msgPtr->envelope.subjectWidth, layout.subjectChars);
 	}
 	else { //If the message does not have a subject
-		printf("(No Subject)");
+		renderStrPreview(&lineBuf, "(No Subject)", 12, layout.subjectChars);
 	}
-	printWhitespaces(2);
+	outPad(&lineBuf, 2);
 
-	/*For the From field, print the personal-name ofthe first from-address, (head of list),
-	 and if it does not exist, print the mailbox name of the head. */
-	if (msgPtr->envelope.fromList->personalName != NULL) {
-		displayStrPreview(msgPtr->envelope.fromList->personalName, FROM_CHARS);
+	/*For the From field, show the personal-name of the first from-address,
+	 and if it does not exist, its mailbox name (check senderName()). */
+	if (senderName(&msgPtr->envelope.fromList) != NULL) {
+		renderStrPreview(&lineBuf, senderName(&msgPtr->envelope.fromList), msgPtr->envelope.fromWidth, FROM_CHARS);
 	}
-	else{
-		displayStrPreview(msgPtr->envelope.fromList->mailboxName, FROM_CHARS);
+	else { //If the message has no sender (an empty From list, or a group without addresses)
+		renderStrPreview(&lineBuf, "(Unknown)", 9, FROM_CHARS);
 	}
+	outPad(&lineBuf, 2);
 
-	printWhitespaces(2);
+	//The Date field
+	formatDateTime(dateStr, msgPtr->internalDate, msgPtr->tzOffset);
+	outPrintf(&lineBuf, "%.*s", DATE_CHARS, dateStr);
+	outPad(&lineBuf, 2);
 
-	//Print the Date field
-	printNChars(msgPtr->internalDate, DATE_CHARS);
-	printWhitespaces(2);
+	//The Size field
+	renderSize(&lineBuf, msgPtr->size);
 
-	//Print the Size field
-	printSize(msgPtr->size);
+	outChar(&lineBuf, '\n');
+
+	if (lineBuf.failed || !(temp = realloc(msgPtr->preview, lineBuf.len))) {
+		outReset(&lineBuf);
+		return(MEM_ERROR);
+	}
+	memcpy(temp, lineBuf.buf, lineBuf.len);
+	msgPtr->preview = temp;
+	msgPtr->previewLen = lineBuf.len;
+	msgPtr->previewLayout = layout.generation;
+	outReset(&lineBuf);
 
-	putchar('\n');
+	return(SUCCESS);
+}
+
+int renderMsgPreview(outBufT *outPtr, msgCacheT *cachePtr, size_t pos) {
+	msgT *msgPtr = cachePtr->msgPtrArray[pos];
+	int retVal;
+
+	if (msgPtr->previewLayout != layout.generation) {
+		if (isError(retVal = cachePreview(msgPtr))) {
+			return(retVal);
+		}
+		cacheAccount(cachePtr, msgPtr); //The preview is kept, and the envelope may have been decoded
+	}
+
+	//The message sequence number, zero padded to NUM_CHARS digits, followed by the cached preview
+	outPrintf(outPtr, "[%0*lu] ", NUM_CHARS, pos+1);
+	outWrite(outPtr, msgPtr->preview, msgPtr->previewLen);
+
+	return(SUCCESS);
 }
 
 int displayMsg(FILE *imapStream, msgCacheT *cachePtr, int msgNum) {
-	msgT **msgPtrArray = cachePtr->msgPtrArray;
 	int retVal;
 
 	if (cachePtr->cacheSize == 0) {
@@ -166,41 +320,82 @@ int displayMsg(FILE *imapStream, msgCacheT *cachePtr, int msgNum) {
 	}
 
 	//If the text field is NULL, the text hasn't been fetched yet, so is here
-	if (!msgPtrArray[msgNum-1]->text)  {
+	if (!cachePtr->msgPtrArray[msgNum-1]->text)  {
 		retVal = sendFetchText(imapStream, cachePtr, msgNum);
 		if (isError(retVal)) {
 			return(retVal);
 		}
 	}
 
-	printMsgContents(msgPtrArray[msgNum-1]);
+	//The array is accessed again, as untagged responses to the fetch can resize it
+	if (msgNum > cachePtr->cacheSize || !cachePtr->msgPtrArray[msgNum-1]->text) {
+		printf("The message was deleted.\n");
+		return(SUCCESS);
+	}
+	retVal = renderMsgContents(&screenBuf, cachePtr->msgPtrArray[msgNum-1]);
+	if (isError(retVal)) {
+		return(retVal);
+	}
+	cacheAccount(cachePtr, cachePtr->msgPtrArray[msgNum-1]); //The envelope may have been decoded
+
+	return(outFlush(&screenBuf, STDOUT_FILENO));
+}
+
+int saveMsgAttachments(FILE *imapStream, msgCacheT *cachePtr, int msgNum, char *saveDir) {
+	int saved, failed, retVal;
+
+	if (cachePtr->cacheSize == 0) {
+		printf("Mailbox is empty.\n");
+		return(SUCCESS);
+	}
+	else if (msgNum > cachePtr->cacheSize || msgNum <= 0) {
+		printf("Message number is out of bounds, try 0 < msgNum =< %lu, next time.\n", cachePtr->cacheSize);
+		return(SUCCESS);
+	}
+
+	retVal = sendSaveAttachments(imapStream, cachePtr, msgNum, saveDir, &saved, &failed);
+	if (isError(retVal)) {
+		return(retVal);
+	}
+
+	if (saved == 0 && failed == 0) {
+		printf("The message has no attachments.\n");
+	}
+	else {
+		printf("Saved %d attachment(s) to %s", saved, saveDir);
+		if (failed > 0) {
+			printf(", %d could not be saved", failed);
+		}
+		printf(".\n");
+	}
 
 	return(SUCCESS);
 }
 
-void printPageHeader(void) {
-	printf("Msgnum:  ");
-	printf("Subject:");
-	printWhitespaces(SUBJECT_CHARS-6); //8 is the length of "Subject:", minus the 2 whitespaces in displayMsgPreview
-	printf("From:");
-	printWhitespaces(FROM_CHARS-3); //5 is the length of "From:", minus the 2 whitespaces in displayMsgPreview
-	printf("Date:");
-	printWhitespaces(DATE_CHARS-3); //5 is the length of "Date:", minus the 2 whitespaces in displayMsgPreview
-	printf("Size:\n");
+void renderPageHeader(outBufT *outPtr) {
+	outStr(outPtr, "Msgnum:    "); //The number and the flag
+	outStr(outPtr, "Subject:");
+	outPad(outPtr, layout.subjectChars-6); //8 is the length of "Subject:", minus the 2 whitespaces in renderMsgPreview
+	outStr(outPtr, "From:");
+	outPad(outPtr, FROM_CHARS-3); //5 is the length of "From:", minus the 2 whitespaces in renderMsgPreview
+	outStr(outPtr, "Date:");
+	outPad(outPtr, DATE_CHARS-3); //5 is the length of "Date:", minus the 2 whitespaces in renderMsgPreview
+	outStr(outPtr, "Size:\n");
 }
 
-void displayMsgPage(FILE *imapStream, msgCacheT *cachePtr, size_t pageNum) {
-	size_t msgs = cachePtr->cacheSize, loopLimit;
-	msgT **msgPtrArray = cachePtr->msgPtrArray;
+int displayMsgPage(FILE *imapStream, msgCacheT *cachePtr, size_t pageNum) {
+	//Pages follow the current sort order (check sort.h), which is the sequence number order by default
+	size_t msgs = viewLength(cachePtr), loopLimit, pos;
+	int retVal;
 
 	if (msgs == 0) {
 		printf("Mailbox is empty.\n");
-		return;
+		return(SUCCESS);
 	} 
 	//msgs / PAGE_MSGS + 1 is the total number of pages
 	else if (pageNum > msgs / PAGE_MSGS +1 || pageNum < 1) {
 		printf("Page number is out of bounds, try 0 < pageNum =< %lu, next time.\n", msgs / PAGE_MSGS + 1);
-		return;
+		return(SUCCESS);
 	}
 
 	/* If the page is not the last, or it has exactly PAGE_MSGS messages, then the limit 
@@ -212,10 +407,151 @@ void displayMsgPage(FILE *imapStream, msgCacheT *cachePtr, size_t pageNum) {
 		loopLimit = msgs;
 	}
 
-	printPageHeader();
+	updateLayout();
+	renderPageHeader(&screenBuf);
 
-	//Display all messages of the page
+	//Format all messages of the page, and display them at once
 	for (size_t k = PAGE_MSGS * (pageNum-1) ; k < loopLimit ; k++) { 
-		displayMsgPreview(msgPtrArray[k], k+1);
+		pos = viewMsgPos(cachePtr, k);
+		if (isError(retVal = renderMsgPreview(&screenBuf, cachePtr, pos))) {
+			return(retVal);
+		}
+	}
+
+	return(outFlush(&screenBuf, STDOUT_FILENO));
+}
+
+/* Display the messages with the given UIDs (in ascending order), used for search and filter results,
+  the number of them that are still in the mailbox is stored in foundPtr */
+int displayUidList(msgCacheT *cachePtr, unsigned long *uids, size_t count, size_t *foundPtr) {
+	size_t pos, found = 0;
+	int retVal;
+
+	if (count > 0) {
+		updateLayout();
+		renderPageHeader(&screenBuf);
+	}
+
+	//The most recent messages are displayed first, UIDs of expunged messages are not found, so they are skipped
+	for (size_t k = count ; k > 0 ; k--) {
+		if (cacheFindUid(cachePtr, uids[k-1], &pos)) {
+			if (found < SEARCH_MSGS && isError(retVal = renderMsgPreview(&screenBuf, cachePtr, pos))) {
+				return(retVal);
+			}
+			found++;
+		}
+	}
+
+	if (found > SEARCH_MSGS) {
+		outPrintf(&screenBuf, "(Only the %d most recent messages are displayed)\n", SEARCH_MSGS);
+	}
+	*foundPtr = found;
+
+	return(outFlush(&screenBuf, STDOUT_FILENO));
+}
+
+int displaySearch(msgCacheT *cachePtr, char *query) {
+	struct timespec start, end;
+	unsigned long *uids;
+	size_t count;
+	int retVal;
+
+	/* The envelopes are indexed while the user is idle (check search.h), the time includes indexing
+	  those that arrived since then, or all of them, if the user searches before it is done */
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	retVal = indexEnvelopes(cachePtr, SIZE_MAX);
+	if (isError(retVal)) {
+		return(retVal);
+	}
+	retVal = searchIndexQuery(cachePtr->searchIndex, query, &uids, &count);
+	if (isError(retVal)) {
+		return(retVal);
 	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	//Counted again, as the UIDs of expunged messages may still be in the index
+	retVal = displayUidList(cachePtr, uids, count, &count);
+	free(uids);
+	if (isError(retVal)) {
+		return(retVal);
+	}
+	printf("%lu messages found in %.3f ms.\n", count, (end.tv_sec - start.tv_sec)*1000.0 + (end.tv_nsec - start.tv_nsec)/1e6);
+
+	return(SUCCESS);
+}
+
+int displaySenders(msgCacheT *cachePtr, int rankBy) {
+	senderT **senders;
+	size_t count, start;
+	char *name, *address;
+	int retVal;
+
+	retVal = rankSenders(cachePtr->senderIndex, rankBy, &senders, &count);
+	if (isError(retVal)) {
+		return(retVal);
+	}
+	if (count == 0) {
+		printf("No senders yet.\n");
+		return(SUCCESS);
+	}
+
+	outStr(&screenBuf, "Msgs:    Unseen:  Size:       Sender:\n");
+	for (size_t k = 0 ; k < count && k < SENDERS_SHOWN ; k++) {
+		outPrintf(&screenBuf, "%-7lu  %-7lu  ", senders[k]->msgs, senders[k]->unseen);
+		start = screenBuf.len;
+		renderSize(&screenBuf, senders[k]->size);
+		outPad(&screenBuf, SIZE_CHARS+2 - (int)(screenBuf.len - start));
+		//The name is the one the sender's messages came with, so it may not be decoded yet
+		name = NULL;
+		if (senders[k]->name != NULL && (name = strdup(senders[k]->name)) != NULL && isError(decodeHeaderField(&name))) {
+			free(name);
+			name = NULL;
+		}
+		//The address is kept as the server sent it, to be matched, so a copy is sanitized to be displayed
+		address = strdup(senders[k]->address);
+		if (!address || isError(utf8Sanitize(&address, 0))) {
+			free(address);
+			free(name);
+			free(senders);
+			outReset(&screenBuf);
+			return(MEM_ERROR);
+		}
+		if (name != NULL) {
+			outPrintf(&screenBuf, "%s <%s>\n", name, address);
+			free(name);
+		}
+		else {
+			outPrintf(&screenBuf, "<%s>\n", address);
+		}
+		free(address);
+	}
+	if (count > SENDERS_SHOWN) {
+		outPrintf(&screenBuf, "(and %lu more senders)\n", count - SENDERS_SHOWN);
+	}
+	free(senders);
+
+	return(outFlush(&screenBuf, STDOUT_FILENO));
+}
+
+int displayFilter(msgCacheT *cachePtr, int setFlags, int unsetFlags) {
+	struct timespec start, end;
+	unsigned long *uids;
+	size_t count;
+	int retVal;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	retVal = flagIndexFilter(cachePtr->flagIndex, setFlags, unsetFlags, &uids, &count);
+	if (isError(retVal)) {
+		return(retVal);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	retVal = displayUidList(cachePtr, uids, count, &count);
+	free(uids);
+	if (isError(retVal)) {
+		return(retVal);
+	}
+	printf("%lu messages found in %.3f ms.\n", count, (end.tv_sec - start.tv_sec)*1000.0 + (end.tv_nsec - start.tv_nsec)/1e6);
+
+	return(SUCCESS);
 }
@@ -0,0 +1,133 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include "error.h"
+#include "queue.h"
+
+int queueInit(spscQueueT *queuePtr, size_t capacity) {
+	size_t cap = 1;
+
+	while (cap < capacity) {
+		cap *= 2;
+	}
+	queuePtr->ring = malloc(cap*sizeof(void *));
+	if (!queuePtr->ring) {
+		return(MEM_ERROR);
+	}
+	queuePtr->mask = cap - 1;
+	atomic_init(&queuePtr->head, 0);
+	atomic_init(&queuePtr->tail, 0);
+
+	queuePtr->itemFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	queuePtr->spaceFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (queuePtr->itemFd < 0 || queuePtr->spaceFd < 0) {
+		freeQueue(queuePtr);
+		return(SYSCALL_ERROR);
+	}
+
+	return(SUCCESS);
+}
+
+void signalFd(int fd) {
+	uint64_t one = 1;
+
+	//It can only fail if the counter would overflow, in which case it is signalled anyway
+	if (write(fd, &one, sizeof(one)) < 0) {
+		return;
+	}
+}
+
+void clearFd(int fd) {
+	uint64_t count;
+
+	//Nothing to read (EAGAIN) means that it was not signalled
+	if (read(fd, &count, sizeof(count)) < 0) {
+		return;
+	}
+}
+
+int queuePush(spscQueueT *queuePtr, void *item) {
+	size_t tail = atomic_load(&queuePtr->tail);
+
+	if (tail - atomic_load(&queuePtr->head) > queuePtr->mask) {
+		return(0);
+	}
+	queuePtr->ring[tail & queuePtr->mask] = item;
+	atomic_store(&queuePtr->tail, tail + 1);
+
+	return(1);
+}
+
+void queueSignal(spscQueueT *queuePtr) {
+	signalFd(queuePtr->itemFd);
+}
+
+void *queuePop(spscQueueT *queuePtr) {
+	size_t head = atomic_load(&queuePtr->head);
+	void *item;
+
+	if (head == atomic_load(&queuePtr->tail)) {
+		return(NULL);
+	}
+	item = queuePtr->ring[head & queuePtr->mask];
+	atomic_store(&queuePtr->head, head + 1);
+
+	//The tail is read again after the item is out, if the queue was full, the producer may be waiting
+	if (atomic_load(&queuePtr->tail) - head > queuePtr->mask) {
+		signalFd(queuePtr->spaceFd);
+	}
+
+	return(item);
+}
+
+int waitFd(int fd) {
+	struct pollfd pollfd = {fd, POLLIN, 0};
+
+	while (poll(&pollfd, 1, -1) < 0) {
+		if (errno != EINTR) {
+			return(SYSCALL_ERROR);
+		}
+	}
+	clearFd(fd);
+
+	return(SUCCESS);
+}
+
+int queueWaitItem(spscQueueT *queuePtr) {
+	if (atomic_load(&queuePtr->head) != atomic_load(&queuePtr->tail)) {
+		return(SUCCESS);
+	}
+
+	return(waitFd(queuePtr->itemFd));
+}
+
+int queueWaitSpace(spscQueueT *queuePtr) {
+	if (atomic_load(&queuePtr->tail) - atomic_load(&queuePtr->head) <= queuePtr->mask) {
+		return(SUCCESS);
+	}
+
+	return(waitFd(queuePtr->spaceFd));
+}
+
+int queueItemFd(spscQueueT *queuePtr) {
+	return(queuePtr->itemFd);
+}
+
+void queueClearItemFd(spscQueueT *queuePtr) {
+	clearFd(queuePtr->itemFd);
+}
+
+void freeQueue(spscQueueT *queuePtr) {
+	free(queuePtr->ring);
+	queuePtr->ring = NULL;
+	if (queuePtr->itemFd >= 0) {
+		close(queuePtr->itemFd);
+	}
+	if (queuePtr->spaceFd >= 0) {
+		close(queuePtr->spaceFd);
+	}
+	queuePtr->itemFd = queuePtr->spaceFd = -1;
+}
@@ -0,0 +1,438 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include "parsing.h"
+#include "addresses.h"
+#include "cache.h"
+#include "error.h"
+#include "utils.h"
+#include "untagged.h"
+#include "search.h"
+
+#define INIT_TABLE_SIZE 1024 //Must be a power of two
+#define POSTINGS_BATCH 16 //Used to decrease the number of allocations of posting lists
+#define MAX_WORD 64 //Longer words are cut, as they are most likely encoded data, not words
+#define MIN_WORD 2 //Shorter words are not indexed, as they appear in almost every message
+#define MAX_QUERY_WORDS 16
+
+/* Words are runs of ASCII letters and digits, or of non-ASCII bytes (so that
+  UTF-8 words are kept whole), ASCII letters are converted to lowercase, so that
+  searches are case-insensitive. Returns the length of the word found, or 0 if
+  the string is over */
+int nextWord(char *str, size_t *posPtr, char word[MAX_WORD+1]) {
+	size_t pos = *posPtr;
+	unsigned char c;
+	int len;
+
+	do {
+		//Skip the characters between words
+		for ( ; str[pos] != '\0' ; pos++) {
+			c = str[pos];
+			if (isalnum(c) || c >= 128) {
+				break;
+			}
+		}
+		if (str[pos] == '\0') {
+			*posPtr = pos;
+			return(0);
+		}
+
+		//Copy the word
+		for (len = 0 ; str[pos] != '\0' ; pos++) {
+			c = str[pos];
+			if (!isalnum(c) && c < 128) {
+				break;
+			}
+			if (len < MAX_WORD) {
+				word[len++] = tolower(c);
+			}
+		}
+		word[len] = '\0';
+	} while (len < MIN_WORD);
+
+	*posPtr = pos;
+
+	return(len);
+}
+
+searchIndexT *searchIndexInit(void) {
+	searchIndexT *indexPtr;
+
+	indexPtr = malloc(sizeof(searchIndexT));
+	if (!indexPtr) {
+		return(NULL);
+	}
+
+	//calloc() marks all slots as empty (word == NULL)
+	indexPtr->termTable = calloc(INIT_TABLE_SIZE, sizeof(struct term));
+	if (!indexPtr->termTable) {
+		free(indexPtr);
+		return(NULL);
+	}
+	indexPtr->tableSize = INIT_TABLE_SIZE;
+	indexPtr->terms = 0;
+
+	return(indexPtr);
+}
+
+//Returns the slot of a word in the table, which is the empty slot the word should go to, if not there
+struct term *findTerm(struct term *termTable, size_t tableSize, char *word) {
+	size_t slot = hashString(word) & (tableSize-1);
+
+	while (termTable[slot].word != NULL && strcmp(termTable[slot].word, word)) {
+		slot = (slot+1) & (tableSize-1);
+	}
+
+	return(&termTable[slot]);
+}
+
+//Double the size of the hash table, moving all terms to their new slots
+int growTable(searchIndexT *indexPtr) {
+	struct term *newTable, *oldTable = indexPtr->termTable;
+	size_t newSize = indexPtr->tableSize*2;
+
+	newTable = calloc(newSize, sizeof(struct term));
+	if (!newTable) {
+		return(MEM_ERROR);
+	}
+
+	for (size_t k = 0 ; k < indexPtr->tableSize ; k++) {
+		if (oldTable[k].word != NULL) {
+			*findTerm(newTable, newSize, oldTable[k].word) = oldTable[k];
+		}
+	}
+
+	free(oldTable);
+	indexPtr->termTable = newTable;
+	indexPtr->tableSize = newSize;
+
+	return(SUCCESS);
+}
+
+//Add a UID to the posting list of a term
+int addPosting(struct term *termPtr, unsigned long uid) {
+	unsigned long delta, *temp;
+	unsigned char *tempBytes;
+	size_t len;
+
+	if (uid == termPtr->lastUid) { //The word appeared in the same message again
+		return(SUCCESS);
+	}
+	else if (uid < termPtr->lastUid) {
+		//A word repeated in a text is added once (the UIDs of a text are added one after the other)
+		len = termPtr->unorderedLen;
+		if (len > 0 && termPtr->unordered[len-1] == uid) {
+			return(SUCCESS);
+		}
+		//Resize when the length is a power of two (so the size doubles)
+		if ((len & (len-1)) == 0) {
+			temp = realloc(termPtr->unordered, (len ? len*2 : 1)*sizeof(unsigned long));
+			if (!temp) {
+				return(MEM_ERROR);
+			}
+			termPtr->unordered = temp;
+		}
+		termPtr->unordered[termPtr->unorderedLen++] = uid;
+		termPtr->unorderedSorted = 0;
+		return(SUCCESS);
+	}
+
+	//A 64 bit delta takes at most 10 bytes
+	if (termPtr->postingsLen + 10 > termPtr->postingsCap) {
+		tempBytes = realloc(termPtr->postings, termPtr->postingsCap + POSTINGS_BATCH + 10);
+		if (!tempBytes) {
+			return(MEM_ERROR);
+		}
+		termPtr->postings = tempBytes;
+		termPtr->postingsCap += POSTINGS_BATCH + 10;
+	}
+
+	//Store the difference from the last UID, 7 bits at a time
+	delta = uid - termPtr->lastUid;
+	while (delta >= 128) {
+		termPtr->postings[termPtr->postingsLen++] = (delta & 127) | 128;
+		delta >>= 7;
+	}
+	termPtr->postings[termPtr->postingsLen++] = delta;
+	termPtr->lastUid = uid;
+
+	return(SUCCESS);
+}
+
+int addWord(searchIndexT *indexPtr, char *word, unsigned long uid) {
+	struct term *termPtr;
+	int retVal;
+
+	//Keep the table at most half full, so that probing stays short
+	if ((indexPtr->terms+1)*2 > indexPtr->tableSize) {
+		retVal = growTable(indexPtr);
+		if (isError(retVal)) {
+			return(retVal);
+		}
+	}
+
+	termPtr = findTerm(indexPtr->termTable, indexPtr->tableSize, word);
+	if (!termPtr->word) { //A new term
+		termPtr->word = strdup(word);
+		if (!termPtr->word) {
+			return(MEM_ERROR);
+		}
+		indexPtr->terms++;
+	}
+
+	return(addPosting(termPtr, uid));
+}
+
+//Add all the words of a string to the index
+int indexString(searchIndexT *indexPtr, char *str, unsigned long uid) {
+	char word[MAX_WORD+1];
+	size_t pos = 0;
+	int retVal;
+
+	if (!str) {
+		return(SUCCESS);
+	}
+
+	while (nextWord(str, &pos, word) > 0) {
+		retVal = addWord(indexPtr, word, uid);
+		if (isError(retVal)) {
+			return(retVal);
+		}
+	}
+
+	return(SUCCESS);
+}
+
+int indexAddressList(searchIndexT *indexPtr, addressListT *listPtr, unsigned long uid) {
+	int retVal;
+
+	for (int k = 0 ; k < listPtr->count ; k++) {
+		if (isError(retVal = indexString(indexPtr, listPtr->addrs[k].personalName, uid))) {
+			return(retVal);
+		}
+		if (isError(retVal = indexString(indexPtr, listPtr->addrs[k].mailboxName, uid))) {
+			return(retVal);
+		}
+		if (isError(retVal = indexString(indexPtr, listPtr->addrs[k].hostName, uid))) {
+			return(retVal);
+		}
+	}
+
+	return(SUCCESS);
+}
+
+int indexEnvelope(searchIndexT *indexPtr, msgT *msgPtr) {
+	int retVal;
+
+	if (msgPtr->uid == 0) { //Without a UID, the message can't be found later on
+		return(SUCCESS);
+	}
+
+	if (isError(retVal = indexString(indexPtr, msgPtr->envelope.subject, msgPtr->uid))) {
+		return(retVal);
+	}
+	if (isError(retVal = indexAddressList(indexPtr, &msgPtr->envelope.fromList, msgPtr->uid))) {
+		return(retVal);
+	}
+	if (isError(retVal = indexAddressList(indexPtr, &msgPtr->envelope.toList, msgPtr->uid))) {
+		return(retVal);
+	}
+
+	return(indexAddressList(indexPtr, &msgPtr->envelope.ccList, msgPtr->uid));
+}
+
+int indexEnvelopes(msgCacheT *cachePtr, size_t batch) {
+	msgT *msgPtr;
+	size_t indexed = 0;
+	int retVal;
+
+	//In cache order, so that the UIDs are added in ascending order, and their postings stay compressed
+	for (size_t k = 0 ; k < cachePtr->cacheSize && indexed < batch ; k++) {
+		msgPtr = cachePtr->msgPtrArray[k];
+		if (!msgPtr || msgPtr->uid == 0 || msgPtr->indexed) {
+			continue;
+		}
+
+		if (isError(retVal = decodeEnvelope(&msgPtr->envelope))) {
+			return(retVal);
+		}
+		cacheAccount(cachePtr, msgPtr);
+		if (isError(retVal = indexEnvelope(cachePtr->searchIndex, msgPtr))) {
+			return(retVal);
+		}
+		msgPtr->indexed = 1;
+		indexed++;
+	}
+
+	return(indexed);
+}
+
+int indexText(searchIndexT *indexPtr, msgT *msgPtr) {
+	if (msgPtr->uid == 0) {
+		return(SUCCESS);
+	}
+
+	return(indexString(indexPtr, msgPtr->text, msgPtr->uid));
+}
+
+int compareUids(const void *uid1Ptr, const void *uid2Ptr) {
+	unsigned long uid1 = *(unsigned long*)uid1Ptr, uid2 = *(unsigned long*)uid2Ptr;
+
+	return((uid1 > uid2) - (uid1 < uid2));
+}
+
+/* Sort the UIDs of a term that were added out of order, and drop the duplicates (the same old message
+  can have its text fetched again), once after they change, and not on every query */
+void sortUnordered(struct term *termPtr) {
+	size_t len = 0;
+
+	if (termPtr->unorderedSorted) {
+		return;
+	}
+
+	qsort(termPtr->unordered, termPtr->unorderedLen, sizeof(unsigned long), compareUids);
+	for (size_t k = 0 ; k < termPtr->unorderedLen ; k++) {
+		if (len == 0 || termPtr->unordered[len-1] != termPtr->unordered[k]) {
+			termPtr->unordered[len++] = termPtr->unordered[k];
+		}
+	}
+	//The array is not shrunk, as it is resized whenever the length reaches a power of two (check addPosting())
+	termPtr->unorderedLen = len;
+	termPtr->unorderedSorted = 1;
+}
+
+/* Decompress the posting list of a term, and merge in the UIDs added out of order,
+  producing an ascending array of UIDs without duplicates */
+int decodePostings(struct term *termPtr, unsigned long **uidsPtr, size_t *countPtr) {
+	unsigned long *uids, uid = 0, delta;
+	size_t count = 0, pos = 0, unorderedPos = 0;
+	int shift;
+
+	//Each UID takes at least one byte, so there can't be more UIDs than bytes
+	uids = malloc((termPtr->postingsLen + termPtr->unorderedLen + 1)*sizeof(unsigned long));
+	if (!uids) {
+		return(MEM_ERROR);
+	}
+
+	sortUnordered(termPtr);
+
+	while (pos < termPtr->postingsLen) {
+		delta = 0;
+		shift = 0;
+		do {
+			delta |= (unsigned long)(termPtr->postings[pos] & 127) << shift;
+			shift += 7;
+		} while (termPtr->postings[pos++] & 128);
+		uid += delta;
+
+		//Merge the unordered UIDs that come before this one
+		while (unorderedPos < termPtr->unorderedLen && termPtr->unordered[unorderedPos] <= uid) {
+			if (termPtr->unordered[unorderedPos] != uid && (count == 0 || uids[count-1] != termPtr->unordered[unorderedPos])) {
+				uids[count++] = termPtr->unordered[unorderedPos];
+			}
+			unorderedPos++;
+		}
+		uids[count++] = uid;
+	}
+
+	*uidsPtr = uids;
+	*countPtr = count;
+
+	return(SUCCESS);
+}
+
+//Keep the UIDs of the first array that are also in the second one (both are ascending)
+size_t intersectUids(unsigned long *uids1, size_t count1, unsigned long *uids2, size_t count2) {
+	size_t pos1 = 0, pos2 = 0, count = 0;
+
+	while (pos1 < count1 && pos2 < count2) {
+		if (uids1[pos1] < uids2[pos2]) {
+			pos1++;
+		}
+		else if (uids1[pos1] > uids2[pos2]) {
+			pos2++;
+		}
+		else {
+			uids1[count++] = uids1[pos1];
+			pos1++;
+			pos2++;
+		}
+	}
+
+	return(count);
+}
+
+int searchIndexQuery(searchIndexT *indexPtr, char *query, unsigned long **uidsPtr, size_t *countPtr) {
+	struct term *queryTerms[MAX_QUERY_WORDS], *termPtr;
+	char word[MAX_WORD+1];
+	unsigned long *result, *uids;
+	size_t resultCount, count, pos = 0;
+	int termCount = 0, retVal;
+
+	*uidsPtr = NULL;
+	*countPtr = 0;
+
+	//Look up every word of the query, if one is missing, no message contains all of them
+	while (termCount < MAX_QUERY_WORDS && nextWord(query, &pos, word) > 0) {
+		termPtr = findTerm(indexPtr->termTable, indexPtr->tableSize, word);
+		if (!termPtr->word) {
+			return(SUCCESS);
+		}
+		queryTerms[termCount++] = termPtr;
+	}
+	if (termCount == 0) {
+		return(SUCCESS);
+	}
+
+	//Start from the shortest posting list, so that the result only gets smaller
+	for (int k = 1 ; k < termCount ; k++) {
+		if (queryTerms[k]->postingsLen + queryTerms[k]->unorderedLen 
+		    < queryTerms[0]->postingsLen + queryTerms[0]->unorderedLen) {
+			termPtr = queryTerms[0];
+			queryTerms[0] = queryTerms[k];
+			queryTerms[k] = termPtr;
+		}
+	}
+
+	retVal = decodePostings(queryTerms[0], &result, &resultCount);
+	if (isError(retVal)) {
+		return(retVal);
+	}
+
+	for (int k = 1 ; k < termCount && resultCount > 0 ; k++) {
+		retVal = decodePostings(queryTerms[k], &uids, &count);
+		if (isError(retVal)) {
+			free(result);
+			return(retVal);
+		}
+		resultCount = intersectUids(result, resultCount, uids, count);
+		free(uids);
+	}
+
+	if (resultCount == 0) {
+		free(result);
+		return(SUCCESS);
+	}
+
+	*uidsPtr = result;
+	*countPtr = resultCount;
+
+	return(SUCCESS);
+}
+
+void freeSearchIndex(searchIndexT *indexPtr) {
+	if (!indexPtr) {
+		return;
+	}
+
+	for (size_t k = 0 ; k < indexPtr->tableSize ; k++) {
+		if (indexPtr->termTable[k].word != NULL) {
+			free(indexPtr->termTable[k].word);
+			free(indexPtr->termTable[k].postings);
+			free(indexPtr->termTable[k].unordered);
+		}
+	}
+	free(indexPtr->termTable);
+	free(indexPtr);
+}
@@ -0,0 +1,266 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include "parsing.h"
+#include "addresses.h"
+#include "cache.h"
+#include "error.h"
+#include "utils.h"
+#include "bitmap.h"
+#include "intern.h"
+#include "senders.h"
+
+#define SENDERS_MIN_SIZE 64 //The initial size of the hash table, a power of two
+
+//The key of the sender being looked up, kept between calls to avoid allocating it every time
+char *keyBuf = NULL;
+size_t keyCap = 0;
+
+//qsort() takes no context arguement, so the order senders are ranked in is kept here
+int rankedBy;
+
+senderIndexT *senderIndexInit(void) {
+	senderIndexT *indexPtr;
+
+	indexPtr = calloc(1, sizeof(senderIndexT));
+	if (!indexPtr) {
+		return(NULL);
+	}
+
+	return(indexPtr);
+}
+
+//Build the key of an address (mailbox-name@host-name in lowercase) into keyBuf
+int senderKey(char *mailboxName, char *hostName) {
+	size_t len = strlen(mailboxName) + (hostName ? strlen(hostName)+1 : 0) + 1;
+	char *temp;
+
+	if (len > keyCap) {
+		temp = realloc(keyBuf, len);
+		if (!temp) {
+			return(MEM_ERROR);
+		}
+		keyBuf = temp;
+		keyCap = len;
+	}
+	if (hostName != NULL) {
+		sprintf(keyBuf, "%s@%s", mailboxName, hostName);
+	}
+	else {
+		strcpy(keyBuf, mailboxName);
+	}
+	for (char *curr = keyBuf ; *curr != '\0' ; curr++) {
+		*curr = tolower((unsigned char)*curr);
+	}
+
+	return(SUCCESS);
+}
+
+//The slot of the table where the key is, or the empty one where it would go
+size_t findSenderSlot(senderIndexT *indexPtr, char *key) {
+	size_t slot;
+
+	for (slot = hashString(key) & (indexPtr->tableSize-1) ; indexPtr->table[slot] != NULL ; slot = (slot+1) & (indexPtr->tableSize-1)) {
+		if (!strcmp(indexPtr->table[slot]->address, key)) {
+			break;
+		}
+	}
+
+	return(slot);
+}
+
+int growSenderTable(senderIndexT *indexPtr) {
+	size_t newSize = indexPtr->tableSize ? indexPtr->tableSize * 2 : SENDERS_MIN_SIZE, slot;
+	senderT **newTable;
+
+	newTable = calloc(newSize, sizeof(senderT *));
+	if (!newTable) {
+		return(MEM_ERROR);
+	}
+	for (size_t k = 0 ; k < indexPtr->tableSize ; k++) {
+		if (indexPtr->table[k] != NULL) {
+			for (slot = hashString(indexPtr->table[k]->address) & (newSize-1) ; newTable[slot] != NULL ; slot = (slot+1) & (newSize-1));
+			newTable[slot] = indexPtr->table[k];
+		}
+	}
+	free(indexPtr->table);
+	indexPtr->table = newTable;
+	indexPtr->tableSize = newSize;
+
+	return(SUCCESS);
+}
+
+int senderAdd(senderIndexT *indexPtr, msgT *msgPtr) {
+	addressT *fromPtr;
+	senderT *senderPtr;
+	size_t slot;
+	int retVal;
+
+	if (msgPtr->sender != NULL || msgPtr->uid == 0 || msgPtr->envelope.fromList.count == 0) {
+		return(SUCCESS);
+	}
+	fromPtr = &msgPtr->envelope.fromList.addrs[0];
+	if (!fromPtr->mailboxName) { //e.g. the start of a group, which has no address
+		return(SUCCESS);
+	}
+
+	if (isError(retVal = senderKey(fromPtr->mailboxName, fromPtr->hostName))) {
+		return(retVal);
+	}
+	//The table is kept at most half full
+	if (2 * (indexPtr->senders+1) > indexPtr->tableSize && isError(growSenderTable(indexPtr))) {
+		return(MEM_ERROR);
+	}
+
+	slot = findSenderSlot(indexPtr, keyBuf);
+	senderPtr = indexPtr->table[slot];
+	if (!senderPtr) {
+		senderPtr = calloc(1, sizeof(senderT));
+		if (!senderPtr) {
+			return(MEM_ERROR);
+		}
+		senderPtr->address = strdup(keyBuf);
+		if (!senderPtr->address) {
+			free(senderPtr);
+			return(MEM_ERROR);
+		}
+		bitmapInit(&senderPtr->uids);
+		indexPtr->table[slot] = senderPtr;
+		indexPtr->senders++;
+	}
+
+	if (isError(retVal = bitmapAdd(&senderPtr->uids, msgPtr->uid))) {
+		return(retVal);
+	}
+	//The name shown is the last one used, interned strings are equal only if their pointers are
+	if (fromPtr->personalName != NULL && fromPtr->personalName != senderPtr->name) {
+		releaseString(senderPtr->name);
+		internString(fromPtr->personalName, &senderPtr->name); //Can't fail, the string is interned already
+	}
+	senderPtr->msgs++;
+	senderPtr->size += msgPtr->size;
+	if (!(msgPtr->flags & SEEN)) {
+		senderPtr->unseen++;
+	}
+	msgPtr->sender = senderPtr;
+
+	return(SUCCESS);
+}
+
+void senderRemove(msgT *msgPtr) {
+	senderT *senderPtr = msgPtr->sender;
+
+	if (!senderPtr) {
+		return;
+	}
+
+	bitmapRemove(&senderPtr->uids, msgPtr->uid);
+	senderPtr->msgs--;
+	senderPtr->size -= msgPtr->size;
+	if (!(msgPtr->flags & SEEN)) {
+		senderPtr->unseen--;
+	}
+	msgPtr->sender = NULL;
+}
+
+senderT *senderFind(senderIndexT *indexPtr, char *address) {
+	char *at;
+	int retVal;
+
+	if (indexPtr->senders == 0) {
+		return(NULL);
+	}
+
+	//The key is built the same way as for the messages
+	at = strchr(address, '@');
+	if (at != NULL) {
+		*at = '\0';
+		retVal = senderKey(address, at+1);
+		*at = '@';
+	}
+	else {
+		retVal = senderKey(address, NULL);
+	}
+	if (isError(retVal)) {
+		return(NULL);
+	}
+
+	return(indexPtr->table[findSenderSlot(indexPtr, keyBuf)]);
+}
+
+int compareSenders(const void *sender1, const void *sender2) {
+	senderT *senderPtr1 = *(senderT **)sender1, *senderPtr2 = *(senderT **)sender2;
+	unsigned long long value1, value2;
+
+	if (rankedBy == SENDERS_BY_SIZE) {
+		value1 = senderPtr1->size;
+		value2 = senderPtr2->size;
+	}
+	else if (rankedBy == SENDERS_BY_UNSEEN) {
+		value1 = senderPtr1->unseen;
+		value2 = senderPtr2->unseen;
+	}
+	else {
+		value1 = senderPtr1->msgs;
+		value2 = senderPtr2->msgs;
+	}
+
+	//Descending, ties are broken by the address, so that the order is stable
+	if (value1 != value2) {
+		return(value1 < value2 ? 1 : -1);
+	}
+
+	return(strcmp(senderPtr1->address, senderPtr2->address));
+}
+
+int rankSenders(senderIndexT *indexPtr, int rankBy, senderT ***sendersPtr, size_t *countPtr) {
+	senderT **senders;
+	size_t count = 0;
+
+	*sendersPtr = NULL;
+	*countPtr = 0;
+	if (indexPtr->senders == 0) {
+		return(SUCCESS);
+	}
+
+	senders = malloc(indexPtr->senders * sizeof(senderT *));
+	if (!senders) {
+		return(MEM_ERROR);
+	}
+	//Senders whose messages were all expunged are left out
+	for (size_t k = 0 ; k < indexPtr->tableSize ; k++) {
+		if (indexPtr->table[k] != NULL && indexPtr->table[k]->msgs > 0) {
+			senders[count++] = indexPtr->table[k];
+		}
+	}
+	if (count == 0) {
+		free(senders);
+		return(SUCCESS);
+	}
+
+	rankedBy = rankBy;
+	qsort(senders, count, sizeof(senderT *), compareSenders);
+
+	*sendersPtr = senders;
+	*countPtr = count;
+
+	return(SUCCESS);
+}
+
+void freeSenderIndex(senderIndexT *indexPtr) {
+	if (!indexPtr) {
+		return;
+	}
+
+	for (size_t k = 0 ; k < indexPtr->tableSize ; k++) {
+		if (indexPtr->table[k] != NULL) {
+			free(indexPtr->table[k]->address);
+			releaseString(indexPtr->table[k]->name);
+			freeBitmap(&indexPtr->table[k]->uids);
+			free(indexPtr->table[k]);
+		}
+	}
+	free(indexPtr->table);
+	free(indexPtr);
+}
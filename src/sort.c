@@ -0,0 +1,358 @@
+#define _GNU_SOURCE //For qsort_r()
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include "parsing.h"
+#include "addresses.h"
+#include "cache.h"
+#include "error.h"
+#include "untagged.h"
+#include "sort.h"
+
+#define VIEW_BATCH 1024 //Used to decrease the number of allocations when views grow
+
+//What the comparator of qsort_r() is given, to compare two positions of a view
+typedef struct sortContext {
+	msgCacheT *cachePtr;
+	int sortKey;
+} sortContextT;
+
+//The name shown for a sender (check senderName() in addresses.h), "" if there is none
+char *sortSenderName(msgT *msgPtr) {
+	char *name = senderName(&msgPtr->envelope.fromList);
+
+	return(name ? name : "");
+}
+
+//Compare the messages at two cache positions by a key, ties are broken by the positions
+int comparePositions(msgCacheT *cachePtr, int sortKey, size_t pos1, size_t pos2) {
+	msgT *msg1 = cachePtr->msgPtrArray[pos1], *msg2 = cachePtr->msgPtrArray[pos2];
+	int result = 0;
+
+	switch(sortKey) {
+		case SORT_DATE:
+			result = (msg1->internalDate > msg2->internalDate) - (msg1->internalDate < msg2->internalDate);
+			break;
+		case SORT_SIZE:
+			result = (msg1->size > msg2->size) - (msg1->size < msg2->size);
+			break;
+		case SORT_FROM:
+			result = strcasecmp(sortSenderName(msg1), sortSenderName(msg2));
+			break;
+		case SORT_SUBJECT:
+			result = strcasecmp(msg1->envelope.subject ? msg1->envelope.subject : "",
+			                    msg2->envelope.subject ? msg2->envelope.subject : "");
+			break;
+	}
+	if (result != 0) {
+		return(result);
+	}
+
+	return((pos1 > pos2) - (pos1 < pos2));
+}
+
+int qsortCompare(const void *pos1Ptr, const void *pos2Ptr, void *contextPtr) {
+	sortContextT *context = contextPtr;
+
+	return(comparePositions(context->cachePtr, context->sortKey, *(size_t*)pos1Ptr, *(size_t*)pos2Ptr));
+}
+
+//The number of noted expunges below a position of the views (the list is ascending)
+size_t expungedBelow(msgCacheT *cachePtr, size_t pos) {
+	size_t low = 0, high = cachePtr->viewExpungedLen, mid;
+
+	while (low < high) {
+		mid = low + (high - low) / 2;
+		if (cachePtr->viewExpunged[mid] < pos) {
+			low = mid + 1;
+		}
+		else {
+			high = mid;
+		}
+	}
+
+	return(low);
+}
+
+/* Renumber the views after the noted expunges, in one pass over each view: the expunged positions are
+  dropped, and the rest are shifted down by the number of expunged positions below them (which keeps the
+  order of the view, as the positions keep their relative order). The views are used through this */
+void viewSync(msgCacheT *cachePtr) {
+	sortViewT *view;
+	size_t below, len;
+
+	if (cachePtr->viewExpungedLen == 0) {
+		return;
+	}
+
+	for (int key = 0 ; key < SORT_KEYS ; key++) {
+		view = cachePtr->views[key];
+		if (!view) {
+			continue;
+		}
+		len = 0;
+		for (size_t k = 0 ; k < view->len ; k++) {
+			below = expungedBelow(cachePtr, view->posArray[k]);
+			if (below < cachePtr->viewExpungedLen && cachePtr->viewExpunged[below] == view->posArray[k]) {
+				continue; //Expunged
+			}
+			view->posArray[len++] = view->posArray[k] - below;
+		}
+		view->len = len;
+	}
+	cachePtr->viewExpungedLen = 0;
+}
+
+/* The sender and the subject are compared decoded, so the envelopes of the messages in their
+  views are decoded before they enter them (check decodeEnvelope() in untagged.h) */
+int decodeSortKey(msgT *msgPtr, int sortKey) {
+	if (sortKey == SORT_FROM || sortKey == SORT_SUBJECT) {
+		return(decodeEnvelope(&msgPtr->envelope));
+	}
+
+	return(SUCCESS);
+}
+
+//Build a view from scratch, by sorting the positions of all messages that have been fetched
+int viewBuild(msgCacheT *cachePtr, int sortKey) {
+	sortContextT context;
+	sortViewT *view;
+	size_t len = 0;
+	int retVal;
+
+	viewSync(cachePtr); //The new view is built in the current numbering, so the others have to be in it too
+
+	view = malloc(sizeof(sortViewT));
+	if (!view) {
+		return(MEM_ERROR);
+	}
+
+	//Make space for the whole cache at once, as most messages will have been fetched
+	view->cap = cachePtr->cacheSize + VIEW_BATCH;
+	view->posArray = malloc(view->cap*sizeof(size_t));
+	if (!view->posArray) {
+		free(view);
+		return(MEM_ERROR);
+	}
+
+	for (size_t k = 0 ; k < cachePtr->cacheSize ; k++) {
+		if (cachePtr->msgPtrArray[k] != NULL && cachePtr->msgPtrArray[k]->inViews) {
+			if (isError(retVal = decodeSortKey(cachePtr->msgPtrArray[k], sortKey))) {
+				free(view->posArray);
+				free(view);
+				return(retVal);
+			}
+			cacheAccount(cachePtr, cachePtr->msgPtrArray[k]);
+			view->posArray[len++] = k;
+		}
+	}
+	view->len = len;
+
+	context.cachePtr = cachePtr;
+	context.sortKey = sortKey;
+	qsort_r(view->posArray, len, sizeof(size_t), qsortCompare, &context);
+
+	cachePtr->views[sortKey] = view;
+
+	return(SUCCESS);
+}
+
+/* Binary search for the index of the first position in a view, that does not compare lower than pos,
+  which is where pos is (if it is in the view), or where it should be inserted */
+size_t viewSearch(msgCacheT *cachePtr, int sortKey, size_t pos) {
+	sortViewT *view = cachePtr->views[sortKey];
+	size_t low = 0, high = view->len, mid;
+
+	while (low < high) {
+		mid = low + (high - low) / 2;
+		if (comparePositions(cachePtr, sortKey, view->posArray[mid], pos) < 0) {
+			low = mid + 1;
+		}
+		else {
+			high = mid;
+		}
+	}
+
+	return(low);
+}
+
+int viewInsert(msgCacheT *cachePtr, size_t pos) {
+	sortViewT *view;
+	size_t index, *temp;
+	int retVal;
+
+	if (cachePtr->msgPtrArray[pos]->inViews) { //Already inserted
+		return(SUCCESS);
+	}
+	viewSync(cachePtr);
+
+	/* Everything that can fail is done for every view first, so that a failure leaves the message
+	  out of all of them (it is inserted when its data is fetched again), and not in some of them,
+	  which would have it inserted twice then */
+	for (int key = 0 ; key < SORT_KEYS ; key++) {
+		view = cachePtr->views[key];
+		if (!view) { //Not built, so it will include the message when it is
+			continue;
+		}
+		if (isError(retVal = decodeSortKey(cachePtr->msgPtrArray[pos], key))) {
+			cacheAccount(cachePtr, cachePtr->msgPtrArray[pos]); //What was decoded before the failure stays
+			return(retVal);
+		}
+
+		if (view->len == view->cap) {
+			temp = realloc(view->posArray, (view->cap + VIEW_BATCH)*sizeof(size_t));
+			if (!temp) {
+				return(MEM_ERROR);
+			}
+			view->posArray = temp;
+			view->cap += VIEW_BATCH;
+		}
+	}
+	cacheAccount(cachePtr, cachePtr->msgPtrArray[pos]);
+
+	for (int key = 0 ; key < SORT_KEYS ; key++) {
+		view = cachePtr->views[key];
+		if (!view) {
+			continue;
+		}
+
+		//Find where the position belongs, and make space for it
+		index = viewSearch(cachePtr, key, pos);
+		memmove(view->posArray + index + 1, view->posArray + index, (view->len - index)*sizeof(size_t));
+		view->posArray[index] = pos;
+		view->len++;
+	}
+	cachePtr->msgPtrArray[pos]->inViews = 1;
+
+	return(SUCCESS);
+}
+
+void viewRemove(msgCacheT *cachePtr, size_t pos) {
+	sortViewT *view;
+	size_t index;
+
+	if (!cachePtr->msgPtrArray[pos] || !cachePtr->msgPtrArray[pos]->inViews) {
+		return;
+	}
+	viewSync(cachePtr);
+
+	for (int key = 0 ; key < SORT_KEYS ; key++) {
+		view = cachePtr->views[key];
+		if (!view) {
+			continue;
+		}
+
+		index = viewSearch(cachePtr, key, pos);
+		if (index < view->len && view->posArray[index] == pos) {
+			memmove(view->posArray + index, view->posArray + index + 1, (view->len - index - 1)*sizeof(size_t));
+			view->len--;
+		}
+	}
+	cachePtr->msgPtrArray[pos]->inViews = 0;
+}
+
+void viewExpunge(msgCacheT *cachePtr, size_t pos) {
+	size_t low = 0, high = cachePtr->viewExpungedLen, mid, *temp, *expunged;
+	int built = 0;
+
+	for (int key = 0 ; key < SORT_KEYS ; key++) {
+		built |= cachePtr->views[key] != NULL;
+	}
+	if (!built) {
+		return;
+	}
+
+	if (cachePtr->viewExpungedLen == cachePtr->viewExpungedCap) {
+		temp = realloc(cachePtr->viewExpunged, (cachePtr->viewExpungedCap + VIEW_BATCH)*sizeof(size_t));
+		if (temp != NULL) {
+			cachePtr->viewExpunged = temp;
+			cachePtr->viewExpungedCap += VIEW_BATCH;
+		}
+		else { //The noted expunges are applied, to make room for this one
+			viewSync(cachePtr);
+		}
+	}
+	if (cachePtr->viewExpungedCap == 0) { //Nothing could be allocated, so the views are renumbered right away
+		viewRemove(cachePtr, pos);
+		for (int key = 0 ; key < SORT_KEYS ; key++) {
+			for (size_t k = 0 ; cachePtr->views[key] && k < cachePtr->views[key]->len ; k++) {
+				if (cachePtr->views[key]->posArray[k] > pos) {
+					cachePtr->views[key]->posArray[k]--;
+				}
+			}
+		}
+		return;
+	}
+	expunged = cachePtr->viewExpunged;
+
+	/* The position is in the current numbering of the cache, and is noted in the numbering of the views:
+	  it is the pos-th position (from 0) the earlier expunges left, which is pos plus the number of expunged
+	  positions below it, the first index k for which expunged[k] - k > pos (found by binary search) */
+	while (low < high) {
+		mid = low + (high - low) / 2;
+		if (expunged[mid] - mid > pos) {
+			high = mid;
+		}
+		else {
+			low = mid + 1;
+		}
+	}
+	memmove(expunged + low + 1, expunged + low, (cachePtr->viewExpungedLen - low)*sizeof(size_t));
+	expunged[low] = pos + low;
+	cachePtr->viewExpungedLen++;
+}
+
+void freeViews(msgCacheT *cachePtr) {
+	for (int key = 0 ; key < SORT_KEYS ; key++) {
+		if (cachePtr->views[key] != NULL) {
+			free(cachePtr->views[key]->posArray);
+			free(cachePtr->views[key]);
+			cachePtr->views[key] = NULL;
+		}
+	}
+	free(cachePtr->viewExpunged);
+	cachePtr->viewExpunged = NULL;
+	cachePtr->viewExpungedLen = cachePtr->viewExpungedCap = 0;
+	cachePtr->sortKey = SORT_NONE;
+}
+
+int selectSortOrder(msgCacheT *cachePtr, int sortKey, int sortOrder) {
+	int retVal;
+
+	if (sortKey != SORT_NONE && !cachePtr->views[sortKey]) {
+		retVal = viewBuild(cachePtr, sortKey);
+		if (isError(retVal)) {
+			return(retVal);
+		}
+	}
+	cachePtr->sortKey = sortKey;
+	cachePtr->sortOrder = sortOrder;
+
+	return(SUCCESS);
+}
+
+size_t viewLength(msgCacheT *cachePtr) {
+	if (cachePtr->sortKey == SORT_NONE) {
+		return(cachePtr->cacheSize);
+	}
+	viewSync(cachePtr);
+
+	return(cachePtr->views[cachePtr->sortKey]->len);
+}
+
+size_t viewMsgPos(msgCacheT *cachePtr, size_t index) {
+	sortViewT *view;
+
+	if (cachePtr->sortKey == SORT_NONE) {
+		return(index);
+	}
+	viewSync(cachePtr);
+
+	view = cachePtr->views[cachePtr->sortKey];
+	if (cachePtr->sortOrder == DESCENDING) {
+		return(view->posArray[view->len - 1 - index]);
+	}
+
+	return(view->posArray[index]);
+}
@@ -0,0 +1,321 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include "error.h"
+#include "utils.h"
+#include "transport.h"
+#include "tls.h"
+
+#ifndef NO_TLS
+
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <openssl/pem.h>
+#include <openssl/x509v3.h>
+
+SSL_CTX *tlsContext = NULL; //Shared by all connections
+BIO_METHOD *transportBioMethod = NULL; //Check bioRead()
+
+//The file the sessions of a host are saved to (dynamically allocated), NULL if there is no home directory
+char *sessionPath(char *hostname, char *port) {
+	char *cacheDir = getenv("XDG_CACHE_HOME"), *home = getenv("HOME"), *path, *fileName;
+	size_t len;
+
+	if (!cacheDir || *cacheDir == '\0') {
+		cacheDir = NULL;
+		if (!home || *home == '\0') {
+			return(NULL);
+		}
+	}
+
+	len = strlen(cacheDir ? cacheDir : home) + strlen("/.cache/" TLS_SESSION_DIR "/") + strlen(hostname) + strlen(port) + strlen("_.session") + 1;
+	path = malloc(len);
+	if (!path) {
+		return(NULL);
+	}
+	if (!cacheDir) {
+		snprintf(path, len, "%s/.cache", home);
+		mkdir(path, 0700);
+		snprintf(path, len, "%s/.cache/" TLS_SESSION_DIR, home);
+	}
+	else {
+		mkdir(cacheDir, 0700);
+		snprintf(path, len, "%s/" TLS_SESSION_DIR, cacheDir);
+	}
+	mkdir(path, 0700); //The sessions hold the keys to resume them, so only the user may read them
+
+	fileName = path + strlen(path) + 1;
+	snprintf(path + strlen(path), len - strlen(path), "/%s_%s.session", hostname, port);
+	//The arguments could contain '/', which would point elsewhere
+	for (char *curr = fileName ; *curr != '\0' ; curr++) {
+		if (*curr == '/') {
+			*curr = '_';
+		}
+	}
+
+	return(path);
+}
+
+//Called by OpenSSL whenever the server issues a session (with TLS 1.3, after the handshake)
+int saveSession(SSL *ssl, SSL_SESSION *session) {
+	char *path = SSL_get_app_data(ssl);
+	FILE *sessionFile;
+	int fd;
+
+	if (!path || !SSL_SESSION_is_resumable(session)) {
+		return(0);
+	}
+
+	fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	if (fd < 0) {
+		return(0);
+	}
+	sessionFile = fdopen(fd, "w");
+	if (!sessionFile) {
+		close(fd);
+		return(0);
+	}
+	PEM_write_SSL_SESSION(sessionFile, session);
+	fclose(sessionFile);
+
+	return(0); //The session is not kept, so OpenSSL frees it
+}
+
+//Resume the last session with the server, if one was saved and it has not expired
+void loadSession(SSL *ssl, char *path) {
+	SSL_SESSION *session;
+	FILE *sessionFile;
+
+	sessionFile = fopen(path, "r");
+	if (!sessionFile) {
+		return;
+	}
+	session = PEM_read_SSL_SESSION(sessionFile, NULL, NULL, NULL);
+	fclose(sessionFile);
+	if (!session) {
+		return;
+	}
+
+	if (SSL_SESSION_get_time(session) + SSL_SESSION_get_timeout(session) > time(NULL)) {
+		SSL_set_session(ssl, session);
+	}
+	SSL_SESSION_free(session); //SSL_set_session() takes its own reference
+}
+
+/* The BIO the TLS records go through: it reads from, and writes to, the layer below (check transport.h),
+  instead of the socket, so the records are counted along with the rest of what goes through it */
+int bioRead(BIO *bio, char *buf, size_t size, size_t *readPtr) {
+	ssize_t len = transportRead(BIO_get_data(bio), buf, size);
+
+	BIO_clear_retry_flags(bio); //The socket blocks, so a read is never retried
+	if (len <= 0) {
+		return(0);
+	}
+	*readPtr = len;
+
+	return(1);
+}
+
+int bioWrite(BIO *bio, const char *buf, size_t size, size_t *writtenPtr) {
+	struct iovec iov = {(void *)buf, size};
+	ssize_t len = transportWritev(BIO_get_data(bio), &iov, 1);
+
+	BIO_clear_retry_flags(bio);
+	if (len < 0) {
+		return(0);
+	}
+	*writtenPtr = len;
+
+	return(1);
+}
+
+long bioCtrl(BIO *bio, int cmd, long num, void *ptr) {
+	return(cmd == BIO_CTRL_FLUSH); //Writes are not buffered, so there is nothing to flush
+}
+
+int bioCreate(BIO *bio) {
+	BIO_set_init(bio, 1);
+	return(1);
+}
+
+int initTlsContext(void) {
+	if (tlsContext != NULL) {
+		return(SUCCESS);
+	}
+
+	transportBioMethod = BIO_meth_new(BIO_get_new_index() | BIO_TYPE_SOURCE_SINK, "transport");
+	if (!transportBioMethod || !BIO_meth_set_read_ex(transportBioMethod, bioRead) || !BIO_meth_set_write_ex(transportBioMethod, bioWrite)
+	  || !BIO_meth_set_ctrl(transportBioMethod, bioCtrl) || !BIO_meth_set_create(transportBioMethod, bioCreate)) {
+		BIO_meth_free(transportBioMethod);
+		transportBioMethod = NULL;
+		return(TLS_ERROR);
+	}
+
+	tlsContext = SSL_CTX_new(TLS_client_method());
+	if (!tlsContext) {
+		return(TLS_ERROR);
+	}
+	SSL_CTX_set_min_proto_version(tlsContext, TLS1_2_VERSION);
+	SSL_CTX_set_verify(tlsContext, SSL_VERIFY_PEER, NULL);
+	if (!SSL_CTX_set_default_verify_paths(tlsContext)) { //Honours SSL_CERT_FILE and SSL_CERT_DIR
+		SSL_CTX_free(tlsContext);
+		tlsContext = NULL;
+		return(TLS_ERROR);
+	}
+
+	//The sessions are only kept in files, through saveSession()
+	SSL_CTX_set_session_cache_mode(tlsContext, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+	SSL_CTX_sess_set_new_cb(tlsContext, saveSession);
+
+	//Read as many records as the socket has at once, instead of a header and a body at a time
+	SSL_CTX_set_read_ahead(tlsContext, 1);
+	SSL_CTX_set_default_read_buffer_len(tlsContext, 4 * TLS_RECORD_SIZE);
+
+	return(SUCCESS);
+}
+
+//The functions of the TLS layer
+ssize_t tlsRead(transportT *layerPtr, char *buf, size_t size) {
+	int len = SSL_read(layerPtr->state, buf, size > INT32_MAX ? INT32_MAX : size);
+
+	if (len > 0) {
+		return(len);
+	}
+	//A close_notify, or the connection closing, is the end of the stream
+	return(SSL_get_error(layerPtr->state, len) == SSL_ERROR_ZERO_RETURN ? 0 : -1);
+}
+
+ssize_t tlsWritev(transportT *layerPtr, const struct iovec *iov, int iovCount) {
+	ssize_t total = 0;
+	size_t written;
+
+	//Every buffer is written as it is, the records are as large as it allows
+	for (int k = 0 ; k < iovCount ; k++) {
+		if (iov[k].iov_len > 0 && SSL_write_ex(layerPtr->state, iov[k].iov_base, iov[k].iov_len, &written) <= 0) {
+			return(-1);
+		}
+		total += iov[k].iov_len;
+	}
+
+	return(total);
+}
+
+void tlsClose(transportT *layerPtr) {
+	SSL *ssl = layerPtr->state;
+
+	SSL_shutdown(ssl); //Only sends the close_notify, the one of the server is not waited for
+	free(SSL_get_app_data(ssl));
+	SSL_free(ssl);
+}
+
+//Print why the handshake failed, the verification of the certificate is the likely reason
+void printTlsError(SSL *ssl) {
+	long verifyResult = SSL_get_verify_result(ssl);
+
+	if (verifyResult != X509_V_OK) {
+		fprintf(stderr, "TLS: certificate verification failed: %s\n", X509_verify_cert_error_string(verifyResult));
+	}
+	else {
+		fprintf(stderr, "TLS: handshake failed\n");
+		ERR_print_errors_fp(stderr);
+	}
+	ERR_clear_error();
+}
+
+int tlsOpen(FILE *imapStream, char *hostname, char *port, tlsStatsT *statsPtr) {
+	transportT *belowPtr = streamTransport(imapStream), *layerPtr;
+	struct timespec start;
+	char *path;
+	SSL *ssl;
+	BIO *bio;
+	int retVal;
+
+	if (!belowPtr) {
+		return(COMMAND_ERROR);
+	}
+	if (isError(initTlsContext())) {
+		return(TLS_ERROR);
+	}
+	ssl = SSL_new(tlsContext);
+	if (!ssl) {
+		return(MEM_ERROR);
+	}
+	bio = BIO_new(transportBioMethod);
+	if (!bio) {
+		SSL_free(ssl);
+		return(MEM_ERROR);
+	}
+	BIO_set_data(bio, belowPtr);
+	SSL_set_bio(ssl, bio, bio); //Freed along with ssl
+	if (!SSL_set_tlsext_host_name(ssl, hostname) || !SSL_set1_host(ssl, hostname)) {
+		SSL_free(ssl);
+		return(TLS_ERROR);
+	}
+
+	path = sessionPath(hostname, port);
+	if (path != NULL) {
+		loadSession(ssl, path);
+		SSL_set_app_data(ssl, path); //Where saveSession() writes, freed along with ssl, by tlsClose()
+	}
+
+	//Whatever was written to the stream is sent before the handshake
+	if (fflush(imapStream) == EOF) {
+		free(path);
+		SSL_free(ssl);
+		return(SOCKET_ERROR);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if (SSL_connect(ssl) != 1) {
+		printTlsError(ssl);
+		free(path);
+		SSL_free(ssl);
+		return(TLS_ERROR);
+	}
+
+	if (statsPtr != NULL) {
+		statsPtr->handshakeMs = elapsedMs(&start);
+		statsPtr->resumed = SSL_session_reused(ssl);
+		snprintf(statsPtr->version, sizeof(statsPtr->version), "%s", SSL_get_version(ssl));
+		snprintf(statsPtr->cipher, sizeof(statsPtr->cipher), "%s", SSL_get_cipher_name(ssl));
+	}
+
+	layerPtr = newTransport("tls", tlsRead, tlsWritev, tlsClose, ssl);
+	if (!layerPtr) {
+		free(path);
+		SSL_free(ssl);
+		return(MEM_ERROR);
+	}
+
+	retVal = pushTransport(imapStream, layerPtr, TRANSPORT_DROP_READ_AHEAD);
+	if (isError(retVal)) {
+		tlsClose(layerPtr);
+		free(layerPtr);
+	}
+
+	return(retVal);
+}
+
+void freeTlsContext(void) {
+	SSL_CTX_free(tlsContext);
+	tlsContext = NULL;
+	BIO_meth_free(transportBioMethod);
+	transportBioMethod = NULL;
+}
+
+#else
+
+int tlsOpen(FILE *imapStream, char *hostname, char *port, tlsStatsT *statsPtr) {
+	fprintf(stderr, "TLS: built without TLS support (NO_TLS)\n");
+	return(TLS_ERROR);
+}
+
+void freeTlsContext(void) {
+}
+
+#endif
@@ -0,0 +1,360 @@
+#define _GNU_SOURCE //For fopencookie()
+#include <stdio.h>
+#include <stdio_ext.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <sys/socket.h>
+#include "error.h"
+#include "transport.h"
+
+#define MAX_IOV 16 //The buffers a write of the socket layer takes at once
+
+//The cookie of a stream
+typedef struct transportStream {
+	FILE *stream;
+	transportT *top;
+	void (*readHook)(void *); //Check setTransportReadHook()
+	void *readHookArg;
+	off64_t position; //The bytes read and written through the stream, reported as its offset (check transportStreamSeek())
+	struct transportStream *next;
+} transportStreamT;
+
+transportStreamT *openStreams = NULL; //A client has a stream or two open, so a list will do
+
+transportStreamT *findTransportStream(FILE *imapStream) {
+	for (transportStreamT *streamPtr = openStreams ; streamPtr != NULL ; streamPtr = streamPtr->next) {
+		if (streamPtr->stream == imapStream) {
+			return(streamPtr);
+		}
+	}
+
+	return(NULL);
+}
+
+transportT *newTransport(char *name, ssize_t (*read)(transportT *, char *, size_t), ssize_t (*writev)(transportT *, const struct iovec *, int), void (*close)(transportT *), void *state) {
+	transportT *layerPtr = calloc(1, sizeof(transportT));
+
+	if (!layerPtr) {
+		return(NULL);
+	}
+	snprintf(layerPtr->name, TRANSPORT_NAME_SIZE, "%s", name);
+	layerPtr->read = read;
+	layerPtr->writev = writev;
+	layerPtr->close = close;
+	layerPtr->state = state;
+	layerPtr->fd = -1;
+
+	return(layerPtr);
+}
+
+//The socket layer
+ssize_t socketRead(transportT *layerPtr, char *buf, size_t size) {
+	ssize_t len;
+
+	do {
+		len = read(layerPtr->fd, buf, size);
+	} while (len < 0 && errno == EINTR);
+
+	return(len);
+}
+
+ssize_t socketWritev(transportT *layerPtr, const struct iovec *iov, int iovCount) {
+	struct iovec pending[MAX_IOV];
+	struct msghdr msg = {0};
+	ssize_t len, total = 0;
+	int count, k;
+
+	//sendmsg() can write part of the buffers, so what is left is written again
+	while (iovCount > 0) {
+		count = iovCount < MAX_IOV ? iovCount : MAX_IOV;
+		memcpy(pending, iov, count * sizeof(struct iovec));
+		for (k = 0 ; k < count ; ) {
+			//As writev(), but a connection the server closed is an error (EPIPE), instead of a SIGPIPE
+			msg.msg_iov = pending + k;
+			msg.msg_iovlen = count - k;
+			len = sendmsg(layerPtr->fd, &msg, MSG_NOSIGNAL);
+			if (len < 0 && errno == EINTR) {
+				continue;
+			}
+			else if (len < 0) {
+				return(-1);
+			}
+			total += len;
+			for ( ; k < count && (size_t)len >= pending[k].iov_len ; k++) {
+				len -= pending[k].iov_len;
+			}
+			if (k < count) {
+				pending[k].iov_base = (char *)pending[k].iov_base + len;
+				pending[k].iov_len -= len;
+			}
+		}
+		iov += count;
+		iovCount -= count;
+	}
+
+	return(total);
+}
+
+void socketClose(transportT *layerPtr) {
+	close(layerPtr->fd);
+}
+
+ssize_t transportRead(transportT *layerPtr, char *buf, size_t size) {
+	ssize_t len;
+
+	//What was read through the layer before is not counted again
+	if (layerPtr->readAhead != NULL) {
+		len = layerPtr->readAheadLen - layerPtr->readAheadPos;
+		len = (size_t)len < size ? len : (ssize_t)size;
+		memcpy(buf, layerPtr->readAhead + layerPtr->readAheadPos, len);
+		layerPtr->readAheadPos += len;
+		if (layerPtr->readAheadPos == layerPtr->readAheadLen) {
+			free(layerPtr->readAhead);
+			layerPtr->readAhead = NULL;
+		}
+		return(len);
+	}
+
+	len = layerPtr->read(layerPtr, buf, size);
+	layerPtr->reads++;
+	if (len > 0) {
+		layerPtr->bytesRead += len;
+	}
+
+	return(len);
+}
+
+ssize_t transportWritev(transportT *layerPtr, const struct iovec *iov, int iovCount) {
+	ssize_t len = layerPtr->writev(layerPtr, iov, iovCount);
+
+	layerPtr->writes++;
+	if (len > 0) {
+		layerPtr->bytesWritten += len;
+	}
+
+	return(len);
+}
+
+//The functions fopencookie() takes, they go through the top layer
+ssize_t transportStreamRead(void *cookie, char *buf, size_t size) {
+	transportStreamT *streamPtr = cookie;
+	ssize_t len;
+
+	if (streamPtr->readHook != NULL) {
+		streamPtr->readHook(streamPtr->readHookArg);
+	}
+
+	len = transportRead(streamPtr->top, buf, size);
+	if (len > 0) {
+		streamPtr->position += len;
+	}
+
+	return(len);
+}
+
+ssize_t transportStreamWrite(void *cookie, const char *buf, size_t size) {
+	transportStreamT *streamPtr = cookie;
+	struct iovec iov = {(void *)buf, size};
+	ssize_t len;
+
+	len = transportWritev(streamPtr->top, &iov, 1);
+	if (len > 0) {
+		streamPtr->position += len;
+	}
+
+	return(len);
+}
+
+/* A connection can't seek, but the stream reports its offset (the bytes read and written through it),
+  so that ftell() tells how much of what it read is still in its buffer (check pushTransport()). Any other
+  seek fails as it does on a pipe, which stdio ignores when it flushes a stream that has data to be read */
+int transportStreamSeek(void *cookie, off64_t *offsetPtr, int whence) {
+	if (*offsetPtr != 0 || whence != SEEK_CUR) {
+		errno = ESPIPE;
+		return(-1);
+	}
+	*offsetPtr = ((transportStreamT *)cookie)->position;
+
+	return(0);
+}
+
+//Close the layers of a stream, from the top down, so that a layer can still send what it has to (e.g. a close_notify)
+void closeLayers(transportStreamT *streamPtr) {
+	transportT *below;
+
+	for (transportT *layerPtr = streamPtr->top ; layerPtr != NULL ; layerPtr = below) {
+		below = layerPtr->below;
+		layerPtr->close(layerPtr);
+		free(layerPtr->readAhead);
+		free(layerPtr);
+	}
+	streamPtr->top = NULL;
+}
+
+int transportStreamClose(void *cookie) {
+	transportStreamT *streamPtr = cookie, **prevPtr;
+
+	closeLayers(streamPtr);
+
+	for (prevPtr = &openStreams ; *prevPtr != streamPtr ; prevPtr = &(*prevPtr)->next);
+	*prevPtr = streamPtr->next;
+	free(streamPtr);
+
+	return(0);
+}
+
+transportT *socketTransport(int sockFd) {
+	transportT *socketPtr = newTransport("tcp", socketRead, socketWritev, socketClose, NULL);
+
+	if (socketPtr != NULL) {
+		socketPtr->fd = sockFd;
+	}
+
+	return(socketPtr);
+}
+
+FILE *openTransportStream(int sockFd) {
+	cookie_io_functions_t streamFunctions = {transportStreamRead, transportStreamWrite, transportStreamSeek, transportStreamClose};
+	transportStreamT *streamPtr;
+	transportT *socketPtr;
+
+	streamPtr = malloc(sizeof(transportStreamT));
+	if (!streamPtr) {
+		return(NULL);
+	}
+	socketPtr = socketTransport(sockFd);
+	if (!socketPtr) {
+		free(streamPtr);
+		return(NULL);
+	}
+	streamPtr->top = socketPtr;
+	streamPtr->readHook = NULL;
+	streamPtr->position = 0;
+
+	streamPtr->stream = fopencookie(streamPtr, "r+b", streamFunctions);
+	if (!streamPtr->stream) {
+		free(socketPtr);
+		free(streamPtr);
+		return(NULL);
+	}
+	setvbuf(streamPtr->stream, NULL, _IOFBF, TRANSPORT_BUFFER_SIZE);
+	/* glibc locks a stream made with fopencookie() on every fgetc(), even in a single thread (which a stream
+	  made with fdopen() is spared), which made parsing several times slower. The stream is handed between
+	  threads (check background.h), but it is used by one at a time, and the atomics of the queues it is
+	  handed through order what one thread did to it before what the other does */
+	__fsetlocking(streamPtr->stream, FSETLOCKING_BYCALLER);
+	streamPtr->next = openStreams;
+	openStreams = streamPtr;
+
+	return(streamPtr->stream);
+}
+
+int pushTransport(FILE *imapStream, transportT *layerPtr, int readAhead) {
+	transportStreamT *streamPtr = findTransportStream(imapStream);
+	transportT *topPtr;
+	off_t consumed;
+	size_t len;
+
+	if (!streamPtr) {
+		return(COMMAND_ERROR);
+	}
+	topPtr = streamPtr->top;
+
+	//The seek back over what is left to be read fails, and is ignored (check transportStreamSeek())
+	if (fflush(imapStream) == EOF) {
+		return(SOCKET_ERROR);
+	}
+
+	/* What is left in the buffer of the stream is what the stream read, less what ftell() says was consumed,
+	  it is kept for the new layer, by handing it to the layer below it, to be read again. It is taken out of
+	  the buffer with fread(), which does not read from the layers, as it is all in the buffer */
+	consumed = ftello(imapStream);
+	if (consumed < 0) {
+		return(SYSCALL_ERROR);
+	}
+	len = streamPtr->position - consumed;
+	if (len > 0 && readAhead == TRANSPORT_KEEP_READ_AHEAD) {
+		topPtr->readAhead = malloc(len);
+		if (!topPtr->readAhead) {
+			return(MEM_ERROR);
+		}
+		if (fread(topPtr->readAhead, 1, len, imapStream) != len) {
+			free(topPtr->readAhead);
+			topPtr->readAhead = NULL;
+			return(SOCKET_ERROR);
+		}
+		topPtr->readAheadLen = len;
+		topPtr->readAheadPos = 0;
+	}
+	__fpurge(imapStream);
+
+	layerPtr->below = topPtr;
+	layerPtr->fd = topPtr->fd;
+	streamPtr->top = layerPtr;
+
+	return(SUCCESS);
+}
+
+int resetTransport(FILE *imapStream, int sockFd) {
+	transportStreamT *streamPtr = findTransportStream(imapStream);
+	transportT *socketPtr;
+
+	if (!streamPtr) {
+		return(COMMAND_ERROR);
+	}
+	socketPtr = socketTransport(sockFd);
+	if (!socketPtr) {
+		return(MEM_ERROR);
+	}
+
+	//What the stream holds belongs to the old connection, and so does the end of file, or the error
+	__fpurge(imapStream);
+	clearerr(imapStream);
+	closeLayers(streamPtr);
+	streamPtr->top = socketPtr;
+
+	return(SUCCESS);
+}
+
+int setTransportReadHook(FILE *imapStream, void (*hook)(void *), void *arg) {
+	transportStreamT *streamPtr = findTransportStream(imapStream);
+
+	if (!streamPtr) {
+		return(COMMAND_ERROR);
+	}
+	streamPtr->readHook = hook;
+	streamPtr->readHookArg = arg;
+
+	return(SUCCESS);
+}
+
+transportT *streamTransport(FILE *imapStream) {
+	transportStreamT *streamPtr = findTransportStream(imapStream);
+
+	return(streamPtr != NULL ? streamPtr->top : NULL);
+}
+
+int transportFd(FILE *imapStream) {
+	transportStreamT *streamPtr = findTransportStream(imapStream);
+
+	return(streamPtr != NULL ? streamPtr->top->fd : -1);
+}
+
+void printTransportStats(FILE *imapStream) {
+	transportStreamT *streamPtr = findTransportStream(imapStream);
+
+	if (!streamPtr) {
+		return;
+	}
+	printf("Connection layers (from the top):\n");
+	for (transportT *layerPtr = streamPtr->top ; layerPtr != NULL ; layerPtr = layerPtr->below) {
+		printf("  %-8s %zu bytes read in %zu reads, %zu bytes written in %zu writes\n", layerPtr->name, layerPtr->bytesRead, layerPtr->reads, layerPtr->bytesWritten, layerPtr->writes);
+		if (layerPtr->printStats != NULL) {
+			layerPtr->printStats(layerPtr);
+		}
+	}
+}
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include "parsing.h"
 #include "addresses.h"
 #include "cache.h"
@@ -9,8 +10,18 @@
 #include "utf8.h"
 #include "error.h"
 #include "printing.h"
+#include "date.h"
+#include "sort.h"
+#include "search.h"
+#include "bitmap.h"
+#include "flags.h"
+#include "charset.h"
+#include "decoder.h"
+#include "mailbox.h"
+#include "senders.h"
 
 int interpretList(FILE *imapStream); 
+int interpretCapabilities(FILE *imapStream);
 int interpretExists(FILE *imapStream, msgCacheT *cachePtr, size_t newSize, int context);
 int interpretExpunge(msgCacheT *cachePtr, size_t expungeNum);
 int interpretFetch(FILE *imapStream, msgCacheT *cachePtr, size_t msgNum);
@@ -65,13 +76,24 @@ int interpretUntagged(FILE *imapStream, msgCacheT *cachePtr, int context) {
 			}
 		}
 	}
+	//The response to a CAPABILITY command (consumes the CRLF)
+	else if (!strcmp(strHandle->content.string, "CAPABILITY")) {
+		freeImapObject(strHandle);
+
+		return(interpretCapabilities(imapStream));
+	}
+	//If the response is an untagged OK response, it may contain a response code (e.g. the UIDVALIDITY)
+	else if (!strcmp(strHandle->content.string, "OK")) {
+		freeImapObject(strHandle);
+
+		return(interpretRespCode(imapStream, cachePtr)); //Consumes the rest of the line
+	}
 	//If the response is an untagged NO response 
 	else if (!strcmp(strHandle->content.string, "NO")) {
 		freeImapObject(strHandle);
 
-		if (isError(retVal = printLine(stderr, imapStream))) { //Print the rest of the line, to alert the user
-			return(retVal);
-		}
+		//Print the rest of the line, to alert the user (this consumes the CRLF as well)
+		return(printLine(stderr, imapStream));
 	}
 	//If the response is an untagged BAD response 
 	else if (!strcmp(strHandle->content.string, "BAD")) {
@@ -138,28 +160,187 @@ int interpretNumberResponse(FILE *imapStream, msgCacheT *cachePtr, size_t msgNum
 	return(SUCCESS);
 }
 
+//The capabilities of the server this client makes use of (CAP_ values), as last advertised
+int serverCaps = 0;
+
+int hasCapability(int cap) {
+	return((serverCaps & cap) != 0);
+}
+
+/* The capabilities are a list of atoms, ending with the "]" of the response code,
+  e.g. [CAPABILITY IMAP4rev1 SASL-IR AUTH=PLAIN], or with the line in a CAPABILITY response,
+  a new list replaces the last one (e.g. servers advertise more capabilities after the login) */
+int interpretCapabilities(FILE *imapStream) {
+	imapObjectHandleT capHandle;
+	char *cap;
+	size_t len;
+	int retVal, last = 0;
+
+	serverCaps = 0;
+	while (!last) {
+		retVal = getImapObject(&capHandle, imapStream);
+		if (isError(retVal)) {
+			return(retVal);
+		}
+		else if (capHandle->tag == CRLF) { //The code was not closed, nothing else is left to skip
+			freeImapObject(capHandle);
+			return(SUCCESS);
+		}
+		else if (capHandle->tag != STRING) {
+			freeImapObject(capHandle);
+			continue;
+		}
+
+		cap = capHandle->content.string;
+		len = strlen(cap);
+		if (len > 0 && cap[len-1] == ']') {
+			cap[len-1] = '\0';
+			last = 1;
+		}
+		if (!strcasecmp(cap, "SASL-IR")) {
+			serverCaps |= CAP_SASL_IR;
+		}
+		else if (!strcasecmp(cap, "AUTH=PLAIN")) {
+			serverCaps |= CAP_AUTH_PLAIN;
+		}
+		else if (!strcasecmp(cap, "LOGINDISABLED")) {
+			serverCaps |= CAP_LOGINDISABLED;
+		}
+		else if (!strcasecmp(cap, "STARTTLS")) {
+			serverCaps |= CAP_STARTTLS;
+		}
+		else if (!strcasecmp(cap, "COMPRESS=DEFLATE")) {
+			serverCaps |= CAP_COMPRESS_DEFLATE;
+		}
+		freeImapObject(capHandle);
+	}
+
+	return(skipLine(imapStream)); //The text after the code
+}
+
+//Response codes are of the form "[" <code> SP <value> "]" <text> CRLF, e.g. [UIDVALIDITY 3857529045]
+int interpretRespCode(FILE *imapStream, msgCacheT *cachePtr) {
+	imapObjectHandleT codeHandle, valueHandle;
+	int retVal;
+
+	//The response may end right after OK
+	retVal = getImapObject(&codeHandle, imapStream);
+	if (isError(retVal)) {
+		return(retVal);
+	}
+	else if (codeHandle->tag == CRLF) {
+		freeImapObject(codeHandle);
+		return(SUCCESS);
+	}
+	freeImapObject(codeHandle); //The SP after OK
+
+	retVal = getImapObject(&codeHandle, imapStream);
+	if (isError(retVal)) {
+		return(retVal);
+	}
+	else if (codeHandle->tag == CRLF) {
+		freeImapObject(codeHandle);
+		return(SUCCESS);
+	}
+	else if (codeHandle->tag != STRING) {
+		freeImapObject(codeHandle);
+		return(skipLine(imapStream));
+	}
+
+	strUpper(codeHandle->content.string);
+	if (!strcmp(codeHandle->content.string, "[CAPABILITY")) {
+		freeImapObject(codeHandle);
+		return(interpretCapabilities(imapStream));
+	}
+	else if (cachePtr != NULL && (!strcmp(codeHandle->content.string, "[UIDVALIDITY") || !strcmp(codeHandle->content.string, "[UIDNEXT"))) {
+		if (isError(retVal = skipSpace(imapStream))) {
+			freeImapObject(codeHandle);
+			return(retVal);
+		}
+		retVal = getStringObject(&valueHandle, imapStream);
+		if (isError(retVal)) {
+			freeImapObject(codeHandle);
+			return(retVal);
+		}
+
+		//strtoul() stops at the closing bracket
+		if (!strcmp(codeHandle->content.string, "[UIDVALIDITY")) {
+			cachePtr->uidValidity = strtoul(valueHandle->content.string, NULL, 10);
+		}
+		else {
+			cachePtr->uidNext = strtoul(valueHandle->content.string, NULL, 10);
+		}
+		freeImapObject(valueHandle);
+	}
+	freeImapObject(codeHandle);
+
+	return(skipLine(imapStream));
+}
+
+//The tree LIST responses are added to (check mailbox.h), NULL if they are to be ignored
+folderTreeT *listTree = NULL;
+
+void setListTree(folderTreeT *treePtr) {
+	listTree = treePtr;
+}
+
+//Get the attributes of a mailbox from the list of its flags, e.g. (\HasChildren \Noselect)
+int folderAttributes(imapObjectHandleT attrHandle) {
+	imapObjectHandleT *attrArray = attrHandle->content.list.elemArray;
+	int attributes = 0;
+
+	for (int k = 0 ; k < attrHandle->content.list.elems ; k++) {
+		if (attrArray[k]->tag != STRING) {
+			continue;
+		}
+		//\NonExistent (RFC 5258) is only sent for levels of the hierarchy, so it is treated as \Noselect
+		if (!strcasecmp(attrArray[k]->content.string, "\\Noselect") || !strcasecmp(attrArray[k]->content.string, "\\NonExistent")) {
+			attributes |= FOLDER_NOSELECT;
+		}
+		else if (!strcasecmp(attrArray[k]->content.string, "\\Noinferiors")) {
+			attributes |= FOLDER_NOINFERIORS;
+		}
+		else if (!strcasecmp(attrArray[k]->content.string, "\\Marked")) {
+			attributes |= FOLDER_MARKED;
+		}
+		else if (!strcasecmp(attrArray[k]->content.string, "\\Unmarked")) {
+			attributes |= FOLDER_UNMARKED;
+		}
+	}
+
+	return(attributes);
+}
+
 int interpretList(FILE *imapStream) { 
 	//Response of the form: "LIST" SP <attributes> SP <hierarchy-delimiter> SP <mailbox-name> CRLF
-	imapObjectHandleT mailboxNameHandle; 
-	int retVal;
+	imapObjectHandleT attrHandle, delimHandle, mailboxNameHandle; 
+	char delimiter = '\0';
+	int attributes, retVal;
 
 	if (isError(retVal = skipSpace(imapStream))) { //Skip space
 		return(retVal);
 	}
 
-	//Skip the attributes
-	if (isError(retVal = skipObject(imapStream))) { 
+	retVal = getListObject(&attrHandle, imapStream);
+	if (isError(retVal)) {
 		return(retVal);
 	}
+	attributes = folderAttributes(attrHandle);
+	freeImapObject(attrHandle);
 
 	if (isError(retVal = skipSpace(imapStream))) {
 		return(retVal);
 	}
 
-	//Skip the hierarchy delimiter
-	if (isError(retVal = skipObject(imapStream))) {
+	//The hierarchy delimiter is a quoted character, or NIL if the hierarchy is flat
+	retVal = getImapObject(&delimHandle, imapStream);
+	if (isError(retVal)) {
 		return(retVal);
 	}
+	if (delimHandle->tag == STRING) {
+		delimiter = delimHandle->content.string[0];
+	}
+	freeImapObject(delimHandle);
 
 	if (isError(retVal = skipSpace(imapStream))) {
 		return(retVal);
@@ -171,33 +352,19 @@ int interpretList(FILE *imapStream) {
 		return(retVal);
 	}
 
-	printf("> %s\n", mailboxNameHandle->content.string); //Print that mailbox-name
+	if (listTree) {
+		retVal = folderTreeAdd(listTree, mailboxNameHandle->content.string, delimiter, attributes);
+	}
 
 	freeImapObject(mailboxNameHandle);
 
-	return(SUCCESS);
+	return(retVal);
 }
 
 int interpretExists(FILE *imapStream, msgCacheT *cachePtr, size_t newSize, int context) {
-	msgT **msgPtrArray = cachePtr->msgPtrArray;
-	size_t oldSize = cachePtr->cacheSize;
-
-	//If the EXISTS select was sent in response to a SELECT command
-	if (context == IN_SELECT) {
-
-		//Empty the message pointer array
-		if (msgPtrArray != NULL) {
-			for (int k = 0 ; k < oldSize ; k++) {
-				freeMsgData(msgPtrArray[k]);
-			}
-			free(msgPtrArray);
-		}
-		//Mhdenise ta gia na ftiaxei neo array to resize
-		cachePtr->msgPtrArray = NULL;
-		cachePtr->cacheSize = cachePtr->prevSize = 0;
-	}
-
-	//In any case resize it (resizing an empty array is equivalent to allocating)
+	/* If the EXISTS response was sent in response to a SELECT command (IN_SELECT context),
+	  the cache is empty, as its messages were stashed by sendSelect() (check cache.h),
+	  so in any case resize it (resizing an empty array is equivalent to allocating) */
 	if (cacheResize(cachePtr, newSize) < 0) {
 		return(MEM_ERROR);
 	}
@@ -217,6 +384,16 @@ void interpretRecent(msgCacheT *cachePtr, size_t recentNum) {
 	cachePtr->recent = recentNum; //Update the recent number stored in cache
 }
 
+int getMsgUid(imapObjectHandleT uidHandle, unsigned long *uidPtr) {
+	if (uidHandle->tag != STRING || !isNumber(uidHandle->content.string)) {
+		return(PARSE_ERROR);
+	}
+
+	*uidPtr = strtoul(uidHandle->content.string, NULL, 10);
+
+	return(SUCCESS);
+}
+
 int getMsgSize(imapObjectHandleT sizeHandle, int *sizePtr) {
 	char *sizeStr;
 	int retVal;
@@ -232,14 +409,103 @@ int getMsgSize(imapObjectHandleT sizeHandle, int *sizePtr) {
 	return(SUCCESS);
 }
 
+//Parse the date-time string once, so that only a timestamp is kept in the cache
+int getInternalDate(imapObjectHandleT dateHandle, msgT *msgPtr) {
+	if (dateHandle->tag != STRING) {
+		return(PARSE_ERROR);
+	}
+
+	/* A date that does not parse is not worth losing the message (and the rest of the
+	  response) over, so the message is kept with its date unknown */
+	if (isError(parseDateTime(dateHandle->content.string, &msgPtr->internalDate, &msgPtr->tzOffset))) {
+		msgPtr->internalDate = DATE_UNKNOWN;
+		msgPtr->tzOffset = 0;
+	}
+
+	return(SUCCESS);
+}
+
+//Returns the value of the parameter with the given name, in a BODYSTRUCTURE parameter list, or NULL
+char *findBodyParam(imapObjectHandleT paramHandle, char *name) {
+	imapObjectHandleT *paramArray;
+
+	if (paramHandle->tag != LIST) {
+		return(NULL);
+	}
+
+	//The parameters are a list of names, each followed by its value
+	paramArray = paramHandle->content.list.elemArray;
+	for (int k = 0 ; k+1 < paramHandle->content.list.elems ; k += 2) {
+		if (paramArray[k]->tag == STRING && paramArray[k+1]->tag == STRING && !strcasecmp(paramArray[k]->content.string, name)) {
+			return(paramArray[k+1]->content.string);
+		}
+	}
+
+	return(NULL);
+}
+
+/* Get the transfer encoding and charset of the message's text from its BODYSTRUCTURE, e.g.
+  ("TEXT" "PLAIN" ("CHARSET" "iso-8859-1") NIL NIL "QUOTED-PRINTABLE" 1234 20), single part text
+  bodies are decoded as a whole, and multipart ones, e.g. (("TEXT" ...)("IMAGE" ...) "MIXED"
+  ("BOUNDARY" "xyz") NIL NIL), are split by their boundary (check mime.h) */
+int parseBodyStructure(imapObjectHandleT structHandle, msgT *msgPtr) {
+	imapObjectHandleT *elemArray;
+	char *param;
+	int elems, charset, k;
+
+	msgPtr->encoding = ENCODING_IDENTITY;
+	msgPtr->charset = CHARSET_UTF8;
+	free(msgPtr->boundary);
+	msgPtr->boundary = NULL;
+	msgPtr->structureFetched = 1;
+
+	if (structHandle->tag != LIST) {
+		return(PARSE_ERROR);
+	}
+	elemArray = structHandle->content.list.elemArray;
+	elems = structHandle->content.list.elems;
+
+	//A multipart body starts with the list of its parts, followed by its subtype and its parameters
+	if (elems > 0 && elemArray[0]->tag == LIST) {
+		for (k = 0 ; k < elems && elemArray[k]->tag == LIST ; k++);
+		if (k+1 < elems && (param = findBodyParam(elemArray[k+1], "BOUNDARY")) && *param != '\0') {
+			msgPtr->boundary = strdup(param);
+			if (!msgPtr->boundary) {
+				return(MEM_ERROR);
+			}
+		}
+		return(SUCCESS);
+	}
+
+	//Other single part bodies are displayed as they are
+	if (elems < 6 || elemArray[0]->tag != STRING || strcasecmp(elemArray[0]->content.string, "TEXT")) {
+		return(SUCCESS);
+	}
+
+	if (elemArray[5]->tag == STRING) {
+		msgPtr->encoding = findEncoding(elemArray[5]->content.string);
+	}
+
+	//Text in an unknown charset is displayed as it is
+	param = findBodyParam(elemArray[2], "CHARSET");
+	if (param) {
+		charset = findCharset(param, strlen(param));
+		if (charset != CHARSET_UNKNOWN) {
+			msgPtr->charset = charset;
+		}
+	}
+
+	return(SUCCESS);
+}
+
 int parseEnvelope(imapObjectHandleT envelopeHandle, struct envelope *envPtr) {
 	imapObjectHandleT *elemArray = envelopeHandle->content.list.elemArray;
 	struct envelope envelope;
 	int retVal;
 
 	/*Skip zeroth element (date, not to be confused with internal date),
-	 and get decoded subject string */
-	retVal = decodedCopyFromObject(&envelope.subject, elemArray[1]);
+	 and get the subject string (it is decoded by decodeEnvelope()) */
+	retVal = copyStrFromObject(&envelope.subject, elemArray[1], NULLABLE);
 	if (isError(retVal)) {
 		return(retVal);
 	}
@@ -253,24 +519,55 @@ int parseEnvelope(imapObjectHandleT envelopeHandle, struct envelope *envPtr) {
 	//Get To address list
 	retVal = getAddressList(&envelope.toList, elemArray[5]);
 	if (isError(retVal)) {
-		freeAddressList(envelope.fromList);
+		freeAddressList(&envelope.fromList);
 		free(envelope.subject);
 		return(retVal);
 	}
 	//Get CC address list
 	retVal = getAddressList(&envelope.ccList, elemArray[6]);
 	if (isError(retVal)) {
-		freeAddressList(envelope.toList);
-		freeAddressList(envelope.fromList);
+		freeAddressList(&envelope.toList);
+		freeAddressList(&envelope.fromList);
 		free(envelope.subject);
 		return(retVal);
 	}
 
+	envelope.subjectWidth = envelope.fromWidth = 0;
+	envelope.decoded = 0;
+
 	*envPtr = envelope;
 
 	return(SUCCESS); 
 }
 
+int decodeEnvelope(struct envelope *envPtr) {
+	int retVal;
+
+	if (envPtr->decoded) {
+		return(SUCCESS);
+	}
+
+	if (isError(retVal = decodeHeaderField(&envPtr->subject))) {
+		return(retVal);
+	}
+	if (isError(retVal = decodeAddressList(&envPtr->fromList))) {
+		return(retVal);
+	}
+	if (isError(retVal = decodeAddressList(&envPtr->toList))) {
+		return(retVal);
+	}
+	if (isError(retVal = decodeAddressList(&envPtr->ccList))) {
+		return(retVal);
+	}
+
+	//The widths are only computed once, instead of every time a page is displayed
+	envPtr->subjectWidth = envPtr->subject ? utf8Width(envPtr->subject) : 0;
+	envPtr->fromWidth = senderName(&envPtr->fromList) ? utf8Width(senderName(&envPtr->fromList)) : 0;
+	envPtr->decoded = 1;
+
+	return(SUCCESS);
+}
+
 //Parse a list of flags, for example (\Deleted \Seen \Recent), and store the flags into an integer 
 int parseFlags(imapObjectHandleT flagsHandle) {
 	struct imapObject **elemArray = flagsHandle->content.list.elemArray;
@@ -338,16 +635,52 @@ msgT *initCurrMsg(msgCacheT *cachePtr, size_t msgNum) {
 	return(currMsg);
 }
 
-int interpretFetch(FILE *imapStream, msgCacheT *cachePtr, size_t msgNum) {
-	imapObjectHandleT fetchList; //The list of things that FETCH returned
-
-	/* fetchElems, fetchStr and fetchElemArray are used for readability and to
-	  limit access to struct fields via pointer */
-	int fetchElems;
-	imapObjectHandleT *fetchElemArray; 
+//Check whether a fetch list contains any of the fields the messages are sorted by
+int hasSortKeys(imapObjectHandleT *fetchElemArray, int fetchElems) {
 	char *fetchStr;
 
-	msgT *currMsg;
+	for (int k = 0 ; k < fetchElems ; k += 2) {
+		if (fetchElemArray[k]->tag != STRING) {
+			continue;
+		}
+		fetchStr = fetchElemArray[k]->content.string;
+		if (!strcasecmp(fetchStr, "ENVELOPE") || !strcasecmp(fetchStr, "INTERNALDATE")
+		    || !strcasecmp(fetchStr, "RFC822.SIZE")) {
+			return(1);
+		}
+	}
+
+	return(0);
+}
+
+/* When a mailbox is selected again, its cached messages are stashed (check cache.h), and
+  as the server reports the UID of each message, the message is moved back from the stash 
+  to its (possibly new) position, instead of being fetched again */
+int unstashMsg(msgCacheT *cachePtr, size_t msgNum, imapObjectHandleT *fetchElemArray, int fetchElems) {
+	unsigned long uid;
+	msgT *msgPtr;
+	int retVal;
+
+	for (int k = 0 ; k+1 < fetchElems ; k += 2) {
+		if (fetchElemArray[k]->tag == STRING && !strcasecmp(fetchElemArray[k]->content.string, "UID")) {
+			retVal = getMsgUid(fetchElemArray[k+1], &uid);
+			if (isError(retVal)) {
+				return(retVal);
+			}
+
+			msgPtr = cacheUnstash(cachePtr, uid);
+			if (msgPtr != NULL) {
+				cacheInsert(cachePtr, msgPtr, msgNum-1);
+			}
+			break;
+		}
+	}
+
+	return(SUCCESS);
+}
+
+int interpretFetch(FILE *imapStream, msgCacheT *cachePtr, size_t msgNum) {
+	imapObjectHandleT fetchList; //The list of things that FETCH returned
 	int retVal;
 
 	if (isError(retVal = skipSpace(imapStream))) { //Skip a space
@@ -359,10 +692,46 @@ int interpretFetch(FILE *imapStream, msgCacheT *cachePtr, size_t msgNum) {
 	if (isError(retVal)) {
 		return(retVal);
 	}
+
+	return(applyFetch(cachePtr, msgNum, fetchList));
+}
+
+int applyFetch(msgCacheT *cachePtr, size_t msgNum, imapObjectHandleT fetchList) {
+	/* fetchElems, fetchStr and fetchElemArray are used for readability and to
+	  limit access to struct fields via pointer */
+	int fetchElems;
+	imapObjectHandleT *fetchElemArray; 
+	char *fetchStr;
+
+	msgT *currMsg;
+	int retVal, sortKeys;
+	int textFetched = 0; //If so, the text is to be added to the search index
+	int flags;
+	int flagsFetched = 0; //If so, the flag index is updated
+
+	if (fetchList->tag == NIL || msgNum < 1 || msgNum > cachePtr->cacheSize) {
+		//Nothing was fetched, or the message does not exist, so nothing to store
+		freeImapObject(fetchList);
+		return(SUCCESS);
+	}
 	fetchElems = fetchList->content.list.elems; 
 	fetchElemArray = fetchList->content.list.elemArray;
 
 
+	if (cachePtr->stashSize > 0 && !cachePtr->msgPtrArray[msgNum-1]) {
+		retVal = unstashMsg(cachePtr, msgNum, fetchElemArray, fetchElems);
+		if (isError(retVal)) {
+			freeImapObject(fetchList);
+			return(retVal);
+		}
+		/* A message that is not in the stash arrived since, it is left to be fetched in full with the rest
+		  of the missing ones (check fetchMissing() in commands.c), instead of being kept with only a UID and flags */
+		if (!cachePtr->msgPtrArray[msgNum-1] && !hasSortKeys(fetchElemArray, fetchElems)) {
+			freeImapObject(fetchList);
+			return(SUCCESS);
+		}
+	}
+
 	//Give currMsg a suitable value, check initCurrMsg() for more
 	currMsg = initCurrMsg(cachePtr, msgNum);
 	if (!currMsg) {
@@ -370,6 +739,15 @@ int interpretFetch(FILE *imapStream, msgCacheT *cachePtr, size_t msgNum) {
 		return(MEM_ERROR);
 	}
 
+	/* If the fields the sort views use are about to change, the message must leave the views
+	  first, as it is found in them by binary search, and be inserted again afterwards */
+	sortKeys = hasSortKeys(fetchElemArray, fetchElems);
+	if (sortKeys) {
+		viewRemove(cachePtr, msgNum-1);
+	}
+	//The same goes for the counts of the sender, which depend on the envelope, the size and the flags
+	senderRemove(currMsg);
+
 	/* Interate over the fetch list, and depending on the string encountered
 	  fetch the message's text, flags, internal date, size or envelope. After
 	  fetching the corresponding data (the next element), skip the string by incrementing the counter
@@ -388,19 +766,56 @@ int interpretFetch(FILE *imapStream, msgCacheT *cachePtr, size_t msgNum) {
 
 		strUpper(fetchStr); //Ta thelw case insensitive
 		if (!strcmp(fetchStr, "RFC822.TEXT")) { //Fetch the text
-			retVal = copyStrFromObject(&currMsg->text, fetchElemArray[k+1], NOT_NULLABLE);
-			if (!currMsg->text) {
+			/* The text was decoded while it was read (check sendFetchText()), and it can be
+			  large, so it is taken from the object instead of being copied */
+			if (fetchElemArray[k+1]->tag == STRING) {
+				free(currMsg->text);
+				currMsg->text = fetchElemArray[k+1]->content.string;
+				fetchElemArray[k+1]->tag = NIL;
+			}
+			else {
+				retVal = copyStrFromObject(&currMsg->text, fetchElemArray[k+1], NOT_NULLABLE);
+				if (!currMsg->text) {
+					freeImapObject(fetchList);
+					return(retVal);
+				}
+			}
+			//The text is displayed as it is, so malformed UTF-8 and control characters (e.g. escape sequences) are replaced
+			retVal = utf8Sanitize(&currMsg->text, 1);
+			if (isError(retVal)) {
 				freeImapObject(fetchList);
 				return(retVal);
 			}
+			textFetched = 1;
 			k++; //Skip the word RFC822.TEXT
 		}
+		else if (!strcmp(fetchStr, "BODYSTRUCTURE")) { //Fetch how the text is encoded
+			retVal = parseBodyStructure(fetchElemArray[k+1], currMsg);
+			if (isError(retVal)) {
+				freeImapObject(fetchList);
+				return(retVal);
+			}
+			k++; //Skip the word BODYSTRUCTURE
+		}
+		else if (!strcmp(fetchStr, "UID")) { //Fetch the UID
+			retVal = getMsgUid(fetchElemArray[k+1], &currMsg->uid);
+			if (isError(retVal)) {
+				freeImapObject(fetchList);
+				return(retVal);
+			}
+			k++; //Skip the word UID
+		}
 		else if (!strcmp(fetchStr, "FLAGS")) { //Fetch flags
-			currMsg->flags = parseFlags(fetchElemArray[k+1]);
+			flags = parseFlags(fetchElemArray[k+1]);
+			if (flags != currMsg->flags) { //The flags are shown in the preview, so it is rendered again
+				currMsg->flags = flags;
+				currMsg->previewLayout = 0;
+			}
+			flagsFetched = 1;
 			k++; //Skip the word FLAGS
 		}
 		else if (!strcmp(fetchStr, "INTERNALDATE")) { //Fetch date
-			retVal = copyStrFromObject(&currMsg->internalDate , fetchElemArray[k+1], NOT_NULLABLE); 
+			retVal = getInternalDate(fetchElemArray[k+1], currMsg);
 			if (isError(retVal)) {
 				freeImapObject(fetchList);
 				return(retVal);
@@ -416,16 +831,44 @@ int interpretFetch(FILE *imapStream, msgCacheT *cachePtr, size_t msgNum) {
 			k++; //Skip the word RFC822.SIZE
 		}
 		else if (!strcmp(fetchStr, "ENVELOPE")) { //Fetch the envelope
-			retVal = parseEnvelope(fetchElemArray[k+1], &currMsg->envelope);
+			struct envelope envelope;
+
+			retVal = parseEnvelope(fetchElemArray[k+1], &envelope);
 			if (isError(retVal)) {
 				freeImapObject(fetchList);
 				return(retVal);
 			}
+			freeEnvelope(&currMsg->envelope); //If the envelope was fetched before
+			currMsg->envelope = envelope;
+			currMsg->indexed = 0; //It is indexed again (check search.h)
+			currMsg->previewLayout = 0;
 			k++; //Skip the word ENVELOPE
 		}
 	}
 
 	freeImapObject(fetchList);
+	cacheAccount(cachePtr, currMsg);
 
-	return(SUCCESS);
+	//Indexing is done after the loop, as the UID may come after the text in the list
+	if (textFetched) {
+		retVal = indexText(cachePtr->searchIndex, currMsg);
+		if (isError(retVal)) {
+			return(retVal);
+		}
+	}
+	if (flagsFetched) {
+		retVal = flagIndexUpdate(cachePtr->flagIndex, currMsg->uid, currMsg->flags);
+		if (isError(retVal)) {
+			return(retVal);
+		}
+	}
+
+	if (sortKeys) {
+		retVal = viewInsert(cachePtr, msgNum-1);
+		if (isError(retVal)) {
+			return(retVal);
+		}
+	}
+
+	return(senderAdd(cachePtr->senderIndex, currMsg));
 }
\ No newline at end of file
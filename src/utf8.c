@@ -4,380 +4,547 @@
 #include <string.h>
 #include "error.h"
 #include "parsing.h"
+#include "base64.h"
+#include "charset.h"
+#include "utils.h"
+#include "width.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+	#include <immintrin.h>
+	#define UTF8_SIMD
+#endif
+
+//The notes appended to strings that can't be decoded, MAX_NOTE_LEN is the length of the longest one
+#define UNKNOWN_CHARSET "??Unknown charset??"
+#define UNKNOWN_ENCODING "??Unknown encoding??"
+#define NOT_ENDED "?? not ended with ?= ??"
+#define MALFORMED_B64 "??Malformed base 64??"
+#define MAX_NOTE_LEN 23
+
+#define REPLACEMENT_CHAR "\xEF\xBF\xBD" //U+FFFD, in place of what can't be displayed
+
+/* Encoded-words can't be longer than 75 characters (RFC 2047), so their text is decoded on the
+  stack, before being converted to UTF-8, longer ones (from non-conforming mailers) are allocated */
+#define WORD_BUF_SIZE 128
+
+/* Decode the text of a Q encoded-word (RFC 2047, a variant of quoted-printable) into decodedStr,
+  '_' stands for a space, and "=XX" for the byte with the hexadecimal value XX. Returns the
+  number of bytes decoded, which is never more than len */
+size_t decodeQWord(char *qStr, size_t len, char *decodedStr) {
+	size_t pos, bytes = 0;
+	int high, low;
+
+	for (pos = 0 ; pos < len ; pos++) {
+		if (qStr[pos] == '_') {
+			decodedStr[bytes++] = ' ';
+		}
+		else if (qStr[pos] == '=' && pos + 2 < len && (high = hexDigitValue(qStr[pos+1])) >= 0 
+		         && (low = hexDigitValue(qStr[pos+2])) >= 0) {
+			decodedStr[bytes++] = (high << 4) | low;
+			pos += 2;
+		}
+		else { //Anything else (including a stray '=') stands for itself
+			decodedStr[bytes++] = qStr[pos];
+		}
+	}
 
-//For reading on decoding base 64, check https://en.wikipedia.org/wiki/Base64
-
-#define B64_BATCH 63 //Each base 64 quartet decodes to 3 bytes, so the batch size is divisible by 3 
+	return(bytes);
+}
 
-char b64DigitToSextet(char digit) {
+/* Decode the encoded-word that starts at wordStr ("=?charset?encoding?text?=") into decodedStr,
+  in UTF-8, and store its length in wordLenPtr. Returns the number of bytes decoded, or
+  returns -1 and points notePtr to the note to display, if the word can't be decoded */
+int decodeWord(char *wordStr, size_t *wordLenPtr, char *decodedStr, char **notePtr) {
+	char wordBuf[WORD_BUF_SIZE], *word = wordBuf, *charsetEnd, *text, *textEnd, encoding;
+	size_t textLen, wordBytes;
+	int charset, retVal = SUCCESS;
+
+	charsetEnd = strchr(wordStr + 2, '?'); //Skip the "=?"
+	if (!charsetEnd || (charset = findCharset(wordStr + 2, charsetEnd - (wordStr + 2))) == CHARSET_UNKNOWN) {
+		*notePtr = UNKNOWN_CHARSET;
+		return(-1);
+	}
 
-	/* For each base 64 digit, return the matching value (sextet of bits),
-	   in order to not write a big switch-case statement, or implement 
-	   dictionaries in C, character arithmetic was used */
-	if (isupper(digit)) {
-		return(digit - 'A');
+	//Only the Base 64 (B) and Q encodings exist
+	encoding = toupper(charsetEnd[1]);
+	if ((encoding != 'B' && encoding != 'Q') || charsetEnd[2] != '?') {
+		*notePtr = UNKNOWN_ENCODING;
+		return(-1);
 	}
-	else if (islower(digit)) {
-		return(digit - 'a' + 26);
+	text = charsetEnd + 3;
+	textEnd = strstr(text, "?=");
+	if (!textEnd) {
+		//Inform the user that the string the server sent was malformed
+		*notePtr = NOT_ENDED;
+		return(-1);
 	}
-	else if (isdigit(digit)) {
-		return(52 + digit - '0');
+	textLen = textEnd - text;
+
+	//Q text decodes to at most textLen bytes, and base 64 to at most B64_DECODED_SIZE(textLen) <= textLen+2
+	if (textLen + 2 > WORD_BUF_SIZE) {
+		word = malloc(textLen + 2);
+		if (!word) {
+			*notePtr = NULL;
+			return(-1);
+		}
 	}
-	else if (digit == '+') {
-		return(62);
+
+	if (encoding == 'B') {
+		retVal = b64Decode(text, textLen, word, &wordBytes);
 	}
-	else if (digit == '/') {
-		return(63);
+	else {
+		wordBytes = decodeQWord(text, textLen, word);
 	}
 
-	return(-1); //Not a base 64 digit
-}
+	if (isError(retVal)) {
+		*notePtr = MALFORMED_B64;
+	}
+	else {
+		//Convert the decoded bytes from the word's charset to UTF-8
+		wordBytes = charsetToUtf8(charset, word, wordBytes, decodedStr);
+	}
+	if (word != wordBuf) {
+		free(word);
+	}
 
-char *createDecodedB64(char *b64Str, int *posPtr) {
-	int pos = *posPtr;
-	unsigned char sextet;
-	char *decodedStr, *temp;
-	int bytes = 0; //Number of bytes in decodedStr
+	*wordLenPtr = textEnd + 2 - wordStr; //Pass the "?="
 
-	if (!b64Str) { //If NULL, something went wrong outside
-		return(NULL);
-	}
+	return(isError(retVal) ? -1 : wordBytes);
+}
 
-	decodedStr = malloc(B64_BATCH); //Allocate buffer using a batch size, to decrease allocations
+char *decodeUtf8Str(char *encodedStr) {
+	size_t encodedLen, wordLen, len = 0, bytes; //len is the number of bytes in decodedStr
+	char *decodedStr, *temp, *note = NULL, *pos = encodedStr, *nextWord, *afterSpace;
+	int wordBytes, wordsDecoded = 0;
+
+	/* The decoded text is never longer than the encoded text (base 64 decodes 4 digits to 3 bytes,
+	  Q 3 characters to 1 byte, and everything else is copied as is), but converting it to UTF-8
+	  can take up to UTF8_EXPANSION bytes per byte, so the string is allocated once, with
+	  enough room for that, and for a note, if decoding has to stop */
+	encodedLen = strlen(encodedStr);
+	decodedStr = malloc(UTF8_EXPANSION*encodedLen + MAX_NOTE_LEN + 1);
 	if (!decodedStr) {
 		return(NULL);
 	}
 
-	do {
-		//Decoding first byte
-		sextet = b64DigitToSextet(b64Str[pos]);
-		if (sextet < 0) { //If illegal char
-			return(NULL);
-		}
-		decodedStr[bytes] = (sextet << 2); //First six bits of first byte
-		pos++;
-		sextet = b64DigitToSextet(b64Str[pos]); //Next sextet
-		if (sextet < 0) { //If illegal char
-			return(NULL);
+	while (*pos != '\0') { //While the end of the string has not been reached
+		if (pos[0] == '=' && pos[1] == '?') {
+			wordBytes = decodeWord(pos, &wordLen, decodedStr + len, &note);
+			if (wordBytes < 0) {
+				if (!note) { //Out of memory
+					free(decodedStr);
+					return(NULL);
+				}
+				break;
+			}
+			len += wordBytes;
+			pos += wordLen;
+			wordsDecoded = 1;
+
+			/* Whitespace between two encoded-words is not displayed (RFC 2047), as it only
+			  separates them (long texts are split into several words), actual spaces are encoded */
+			for (afterSpace = pos ; *afterSpace == ' ' || *afterSpace == '\t' || *afterSpace == '\r' || *afterSpace == '\n' ; afterSpace++);
+			if (afterSpace[0] == '=' && afterSpace[1] == '?') {
+				pos = afterSpace;
+			}
+		} 
+		else { //Copy the ASCII text up to the next encoded-word (or the end) at once
+			nextWord = strstr(pos + 1, "=?");
+			bytes = nextWord ? nextWord - pos : strlen(pos);
+			memcpy(decodedStr + len, pos, bytes);
+			len += bytes;
+			pos += bytes;
 		}
-		decodedStr[bytes] |= (sextet >> 4); //Next two bits
-		bytes++;
+	}
 
-		//Second byte
-		decodedStr[bytes] = (sextet << 4); //First four bits
-		pos++;	
+	if (note != NULL) {
+		memcpy(decodedStr + len, note, strlen(note));
+		len += strlen(note);
+	}
+	decodedStr[len] = '\0'; //Terminate string
 
-		//If the pad character '=' is encountered, only one bytes is to be decoded
-		if (b64Str[pos] == '=') { 
-			pos += 2; //Pass the second padding char as well
-			break;
+	//Give back the room left for the conversion to UTF-8, as the string is kept in the cache
+	if (wordsDecoded) {
+		temp = realloc(decodedStr, len + 1);
+		if (temp != NULL) {
+			decodedStr = temp;
 		}
-		sextet = b64DigitToSextet(b64Str[pos]);
-		if (sextet < 0) {
-			return(NULL);
+	}
+
+	return(decodedStr);
+}
+
+#ifdef UTF8_SIMD
+/* The vectorized validation follows John Keiser's and Daniel Lemire's algorithm ("Validating UTF-8
+  in less than one instruction per byte", check https://arxiv.org/abs/2010.03090). Every byte is
+  checked together with the 3 before it: the high nibble of the byte before, its low nibble, and
+  the high nibble of the byte itself are looked up in three tables (with pshufb), each giving the
+  errors the pair could be part of, and the errors all three agree on are the actual ones. That
+  a 3rd or 4th byte of a character is a continuation byte is checked on its own, and a block of
+  ASCII only needs the previous one not to end in the middle of a character. */
+
+//The errors a pair of bytes can make
+#define TOO_SHORT (1<<0) //A lead byte not followed by a continuation byte
+#define TOO_LONG (1<<1) //A continuation byte after an ASCII byte
+#define OVERLONG_3 (1<<2)
+#define TOO_LARGE (1<<3) //Above U+10FFFF
+#define SURROGATE (1<<4)
+#define OVERLONG_2 (1<<5)
+#define TOO_LARGE_1000 (1<<6)
+#define OVERLONG_4 (1<<6)
+#define TWO_CONTS (1<<7) //Two continuation bytes, only valid if they are the 3rd or the 4th of a character
+#define CARRY (TOO_SHORT | TOO_LONG | TWO_CONTS)
+
+__attribute__((target("ssse3")))
+size_t utf8CleanPrefixSsse3(unsigned char *str, size_t len, int keepLines) {
+	//Indexed by the high nibble of the first byte of the pair
+	const __m128i byte1High = _mm_setr_epi8(TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+	                                        TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS, TOO_SHORT | OVERLONG_2, TOO_SHORT,
+	                                        TOO_SHORT | OVERLONG_3 | SURROGATE, TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4);
+	//By its low nibble
+	const __m128i byte1Low = _mm_setr_epi8(CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4, CARRY | OVERLONG_2, CARRY, CARRY,
+	                                       CARRY | TOO_LARGE, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+	                                       CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+	                                       CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+	                                       CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+	                                       CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE, CARRY | TOO_LARGE | TOO_LARGE_1000,
+	                                       CARRY | TOO_LARGE | TOO_LARGE_1000);
+	//By the high nibble of the second byte
+	const __m128i byte2High = _mm_setr_epi8(TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+	                                        TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+	                                        TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+	                                        TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+	                                        TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+	                                        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT);
+	//A block ends in the middle of a character if one of its last 3 bytes is a lead byte too long to fit
+	const __m128i maxLast = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1);
+	const __m128i nibble = _mm_set1_epi8(0x0F), zero = _mm_setzero_si128();
+	__m128i input, prev = zero, prevIncomplete = zero, prev1, special, must23, error, control;
+	size_t pos;
+	int back;
+
+	for (pos = 0 ; pos + 16 <= len ; pos += 16) {
+		input = _mm_loadu_si128((__m128i*)(str + pos));
+
+		//Control characters are C0 (up to 0x1F), DEL and C1 (U+0080 to U+009F, so 0xC2 followed by 0x80 to 0x9F)
+		control = _mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(input, _mm_set1_epi8(0x1F)), input), _mm_cmpeq_epi8(input, _mm_set1_epi8(0x7F)));
+		if (keepLines) {
+			control = _mm_andnot_si128(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(input, _mm_set1_epi8('\n')),
+			                                                     _mm_cmpeq_epi8(input, _mm_set1_epi8('\r'))),
+			                                        _mm_cmpeq_epi8(input, _mm_set1_epi8('\t'))), control);
 		}
-		decodedStr[bytes] |= (sextet >> 2); //Next four bits
-		bytes++;
 
-		//third byte
-		decodedStr[bytes] = (sextet << 6); //First two bits
-		pos++;
-		if (b64Str[pos] == '=') { //if padding is encountered, only two bytes are to be decoded
-			pos++;
-			break;
+		if (_mm_movemask_epi8(input) == 0) {
+			error = _mm_or_si128(prevIncomplete, control);
 		}
-		sextet = b64DigitToSextet(b64Str[pos]);
-		if (sextet < 0) { //illegal char
-			return(NULL);
+		else {
+			prev1 = _mm_alignr_epi8(input, prev, 15);
+			special = _mm_and_si128(_mm_and_si128(_mm_shuffle_epi8(byte1High, _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)),
+			                                      _mm_shuffle_epi8(byte1Low, _mm_and_si128(prev1, nibble))),
+			                        _mm_shuffle_epi8(byte2High, _mm_and_si128(_mm_srli_epi16(input, 4), nibble)));
+			//Bytes 2 and 3 after a lead byte of 3 or 4 byte characters must be continuation bytes
+			must23 = _mm_or_si128(_mm_subs_epu8(_mm_alignr_epi8(input, prev, 14), _mm_set1_epi8(0xE0 - 0x80)),
+			                      _mm_subs_epu8(_mm_alignr_epi8(input, prev, 13), _mm_set1_epi8(0xF0 - 0x80)));
+			error = _mm_xor_si128(_mm_and_si128(must23, _mm_set1_epi8(0x80)), special);
+			control = _mm_or_si128(control, _mm_and_si128(_mm_cmpeq_epi8(prev1, _mm_set1_epi8(0xC2)),
+			                                              _mm_cmpeq_epi8(_mm_and_si128(input, _mm_set1_epi8(0xE0)), _mm_set1_epi8(0x80))));
+			error = _mm_or_si128(error, control);
 		}
-		decodedStr[bytes] |= sextet; //Last six bits
-		bytes++;
-		pos++;	//Pass fourth char
-
-		if (bytes % B64_BATCH == 0) { //Resize using batch size, to reduce reallocs
-			temp = realloc(decodedStr, bytes+B64_BATCH);
-			if (!temp) {
-				free(decodedStr);
-				return(NULL);
-			}
-			decodedStr = temp;
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(error, zero)) != 0xFFFF) {
+			break;
 		}
 
-		//If either is encountered, the MIME encoded-word is over
-		if (b64Str[pos] == '\0' || b64Str[pos] == '?') {
+		prevIncomplete = _mm_subs_epu8(input, maxLast);
+		prev = input;
+	}
+
+	/* Every character before the position is valid, but the last one can be incomplete, it is then
+	  checked by the caller (with the rest), so the position goes back to its lead byte */
+	for (back = 1 ; back <= 3 && back <= pos ; back++) {
+		if ((str[pos-back] & 0xC0) != 0x80) {
+			if (str[pos-back] >= 0xC0 && (str[pos-back] >= 0xF0 ? 4 : str[pos-back] >= 0xE0 ? 3 : 2) > back) {
+				pos -= back;
+			}
 			break;
 		}
-	} while(1);
-
-	//Resize to final size
-	temp = realloc(decodedStr, bytes+1);
-	if (!temp) {
-		free(decodedStr);
-		return(NULL);
 	}
-	decodedStr = temp;
-	decodedStr[bytes] = '\0'; //Terminate string
 
-	*posPtr = pos; //Return new position outside
+	return(pos);
+}
 
-	return(decodedStr);
+__attribute__((target("sse2")))
+size_t asciiPrefixSse2(unsigned char *str, size_t len) {
+	size_t pos;
+	int mask;
+
+	for (pos = 0 ; pos + 16 <= len ; pos += 16) {
+		mask = _mm_movemask_epi8(_mm_loadu_si128((__m128i*)(str + pos)));
+		if (mask != 0) {
+			return(pos + __builtin_ctz(mask));
+		}
+	}
+
+	return(pos);
 }
+#endif
 
+size_t utf8CharLen(char *str, size_t len) {
+	unsigned char *bytes = (unsigned char*)str;
+	size_t charLen;
 
-/* Checks if the charset of encoded-word matches the one supplied as an arguement.
-   Is case-insensitive, as RFC 2045 does not imply otherwise */
-int matchCharset(char *string, int *posPtr, char *charsetStr, int charsetLen) {
-	int strPos = *posPtr, subPos = 0;
+	if (bytes[0] < 0x80) {
+		return(1);
+	}
+	else if (bytes[0] >= 0xC2 && bytes[0] <= 0xDF) {
+		charLen = 2;
+	}
+	else if (bytes[0] >= 0xE0 && bytes[0] <= 0xEF) {
+		charLen = 3;
+	}
+	else if (bytes[0] >= 0xF0 && bytes[0] <= 0xF4) {
+		charLen = 4;
+	}
+	else { //A continuation byte, or a lead byte that can only start overlong or too large characters
+		return(0);
+	}
+	if (len < charLen) {
+		return(0);
+	}
 
-	//While both strings are not voer
-	for (strPos = *posPtr ; string[strPos] != '\0' && subPos < charsetLen ; strPos++, subPos++) {
-		if (tolower(string[strPos]) != charsetStr[subPos]) {
-			break;
-		}
+	//The second byte has a narrower range after some lead bytes, to rule out overlong forms, surrogates and code points above U+10FFFF
+	if ((bytes[0] == 0xE0 && bytes[1] < 0xA0) || (bytes[0] == 0xED && bytes[1] > 0x9F) ||
+	    (bytes[0] == 0xF0 && bytes[1] < 0x90) || (bytes[0] == 0xF4 && bytes[1] > 0x8F)) {
+		return(0);
 	}
-	/* If it stopped before all of the charsetStr's length being checked,
-	 or the charset name wasn't finished, it didn't match */
-	if (subPos < charsetLen || string[strPos] != '?') { //Den htan idio akribws
-		return(0); 
+	for (size_t k = 1 ; k < charLen ; k++) {
+		if ((bytes[k] & 0xC0) != 0x80) {
+			return(0);
+		}
 	}
 
-	*posPtr = strPos; //Return new position outside
+	return(charLen);
+}
+
+//Returns 1 if the (valid) character is a control character, and is not allowed
+int isControlChar(char *str, int keepLines) {
+	unsigned char c = str[0];
+
+	if (keepLines && (c == '\n' || c == '\r' || c == '\t')) {
+		return(0);
+	}
 
-	return(1);
+	return(c < 0x20 || c == 0x7F || (c == 0xC2 && (unsigned char)str[1] < 0xA0));
 }
 
-//Concatenate two dynamically allocated strings, producing another dynamically allocated string
-char *allocStrcat(char *str1, char *str2) {
-	char *catStr;
+size_t utf8CleanPrefix(char *str, size_t len, int keepLines) {
+	size_t pos = 0, charLen;
 
-	if (!str1) { //Degenerates to strdup() if the first string is NULL
-		catStr = strdup(str2);
-		if (!catStr) {
-			return(NULL);
-		}
+#ifdef UTF8_SIMD
+	if (__builtin_cpu_supports("ssse3")) {
+		pos = utf8CleanPrefixSsse3((unsigned char*)str, len, keepLines);
 	}
-	else {
-		catStr = realloc(str1, strlen(str1) + strlen(str2) + 1); //+1 for '/0'
-		if (!catStr) {
-			return(NULL);
-		}
+#endif
 
-		strcat(catStr, str2); //Concatenate the strings
+	//The rest (less than a block, or from the block the first error is in) is checked one character at a time
+	while (pos < len) {
+		charLen = utf8CharLen(str + pos, len - pos);
+		if (charLen == 0 || isControlChar(str + pos, keepLines)) {
+			break;
+		}
+		pos += charLen;
 	}
 
-	return(catStr);
+	return(pos);
 }
 
-//Appends a character to a dynamically allocated string
-char *appendChar(char *str, char c) {
-	char *temp;
+int utf8Sanitize(char **strPtr, int keepLines) {
+	char *str = *strPtr, *clean, *temp;
+	size_t len, pos, cleanLen = 0, run, charLen;
 
 	if (!str) {
-		str = calloc(2, 1); 
-		if (!str) {
-			return(NULL);
-		}
-		str[0] = c; //Create an one-char stirng
+		return(SUCCESS);
+	}
+	len = strlen(str);
+	run = utf8CleanPrefix(str, len, keepLines);
+	if (run == len) { //Nearly always, so nothing is copied
+		return(SUCCESS);
+	}
+
+	//Every byte that is replaced becomes U+FFFD, which takes 3
+	clean = malloc(UTF8_EXPANSION*len + 1);
+	if (!clean) {
+		return(MEM_ERROR);
 	}
-	else {
-		int len = strlen(str);
 
-		temp = realloc(str, len+1+1); //Resize the string
-		if (!temp) {
-			return(NULL);
+	for (pos = 0 ; ; pos += charLen) {
+		memcpy(clean + cleanLen, str + pos, run);
+		cleanLen += run;
+		pos += run;
+		if (pos == len) {
+			break;
 		}
-		str = temp;
 
-		str[len] = c; //Append the char
-		str[len+1] = '\0'; //Terminate the new string
+		charLen = utf8CharLen(str + pos, len - pos);
+		if (charLen == 0) { //A malformed byte
+			charLen = 1;
+			memcpy(clean + cleanLen, REPLACEMENT_CHAR, 3);
+			cleanLen += 3;
+		}
+		else if (str[pos] == '\n' || str[pos] == '\r' || str[pos] == '\t') { //In a single line string
+			clean[cleanLen++] = ' ';
+		}
+		else {
+			memcpy(clean + cleanLen, REPLACEMENT_CHAR, 3);
+			cleanLen += 3;
+		}
+		run = utf8CleanPrefix(str + pos + charLen, len - pos - charLen, keepLines);
 	}
+	clean[cleanLen] = '\0';
 
-	return(str);
-}
+	temp = realloc(clean, cleanLen + 1);
+	free(str);
+	*strPtr = temp ? temp : clean;
 
-char *decodeUtf8Str(char *encodedStr) {
-	int pos = 0;
-	char *decodedStr = NULL, *temp, *retStr;
-
-	do {
-		if (encodedStr[pos] == '=' && encodedStr[pos+1] == '?') {
-			pos += 2; //Skip the "=?"
-			if (!matchCharset(encodedStr, &pos, "utf-8", 5)) {
-				//Inform the user that the charset is not supported (only utf-8 is)
-				temp = allocStrcat(decodedStr, "??Unknown charset??"); 
-				if (!temp) {
-					free(decodedStr);
-					return(NULL);
-				}
-				decodedStr = temp;
-				break;
-			}
-			pos++; //Skip the '?'
-			if (encodedStr[pos] == 'b' || encodedStr[pos] == 'B') {
-				pos += 2; //Skip "b?"
+	return(SUCCESS);
+}
 
-				//Create the base 64 decoded string
-				retStr = createDecodedB64(encodedStr, &pos); 
-				if (!retStr) {
-					free(decodedStr);
-					return(NULL);
-				}
+//The length of the ASCII prefix of a string
+size_t asciiPrefix(char *str, size_t len) {
+	size_t pos = 0;
 
-				//Concatenate the utf-8 string with the new part
-				temp = allocStrcat(decodedStr, retStr);
-				if (!temp) {
-					free(decodedStr);
-					free(retStr);
-					return(NULL);
-				}
-				free(retStr); //Free what is not used anymore
-				decodedStr = temp;
-			}
-			else {
-				//Inform the user that the encoding is not supported (only BASE 64 is)
-				temp = allocStrcat(decodedStr, "??Unknown encoding??"); 
-				if (!temp) {
-					free(decodedStr);
-					return(NULL);
-				}
-				decodedStr = temp;
-				break;
-			}
-			if (encodedStr[pos] != '?' || encodedStr[pos+1] != '=') {
-				//Inform the user that the string the server sent was malformed
-				temp = allocStrcat(decodedStr, "?? not ended with ?= ??"); 
-				if (!temp) {
-					free(decodedStr);
-					return(NULL);
-				}
-				decodedStr = temp;
-				break;
-			}
-			pos += 2; //Pass the "?="
-			/* Skip space, as it just seperates the mime encoded lines 
-			   (server sends non-ascii strings in lines of 75 b64 digits) seperated by space.
-			   Actual ' ' is encoded in Base 64 anyway. */
-			if (encodedStr[pos] == ' ') { 
-				pos++;
-			}
-		} 
-		else { //If an ASCII char, append it to string
-			temp = appendChar(decodedStr, encodedStr[pos]); 
-			if (!temp) {
-				free(decodedStr);
-				return(NULL);
-			}
-			decodedStr = temp;
-			pos++; 
-		}
-	} while(encodedStr[pos] != '\0'); //While the end of the string has not been reached
+#ifdef UTF8_SIMD
+	if (__builtin_cpu_supports("sse2")) {
+		pos = asciiPrefixSse2((unsigned char*)str, len);
+	}
+#endif
+	while (pos < len && !(str[pos] & 0x80)) {
+		pos++;
+	}
 
-	return(decodedStr);
+	return(pos);
 }
 
-void printNChars(char *str, int chars) {
-	int pos, printedChars;
-	int k;
+//Decode the character at the start of str, returns its length (a malformed byte is decoded as U+FFFD)
+size_t utf8Decode(char *str, size_t len, unsigned int *codePointPtr) {
+	unsigned char *bytes = (unsigned char*)str;
+	size_t charLen = utf8CharLen(str, len);
+
+	switch (charLen) {
+		case 0:
+			*codePointPtr = 0xFFFD;
+			return(1);
+		case 1:
+			*codePointPtr = bytes[0];
+			break;
+		case 2:
+			*codePointPtr = (bytes[0] & 0x1F) << 6 | (bytes[1] & 0x3F);
+			break;
+		case 3:
+			*codePointPtr = (bytes[0] & 0x0F) << 12 | (bytes[1] & 0x3F) << 6 | (bytes[2] & 0x3F);
+			break;
+		default:
+			*codePointPtr = (bytes[0] & 0x07) << 18 | (bytes[1] & 0x3F) << 12 | (bytes[2] & 0x3F) << 6 | (bytes[3] & 0x3F);
+	}
 
-	for (pos = 0, printedChars = 0 ; str[pos] != '\0' && printedChars < chars ; pos++) {
-		
-		//For each byte, check the first bit
+	return(charLen);
+}
 
-		//If it is 0, the character is ASCII, so one byte long
-		if (!(str[pos] & 128)) {
-			putchar(str[pos]);
-			printedChars++;
-		} 
-		else if (str[pos] & 64) {
-			if (str[pos] & 32) {
-				if (str[pos] & 16) {
-					//If the first four bits are set, the char is four bytes long
-					for (k = 0 ; k < 3 ; k++) {
-						putchar(str[pos]);
-						pos++;
-					}
-					putchar(str[pos]);
-				}
-				else { //Only the first three bits are set, so the char is three bytes long
-					for (k = 0 ; k < 2 ; k++) {
-						putchar(str[pos]);
-						pos++;
-					}
-					putchar(str[pos]);
-				}
-			}
-			else { //Only the first two are set, so the char is two bytes long
-				putchar(str[pos]);
-				pos++;
-				putchar(str[pos]);
-			}
-			printedChars++;
-		}
-		/* I do not check the case of the server sending a continuation byte without sending a coutning byte,
-		 which is not a valid UTF-8 sequence, because I assume that server implementations are sane. */
+//Encode a code point as UTF-8 into dest (which must have room for 4 bytes), returns the length
+size_t utf8Encode(unsigned int codePoint, char *dest) {
+	if (codePoint < 0x80) {
+		dest[0] = codePoint;
+		return(1);
+	}
+	else if (codePoint < 0x800) {
+		dest[0] = 0xC0 | codePoint >> 6;
+		dest[1] = 0x80 | (codePoint & 0x3F);
+		return(2);
+	}
+	else if (codePoint < 0x10000) {
+		dest[0] = 0xE0 | codePoint >> 12;
+		dest[1] = 0x80 | (codePoint >> 6 & 0x3F);
+		dest[2] = 0x80 | (codePoint & 0x3F);
+		return(3);
 	}
+	dest[0] = 0xF0 | codePoint >> 18;
+	dest[1] = 0x80 | (codePoint >> 12 & 0x3F);
+	dest[2] = 0x80 | (codePoint >> 6 & 0x3F);
+	dest[3] = 0x80 | (codePoint & 0x3F);
+	return(4);
 }
 
-int utf8StrLen(char *str) {
-	int pos, len;
-	int k;
-
-	for (pos = 0, len = 0 ; str[pos] != '\0' ; pos++) {
-		
-		//For each byte, check the first bit
-
-		//If it is 0, the character is ASCII, so one byte long
-		if (!(str[pos] & 128)) {
-			len++;
-		} 
-		else if (str[pos] & 64) {
-			if (str[pos] & 32) {
-				if (str[pos] & 16) {
-					//If the first four bits are set, the char is four bytes long
-					for (k = 0 ; k < 3 ; k++) {
-						pos++;
-					}
-				}
-				else { //Only the first three bits are set, so the char is three bytes long
-					for (k = 0 ; k < 2 ; k++) {
-						pos++;
-					}
-				}
-			}
-			else { //Only the first two are set, so the char is two bytes long
-				pos++;
-			}
-			len++;
+int utf8Width(char *str) {
+	size_t len = strlen(str), pos = 0, run;
+	unsigned int codePoint;
+	int width = 0;
+
+	while (pos < len) {
+		//Runs of ASCII (which takes a column per character, as control characters were replaced) are counted at once
+		run = asciiPrefix(str + pos, len - pos);
+		width += run;
+		pos += run;
+		if (pos < len) {
+			pos += utf8Decode(str + pos, len - pos, &codePoint);
+			width += charWidth(codePoint);
 		}
-		/* I do not check the case of the server sending a byte with only one MSB bit set,
-		 which is not a valid UTF-8, because I assume that the server implementations are sane. */
 	}
 
-	return(len);
+	return(width);
 }
 
-int decodedCopyFromObject(char **decodedPtr, imapObjectHandleT imapHandle) {
-	char *temp, *str;
-	int retVal;
+size_t columnsPrefix(char *str, int columns, int *widthPtr) {
+	size_t len = strlen(str), pos = 0, run, charLen;
+	unsigned int codePoint;
+	int width = 0, charCols;
 
-	retVal = copyStrFromObject(&str, imapHandle, NULLABLE);
-	if (isError(retVal)) {
-		return(retVal);
+	while (pos < len && width < columns) {
+		run = asciiPrefix(str + pos, len - pos);
+		if (run > (size_t)(columns - width)) {
+			run = columns - width;
+		}
+		width += run;
+		pos += run;
+		if (pos == len || width == columns) {
+			break;
+		}
+
+		charLen = utf8Decode(str + pos, len - pos, &codePoint);
+		charCols = charWidth(codePoint);
+		if (width + charCols > columns) { //A wide character that does not fit
+			break;
+		}
+		width += charCols;
+		pos += charLen;
 	}
 
-	if (!str) {
-		*decodedPtr = NULL;
-		return(SUCCESS); //No decoding needed, because the object was NIL
+	//A combining mark after the last character printed still belongs to it
+	while (pos < len && (str[pos] & 0x80)) {
+		charLen = utf8Decode(str + pos, len - pos, &codePoint);
+		if (charWidth(codePoint) != 0) {
+			break;
+		}
+		pos += charLen;
 	}
 
-	//Try to decode the string
-	temp = decodeUtf8Str(str);
-	free(str); //Not needed anymore
-	if (!temp) {
-		return(MEM_ERROR);
+	*widthPtr = width;
+	return(pos);
+}
+
+int decodeHeaderField(char **strPtr) {
+	char *decoded;
+
+	if (!*strPtr) {
+		return(SUCCESS);
+	}
+	if (strstr(*strPtr, "=?")) { //Without encoded-words, the string is already decoded
+		decoded = decodeUtf8Str(*strPtr);
+		if (!decoded) {
+			return(MEM_ERROR);
+		}
+		free(*strPtr);
+		*strPtr = decoded;
 	}
 
-	*decodedPtr = temp; //Return the decoded string
-	
-	return(SUCCESS); 
+	//The string is displayed as it is, so malformed UTF-8 and control characters (e.g. escape sequences) are replaced
+	return(utf8Sanitize(strPtr, 0));
 }
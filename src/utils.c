@@ -1,7 +1,10 @@
 #include <ctype.h>
-#include "utils.h"
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "utils.h"
+#include "error.h"
 
 int isNumber(char *str) {
 	for (int k = 0 ; str[k] != '\0' ; k++) {
@@ -20,6 +23,19 @@ void strUpper(char *str) {
 	}
 }
 
+int hexDigitValue(char digit) {
+	if (isdigit(digit)) {
+		return(digit - '0');
+	}
+	else if (digit >= 'A' && digit <= 'F') {
+		return(digit - 'A' + 10);
+	}
+	else if (digit >= 'a' && digit <= 'f') {
+		return(digit - 'a' + 10);
+	}
+
+	return(-1);
+}
 
 //The generated tags are of the form: ADDD where D are digits, and A an uppercase letter
 void generateTag(char tag[TAG_SIZE]) {
@@ -42,4 +58,53 @@ void generateTag(char tag[TAG_SIZE]) {
 		}
 		num = 0;
 	}
-}
\ No newline at end of file
+}
+
+//FNV-1a, a simple hash function that works well for short strings
+size_t hashString(char *str) {
+	size_t hash = 14695981039346656037UL;
+
+	for (int k = 0 ; str[k] != '\0' ; k++) {
+		hash ^= (unsigned char)str[k];
+		hash *= 1099511628211UL;
+	}
+
+	return(hash);
+}
+
+//A quoted string is enclosed in double quotes, and '"' and '\\' are escaped with a '\\'
+int quoteString(char *str, char **quotedPtr) {
+	char *quoted;
+	size_t len = 2;
+
+	for (int k = 0 ; str[k] != '\0' ; k++) {
+		len += (str[k] == '"' || str[k] == '\\') ? 2 : 1;
+	}
+
+	quoted = malloc(len+1);
+	if (!quoted) {
+		return(MEM_ERROR);
+	}
+
+	len = 0;
+	quoted[len++] = '"';
+	for (int k = 0 ; str[k] != '\0' ; k++) {
+		if (str[k] == '"' || str[k] == '\\') {
+			quoted[len++] = '\\';
+		}
+		quoted[len++] = str[k];
+	}
+	quoted[len++] = '"';
+	quoted[len] = '\0';
+
+	*quotedPtr = quoted;
+	return(SUCCESS);
+}
+
+double elapsedMs(struct timespec *startPtr) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return((now.tv_sec - startPtr->tv_sec)*1000.0 + (now.tv_nsec - startPtr->tv_nsec)/1e6);
+}
@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+# The IMAP stand-in of tls_standin.py, that also offers COMPRESS=DEFLATE (RFC 4978) once the client has
+# logged in, to try the DEFLATE layer (check compress.h) against. Each response is deflated with a sync
+# flush, and the ratio is logged when the connection ends.
+#  Run with "make standin-compress", then connect with:
+#   ./imap-client localhost 1431 plain
+#   SSL_CERT_FILE=standin/cert.pem ./imap-client localhost 9931 tls
+#  --eager sends a compressed untagged response in the same segment as the OK of COMPRESS, so that the
+#  client reads compressed data ahead of the OK, and --bandwidth throttles what is sent (in bytes per second).
+
+import sys, time, zlib
+from tls_standin import Connection, Server, argumentParser, serveAll
+
+class CompressConnection(Connection):
+	def __init__(self, server, sock):
+		super().__init__(server, sock)
+		self.deflater = self.inflater = None
+		self.sent = self.sentCompressed = 0
+
+	def capabilities(self):
+		caps = super().capabilities()
+		if self.authed and not self.deflater:
+			caps += " COMPRESS=DEFLATE"
+		return caps
+
+	def recv(self):
+		data = super().recv()
+		return self.inflater.decompress(data) if self.inflater and data else data
+
+	def send(self, data):
+		self.sent += len(data)
+		if self.deflater:
+			data = self.deflater.compress(data) + self.deflater.flush(zlib.Z_SYNC_FLUSH)
+		self.sentCompressed += len(data)
+		super().send(data)
+		if self.server.args.bandwidth:
+			time.sleep(len(data) / self.server.args.bandwidth)
+
+	def doCOMPRESS(self, tag, arg):
+		if self.deflater:
+			self.write(tag, " NO [COMPRESSIONACTIVE] already compressing\r\n")
+			return
+		if arg.upper() != "DEFLATE":
+			self.write(tag, " BAD only DEFLATE\r\n")
+			return
+		ok = ("%s OK DEFLATE active\r\n" % tag).encode()
+		#Raw DEFLATE (no zlib header), both ways, what the client sent after the command is compressed already
+		self.deflater = zlib.compressobj(6, zlib.DEFLATED, -15)
+		self.inflater = zlib.decompressobj(-15)
+		self.pending = self.inflater.decompress(self.pending)
+		data = ok
+		self.sent += len(ok)
+		if self.server.args.eager:
+			hello = b"* OK compressed right behind the OK\r\n"
+			self.sent += len(hello)
+			data += self.deflater.compress(hello) + self.deflater.flush(zlib.Z_SYNC_FLUSH)
+		self.sentCompressed += len(data)
+		self.sock.sendall(data) #In a single segment (the OK itself is not compressed)
+
+	def run(self):
+		try:
+			super().run()
+		finally:
+			if self.sentCompressed:
+				self.log("sent %d bytes as %d (%.1f:1)" % (self.sent, self.sentCompressed, self.sent / self.sentCompressed))
+
+if __name__ == "__main__":
+	parser = argumentParser("An IMAP stand-in that offers COMPRESS=DEFLATE, in cleartext, and over implicit TLS")
+	parser.add_argument("--port", type=int, default=1431, help="the port of cleartext connections")
+	parser.add_argument("--tls-port", type=int, default=9931, help="the port of implicit TLS, 0 for none")
+	parser.add_argument("--eager", action="store_true", help="send compressed data right behind the OK of COMPRESS")
+	parser.add_argument("--bandwidth", type=float, default=0, help="bytes per second sent, 0 for no limit")
+	args = parser.parse_args()
+	servers = [Server(args, args.port, connectionClass=CompressConnection)]
+	if args.tls_port:
+		servers.append(Server(args, args.tls_port, implicitTls=True, connectionClass=CompressConnection))
+	serveAll(servers)
@@ -0,0 +1,301 @@
+#!/usr/bin/env python3
+# A local IMAP server to try the client against, with a generated mailbox, over TLS (implicit, or after
+# STARTTLS) with a self-signed certificate, or in cleartext. It implements the commands the client sends,
+# and no more, and takes any username and password (but "bad", to try a failed login).
+#  Run with "make standin-tls", which makes the certificate (standin/cert.pem) if there is none, then
+#  connect with (the certificate is trusted through SSL_CERT_FILE, check tls.h):
+#   SSL_CERT_FILE=standin/cert.pem ./imap-client localhost 9930 tls
+#   SSL_CERT_FILE=standin/cert.pem ./imap-client localhost 1430 starttls
+#  A resumed session is logged as "resumed=True" (check the sessions of tls.c).
+
+import argparse, base64, random, socket, ssl, sys, threading
+
+MONTHS = ["Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"]
+SYSTEM_FLAGS = {flag.upper(): flag for flag in ["\\Seen", "\\Answered", "\\Flagged", "\\Deleted", "\\Draft"]}
+NAMES = ["Alice", "Bob", "=?utf-8?B?zprPjs+Dz4TOsc+C?=", "=?iso-8859-1?Q?J=F6rg_M=FCller?=", None]
+
+def makeMailbox(count, seed=1):
+	rand = random.Random(seed)
+	msgs = []
+	for uid in range(1, count+1):
+		subject = rand.choice(["Hello %d" % uid, "Re: meeting %d" % (count-uid), "=?windows-1252?Q?caf=E9_=93quoted=94?=", None])
+		text = "".join("Line %d of message %d.\r\n" % (k, uid) for k in range(rand.randint(2, 40))).encode()
+		msgs.append(dict(uid=uid, flags=rand.choice([[], ["\\Seen"], ["\\Seen", "\\Flagged"]]), subject=subject, name=rand.choice(NAMES),
+			mailbox="user%d" % (uid % 7), text=text, size=len(text) + rand.randint(500, 50000),
+			date="%02d-%s-20%02d %02d:%02d:%02d +0200" % (rand.randint(1, 28), rand.choice(MONTHS), rand.randint(10, 24), rand.randint(0, 23), rand.randint(0, 59), rand.randint(0, 59))))
+	return msgs
+
+def quote(string):
+	return "NIL" if string is None else '"%s"' % string.replace("\\", "\\\\").replace('"', '\\"')
+
+def envelope(msg):
+	address = '((%s NIL "%s" "example.com"))' % (quote(msg["name"]), msg["mailbox"])
+	return '("%s" %s %s %s %s %s NIL NIL NIL "<%d@example.com>")' % (msg["date"], quote(msg["subject"]), address, address, address, address, msg["uid"])
+
+def parseSet(string, largest):
+	#A sequence set (e.g. 1:20,25,30:*), as a function that tells whether a number is in it
+	ranges = []
+	for part in string.split(","):
+		low, _, high = part.partition(":")
+		low = largest if low == "*" else int(low)
+		high = low if not high else largest if high == "*" else int(high)
+		ranges.append((min(low, high), max(low, high)))
+	return lambda num: any(low <= num <= high for low, high in ranges)
+
+class Connection:
+	"""One client, the commands are read a line at a time, subclasses may add commands (do<COMMAND>)
+	  and layers (by overriding recv() and send())"""
+	def __init__(self, server, sock):
+		self.server, self.sock = server, sock
+		self.pending = b""
+		self.authed, self.selected = False, None
+		#Every connection has a mailbox of its own, so that what one deletes is there for the next
+		self.mailboxes = {"INBOX": makeMailbox(server.args.messages), "Archive": makeMailbox(20, 2), "Archive/2020": makeMailbox(5, 3)}
+
+	def recv(self):
+		return self.sock.recv(65536)
+
+	def send(self, data):
+		self.sock.sendall(data)
+
+	def write(self, *parts):
+		self.send(b"".join(part if isinstance(part, bytes) else part.encode() for part in parts))
+
+	def readLine(self):
+		while b"\n" not in self.pending:
+			data = self.recv()
+			if not data:
+				return None
+			self.pending += data
+		line, _, self.pending = self.pending.partition(b"\n")
+		return line.decode("utf-8", "replace").rstrip("\r")
+
+	def capabilities(self):
+		caps = "IMAP4rev1 SASL-IR AUTH=PLAIN"
+		if self.server.starttls and not isinstance(self.sock, ssl.SSLSocket):
+			caps += " STARTTLS"
+		return caps
+
+	def log(self, message):
+		sys.stderr.write("[%s] %s\n" % (self.server.name, message))
+
+	def run(self):
+		if self.server.implicitTls:
+			self.startTls()
+		self.write("* OK [CAPABILITY %s] stand-in ready\r\n" % self.capabilities())
+		while True:
+			line = self.readLine()
+			if line is None:
+				return
+			tag, _, rest = line.partition(" ")
+			command, _, arg = rest.partition(" ")
+			command = command.upper()
+			if command == "UID":
+				command, _, arg = arg.partition(" ")
+				command = "UID" + command.upper()
+			self.log("C: " + (line if command not in ("LOGIN", "AUTHENTICATE") else tag + " " + command + " ..."))
+			handler = getattr(self, "do" + command, None)
+			if not handler:
+				self.write(tag, " BAD unknown command\r\n")
+			elif not self.authed and command not in ("CAPABILITY", "STARTTLS", "LOGIN", "AUTHENTICATE", "NOOP", "LOGOUT"):
+				self.write(tag, " BAD not authenticated\r\n")
+			elif self.selected is None and command in ("FETCH", "UIDFETCH", "STORE", "UIDSTORE", "EXPUNGE"):
+				self.write(tag, " BAD no mailbox selected\r\n")
+			elif handler(tag, arg) is False:
+				return
+
+	def startTls(self):
+		self.sock = self.server.context.wrap_socket(self.sock, server_side=True)
+		self.log("TLS up %s resumed=%s" % (self.sock.version(), self.sock.session_reused))
+
+	def doCAPABILITY(self, tag, arg):
+		self.write("* CAPABILITY %s\r\n" % self.capabilities(), tag, " OK done\r\n")
+
+	def doSTARTTLS(self, tag, arg):
+		if "STARTTLS" not in self.capabilities():
+			self.write(tag, " BAD STARTTLS not offered\r\n")
+			return
+		self.write(tag, " OK begin TLS\r\n")
+		self.pending = b"" #Anything sent with the command was not protected, and is dropped (RFC 7457, 2.2)
+		self.startTls()
+
+	def login(self, tag, user, password):
+		if password == "bad":
+			self.write(tag, " NO [AUTHENTICATIONFAILED] invalid credentials\r\n")
+			return
+		self.authed = True
+		self.log("logged in as %s" % user)
+		self.write(tag, " OK [CAPABILITY %s] logged in\r\n" % self.capabilities())
+
+	def doLOGIN(self, tag, arg):
+		args, current, quoted, escaped = [], "", False, False
+		for char in arg: #Two atoms or quoted strings
+			if escaped:
+				current, escaped = current + char, False
+			elif quoted and char == "\\":
+				escaped = True
+			elif char == '"':
+				quoted = not quoted
+			elif char == " " and not quoted:
+				args.append(current)
+				current = ""
+			else:
+				current += char
+		args.append(current)
+		if len(args) != 2:
+			self.write(tag, " BAD LOGIN takes a username and a password\r\n")
+			return
+		self.login(tag, *args)
+
+	def doAUTHENTICATE(self, tag, arg):
+		mechanism, _, initial = arg.partition(" ")
+		try:
+			_, user, password = base64.b64decode(initial).split(b"\0")
+		except ValueError:
+			self.write(tag, " BAD only PLAIN with an initial response\r\n")
+			return
+		self.login(tag, user.decode(), password.decode())
+
+	def doLIST(self, tag, arg):
+		for name in self.mailboxes:
+			self.write('* LIST (\\HasNoChildren) "/" %s\r\n' % quote(name))
+		self.write(tag, " OK done\r\n")
+
+	def doSELECT(self, tag, arg):
+		name = arg.strip('"')
+		name = "INBOX" if name.upper() == "INBOX" else name
+		if name not in self.mailboxes:
+			self.selected = None
+			self.write(tag, " NO no such mailbox\r\n")
+			return
+		self.selected = msgs = self.mailboxes[name]
+		self.write("* FLAGS (\\Seen \\Answered \\Flagged \\Deleted)\r\n* %d EXISTS\r\n* 0 RECENT\r\n" % len(msgs),
+			"* OK [UIDVALIDITY 1] UIDs valid\r\n* OK [UIDNEXT %d] next UID\r\n" % ((msgs[-1]["uid"] if msgs else 0) + 1), tag, " OK [READ-WRITE] selected\r\n")
+
+	def fetch(self, tag, arg, byUid):
+		numbers, _, items = arg.partition(" ")
+		items = items.upper()
+		largest = (self.selected[-1]["uid"] if byUid else len(self.selected)) if self.selected else 0
+		inSet = parseSet(numbers, largest)
+		if not byUid and any(part != "*" and int(part) > largest for part in numbers.replace(",", ":").split(":")):
+			self.write(tag, " BAD invalid message set\r\n")
+			return
+		for seq, msg in enumerate(self.selected, 1):
+			if not inSet(msg["uid"] if byUid else seq):
+				continue
+			data = []
+			if byUid or "UID" in items:
+				data.append(b"UID %d" % msg["uid"])
+			if "FLAGS" in items:
+				data.append(("FLAGS (%s)" % " ".join(msg["flags"])).encode())
+			if "INTERNALDATE" in items:
+				data.append(('INTERNALDATE "%s"' % msg["date"]).encode())
+			if "RFC822.SIZE" in items:
+				data.append(b"RFC822.SIZE %d" % msg["size"])
+			if "ENVELOPE" in items:
+				data.append(("ENVELOPE " + envelope(msg)).encode())
+			if "BODYSTRUCTURE" in items:
+				data.append(b'BODYSTRUCTURE ("TEXT" "PLAIN" ("CHARSET" "US-ASCII") NIL NIL "7BIT" %d %d NIL NIL NIL)' % (len(msg["text"]), msg["text"].count(b"\n")))
+			if "RFC822.TEXT" in items:
+				data.append(b"RFC822.TEXT {%d}\r\n" % len(msg["text"]) + msg["text"])
+			self.write(b"* %d FETCH (%s)\r\n" % (seq, b" ".join(data)))
+		self.write(tag, " OK done\r\n")
+
+	def doFETCH(self, tag, arg):
+		self.fetch(tag, arg, False)
+
+	def doUIDFETCH(self, tag, arg):
+		self.fetch(tag, arg, True)
+
+	def store(self, tag, arg, byUid):
+		numbers, _, change = arg.partition(" ")
+		largest = (self.selected[-1]["uid"] if byUid else len(self.selected)) if self.selected else 0
+		inSet = parseSet(numbers, largest)
+		flags = change[change.find("(")+1:change.rfind(")")].split()
+		for seq, msg in enumerate(self.selected, 1):
+			if not inSet(msg["uid"] if byUid else seq):
+				continue
+			for flag in flags:
+				flag = SYSTEM_FLAGS.get(flag.upper(), flag) #Flags are case-insensitive
+				if change.startswith("+") and flag not in msg["flags"]:
+					msg["flags"].append(flag)
+				elif change.startswith("-") and flag in msg["flags"]:
+					msg["flags"].remove(flag)
+			self.write("* %d FETCH (%sFLAGS (%s))\r\n" % (seq, "UID %d " % msg["uid"] if byUid else "", " ".join(msg["flags"])))
+		self.write(tag, " OK done\r\n")
+
+	def doSTORE(self, tag, arg):
+		self.store(tag, arg, False)
+
+	def doUIDSTORE(self, tag, arg):
+		self.store(tag, arg, True)
+
+	def doEXPUNGE(self, tag, arg):
+		seq = 0
+		while seq < len(self.selected):
+			if "\\Deleted" in self.selected[seq]["flags"]:
+				del self.selected[seq]
+				self.write("* %d EXPUNGE\r\n" % (seq+1))
+			else:
+				seq += 1
+		self.write(tag, " OK done\r\n")
+
+	def doNOOP(self, tag, arg):
+		self.write(tag, " OK done\r\n")
+
+	def doLOGOUT(self, tag, arg):
+		self.write("* BYE logging out\r\n", tag, " OK done\r\n")
+		return False
+
+class Server:
+	"""A listening socket, TLS is either implicit (from the start of every connection), or offered through
+	  STARTTLS (starttls), or neither"""
+	def __init__(self, args, port, implicitTls=False, starttls=False, connectionClass=Connection):
+		self.args, self.port, self.implicitTls, self.starttls = args, port, implicitTls, starttls
+		self.connectionClass = connectionClass
+		self.name = "%s:%d" % ("tls" if implicitTls else "starttls" if starttls else "plain", port)
+		self.context = None
+		if implicitTls or starttls:
+			self.context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+			self.context.load_cert_chain(args.cert, args.key)
+
+	def serveClient(self, sock):
+		try:
+			self.connectionClass(self, sock).run()
+		except (OSError, ssl.SSLError) as error:
+			sys.stderr.write("[%s] connection ended: %s\n" % (self.name, error))
+		finally:
+			sock.close()
+
+	def serve(self):
+		listener = socket.socket()
+		listener.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+		listener.bind(("127.0.0.1", self.port))
+		listener.listen(5)
+		sys.stderr.write("[%s] listening\n" % self.name)
+		while True:
+			sock, _ = listener.accept()
+			threading.Thread(target=self.serveClient, args=(sock,), daemon=True).start()
+
+def serveAll(servers):
+	#Each server in a thread of its own, until Ctrl-C
+	for server in servers:
+		threading.Thread(target=server.serve, daemon=True).start()
+	try:
+		threading.Event().wait()
+	except KeyboardInterrupt:
+		pass
+
+def argumentParser(description):
+	parser = argparse.ArgumentParser(description=description)
+	parser.add_argument("--messages", type=int, default=500, help="the number of messages in INBOX")
+	parser.add_argument("--cert", default="standin/cert.pem")
+	parser.add_argument("--key", default="standin/key.pem")
+	return parser
+
+if __name__ == "__main__":
+	parser = argumentParser("An IMAP stand-in, with implicit TLS and STARTTLS, through a self-signed certificate")
+	parser.add_argument("--tls-port", type=int, default=9930, help="the port of implicit TLS")
+	parser.add_argument("--port", type=int, default=1430, help="the port that offers STARTTLS")
+	args = parser.parse_args()
+	serveAll([Server(args, args.tls_port, implicitTls=True), Server(args, args.port, starttls=True)])